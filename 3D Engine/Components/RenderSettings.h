@@ -1,6 +1,23 @@
 #pragma once
 #include <ECS/Component.h>
 
+/** Triangles a view drew with LOD selection, and would have drawn at full detail. */
+struct LODStats
+{
+	uint64 numTriangles = 0;
+	uint64 numFullDetailTriangles = 0;
+	/** Submeshes drawn at two levels of detail to cross-fade between them. */
+	uint32 numCrossFades = 0;
+};
+
+/** Meshlets a view submitted to cluster culling. */
+struct ClusterCullingStats
+{
+	uint32 numCandidates = 0;
+	/** Draws that submitted them, one per drawn level of a submesh. */
+	uint32 numDraws = 0;
+};
+
 class RenderSettings : public Component
 {
 public:
@@ -11,10 +28,44 @@ public:
 	/** Ray Tracing */
 	bool _UseRayTracing = false;
 
+	/** Level of Detail. The coarsest level whose error projects to at most this many pixels is drawn. */
+	float _LODErrorPixels;
+	/** Shadow maps pick levels as seen from the camera, and tolerate more error since they're filtered and rarely seen up close. */
+	float _ShadowLODErrorPixels;
+	/** Cross-fade to the next level while the projected error is within this fraction of the threshold. Only if LODCrossFade is set. */
+	float _LODCrossFadeRange;
+	/** LODCrossFade in Engine.ini. Compiled into the mesh shaders, so it can't be toggled at runtime. */
+	bool _LODCrossFade;
+
+	/** Triangles drawn in the last frame. */
+	LODStats _GBufferLODStats;
+	LODStats _ShadowLODStats;
+
+	/** Cull meshlets on the GPU against the view frustum, and their normal cones against the camera. */
+	bool _ClusterCulling;
+	/** Also cull the camera's meshlets hidden behind the last frame's depth. */
+	bool _OcclusionCulling;
+
+	/** Cluster culling candidates of the last frame. */
+	ClusterCullingStats _GBufferClusterStats;
+	ClusterCullingStats _ShadowClusterStats;
+
+	/** Write the next frame's graph to FrameGraph.dot. */
+	bool _DumpFrameGraph = false;
+
+	/** GPU time in milliseconds of each pass in a recently completed frame. */
+	std::vector<std::pair<std::string, float>> _PassTimings;
+
 	RenderSettings()
 		: _ExposureAdjustment(Platform::GetFloat("Engine.ini", "Camera", "ExposureAdjustment", 2.0f))
 		, _ExposureBias(Platform::GetFloat("Engine.ini", "Camera", "ExposureBias", 2.0f))
 		, _UseRayTracing(Platform::GetBool("Engine.ini", "Scene", "RayTracing", false))
+		, _LODErrorPixels(Platform::GetFloat("Engine.ini", "Renderer", "LODErrorPixels", 1.0f))
+		, _ShadowLODErrorPixels(Platform::GetFloat("Engine.ini", "Renderer", "ShadowLODErrorPixels", 4.0f))
+		, _LODCrossFadeRange(Platform::GetFloat("Engine.ini", "Renderer", "LODCrossFadeRange", 0.25f))
+		, _LODCrossFade(Platform::GetBool("Engine.ini", "Renderer", "LODCrossFade", false))
+		, _ClusterCulling(Platform::GetBool("Engine.ini", "Renderer", "ClusterCulling", true))
+		, _OcclusionCulling(Platform::GetBool("Engine.ini", "Renderer", "OcclusionCulling", true))
 	{
 	}
 };
\ No newline at end of file
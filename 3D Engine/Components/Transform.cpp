@@ -23,6 +23,7 @@ Transform::Transform(Transform&& other)
 	, _Rotation(other._Rotation)
 	, _Scale(other._Scale)
 	, _LocalToWorld(std::move(other._LocalToWorld))
+	, _Version(other._Version)
 	, _Children(std::move(other._Children))
 {
 }
@@ -35,6 +36,7 @@ Transform& Transform::operator=(Transform&& other)
 	_Rotation = other._Rotation;
 	_Scale = other._Scale;
 	_LocalToWorld = std::move(other._LocalToWorld);
+	_Version = other._Version;
 	_Children = std::move(other._Children);
 	return *this;
 }
@@ -108,6 +110,8 @@ void Transform::Clean(EntityManager& ecs)
 		_LocalToWorld = parentTransform.GetLocalToWorld() * _LocalToWorld;
 	}
 
+	_Version++;
+
 	std::for_each(_Children.begin(), _Children.end(), [&] (Entity child) 
 	{
 		Transform& childTransform = ecs.GetComponent<Transform>(child);
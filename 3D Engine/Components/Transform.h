@@ -36,6 +36,7 @@ public:
 	inline const glm::vec3 GetEulerAngles() const { return glm::eulerAngles(_Rotation); }
 	inline const glm::vec3 GetForward() const { return glm::normalize( _Rotation * forward ); }
 	inline const glm::mat4& GetLocalToWorld() const { return _LocalToWorld; }
+	inline uint64 GetVersion() const { return _Version; }
 
 private:
 	/** The owning entity. */
@@ -56,6 +57,9 @@ private:
 	/** Cached local to world. */
 	glm::mat4 _LocalToWorld;
 
+	/** Incremented whenever the local to world changes, so systems can skip transforms that haven't moved. */
+	uint64 _Version = 0;
+
 	/** Child entities of this transform. */
 	std::list<Entity> _Children;
 
@@ -31,6 +31,9 @@ public:
 	/** Add a callback for when a component is created.	*/
 	void OnComponentCreated(ComponentEvent<ComponentType> componentEvent);
 
+	/** Add a callback for when a component is destroyed. Called before the component is removed. */
+	void OnComponentDestroyed(ComponentEvent<ComponentType> componentEvent);
+
 	/** Notify callbacks that a component was created. */
 	virtual void NotifyOnComponentCreatedEvents() final;
 
@@ -55,6 +58,9 @@ private:
 	/** Component created events. */
 	std::vector<ComponentEvent<ComponentType>> _ComponentCreatedEvents;
 
+	/** Component destroyed events. */
+	std::vector<ComponentEvent<ComponentType>> _ComponentDestroyedEvents;
+
 	/** Entities that were given a component this frame. */
 	std::vector<Entity> _NewEntities;
 };
\ No newline at end of file
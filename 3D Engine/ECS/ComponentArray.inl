@@ -35,6 +35,12 @@ inline void ComponentArray<ComponentType>::OnComponentCreated(ComponentEvent<Com
 	_ComponentCreatedEvents.push_back(componentEvent);
 }
 
+template<typename ComponentType>
+inline void ComponentArray<ComponentType>::OnComponentDestroyed(ComponentEvent<ComponentType> componentEvent)
+{
+	_ComponentDestroyedEvents.push_back(componentEvent);
+}
+
 template<typename ComponentType>
 inline void ComponentArray<ComponentType>::NotifyOnComponentCreatedEvents()
 {
@@ -62,6 +68,11 @@ inline void ComponentArray<ComponentType>::RemoveComponent(Entity& entity)
 	const std::size_t back = _Components.size() - 1;
 	const std::size_t movedEntity = _ArrayIndexToEntity.at(back);
 	const std::size_t moveTo = _EntityToArrayIndex.at(entity.GetEntityID());
+
+	std::for_each(_ComponentDestroyedEvents.begin(), _ComponentDestroyedEvents.end(), [&] (auto& callback)
+	{
+		callback(entity, _Components[moveTo]);
+	});
 	
 	if (_Components.size() > 1)
 	{
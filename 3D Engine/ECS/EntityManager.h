@@ -148,6 +148,15 @@ public:
 		componentArray->OnComponentCreated(componentEvent);
 	}
 
+	/** Add a callback for when ComponentType is destroyed. */
+	template<typename ComponentType>
+	void OnComponentDestroyed(ComponentEvent<ComponentType> componentEvent)
+	{
+		static_assert(std::is_base_of<Component, ComponentType>::value);
+		auto componentArray = GetComponentArray<ComponentType>();
+		componentArray->OnComponentDestroyed(componentEvent);
+	}
+
 	/** Create an entity iterator. */
 	EntityIterator Iter();
 
@@ -1,8 +1,10 @@
 #include "AssetManager.h"
+#include "MipChain.h"
 #include <GPU/GPU.h>
 
 AssetManager::AssetManager(gpu::Device& device)
 	: _Device(device)
+	, _TextureStreamer(device)
 {
 	CreateDebugImages();
 
@@ -57,31 +59,31 @@ gpu::Image* AssetManager::LoadImage(const std::string& assetName, const std::fil
 		return nullptr;
 	}
 
+	// Images loaded from file are sRGB-encoded color.
+	const MipChain mipChain(pixels, width, height, true);
+
+	Platform::FreeImage(pixels);
+
 	std::unique_ptr<gpu::Image> image = std::make_unique<gpu::Image>(
-		_Device.CreateImage(width, height, 1, format, EImageUsage::Sampled | EImageUsage::TransferDst | additionalUsage)
+		_Device.CreateImage(width, height, 1, format, EImageUsage::Sampled | EImageUsage::TransferDst | additionalUsage, mipChain.GetNumMips())
 	);
 
-	gpu::UploadImageData(_Device, pixels, *image);
-
-	Platform::FreeImage(pixels);
+	_UploadTickets[image.get()] = _Device.UploadImageData(*image, mipChain.GetData());
 
 	_Images[assetName] = std::move(image);
 
 	return _Images[assetName].get();
 }
 
-gpu::Image* AssetManager::LoadImage(const std::filesystem::path& path, std::unique_ptr<gpu::Image> image)
+gpu::Image* AssetManager::GetImage(const std::string& assetName) const
 {
-	check(_Images.find(path.generic_string()) == _Images.end(), "Image %s already exists.", path.generic_string().c_str());
-
-	_Images[path.generic_string()] = std::move(image);
-
-	return _Images[path.generic_string()].get();
+	return _Images.find(assetName) == _Images.end() ? nullptr : _Images.at(assetName).get();
 }
 
-gpu::Image* AssetManager::GetImage(const std::string& assetName) const
+gpu::UploadTicket AssetManager::GetUploadTicket(const gpu::Image* image) const
 {
-	return _Images.find(assetName) == _Images.end() ? nullptr : _Images.at(assetName).get();
+	const auto iter = _UploadTickets.find(image);
+	return iter == _UploadTickets.end() ? 0 : iter->second;
 }
 
 const Material* AssetManager::LoadMaterial(const std::string& assetName, std::unique_ptr<Material> material)
@@ -111,6 +113,7 @@ Skybox* AssetManager::LoadSkybox(const std::string& assetName, const std::filesy
 		const std::string pathStr = path.string();
 
 		std::array<gpu::Image*, 6> images;
+		gpu::UploadTicket uploadTicket = 0;
 
 		for (uint32 face = CubemapFace_Begin; face != CubemapFace_End; face++)
 		{
@@ -136,9 +139,10 @@ Skybox* AssetManager::LoadSkybox(const std::string& assetName, const std::filesy
 			}
 
 			images[face] = image;
+			uploadTicket = std::max(uploadTicket, GetUploadTicket(image));
 		}
 
-		_Skyboxes[assetName] = std::make_unique<Skybox>(_Device, images, EFormat::R8G8B8A8_UNORM);
+		_Skyboxes[assetName] = std::make_unique<Skybox>(_Device, images, EFormat::R8G8B8A8_UNORM, uploadTicket);
 
 		return _Skyboxes[assetName].get();
 	}
@@ -155,52 +159,23 @@ gpu::Image AssetManager::_Blue;
 gpu::Image AssetManager::_White;
 gpu::Image AssetManager::_Black;
 
-void AssetManager::CreateDebugImages() const
+void AssetManager::CreateDebugImages()
 {
-	const std::vector<uint8> colors =
+	const uint8 colors[][4] =
 	{
-		255, 0, 0, 0, // Red
-		0, 255, 0, 0, // Green
-		0, 0, 255, 0, // Blue
-		255, 255, 255, 0, // White
-		0, 0, 0, 0, // Black
+		{ 255, 0, 0, 0 }, // Red
+		{ 0, 255, 0, 0 }, // Green
+		{ 0, 0, 255, 0 }, // Blue
+		{ 255, 255, 255, 0 }, // White
+		{ 0, 0, 0, 0 }, // Black
 	};
 
-	gpu::CommandBuffer cmdBuf = _Device.CreateCommandBuffer(EQueue::Transfer);
+	gpu::Image* images[] = { &_Red, &_Green, &_Blue, &_White, &_Black };
 
-	auto stagingBuffer = cmdBuf.CreateStagingBuffer(colors.size(), colors.data());
-
-	AssetManager::_Red = _Device.CreateImage(1, 1, 1, EFormat::R8G8B8A8_UNORM, EImageUsage::Sampled | EImageUsage::TransferDst);
-	AssetManager::_Green = _Device.CreateImage(1, 1, 1, EFormat::R8G8B8A8_UNORM, EImageUsage::Sampled | EImageUsage::TransferDst);
-	AssetManager::_Blue = _Device.CreateImage(1, 1, 1, EFormat::R8G8B8A8_UNORM, EImageUsage::Sampled | EImageUsage::TransferDst);
-	AssetManager::_White = _Device.CreateImage(1, 1, 1, EFormat::R8G8B8A8_UNORM, EImageUsage::Sampled | EImageUsage::TransferDst);
-	AssetManager::_Black = _Device.CreateImage(1, 1, 1, EFormat::R8G8B8A8_UNORM, EImageUsage::Sampled | EImageUsage::TransferDst);
-
-	std::vector<ImageMemoryBarrier> barriers
-	{
-		ImageMemoryBarrier{ AssetManager::_Red, EAccess::None, EAccess::TransferWrite, EImageLayout::Undefined, EImageLayout::TransferDstOptimal },
-		ImageMemoryBarrier{ AssetManager::_Green, EAccess::None, EAccess::TransferWrite, EImageLayout::Undefined, EImageLayout::TransferDstOptimal },
-		ImageMemoryBarrier{ AssetManager::_Blue, EAccess::None, EAccess::TransferWrite, EImageLayout::Undefined, EImageLayout::TransferDstOptimal },
-		ImageMemoryBarrier{ AssetManager::_White, EAccess::None, EAccess::TransferWrite, EImageLayout::Undefined, EImageLayout::TransferDstOptimal },
-		ImageMemoryBarrier{ AssetManager::_Black, EAccess::None, EAccess::TransferWrite, EImageLayout::Undefined, EImageLayout::TransferDstOptimal },
-	};
-
-	cmdBuf.PipelineBarrier(EPipelineStage::TopOfPipe, EPipelineStage::Transfer, 0, nullptr, barriers.size(), barriers.data());
-
-	for (uint32 colorIndex = 0; colorIndex < barriers.size(); colorIndex++)
+	for (std::size_t colorIndex = 0; colorIndex < std::size(images); colorIndex++)
 	{
-		cmdBuf.CopyBufferToImage(*stagingBuffer, colorIndex * 4 * sizeof(uint8), barriers[colorIndex].image, EImageLayout::TransferDstOptimal);
-	}
+		*images[colorIndex] = _Device.CreateImage(1, 1, 1, EFormat::R8G8B8A8_UNORM, EImageUsage::Sampled | EImageUsage::TransferDst);
 
-	for (auto& barrier : barriers)
-	{
-		barrier.srcAccessMask = EAccess::TransferWrite;
-		barrier.dstAccessMask = EAccess::MemoryRead;
-		barrier.oldLayout = EImageLayout::TransferDstOptimal;
-		barrier.newLayout = EImageLayout::ShaderReadOnlyOptimal;
+		_UploadTickets[images[colorIndex]] = _Device.UploadImageData(*images[colorIndex], colors[colorIndex]);
 	}
-
-	cmdBuf.PipelineBarrier(EPipelineStage::Transfer, EPipelineStage::TopOfPipe, 0, nullptr, barriers.size(), barriers.data());
-
-	_Device.SubmitCommands(cmdBuf);
 }
\ No newline at end of file
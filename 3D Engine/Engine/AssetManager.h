@@ -1,6 +1,7 @@
 #pragma once
 #include "StaticMesh.h"
 #include "Skybox.h"
+#include "TextureStreamer.h"
 #include <filesystem>
 
 class gpu::Device;
@@ -25,9 +26,11 @@ public:
 	const StaticMesh* GetStaticMesh(const std::string& assetName) const;
 
 	gpu::Image* LoadImage(const std::string& assetName, const std::filesystem::path& path, EFormat format, EImageUsage additionalUsage = EImageUsage::None);
-	gpu::Image* LoadImage(const std::filesystem::path& path, std::unique_ptr<gpu::Image> image);
 	gpu::Image* GetImage(const std::string& assetName) const;
 
+	/** Upload of an image's pixels, or 0 if the image is null or wasn't uploaded. */
+	gpu::UploadTicket GetUploadTicket(const gpu::Image* image) const;
+
 	const Material* LoadMaterial(const std::string& assetName, std::unique_ptr<Material> material);
 	const Material* GetMaterial(const std::string& assetName);
 
@@ -38,6 +41,9 @@ public:
 	Skybox* LoadSkybox(const std::string& assetName, const std::filesystem::path& path);
 	Skybox* GetSkybox(const std::string& assetName);
 
+	/** Material textures are streamed. Images loaded with LoadImage() stay fully resident. */
+	inline TextureStreamer& GetTextureStreamer() { return _TextureStreamer; }
+
 	static gpu::Image _Red;
 	static gpu::Image _Green;
 	static gpu::Image _Blue;
@@ -51,6 +57,8 @@ private:
 	std::unordered_map<std::string, std::unique_ptr<Material>> _Materials;
 	std::unordered_map<std::string, std::unique_ptr<Skybox>> _Skyboxes;
 	std::unordered_map<std::string, std::unique_ptr<gpu::Image>> _Images;
+	std::unordered_map<const gpu::Image*, gpu::UploadTicket> _UploadTickets;
+	TextureStreamer _TextureStreamer;
 
-	void CreateDebugImages() const;
+	void CreateDebugImages();
 };
\ No newline at end of file
@@ -0,0 +1,850 @@
+#include "BlockCompression.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <emmintrin.h>
+
+/** Squared distances of 16 texels to a color. Channels with a mask of 0 are ignored. */
+static void ComputeDistances(const uint8 texels[64], const int32 color[4], const int32 mask[4], int32 distances[16])
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i color16 = _mm_setr_epi16(
+		static_cast<int16>(color[0]), static_cast<int16>(color[1]), static_cast<int16>(color[2]), static_cast<int16>(color[3]),
+		static_cast<int16>(color[0]), static_cast<int16>(color[1]), static_cast<int16>(color[2]), static_cast<int16>(color[3]));
+	const __m128i mask16 = _mm_setr_epi16(
+		static_cast<int16>(-mask[0]), static_cast<int16>(-mask[1]), static_cast<int16>(-mask[2]), static_cast<int16>(-mask[3]),
+		static_cast<int16>(-mask[0]), static_cast<int16>(-mask[1]), static_cast<int16>(-mask[2]), static_cast<int16>(-mask[3]));
+
+	for (uint32 i = 0; i < 16; i += 4)
+	{
+		const __m128i fourTexels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(texels + i * 4));
+
+		// Two texels per register as 16-bit channels.
+		const __m128i diffLo = _mm_and_si128(_mm_sub_epi16(_mm_unpacklo_epi8(fourTexels, zero), color16), mask16);
+		const __m128i diffHi = _mm_and_si128(_mm_sub_epi16(_mm_unpackhi_epi8(fourTexels, zero), color16), mask16);
+
+		// (r^2 + g^2, b^2 + a^2) for each texel.
+		const __m128 sumsLo = _mm_castsi128_ps(_mm_madd_epi16(diffLo, diffLo));
+		const __m128 sumsHi = _mm_castsi128_ps(_mm_madd_epi16(diffHi, diffHi));
+
+		const __m128i rg = _mm_castps_si128(_mm_shuffle_ps(sumsLo, sumsHi, _MM_SHUFFLE(2, 0, 2, 0)));
+		const __m128i ba = _mm_castps_si128(_mm_shuffle_ps(sumsLo, sumsHi, _MM_SHUFFLE(3, 1, 3, 1)));
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(distances + i), _mm_add_epi32(rg, ba));
+	}
+}
+
+/** Pick the closest palette entry for each texel. Returns the total squared error. */
+static int32 SelectIndices(const uint8 texels[64], const int32 palette[][4], uint32 numEntries, const int32 mask[4], uint8 indices[16])
+{
+	int32 bestDistances[16];
+	int32 distances[16];
+
+	ComputeDistances(texels, palette[0], mask, bestDistances);
+	std::fill_n(indices, 16, 0);
+
+	for (uint32 entry = 1; entry < numEntries; entry++)
+	{
+		ComputeDistances(texels, palette[entry], mask, distances);
+
+		for (uint32 i = 0; i < 16; i++)
+		{
+			if (distances[i] < bestDistances[i])
+			{
+				bestDistances[i] = distances[i];
+				indices[i] = static_cast<uint8>(entry);
+			}
+		}
+	}
+
+	int32 error = 0;
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		error += bestDistances[i];
+	}
+
+	return error;
+}
+
+/** Principal axis of the texels, found by power iteration on the covariance matrix. Returns false if the texels are all the same. */
+static bool ComputePrincipalAxis(const uint8 texels[64], uint32 numChannels, float mean[4], float axis[4])
+{
+	std::fill_n(mean, 4, 0.0f);
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		for (uint32 c = 0; c < numChannels; c++)
+		{
+			mean[c] += texels[i * 4 + c] / 16.0f;
+		}
+	}
+
+	float covariance[4][4] = {};
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		float diff[4] = {};
+
+		for (uint32 c = 0; c < numChannels; c++)
+		{
+			diff[c] = texels[i * 4 + c] - mean[c];
+		}
+
+		for (uint32 row = 0; row < numChannels; row++)
+		{
+			for (uint32 col = 0; col < numChannels; col++)
+			{
+				covariance[row][col] += diff[row] * diff[col];
+			}
+		}
+	}
+
+	float trace = 0.0f;
+
+	for (uint32 c = 0; c < numChannels; c++)
+	{
+		trace += covariance[c][c];
+		axis[c] = 1.0f;
+	}
+
+	if (trace < 1e-3f)
+	{
+		return false;
+	}
+
+	for (uint32 iteration = 0; iteration < 8; iteration++)
+	{
+		float next[4] = {};
+		float length = 0.0f;
+
+		for (uint32 row = 0; row < numChannels; row++)
+		{
+			for (uint32 col = 0; col < numChannels; col++)
+			{
+				next[row] += covariance[row][col] * axis[col];
+			}
+
+			length = std::max(length, std::abs(next[row]));
+		}
+
+		if (length < 1e-6f)
+		{
+			break;
+		}
+
+		for (uint32 c = 0; c < numChannels; c++)
+		{
+			axis[c] = next[c] / length;
+		}
+	}
+
+	return true;
+}
+
+/** Endpoints at the extremes of the texels' projections onto the principal axis. */
+static void ComputeEndpoints(const uint8 texels[64], uint32 numChannels, float endpoint0[4], float endpoint1[4])
+{
+	float mean[4];
+	float axis[4] = {};
+
+	if (!ComputePrincipalAxis(texels, numChannels, mean, axis))
+	{
+		std::copy_n(mean, 4, endpoint0);
+		std::copy_n(mean, 4, endpoint1);
+		return;
+	}
+
+	float minProjection = std::numeric_limits<float>::max();
+	float maxProjection = std::numeric_limits<float>::lowest();
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		float projection = 0.0f;
+
+		for (uint32 c = 0; c < numChannels; c++)
+		{
+			projection += (texels[i * 4 + c] - mean[c]) * axis[c];
+		}
+
+		minProjection = std::min(minProjection, projection);
+		maxProjection = std::max(maxProjection, projection);
+	}
+
+	float lengthSquared = 0.0f;
+
+	for (uint32 c = 0; c < numChannels; c++)
+	{
+		lengthSquared += axis[c] * axis[c];
+	}
+
+	for (uint32 c = 0; c < numChannels; c++)
+	{
+		endpoint0[c] = std::clamp(mean[c] + axis[c] * maxProjection / lengthSquared, 0.0f, 255.0f);
+		endpoint1[c] = std::clamp(mean[c] + axis[c] * minProjection / lengthSquared, 0.0f, 255.0f);
+	}
+}
+
+/**
+  * Least-squares endpoints for the selected indices, where weights[index] is the contribution of endpoint 0.
+  * Returns false if the indices don't constrain both endpoints.
+  */
+static bool FitEndpoints(const uint8 texels[64], uint32 numChannels, const uint8 indices[16], const float* weights, float endpoint0[4], float endpoint1[4])
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = {}, bx[4] = {};
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		const float a = weights[indices[i]];
+		const float b = 1.0f - a;
+
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+
+		for (uint32 c = 0; c < numChannels; c++)
+		{
+			ax[c] += a * texels[i * 4 + c];
+			bx[c] += b * texels[i * 4 + c];
+		}
+	}
+
+	const float determinant = aa * bb - ab * ab;
+
+	if (std::abs(determinant) < 1e-6f)
+	{
+		return false;
+	}
+
+	for (uint32 c = 0; c < numChannels; c++)
+	{
+		endpoint0[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.0f, 255.0f);
+		endpoint1[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.0f, 255.0f);
+	}
+
+	return true;
+}
+
+/** Writes fields to a block from the least significant bit up. The block must be zeroed. */
+class BitWriter
+{
+public:
+	BitWriter(uint8* data) : _Data(data) {}
+
+	void Write(uint32 value, uint32 numBits)
+	{
+		for (uint32 bit = 0; bit < numBits; bit++, _Offset++)
+		{
+			_Data[_Offset / 8] |= ((value >> bit) & 1) << (_Offset % 8);
+		}
+	}
+
+private:
+	uint8* _Data;
+	uint32 _Offset = 0;
+};
+
+class BitReader
+{
+public:
+	BitReader(const uint8* data) : _Data(data) {}
+
+	uint32 Read(uint32 numBits)
+	{
+		uint32 value = 0;
+
+		for (uint32 bit = 0; bit < numBits; bit++, _Offset++)
+		{
+			value |= ((_Data[_Offset / 8] >> (_Offset % 8)) & 1) << bit;
+		}
+
+		return value;
+	}
+
+private:
+	const uint8* _Data;
+	uint32 _Offset = 0;
+};
+
+static uint16 To565(const float color[4])
+{
+	const uint32 r = static_cast<uint32>(color[0] * 31.0f / 255.0f + 0.5f);
+	const uint32 g = static_cast<uint32>(color[1] * 63.0f / 255.0f + 0.5f);
+	const uint32 b = static_cast<uint32>(color[2] * 31.0f / 255.0f + 0.5f);
+	return static_cast<uint16>((r << 11) | (g << 5) | b);
+}
+
+static void From565(uint16 value, int32 color[4])
+{
+	const int32 r = (value >> 11) & 31;
+	const int32 g = (value >> 5) & 63;
+	const int32 b = value & 31;
+	color[0] = (r << 3) | (r >> 2);
+	color[1] = (g << 2) | (g >> 4);
+	color[2] = (b << 3) | (b >> 2);
+	color[3] = 255;
+}
+
+/** Palette of a BC1 color block in four-color mode, in index order. */
+static void GetBC1Palette(uint16 color0, uint16 color1, int32 palette[4][4])
+{
+	From565(color0, palette[0]);
+	From565(color1, palette[1]);
+
+	for (uint32 c = 0; c < 4; c++)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+}
+
+static void WriteColorBlock(uint16 color0, uint16 color1, const uint8 indices[16], uint8 block[8])
+{
+	block[0] = static_cast<uint8>(color0);
+	block[1] = static_cast<uint8>(color0 >> 8);
+	block[2] = static_cast<uint8>(color1);
+	block[3] = static_cast<uint8>(color1 >> 8);
+
+	uint32 packedIndices = 0;
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		packedIndices |= indices[i] << (2 * i);
+	}
+
+	std::memcpy(block + 4, &packedIndices, sizeof(packedIndices));
+}
+
+/**
+  * For each 8-bit value, the 5- or 6-bit endpoints whose first interpolated color, (2 * endpoint0 + endpoint1) / 3, is closest to it.
+  * Rounding a value to one endpoint can be 4 off in 5 bits, and interpolating between two gets within 1. Ties go to the closer pair,
+  * so decoders that round the interpolation differently land near the same value.
+  */
+static std::array<std::array<uint8, 2>, 256> ComputeSingleColorTable(uint32 numBits)
+{
+	const int32 maxEndpoint = (1 << numBits) - 1;
+	const auto expand = [numBits] (int32 endpoint)
+	{
+		return (endpoint << (8 - numBits)) | (endpoint >> (2 * numBits - 8));
+	};
+
+	std::array<std::array<uint8, 2>, 256> table;
+
+	for (int32 value = 0; value < 256; value++)
+	{
+		int32 bestError = std::numeric_limits<int32>::max();
+		int32 bestSpread = std::numeric_limits<int32>::max();
+
+		for (int32 endpoint0 = 0; endpoint0 <= maxEndpoint; endpoint0++)
+		{
+			for (int32 endpoint1 = 0; endpoint1 <= maxEndpoint; endpoint1++)
+			{
+				const int32 error = std::abs((2 * expand(endpoint0) + expand(endpoint1)) / 3 - value);
+				const int32 spread = std::abs(expand(endpoint0) - expand(endpoint1));
+
+				if (error < bestError || (error == bestError && spread < bestSpread))
+				{
+					bestError = error;
+					bestSpread = spread;
+					table[value] = { static_cast<uint8>(endpoint0), static_cast<uint8>(endpoint1) };
+				}
+			}
+		}
+	}
+
+	return table;
+}
+
+static const std::array<std::array<uint8, 2>, 256> gSingleColor5 = ComputeSingleColorTable(5);
+static const std::array<std::array<uint8, 2>, 256> gSingleColor6 = ComputeSingleColorTable(6);
+
+/** Encode a block of one color with the single-color tables, every texel on the first interpolated color. */
+static void EncodeSingleColorBlock(const uint8 color[4], uint8 block[8])
+{
+	const auto& r = gSingleColor5[color[0]];
+	const auto& g = gSingleColor6[color[1]];
+	const auto& b = gSingleColor5[color[2]];
+
+	uint16 color0 = static_cast<uint16>((r[0] << 11) | (g[0] << 5) | b[0]);
+	uint16 color1 = static_cast<uint16>((r[1] << 11) | (g[1] << 5) | b[1]);
+	uint8 index = 2;
+
+	// Four-color mode needs the first color to be greater. Swapped, the same color is the second interpolated one.
+	if (color0 < color1)
+	{
+		std::swap(color0, color1);
+		index = 3;
+	}
+	else if (color0 == color1)
+	{
+		index = 0;
+	}
+
+	uint8 indices[16];
+	std::fill_n(indices, 16, index);
+
+	WriteColorBlock(color0, color1, indices, block);
+}
+
+/** Encode a color block in four-color mode, which is the only mode BC3 color blocks have. */
+static void EncodeColorBlock(const uint8 texels[64], uint8 block[8])
+{
+	static constexpr int32 rgbMask[4] = { 1, 1, 1, 0 };
+	static constexpr float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+
+	bool isSingleColor = true;
+
+	for (uint32 i = 1; i < 16 && isSingleColor; i++)
+	{
+		isSingleColor = std::equal(texels, texels + 3, texels + i * 4);
+	}
+
+	if (isSingleColor)
+	{
+		EncodeSingleColorBlock(texels, block);
+		return;
+	}
+
+	float endpoint0[4] = {}, endpoint1[4] = {};
+	ComputeEndpoints(texels, 3, endpoint0, endpoint1);
+
+	uint16 bestColors[2] = {};
+	uint8 bestIndices[16] = {};
+	int32 bestError = std::numeric_limits<int32>::max();
+
+	for (uint32 iteration = 0; iteration < 3; iteration++)
+	{
+		uint16 colors[2] = { To565(endpoint0), To565(endpoint1) };
+
+		// Four-color mode needs the first color to be greater.
+		if (colors[0] < colors[1])
+		{
+			std::swap(colors[0], colors[1]);
+		}
+
+		int32 palette[4][4];
+		GetBC1Palette(colors[0], colors[1], palette);
+
+		uint8 indices[16];
+		const int32 error = colors[0] == colors[1] ? SelectIndices(texels, palette, 1, rgbMask, indices) : SelectIndices(texels, palette, 4, rgbMask, indices);
+
+		if (error < bestError)
+		{
+			bestError = error;
+			bestColors[0] = colors[0];
+			bestColors[1] = colors[1];
+			std::copy_n(indices, 16, bestIndices);
+		}
+
+		if (error == 0 || !FitEndpoints(texels, 3, indices, weights, endpoint0, endpoint1))
+		{
+			break;
+		}
+	}
+
+	WriteColorBlock(bestColors[0], bestColors[1], bestIndices, block);
+}
+
+static void DecodeColorBlock(const uint8 block[8], uint8 texels[64], bool isBC1)
+{
+	const uint16 color0 = block[0] | (block[1] << 8);
+	const uint16 color1 = block[2] | (block[3] << 8);
+
+	int32 palette[4][4];
+	GetBC1Palette(color0, color1, palette);
+
+	// BC1 blocks with color0 <= color1 are in three-color mode, with transparent black as the fourth color.
+	if (isBC1 && color0 <= color1)
+	{
+		for (uint32 c = 0; c < 4; c++)
+		{
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+
+	uint32 packedIndices;
+	std::memcpy(&packedIndices, block + 4, sizeof(packedIndices));
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		const uint32 index = (packedIndices >> (2 * i)) & 3;
+
+		for (uint32 c = 0; c < 4; c++)
+		{
+			texels[i * 4 + c] = static_cast<uint8>(palette[index][c]);
+		}
+	}
+}
+
+/** Palette of a BC4 block in index order. */
+static void GetBC4Palette(uint8 value0, uint8 value1, int32 palette[8])
+{
+	palette[0] = value0;
+	palette[1] = value1;
+
+	if (value0 > value1)
+	{
+		for (int32 i = 1; i < 7; i++)
+		{
+			palette[i + 1] = ((7 - i) * value0 + i * value1) / 7;
+		}
+	}
+	else
+	{
+		for (int32 i = 1; i < 5; i++)
+		{
+			palette[i + 1] = ((5 - i) * value0 + i * value1) / 5;
+		}
+
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static int32 SelectBC4Indices(const uint8 values[16], const int32 palette[8], uint8 indices[16])
+{
+	int32 error = 0;
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		int32 bestDistance = std::numeric_limits<int32>::max();
+
+		for (uint32 entry = 0; entry < 8; entry++)
+		{
+			const int32 distance = (values[i] - palette[entry]) * (values[i] - palette[entry]);
+
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				indices[i] = static_cast<uint8>(entry);
+			}
+		}
+
+		error += bestDistance;
+	}
+
+	return error;
+}
+
+void BlockCompression::EncodeBC1(const uint8 texels[64], uint8 block[8])
+{
+	EncodeColorBlock(texels, block);
+}
+
+void BlockCompression::DecodeBC1(const uint8 block[8], uint8 texels[64])
+{
+	DecodeColorBlock(block, texels, true);
+}
+
+void BlockCompression::EncodeBC3(const uint8 texels[64], uint8 block[16])
+{
+	uint8 alpha[16];
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		alpha[i] = texels[i * 4 + 3];
+	}
+
+	EncodeBC4(alpha, block);
+	EncodeColorBlock(texels, block + 8);
+}
+
+void BlockCompression::DecodeBC3(const uint8 block[16], uint8 texels[64])
+{
+	uint8 alpha[16];
+
+	DecodeBC4(block, alpha);
+	DecodeColorBlock(block + 8, texels, false);
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		texels[i * 4 + 3] = alpha[i];
+	}
+}
+
+void BlockCompression::EncodeBC4(const uint8 values[16], uint8 block[8])
+{
+	const auto [minValue, maxValue] = std::minmax_element(values, values + 16);
+
+	// Eight interpolated values between the extremes.
+	uint8 bestEndpoints[2] = { *maxValue, *minValue };
+	uint8 bestIndices[16];
+	int32 palette[8];
+
+	GetBC4Palette(bestEndpoints[0], bestEndpoints[1], palette);
+	int32 bestError = SelectBC4Indices(values, palette, bestIndices);
+
+	// Six interpolated values plus exact 0 and 255, for blocks that have them.
+	if (bestError > 0 && (*minValue == 0 || *maxValue == 255))
+	{
+		uint8 innerMin = 255;
+		uint8 innerMax = 0;
+
+		for (uint32 i = 0; i < 16; i++)
+		{
+			if (values[i] != 0 && values[i] != 255)
+			{
+				innerMin = std::min(innerMin, values[i]);
+				innerMax = std::max(innerMax, values[i]);
+			}
+		}
+
+		if (innerMin > innerMax)
+		{
+			innerMin = innerMax = 0;
+		}
+
+		uint8 indices[16];
+		GetBC4Palette(innerMin, innerMax, palette);
+
+		if (const int32 error = SelectBC4Indices(values, palette, indices); error < bestError)
+		{
+			bestError = error;
+			bestEndpoints[0] = innerMin;
+			bestEndpoints[1] = innerMax;
+			std::copy_n(indices, 16, bestIndices);
+		}
+	}
+
+	block[0] = bestEndpoints[0];
+	block[1] = bestEndpoints[1];
+
+	uint64 packedIndices = 0;
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		packedIndices |= uint64(bestIndices[i]) << (3 * i);
+	}
+
+	for (uint32 byte = 0; byte < 6; byte++)
+	{
+		block[2 + byte] = static_cast<uint8>(packedIndices >> (8 * byte));
+	}
+}
+
+void BlockCompression::DecodeBC4(const uint8 block[8], uint8 values[16])
+{
+	int32 palette[8];
+	GetBC4Palette(block[0], block[1], palette);
+
+	uint64 packedIndices = 0;
+
+	for (uint32 byte = 0; byte < 6; byte++)
+	{
+		packedIndices |= uint64(block[2 + byte]) << (8 * byte);
+	}
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		values[i] = static_cast<uint8>(palette[(packedIndices >> (3 * i)) & 7]);
+	}
+}
+
+void BlockCompression::EncodeBC5(const uint8 texels[64], uint8 block[16])
+{
+	uint8 red[16];
+	uint8 green[16];
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		red[i] = texels[i * 4 + 0];
+		green[i] = texels[i * 4 + 1];
+	}
+
+	EncodeBC4(red, block);
+	EncodeBC4(green, block + 8);
+}
+
+void BlockCompression::DecodeBC5(const uint8 block[16], uint8 texels[64])
+{
+	uint8 red[16];
+	uint8 green[16];
+
+	DecodeBC4(block, red);
+	DecodeBC4(block + 8, green);
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		texels[i * 4 + 0] = red[i];
+		texels[i * 4 + 1] = green[i];
+		texels[i * 4 + 2] = 0;
+		texels[i * 4 + 3] = 255;
+	}
+}
+
+static constexpr int32 gBC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+static void GetBC7Palette(const int32 endpoint0[4], const int32 endpoint1[4], int32 palette[16][4])
+{
+	for (uint32 i = 0; i < 16; i++)
+	{
+		for (uint32 c = 0; c < 4; c++)
+		{
+			palette[i][c] = ((64 - gBC7Weights[i]) * endpoint0[c] + gBC7Weights[i] * endpoint1[c] + 32) >> 6;
+		}
+	}
+}
+
+/** Quantize an endpoint to 7 bits per channel and a shared p-bit. */
+static void QuantizeBC7Endpoint(const float endpoint[4], uint32 quantized[4], uint32& pBit)
+{
+	float bestError = std::numeric_limits<float>::max();
+
+	for (uint32 p = 0; p < 2; p++)
+	{
+		uint32 candidate[4];
+		float error = 0.0f;
+
+		for (uint32 c = 0; c < 4; c++)
+		{
+			candidate[c] = static_cast<uint32>(std::clamp(std::floor((endpoint[c] - p) / 2.0f + 0.5f), 0.0f, 127.0f));
+			const float diff = static_cast<float>((candidate[c] << 1) | p) - endpoint[c];
+			error += diff * diff;
+		}
+
+		if (error < bestError)
+		{
+			bestError = error;
+			pBit = p;
+			std::copy_n(candidate, 4, quantized);
+		}
+	}
+}
+
+void BlockCompression::EncodeBC7(const uint8 texels[64], uint8 block[16])
+{
+	static constexpr int32 rgbaMask[4] = { 1, 1, 1, 1 };
+	static const std::array<float, 16> weights = [] ()
+	{
+		std::array<float, 16> weights;
+
+		for (uint32 i = 0; i < 16; i++)
+		{
+			weights[i] = (64 - gBC7Weights[i]) / 64.0f;
+		}
+
+		return weights;
+	}();
+
+	float endpoints[2][4] = {};
+	ComputeEndpoints(texels, 4, endpoints[0], endpoints[1]);
+
+	uint32 bestQuantized[2][4] = {};
+	uint32 bestPBits[2] = {};
+	uint8 bestIndices[16] = {};
+	int32 bestError = std::numeric_limits<int32>::max();
+
+	for (uint32 iteration = 0; iteration < 3; iteration++)
+	{
+		uint32 quantized[2][4];
+		uint32 pBits[2];
+		int32 unquantized[2][4];
+
+		for (uint32 e = 0; e < 2; e++)
+		{
+			QuantizeBC7Endpoint(endpoints[e], quantized[e], pBits[e]);
+
+			for (uint32 c = 0; c < 4; c++)
+			{
+				unquantized[e][c] = (quantized[e][c] << 1) | pBits[e];
+			}
+		}
+
+		int32 palette[16][4];
+		GetBC7Palette(unquantized[0], unquantized[1], palette);
+
+		uint8 indices[16];
+		const int32 error = SelectIndices(texels, palette, 16, rgbaMask, indices);
+
+		if (error < bestError)
+		{
+			bestError = error;
+			std::copy_n(&quantized[0][0], 8, &bestQuantized[0][0]);
+			std::copy_n(pBits, 2, bestPBits);
+			std::copy_n(indices, 16, bestIndices);
+		}
+
+		if (error == 0 || !FitEndpoints(texels, 4, indices, weights.data(), endpoints[0], endpoints[1]))
+		{
+			break;
+		}
+	}
+
+	// The most significant bit of the first index is implied to be 0, so swap the endpoints if it's set.
+	if (bestIndices[0] & 8)
+	{
+		for (uint32 c = 0; c < 4; c++)
+		{
+			std::swap(bestQuantized[0][c], bestQuantized[1][c]);
+		}
+
+		std::swap(bestPBits[0], bestPBits[1]);
+
+		for (uint32 i = 0; i < 16; i++)
+		{
+			bestIndices[i] = 15 - bestIndices[i];
+		}
+	}
+
+	std::fill_n(block, 16, 0);
+
+	BitWriter writer(block);
+	writer.Write(1 << 6, 7);
+
+	for (uint32 c = 0; c < 4; c++)
+	{
+		writer.Write(bestQuantized[0][c], 7);
+		writer.Write(bestQuantized[1][c], 7);
+	}
+
+	writer.Write(bestPBits[0], 1);
+	writer.Write(bestPBits[1], 1);
+	writer.Write(bestIndices[0], 3);
+
+	for (uint32 i = 1; i < 16; i++)
+	{
+		writer.Write(bestIndices[i], 4);
+	}
+}
+
+void BlockCompression::DecodeBC7(const uint8 block[16], uint8 texels[64])
+{
+	BitReader reader(block);
+
+	const uint32 mode = reader.Read(7);
+
+	check(mode == (1 << 6), "Only BC7 mode 6 blocks can be decoded.");
+
+	int32 endpoints[2][4];
+
+	for (uint32 c = 0; c < 4; c++)
+	{
+		endpoints[0][c] = reader.Read(7) << 1;
+		endpoints[1][c] = reader.Read(7) << 1;
+	}
+
+	const uint32 pBit0 = reader.Read(1);
+	const uint32 pBit1 = reader.Read(1);
+
+	for (uint32 c = 0; c < 4; c++)
+	{
+		endpoints[0][c] |= pBit0;
+		endpoints[1][c] |= pBit1;
+	}
+
+	int32 palette[16][4];
+	GetBC7Palette(endpoints[0], endpoints[1], palette);
+
+	for (uint32 i = 0; i < 16; i++)
+	{
+		const uint32 index = reader.Read(i == 0 ? 3 : 4);
+
+		for (uint32 c = 0; c < 4; c++)
+		{
+			texels[i * 4 + c] = static_cast<uint8>(palette[index][c]);
+		}
+	}
+}
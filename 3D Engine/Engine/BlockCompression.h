@@ -0,0 +1,34 @@
+#pragma once
+#include <Platform/Platform.h>
+
+/**
+  * Encoders and decoders of 4x4 blocks of block-compressed formats.
+  * Blocks are 16 RGBA8 texels in row-major order. Single-channel encoders take 16 bytes.
+  * Decoders only need to handle the blocks the encoders write, and are used to measure encoding error.
+  */
+class BlockCompression
+{
+public:
+	static constexpr uint32 blockDim = 4;
+	static constexpr uint32 numBlockTexels = blockDim * blockDim;
+
+	/** RGB in 4 bits per texel. Alpha is ignored. */
+	static void EncodeBC1(const uint8 texels[64], uint8 block[8]);
+	static void DecodeBC1(const uint8 block[8], uint8 texels[64]);
+
+	/** BC1 color and BC4 alpha, in 8 bits per texel. */
+	static void EncodeBC3(const uint8 texels[64], uint8 block[16]);
+	static void DecodeBC3(const uint8 block[16], uint8 texels[64]);
+
+	/** One channel in 4 bits per texel. */
+	static void EncodeBC4(const uint8 values[16], uint8 block[8]);
+	static void DecodeBC4(const uint8 block[8], uint8 values[16]);
+
+	/** Red and green as two BC4 blocks, in 8 bits per texel. Blue and alpha are ignored. */
+	static void EncodeBC5(const uint8 texels[64], uint8 block[16]);
+	static void DecodeBC5(const uint8 block[16], uint8 texels[64]);
+
+	/** RGBA in 8 bits per texel. Only mode 6 is used: one subset with 7-bit endpoints, p-bits and 4-bit indices. */
+	static void EncodeBC7(const uint8 texels[64], uint8 block[16]);
+	static void DecodeBC7(const uint8 block[16], uint8 texels[64]);
+};
@@ -6,6 +6,7 @@
 #include <Systems/UserInterface.h>
 #include <Systems/CameraSystem.h>
 #include <Systems/ShadowSystem.h>
+#include <Systems/TextureStreamingSystem.h>
 #include <Engine/Screen.h>
 #include <Engine/Cursor.h>
 #include <Engine/Input.h>
@@ -13,12 +14,14 @@
 
 Engine::Engine(
 	Platform& platform, 
+	JobSystem& jobSystem,
 	Cursor& cursor,
 	Input& input,
 	Screen& screen,
 	gpu::Device& device,
 	gpu::Compositor& compositor) 
 	: _Platform(platform)
+	, _JobSystem(jobSystem)
 	, _Cursor(cursor)
 	, _Input(input)
 	, _Screen(screen)
@@ -50,6 +53,10 @@ void Engine::Main()
 	ShadowSystem shadowSystem;
 	systemsManager.Register(shadowSystem);
 
+	// After the surface and camera systems, so surface bounds and cameras are up to date.
+	TextureStreamingSystem textureStreamingSystem;
+	systemsManager.Register(textureStreamingSystem);
+
 	systemsManager.StartSystems(*this);
 
 	SceneRenderer sceneRenderer(*this);
@@ -4,6 +4,7 @@
 #include "AssetManager.h"
 #include "Components/Camera.h"
 
+class JobSystem;
 class Cursor;
 class Input;
 class Screen;
@@ -15,6 +16,7 @@ class Engine
 public:
 	Engine(
 		Platform& platform,
+		JobSystem& jobSystem,
 		Cursor& cursor,
 		Input& input,
 		Screen& screen,
@@ -26,6 +28,7 @@ public:
 
 	/** Platform implementations. */
 	Platform& _Platform;
+	JobSystem& _JobSystem;
 	Cursor& _Cursor;
 	Input& _Input;
 	Screen& _Screen;
@@ -0,0 +1,506 @@
+#include "JobSystem.h"
+#include <Platform/Platform.h>
+#include <chrono>
+
+static JobSystem* gJobSystem = nullptr;
+static thread_local int32 gWorkerIndex = -1;
+
+/** Freed jobs are kept by the thread that executed them, so jobs are only allocated until the pools are warm. */
+struct JobPool
+{
+	std::vector<Job*> jobs;
+
+	~JobPool()
+	{
+		for (Job* job : jobs)
+		{
+			delete job;
+		}
+	}
+};
+
+static thread_local JobPool gJobPool;
+static constexpr std::size_t maxPooledJobs = 1024;
+
+static uint64 GetTimeNs()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+bool JobDeque::Push(Job* job)
+{
+	const int64 bottom = _Bottom.load(std::memory_order_relaxed);
+	const int64 top = _Top.load(std::memory_order_acquire);
+
+	if (bottom - top >= capacity)
+	{
+		return false;
+	}
+
+	_Jobs[bottom & (capacity - 1)].store(job, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	_Bottom.store(bottom + 1, std::memory_order_relaxed);
+
+	return true;
+}
+
+Job* JobDeque::Pop()
+{
+	const int64 bottom = _Bottom.load(std::memory_order_relaxed) - 1;
+	_Bottom.store(bottom, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64 top = _Top.load(std::memory_order_relaxed);
+
+	if (top > bottom)
+	{
+		_Bottom.store(bottom + 1, std::memory_order_relaxed);
+		return nullptr;
+	}
+
+	Job* job = _Jobs[bottom & (capacity - 1)].load(std::memory_order_relaxed);
+
+	if (top == bottom)
+	{
+		// Last job. Race the thieves for it.
+		if (!_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+		{
+			job = nullptr;
+		}
+
+		_Bottom.store(bottom + 1, std::memory_order_relaxed);
+	}
+
+	return job;
+}
+
+Job* JobDeque::Steal()
+{
+	int64 top = _Top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	const int64 bottom = _Bottom.load(std::memory_order_acquire);
+
+	if (top >= bottom)
+	{
+		return nullptr;
+	}
+
+	Job* job = _Jobs[top & (capacity - 1)].load(std::memory_order_relaxed);
+
+	if (!_Top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+	{
+		return nullptr;
+	}
+
+	return job;
+}
+
+JobSystem::JobSystem(uint32 numWorkers)
+{
+	check(gJobSystem == nullptr, "Only one job system can exist.");
+	gJobSystem = this;
+
+	if (numWorkers == 0)
+	{
+		numWorkers = std::max(std::thread::hardware_concurrency(), 1u);
+	}
+
+	_Workers.resize(numWorkers);
+
+	for (std::unique_ptr<Worker>& worker : _Workers)
+	{
+		worker = std::make_unique<Worker>();
+	}
+
+	_StatsStartNs = GetTimeNs();
+
+	gWorkerIndex = 0;
+
+	for (uint32 workerIndex = 1; workerIndex < numWorkers; workerIndex++)
+	{
+		_Workers[workerIndex]->thread = std::thread(&JobSystem::WorkerMain, this, workerIndex);
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard lock(_SleepMutex);
+		_Stop = true;
+	}
+
+	_WakeCondition.notify_all();
+
+	for (std::unique_ptr<Worker>& worker : _Workers)
+	{
+		if (worker->thread.joinable())
+		{
+			worker->thread.join();
+		}
+	}
+
+	gWorkerIndex = -1;
+	gJobSystem = nullptr;
+}
+
+JobSystem& JobSystem::Get()
+{
+	return *gJobSystem;
+}
+
+int32 JobSystem::GetWorkerIndex()
+{
+	return gWorkerIndex;
+}
+
+void JobSystem::Run(std::function<void()>&& function, JobCounter* counter, JobCounter* dependency)
+{
+	Job* job = AllocateJob();
+	job->function = std::move(function);
+	job->counter = counter;
+
+	if (counter)
+	{
+		counter->_Count.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	if (dependency)
+	{
+		std::lock_guard lock(dependency->_Mutex);
+
+		if (!dependency->IsDone())
+		{
+			dependency->_Continuations.push_back(job);
+			return;
+		}
+	}
+
+	Queue(job);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+	while (!counter.IsDone())
+	{
+		if (Job* job = FindJob())
+		{
+			Execute(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	// The last release holds the mutex until it's done with the counter, which the caller may be about to destroy.
+	std::lock_guard lock(counter._Mutex);
+}
+
+void JobSystem::ParallelFor(std::size_t count, const std::function<void(std::size_t)>& function, std::size_t grainSize)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	if (grainSize == 0)
+	{
+		grainSize = std::max<std::size_t>(count / (std::size_t(GetNumWorkers()) * 8), 1);
+	}
+
+	JobCounter counter;
+	ParallelForRange(0, count, grainSize, function, counter);
+	Wait(counter);
+}
+
+void JobSystem::ParallelForRange(std::size_t begin, std::size_t end, std::size_t grainSize, const std::function<void(std::size_t)>& function, JobCounter& counter)
+{
+	const int32 workerIndex = GetWorkerIndex();
+
+	while (begin < end)
+	{
+		// Lazy binary splitting: while the caller's deque has jobs, the other workers aren't short of work,
+		// so the range is only split once the last half has been stolen.
+		const bool isDequeEmpty = workerIndex < 0 || _Workers[workerIndex]->deque.IsEmpty();
+
+		if (end - begin >= 2 * grainSize && isDequeEmpty)
+		{
+			const std::size_t middle = begin + (end - begin) / 2;
+
+			Run([this, middle, end, grainSize, &function, &counter] ()
+			{
+				ParallelForRange(middle, end, grainSize, function, counter);
+			}, &counter);
+
+			end = middle;
+			continue;
+		}
+
+		const std::size_t chunkEnd = std::min(begin + grainSize, end);
+
+		for (std::size_t index = begin; index < chunkEnd; index++)
+		{
+			function(index);
+		}
+
+		begin = chunkEnd;
+	}
+}
+
+std::vector<JobSystem::WorkerStats> JobSystem::GetStats() const
+{
+	const float64 elapsedNs = static_cast<float64>(std::max<uint64>(GetTimeNs() - _StatsStartNs, 1));
+
+	std::vector<WorkerStats> stats;
+	stats.reserve(_Workers.size());
+
+	for (const std::unique_ptr<Worker>& worker : _Workers)
+	{
+		stats.push_back({
+			.numJobs = worker->numJobs.load(std::memory_order_relaxed),
+			.numSteals = worker->numSteals.load(std::memory_order_relaxed),
+			.utilization = static_cast<float>(worker->busyNs.load(std::memory_order_relaxed) / elapsedNs),
+		});
+	}
+
+	return stats;
+}
+
+void JobSystem::ResetStats()
+{
+	for (std::unique_ptr<Worker>& worker : _Workers)
+	{
+		worker->numJobs = 0;
+		worker->numSteals = 0;
+		worker->busyNs = 0;
+	}
+
+	_StatsStartNs = GetTimeNs();
+}
+
+float JobSystem::MeasureOverhead(uint32 numJobs)
+{
+	JobCounter counter;
+
+	const uint64 startNs = GetTimeNs();
+
+	for (uint32 i = 0; i < numJobs; i++)
+	{
+		Run([] () {}, &counter);
+	}
+
+	Wait(counter);
+
+	return static_cast<float>(float64(GetTimeNs() - startNs) / std::max(numJobs, 1u));
+}
+
+void JobSystem::WorkerMain(uint32 workerIndex)
+{
+	gWorkerIndex = workerIndex;
+
+	static constexpr uint32 numSpins = 64;
+
+	while (!_Stop.load(std::memory_order_relaxed))
+	{
+		if (Job* job = FindJob())
+		{
+			Execute(job);
+			continue;
+		}
+
+		for (uint32 spin = 0; spin < numSpins && _NumQueued.load(std::memory_order_relaxed) <= 0; spin++)
+		{
+			std::this_thread::yield();
+		}
+
+		if (_NumQueued.load() > 0)
+		{
+			continue;
+		}
+
+		// The sleeping count is incremented before the queued count is checked, and Queue() does the reverse,
+		// so either the worker sees the job or Queue() sees the worker.
+		std::unique_lock lock(_SleepMutex);
+		_NumSleeping++;
+		_WakeCondition.wait(lock, [this] () { return _NumQueued.load() > 0 || _Stop.load(); });
+		_NumSleeping--;
+	}
+}
+
+void JobSystem::Queue(Job* job)
+{
+	_NumQueued++;
+
+	const int32 workerIndex = GetWorkerIndex();
+
+	if (workerIndex >= 0)
+	{
+		if (!_Workers[workerIndex]->deque.Push(job))
+		{
+			_NumQueued--;
+			Execute(job);
+			return;
+		}
+	}
+	else
+	{
+		std::lock_guard lock(_SharedMutex);
+		_SharedJobs.push_back(job);
+	}
+
+	if (_NumSleeping.load() > 0)
+	{
+		std::lock_guard lock(_SleepMutex);
+		_WakeCondition.notify_one();
+	}
+}
+
+Job* JobSystem::FindJob()
+{
+	const int32 workerIndex = GetWorkerIndex();
+	Job* job = nullptr;
+
+	if (workerIndex >= 0)
+	{
+		job = _Workers[workerIndex]->deque.Pop();
+	}
+
+	if (!job)
+	{
+		std::unique_lock lock(_SharedMutex, std::try_to_lock);
+
+		if (lock.owns_lock() && !_SharedJobs.empty())
+		{
+			job = _SharedJobs.front();
+			_SharedJobs.pop_front();
+		}
+	}
+
+	if (!job)
+	{
+		// Start at a random victim so thieves spread out.
+		static thread_local uint32 random = 0x9E3779B9u ^ static_cast<uint32>(workerIndex + 1);
+		random ^= random << 13;
+		random ^= random >> 17;
+		random ^= random << 5;
+
+		const uint32 numWorkers = GetNumWorkers();
+
+		for (uint32 i = 0; i < numWorkers && !job; i++)
+		{
+			const uint32 victim = (random + i) % numWorkers;
+
+			if (static_cast<int32>(victim) != workerIndex)
+			{
+				job = _Workers[victim]->deque.Steal();
+			}
+		}
+
+		if (job && workerIndex >= 0)
+		{
+			_Workers[workerIndex]->numSteals.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	if (job)
+	{
+		_NumQueued--;
+	}
+
+	return job;
+}
+
+void JobSystem::Execute(Job* job)
+{
+	// Jobs executed while waiting run inside another job, and are only timed once.
+	static thread_local uint32 depth = 0;
+
+	const int32 workerIndex = GetWorkerIndex();
+	const uint64 startNs = depth == 0 ? GetTimeNs() : 0;
+
+	depth++;
+	job->function();
+	depth--;
+
+	if (workerIndex >= 0)
+	{
+		Worker& worker = *_Workers[workerIndex];
+		worker.numJobs.fetch_add(1, std::memory_order_relaxed);
+
+		if (depth == 0)
+		{
+			worker.busyNs.fetch_add(GetTimeNs() - startNs, std::memory_order_relaxed);
+		}
+	}
+
+	JobCounter* counter = job->counter;
+
+	FreeJob(job);
+
+	if (counter)
+	{
+		Release(*counter);
+	}
+}
+
+void JobSystem::Release(JobCounter& counter)
+{
+	uint32 count = counter._Count.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		if (count == 1)
+		{
+			std::vector<Job*> continuations;
+
+			{
+				std::lock_guard lock(counter._Mutex);
+
+				if (!counter._Count.compare_exchange_strong(count, 0, std::memory_order_acq_rel, std::memory_order_relaxed))
+				{
+					continue;
+				}
+
+				continuations.swap(counter._Continuations);
+			}
+
+			for (Job* job : continuations)
+			{
+				Queue(job);
+			}
+
+			return;
+		}
+
+		if (counter._Count.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel, std::memory_order_relaxed))
+		{
+			return;
+		}
+	}
+}
+
+Job* JobSystem::AllocateJob()
+{
+	if (gJobPool.jobs.empty())
+	{
+		return new Job();
+	}
+
+	Job* job = gJobPool.jobs.back();
+	gJobPool.jobs.pop_back();
+	return job;
+}
+
+void JobSystem::FreeJob(Job* job)
+{
+	job->function = nullptr;
+	job->counter = nullptr;
+
+	if (gJobPool.jobs.size() < maxPooledJobs)
+	{
+		gJobPool.jobs.push_back(job);
+	}
+	else
+	{
+		delete job;
+	}
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include "Types.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+class JobSystem;
+
+/** A job queued on the job system. Jobs are pooled, and only live until they've executed. */
+struct Job
+{
+	std::function<void()> function;
+	class JobCounter* counter = nullptr;
+};
+
+/**
+  * Counts unfinished jobs. A job run with a counter increments it, and decrements it once it has executed.
+  * Jobs can depend on a counter, in which case they're queued once it reaches zero.
+  */
+class JobCounter
+{
+public:
+	JobCounter(const JobCounter&) = delete;
+	JobCounter& operator=(const JobCounter&) = delete;
+	JobCounter() = default;
+
+	inline bool IsDone() const { return _Count.load(std::memory_order_acquire) == 0; }
+
+private:
+	friend class JobSystem;
+
+	std::atomic<uint32> _Count = 0;
+
+	/** Guards the continuations, and the last decrement so the counter isn't destroyed while it's being released. */
+	std::mutex _Mutex;
+	std::vector<Job*> _Continuations;
+};
+
+/**
+  * Chase-Lev work-stealing deque. The owning worker pushes and pops at the bottom, and other workers steal from the top.
+  * The deque is a fixed-size ring. Push fails when it's full, in which case the job is executed right away.
+  */
+class JobDeque
+{
+public:
+	JobDeque(const JobDeque&) = delete;
+	JobDeque& operator=(const JobDeque&) = delete;
+	JobDeque() = default;
+
+	/** Owner only. */
+	bool Push(Job* job);
+
+	/** Owner only. Returns the most recently pushed job, or null if empty. */
+	Job* Pop();
+
+	/** Any thread. Returns the oldest job, or null if empty or if another thread took it first. */
+	Job* Steal();
+
+	inline bool IsEmpty() const { return _Bottom.load(std::memory_order_relaxed) <= _Top.load(std::memory_order_relaxed); }
+
+	static constexpr int64 capacity = 4096;
+
+private:
+	alignas(64) std::atomic<int64> _Top = 0;
+	alignas(64) std::atomic<int64> _Bottom = 0;
+	std::array<std::atomic<Job*>, capacity> _Jobs;
+};
+
+/**
+  * Work-stealing job system. Each worker has its own deque and steals from the others when it runs out of jobs.
+  * The thread that creates the job system is worker 0. It has no thread of its own, and executes jobs while it waits on counters.
+  * Threads that aren't workers queue their jobs on a shared queue.
+  */
+class JobSystem
+{
+public:
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	/** Start the workers. WorkerThreads in Engine.ini, or every hardware thread if it's 0. There's only one job system. */
+	JobSystem(uint32 numWorkers);
+
+	~JobSystem();
+
+	static JobSystem& Get();
+
+	/** Queue a job. The counter is incremented until it has executed. If it has a dependency, it's queued once the dependency is done. */
+	void Run(std::function<void()>&& function, JobCounter* counter = nullptr, JobCounter* dependency = nullptr);
+
+	/** Execute jobs until the counter is done. */
+	void Wait(JobCounter& counter);
+
+	/**
+	  * Call a function for each index, and wait until they're done. The range is split in half while other workers are idle,
+	  * and indices are executed in chunks of the grain size. A grain size of 0 picks one from the count and the number of workers.
+	  */
+	void ParallelFor(std::size_t count, const std::function<void(std::size_t)>& function, std::size_t grainSize = 0);
+
+	inline uint32 GetNumWorkers() const { return static_cast<uint32>(_Workers.size()); }
+
+	/** Index of the calling thread's worker, or -1 if the thread isn't a worker. */
+	static int32 GetWorkerIndex();
+
+	struct WorkerStats
+	{
+		uint64 numJobs;
+		uint64 numSteals;
+		/** Fraction of the time since the last reset spent executing jobs. */
+		float utilization;
+	};
+
+	std::vector<WorkerStats> GetStats() const;
+	void ResetStats();
+
+	/** Run empty jobs from this thread and return the average scheduling overhead per job, in nanoseconds. */
+	float MeasureOverhead(uint32 numJobs);
+
+private:
+	struct alignas(64) Worker
+	{
+		JobDeque deque;
+		std::thread thread;
+		std::atomic<uint64> numJobs = 0;
+		std::atomic<uint64> numSteals = 0;
+		std::atomic<uint64> busyNs = 0;
+	};
+
+	std::vector<std::unique_ptr<Worker>> _Workers;
+
+	/** Jobs queued by threads that aren't workers. */
+	std::mutex _SharedMutex;
+	std::deque<Job*> _SharedJobs;
+
+	/** Jobs in deques and the shared queue. Idle workers sleep until there are some. */
+	std::atomic<int64> _NumQueued = 0;
+	std::atomic<uint32> _NumSleeping = 0;
+	std::mutex _SleepMutex;
+	std::condition_variable _WakeCondition;
+	std::atomic<bool> _Stop = false;
+
+	std::atomic<uint64> _StatsStartNs;
+
+	void WorkerMain(uint32 workerIndex);
+
+	/** Push a job on the caller's deque, or the shared queue if it isn't a worker. Jobs that don't fit are executed. */
+	void Queue(Job* job);
+
+	/** Pop from the caller's deque, then the shared queue, then steal from the other workers. */
+	Job* FindJob();
+
+	void Execute(Job* job);
+
+	/** Decrement the counter, and queue its continuations if it's done. */
+	void Release(JobCounter& counter);
+
+	void ParallelForRange(std::size_t begin, std::size_t end, std::size_t grainSize, const std::function<void(std::size_t)>& function, JobCounter& counter);
+
+	static Job* AllocateJob();
+	static void FreeJob(Job* job);
+};
@@ -5,21 +5,24 @@
 Material::Material(
 	gpu::Device& device,
 	EMaterialMode materialMode,
-	gpu::Image* baseColor,
-	gpu::Image* metallicRoughness,
-	gpu::Image* normal,
-	gpu::Image* emissive,
+	StreamedTexture* baseColor,
+	StreamedTexture* metallicRoughness,
+	StreamedTexture* normal,
+	StreamedTexture* emissive,
 	float metallic,
 	float roughness,
-	const glm::vec3& emissiveFactor
+	const glm::vec3& emissiveFactor,
+	gpu::UploadTicket uploadTicket
 ) : _MaterialMode(materialMode)
+	, _UploadTicket(uploadTicket)
 {
-	const gpu::Sampler sampler = device.CreateSampler({ EFilter::Linear, ESamplerAddressMode::Repeat, ESamplerMipmapMode::Linear });
+	_Textures = { baseColor, metallicRoughness, normal, emissive };
 
-	_PushConstants._BaseColor = baseColor->GetTextureID(sampler);
-	_PushConstants._MetallicRoughness = metallicRoughness ? metallicRoughness->GetTextureID(sampler) : gpu::TextureID{};
-	_PushConstants._Normal = normal ? normal->GetTextureID(sampler) : gpu::TextureID{};
-	_PushConstants._Emissive = emissive ? emissive->GetTextureID(sampler) : gpu::TextureID{};
+	// Materials without a base color are drawn red.
+	_PushConstants._BaseColor = baseColor ? baseColor->GetTextureID() : AssetManager::_Red.GetTextureID(CreateSampler(device));
+	_PushConstants._MetallicRoughness = metallicRoughness ? metallicRoughness->GetTextureID() : gpu::TextureID{};
+	_PushConstants._Normal = normal ? normal->GetTextureID() : gpu::TextureID{};
+	_PushConstants._Emissive = emissive ? emissive->GetTextureID() : gpu::TextureID{};
 
 	_PushConstants._Metallic = metallic;
 	_PushConstants._Roughness = roughness;
@@ -29,4 +32,16 @@ Material::Material(
 	_SpecializationInfo.Add(1, materialMode == EMaterialMode::Masked);
 	_SpecializationInfo.Add(2, normal != nullptr);
 	_SpecializationInfo.Add(3, emissive != nullptr);
+}
+gpu::Sampler Material::CreateSampler(gpu::Device& device)
+{
+	static const float maxAnisotropy = static_cast<float>(Platform::GetInt("Engine.ini", "Renderer", "MaxAnisotropy", 16));
+
+	return device.CreateSampler({
+		.filter = EFilter::Linear,
+		.sam = ESamplerAddressMode::Repeat,
+		.smm = ESamplerMipmapMode::Linear,
+		.maxLod = SamplerDesc::lodClampNone,
+		.maxAnisotropy = maxAnisotropy
+	});
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <GPU/GPUShader.h>
 
 namespace gpu { class Device; }
+class StreamedTexture;
 
 enum class EMaterialMode
 {
@@ -29,21 +30,33 @@ public:
 	Material(
 		gpu::Device& device,
 		EMaterialMode materialMode,
-		gpu::Image* baseColor,
-		gpu::Image* metallicRoughness,
-		gpu::Image* normal,
-		gpu::Image* emissive,
+		StreamedTexture* baseColor,
+		StreamedTexture* metallicRoughness,
+		StreamedTexture* normal,
+		StreamedTexture* emissive,
 		float metallic,
 		float roughness,
-		const glm::vec3& emissiveFactor
+		const glm::vec3& emissiveFactor,
+		gpu::UploadTicket uploadTicket = 0
 	);
 
 	inline bool IsMasked() const { return _MaterialMode == EMaterialMode::Masked; };
 	inline const PushConstants& GetPushConstants() const { return _PushConstants; }
 	inline const SpecializationInfo& GetSpecializationInfo() const { return _SpecializationInfo; }
+	inline gpu::UploadTicket GetUploadTicket() const { return _UploadTicket; }
+
+	/** Textures the material samples. Null if the material doesn't have the texture. */
+	inline const std::array<StreamedTexture*, 4>& GetTextures() const { return _Textures; }
+
+	/** Sampler of material textures. */
+	static gpu::Sampler CreateSampler(gpu::Device& device);
 
 private:
 	EMaterialMode _MaterialMode;
 	PushConstants _PushConstants;
 	SpecializationInfo _SpecializationInfo;
+	std::array<StreamedTexture*, 4> _Textures;
+
+	/** Upload of the material's textures. */
+	gpu::UploadTicket _UploadTicket = 0;
 };
\ No newline at end of file
@@ -0,0 +1,1093 @@
+#include "MeshCooker.h"
+#include "JobSystem.h"
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <glm/gtc/type_ptr.hpp>
+#define TINYGLTF_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBI_MSC_SECURE_CRT
+#include <tiny_gltf.h>
+
+static constexpr uint32 cookedMeshMagic = 0x4853454d; // "MESH"
+static constexpr uint64 dataAlignment = 16;
+
+struct CookedMeshHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint64 key;
+	/** The glTF file the mesh was cooked from, in the strings. */
+	CookedRange sourcePath;
+	uint32 numSubmeshes;
+	uint32 numMaterials;
+	uint32 numTextures;
+	/** Pads the header to the file size's alignment, so no byte of it is left uninitialized. */
+	uint32 reserved;
+	uint64 fileSize;
+};
+
+CookedMesh::CookedMesh(const std::filesystem::path& path, uint64 key, const std::filesystem::path& sourcePath)
+	: _File(path)
+{
+	if (!_File.IsOpen() || _File.GetSize() < sizeof(CookedMeshHeader))
+	{
+		return;
+	}
+
+	const CookedMeshHeader* header = reinterpret_cast<const CookedMeshHeader*>(_File.GetData());
+
+	if (header->magic != cookedMeshMagic || header->version != MeshCooker::importerVersion || header->key != key || header->fileSize != _File.GetSize() ||
+		header->sourcePath.offset + header->sourcePath.size > _File.GetSize())
+	{
+		return;
+	}
+
+	// The key is a hash, so the source is compared too.
+	const std::string_view cookedSourcePath(reinterpret_cast<const char*>(_File.GetData() + header->sourcePath.offset), header->sourcePath.size);
+
+	if (cookedSourcePath == sourcePath.generic_string())
+	{
+		_Header = header;
+	}
+}
+
+uint32 CookedMesh::GetNumSubmeshes() const
+{
+	return _Header->numSubmeshes;
+}
+
+uint32 CookedMesh::GetNumMaterials() const
+{
+	return _Header->numMaterials;
+}
+
+uint32 CookedMesh::GetNumTextures() const
+{
+	return _Header->numTextures;
+}
+
+const CookedSubmesh& CookedMesh::GetSubmesh(uint32 index) const
+{
+	const CookedSubmesh* submeshes = reinterpret_cast<const CookedSubmesh*>(_Header + 1);
+	return submeshes[index];
+}
+
+const CookedMaterial& CookedMesh::GetMaterial(uint32 index) const
+{
+	const CookedMaterial* materials = reinterpret_cast<const CookedMaterial*>(&GetSubmesh(_Header->numSubmeshes));
+	return materials[index];
+}
+
+const CookedTextureRef& CookedMesh::GetTexture(uint32 index) const
+{
+	const CookedTextureRef* textures = reinterpret_cast<const CookedTextureRef*>(&GetMaterial(_Header->numMaterials));
+	return textures[index];
+}
+
+std::unique_ptr<CookedMesh> MeshCooker::Load(const std::filesystem::path& path, bool forceCook)
+{
+	const uint64 key = GetKey(path);
+	const std::filesystem::path cachePath = GetCachePath(key);
+
+	if (!forceCook)
+	{
+		if (std::unique_ptr<CookedMesh> cookedMesh = std::make_unique<CookedMesh>(cachePath, key, path); cookedMesh->IsValid())
+		{
+			return cookedMesh;
+		}
+	}
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	Cook(path, cachePath, key);
+
+	const float cookMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	LOG("Cooked %s in %.1f ms.", path.generic_string().c_str(), cookMs);
+
+	std::unique_ptr<CookedMesh> cookedMesh = std::make_unique<CookedMesh>(cachePath, key, path);
+
+	check(cookedMesh->IsValid(), "Failed to cook %s.", path.generic_string().c_str());
+
+	return cookedMesh;
+}
+
+uint64 MeshCooker::GetKey(const std::filesystem::path& path)
+{
+	// Hashed member by member, since the layout has padding.
+	const VertexLayout vertexLayout = VertexLayout::GetCookedLayout();
+
+	std::string keyBytes;
+	AppendKeyBytes(keyBytes, path.generic_string());
+	AppendKeyBytes(keyBytes, Platform::GetLastWriteTime(path));
+	AppendKeyBytes(keyBytes, importerVersion);
+	AppendKeyBytes(keyBytes, vertexLayout.formats);
+	AppendKeyBytes(keyBytes, vertexLayout.isInterleaved);
+	AppendKeyBytes(keyBytes, IsOptimizeMeshesEnabled());
+	AppendKeyBytes(keyBytes, GetLODCount());
+
+	return Platform::Hash64(keyBytes.data(), keyBytes.size());
+}
+
+bool MeshCooker::IsOptimizeMeshesEnabled()
+{
+	return Platform::GetBool("Engine.ini", "Renderer", "OptimizeMeshes", true);
+}
+
+uint32 MeshCooker::GetLODCount()
+{
+	return static_cast<uint32>(std::clamp(Platform::GetInt("Engine.ini", "Renderer", "LODCount", 4), 1, static_cast<int32>(maxLODs)));
+}
+
+std::filesystem::path MeshCooker::GetCachePath(uint64 key)
+{
+	return std::filesystem::path("../Cooked/Meshes") / Platform::FormatString("%016llx.mesh", key);
+}
+
+/** Collects the tables, strings and data of a cooked mesh before it's written. */
+class CookedMeshWriter
+{
+public:
+	std::vector<CookedSubmesh> _Submeshes;
+	std::vector<CookedMaterial> _Materials;
+	std::vector<CookedTextureRef> _Textures;
+
+	/** Strings and data are placed relative to the end of the tables until they're written. */
+	CookedRange AddString(const std::string& string)
+	{
+		const CookedRange range = { _Strings.size(), string.size() };
+		_Strings.insert(_Strings.end(), string.begin(), string.end());
+		return range;
+	}
+
+	CookedRange AddData(std::vector<uint8>&& data)
+	{
+		const CookedRange range = { _DataSize, data.size() };
+		_DataSize += DivideAndRoundUp<uint64>(data.size(), dataAlignment) * dataAlignment;
+		_Data.push_back(std::move(data));
+		return range;
+	}
+
+	void Write(const std::filesystem::path& path, uint64 key, const std::string& sourceName)
+	{
+		CookedRange sourcePath = AddString(sourceName);
+
+		const uint64 tablesSize = sizeof(CookedMeshHeader)
+			+ _Submeshes.size() * sizeof(CookedSubmesh)
+			+ _Materials.size() * sizeof(CookedMaterial)
+			+ _Textures.size() * sizeof(CookedTextureRef);
+		const uint64 stringsOffset = tablesSize;
+		const uint64 dataOffset = DivideAndRoundUp<uint64>(stringsOffset + _Strings.size(), dataAlignment) * dataAlignment;
+
+		for (CookedSubmesh& submesh : _Submeshes)
+		{
+			submesh.name.offset += stringsOffset;
+			submesh.indices.offset += dataOffset;
+			submesh.meshlets.offset += dataOffset;
+
+			for (CookedRange& vertexStream : submesh.vertexStreams)
+			{
+				vertexStream.offset += dataOffset;
+			}
+		}
+
+		for (CookedTextureRef& texture : _Textures)
+		{
+			texture.name.offset += stringsOffset;
+			texture.sourcePath.offset += stringsOffset;
+		}
+
+		sourcePath.offset += stringsOffset;
+
+		const CookedMeshHeader header =
+		{
+			.magic = cookedMeshMagic,
+			.version = MeshCooker::importerVersion,
+			.key = key,
+			.sourcePath = sourcePath,
+			.numSubmeshes = static_cast<uint32>(_Submeshes.size()),
+			.numMaterials = static_cast<uint32>(_Materials.size()),
+			.numTextures = static_cast<uint32>(_Textures.size()),
+			.reserved = 0,
+			.fileSize = dataOffset + _DataSize,
+		};
+
+		std::string file(header.fileSize, '\0');
+		uint8* dst = reinterpret_cast<uint8*>(file.data());
+
+		Platform::Memcpy(dst, &header, sizeof(header));
+		dst += sizeof(header);
+		Platform::Memcpy(dst, _Submeshes.data(), _Submeshes.size() * sizeof(CookedSubmesh));
+		dst += _Submeshes.size() * sizeof(CookedSubmesh);
+		Platform::Memcpy(dst, _Materials.data(), _Materials.size() * sizeof(CookedMaterial));
+		dst += _Materials.size() * sizeof(CookedMaterial);
+		Platform::Memcpy(dst, _Textures.data(), _Textures.size() * sizeof(CookedTextureRef));
+
+		Platform::Memcpy(file.data() + stringsOffset, _Strings.data(), _Strings.size());
+
+		uint64 offset = dataOffset;
+
+		for (const std::vector<uint8>& data : _Data)
+		{
+			Platform::Memcpy(file.data() + offset, data.data(), data.size());
+			offset += DivideAndRoundUp<uint64>(data.size(), dataAlignment) * dataAlignment;
+		}
+
+		std::filesystem::create_directories(path.parent_path());
+
+		Platform::FileWrite(path, file);
+	}
+
+private:
+	std::vector<char> _Strings;
+	std::vector<std::vector<uint8>> _Data;
+	uint64 _DataSize = 0;
+};
+
+/** Copy the elements of an accessor, which may be interleaved with other attributes, to a tightly packed array. */
+static std::vector<uint8> CopyAccessor(const tinygltf::Model& model, const tinygltf::Accessor& accessor)
+{
+	const tinygltf::BufferView& view = model.bufferViews[accessor.bufferView];
+	const tinygltf::Buffer& buffer = model.buffers[view.buffer];
+	const std::size_t elementSize = tinygltf::GetComponentSizeInBytes(accessor.componentType) * tinygltf::GetNumComponentsInType(accessor.type);
+	const std::size_t stride = std::max<std::size_t>(accessor.ByteStride(view), elementSize);
+	const uint8* src = buffer.data.data() + view.byteOffset + accessor.byteOffset;
+
+	std::vector<uint8> data(accessor.count * elementSize);
+
+	if (stride == elementSize)
+	{
+		Platform::Memcpy(data.data(), src, data.size());
+	}
+	else
+	{
+		for (std::size_t i = 0; i < accessor.count; i++)
+		{
+			Platform::Memcpy(data.data() + i * elementSize, src + i * stride, elementSize);
+		}
+	}
+
+	return data;
+}
+
+/** Read the elements of an accessor as floats. Normalized integer components are converted to [0, 1]. */
+static std::vector<float> ReadFloats(const tinygltf::Model& model, const tinygltf::Accessor& accessor)
+{
+	const std::vector<uint8> data = CopyAccessor(model, accessor);
+	const std::size_t numComponents = accessor.count * tinygltf::GetNumComponentsInType(accessor.type);
+
+	std::vector<float> floats(numComponents);
+
+	for (std::size_t i = 0; i < numComponents; i++)
+	{
+		switch (accessor.componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_FLOAT:
+			Platform::Memcpy(&floats[i], data.data() + i * sizeof(float), sizeof(float));
+			break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			floats[i] = data[i] / 255.0f;
+			break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			uint16 value;
+			Platform::Memcpy(&value, data.data() + i * sizeof(uint16), sizeof(uint16));
+			floats[i] = value / 65535.0f;
+			break;
+		default:
+			fail("Unsupported component type %d.", accessor.componentType);
+		}
+	}
+
+	return floats;
+}
+
+static std::vector<uint32> ReadIndices(const tinygltf::Model& model, const tinygltf::Accessor& accessor)
+{
+	const std::vector<uint8> data = CopyAccessor(model, accessor);
+
+	std::vector<uint32> indices(accessor.count);
+
+	for (std::size_t i = 0; i < indices.size(); i++)
+	{
+		switch (accessor.componentType)
+		{
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+			indices[i] = data[i];
+			break;
+		case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+			uint16 index;
+			Platform::Memcpy(&index, data.data() + i * sizeof(uint16), sizeof(uint16));
+			indices[i] = index;
+			break;
+		default:
+			Platform::Memcpy(&indices[i], data.data() + i * sizeof(uint32), sizeof(uint32));
+		}
+	}
+
+	return indices;
+}
+
+static uint16 QuantizeUnorm16(float value)
+{
+	return static_cast<uint16>(std::lround(std::clamp(value, 0.0f, 1.0f) * 65535.0f));
+}
+
+static int16 QuantizeSnorm16(float value)
+{
+	return static_cast<int16>(std::lround(std::clamp(value, -1.0f, 1.0f) * 32767.0f));
+}
+
+static glm::vec3 DecodeOctahedral(const std::array<int16, 2>& encoded)
+{
+	const glm::vec2 f = glm::max(glm::vec2(encoded[0], encoded[1]) / 32767.0f, glm::vec2(-1.0f));
+	glm::vec3 n(f.x, f.y, 1.0f - std::abs(f.x) - std::abs(f.y));
+	const float t = std::clamp(-n.z, 0.0f, 1.0f);
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+	return glm::normalize(n);
+}
+
+/**
+  * Map a unit vector to octahedral snorm16x2, which decodes with DecodeOctahedral() in GBufferCommon.glsl.
+  * Of the four nearest encodings, the one that decodes closest to the vector is picked.
+  * Reference: "A Survey of Efficient Representations for Independent Unit Vectors"
+  */
+static std::array<int16, 2> EncodeOctahedral(glm::vec3 n)
+{
+	const float length = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+
+	if (length == 0.0f)
+	{
+		return { 0, 0 };
+	}
+
+	n /= length;
+
+	glm::vec2 p(n.x, n.y);
+
+	if (n.z < 0.0f)
+	{
+		p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * glm::vec2(p.x >= 0.0f ? 1.0f : -1.0f, p.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	const glm::vec3 unitN = glm::normalize(n);
+	std::array<int16, 2> best = { QuantizeSnorm16(p.x), QuantizeSnorm16(p.y) };
+	float bestCos = -2.0f;
+
+	for (uint32 i = 0; i < 4; i++)
+	{
+		const float x = (i & 1) ? std::ceil(p.x * 32767.0f) : std::floor(p.x * 32767.0f);
+		const float y = (i & 2) ? std::ceil(p.y * 32767.0f) : std::floor(p.y * 32767.0f);
+		const std::array<int16, 2> encoded = { QuantizeSnorm16(x / 32767.0f), QuantizeSnorm16(y / 32767.0f) };
+		const float cos = glm::dot(DecodeOctahedral(encoded), unitN);
+
+		if (cos > bestCos)
+		{
+			bestCos = cos;
+			best = encoded;
+		}
+	}
+
+	return best;
+}
+
+/** A submesh built from glTF accessors, before its data is added to the cooked mesh. */
+struct SubmeshImport
+{
+	std::string name;
+	std::vector<uint8> indices;
+	std::array<std::vector<uint8>, numVertexAttributes> vertexStreams;
+	VertexDequantization dequantization;
+	uint32 vertexCount;
+	uint32 indexCount;
+	std::vector<CookedLOD> lods;
+	std::vector<CookedMeshlet> meshlets;
+	/** Unique vertices of the meshlets, added up. */
+	uint32 meshletVertexCount;
+	EIndexType indexType;
+	uint32 materialIndex;
+	glm::vec3 min;
+	glm::vec3 max;
+
+	/** Vertices as authored, and after welding. */
+	uint32 sourceVertexCount;
+	MeshOptimizer::VertexCacheStats sourceCacheStats;
+	MeshOptimizer::VertexCacheStats cookedCacheStats;
+};
+
+/** Write an attribute of a vertex in a layout. */
+static void WriteVertexAttribute(std::array<std::vector<uint8>, numVertexAttributes>& vertexStreams, const VertexLayout& layout, EVertexAttribute attribute, uint32 vertexIndex, const void* data)
+{
+	const uint32 stream = layout.GetStream(attribute);
+	const std::size_t offset = std::size_t(vertexIndex) * layout.GetStride(stream) + layout.GetOffset(attribute);
+
+	Platform::Memcpy(vertexStreams[stream].data() + offset, data, gpu::ImagePrivate::GetSize(layout.GetFormat(attribute)));
+}
+
+/** Indices of a level of detail, and its error in position units. */
+struct LODImport
+{
+	std::vector<uint32> indices;
+	float error;
+};
+
+/** A level is only kept if it has at most this fraction of the triangles of the level above. */
+static constexpr float maxLODTriangleRatio = 0.8f;
+
+/** Largest collapse error while simplifying a level, relative to the submesh's extent. */
+static constexpr float maxLODCollapseError = 0.05f;
+
+/**
+  * Simplify each level of detail to half the triangles of the level above, until there are enough levels or simplifying stops paying off.
+  * The error of a level adds up the errors of the levels above, so it bounds the distance from full detail.
+  * If optimizing, vertices that quantized to the same bytes are welded first, then each level's triangles are reordered for the vertex cache
+  * and overdraw, and the vertices for fetch by full detail. Collapses keep existing vertices, so every level indexes the full detail vertices.
+  * Updates the vertex count, and returns the vertices in their new order.
+  */
+static std::vector<uint8> BuildSubmeshLODs(
+	std::vector<LODImport>& lods,
+	uint32& vertexCount,
+	const std::vector<uint8>& vertices,
+	uint32 vertexSize,
+	const std::vector<float>& positions,
+	bool optimize,
+	uint32 numLODs)
+{
+	std::vector<uint32> weldRemap(vertexCount);
+	uint32 weldedVertexCount = vertexCount;
+
+	if (optimize)
+	{
+		weldedVertexCount = MeshOptimizer::GenerateVertexRemap(weldRemap, vertices.data(), vertexCount, vertexSize);
+		MeshOptimizer::RemapIndices(lods[0].indices, weldRemap);
+	}
+	else
+	{
+		std::iota(weldRemap.begin(), weldRemap.end(), 0);
+	}
+
+	std::vector<glm::vec3> weldedPositions(weldedVertexCount);
+
+	for (uint32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+	{
+		weldedPositions[weldRemap[vertexIndex]] = glm::make_vec3(&positions[vertexIndex * 3]);
+	}
+
+	while (lods.size() < numLODs)
+	{
+		const std::vector<uint32>& finerIndices = lods.back().indices;
+		const uint32 targetIndexCount = static_cast<uint32>(finerIndices.size() / 6 * 3);
+		float error;
+
+		std::vector<uint32> indices = MeshOptimizer::Simplify(finerIndices, weldedPositions, targetIndexCount, maxLODCollapseError, error);
+
+		if (indices.empty() || indices.size() > finerIndices.size() * maxLODTriangleRatio)
+		{
+			break;
+		}
+
+		const float lodError = lods.back().error + error;
+
+		lods.push_back({ std::move(indices), lodError });
+	}
+
+	if (!optimize)
+	{
+		return vertices;
+	}
+
+	for (LODImport& lod : lods)
+	{
+		MeshOptimizer::OptimizeVertexCache(lod.indices, weldedVertexCount);
+		MeshOptimizer::OptimizeOverdraw(lod.indices, weldedPositions);
+	}
+
+	std::vector<uint32> fetchRemap;
+	const uint32 usedVertexCount = MeshOptimizer::OptimizeVertexFetch(lods[0].indices, fetchRemap, weldedVertexCount);
+
+	for (std::size_t lodIndex = 1; lodIndex < lods.size(); lodIndex++)
+	{
+		MeshOptimizer::RemapIndices(lods[lodIndex].indices, fetchRemap);
+	}
+
+	// Vertices that are welded or unused are dropped.
+	std::vector<uint32> remap(vertexCount);
+
+	for (uint32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+	{
+		remap[vertexIndex] = fetchRemap[weldRemap[vertexIndex]];
+	}
+
+	std::vector<uint8> optimizedVertices(std::size_t(usedVertexCount) * vertexSize);
+
+	MeshOptimizer::RemapVertices(optimizedVertices.data(), vertices.data(), vertexCount, vertexSize, remap);
+
+	vertexCount = usedVertexCount;
+
+	return optimizedVertices;
+}
+
+/** Read the position of a packed vertex, dequantized to the submesh's local space. */
+static glm::vec3 ReadPosition(const uint8* vertex, const VertexLayout& packedLayout, const VertexDequantization& dequantization)
+{
+	const uint8* data = vertex + packedLayout.GetOffset(EVertexAttribute::Position);
+
+	if (packedLayout.GetFormat(EVertexAttribute::Position) == EFormat::R32G32B32_SFLOAT)
+	{
+		glm::vec3 position;
+		Platform::Memcpy(&position, data, sizeof(position));
+		return position;
+	}
+
+	uint16 quantizedPosition[3];
+	Platform::Memcpy(quantizedPosition, data, sizeof(quantizedPosition));
+
+	return glm::vec3(quantizedPosition[0], quantizedPosition[1], quantizedPosition[2]) / 65535.0f * dequantization.positionScale + dequantization.positionBias;
+}
+
+/**
+  * Split each level of detail into meshlets. Bounds are computed from the cooked positions, so quantization can't leave a
+  * visible triangle outside its sphere or cone. Triangles of double-sided materials are visible from behind, so they aren't cone culled.
+  */
+static void BuildSubmeshMeshlets(
+	SubmeshImport& submesh,
+	const std::vector<uint32>& indices,
+	const std::vector<uint8>& vertices,
+	const VertexLayout& packedLayout,
+	bool isDoubleSided)
+{
+	const uint32 vertexSize = packedLayout.GetStride(0);
+	std::vector<glm::vec3> positions(submesh.vertexCount);
+
+	for (uint32 vertexIndex = 0; vertexIndex < submesh.vertexCount; vertexIndex++)
+	{
+		positions[vertexIndex] = ReadPosition(vertices.data() + std::size_t(vertexIndex) * vertexSize, packedLayout, submesh.dequantization);
+	}
+
+	submesh.meshletVertexCount = 0;
+
+	for (CookedLOD& lod : submesh.lods)
+	{
+		const std::vector<MeshOptimizer::Meshlet> meshlets = MeshOptimizer::BuildMeshlets(indices, lod.firstIndex, lod.indexCount, submesh.vertexCount);
+
+		lod.firstMeshlet = static_cast<uint32>(submesh.meshlets.size());
+		lod.numMeshlets = static_cast<uint32>(meshlets.size());
+
+		for (const MeshOptimizer::Meshlet& meshlet : meshlets)
+		{
+			const MeshOptimizer::MeshletBounds bounds = MeshOptimizer::ComputeMeshletBounds(indices, meshlet, positions);
+
+			submesh.meshlets.push_back({
+				.center = bounds.center,
+				.radius = bounds.radius,
+				.coneAxis = bounds.coneAxis,
+				.coneCutoff = isDoubleSided ? 1.0f : bounds.coneCutoff,
+				.firstIndex = meshlet.firstIndex,
+				.indexCount = meshlet.indexCount,
+			});
+
+			submesh.meshletVertexCount += meshlet.vertexCount;
+		}
+	}
+}
+
+static SubmeshImport ImportSubmesh(
+	const tinygltf::Model& model,
+	const tinygltf::Mesh& mesh,
+	const tinygltf::Primitive& primitive,
+	const VertexLayout& layout,
+	bool optimize,
+	uint32 numLODs)
+{
+	check(primitive.material != -1, "Primitive of %s doesn't have a material.", mesh.name.c_str());
+
+	const tinygltf::Accessor& indexAccessor = model.accessors[primitive.indices];
+	const tinygltf::Accessor& positionAccessor = model.accessors[primitive.attributes.at("POSITION")];
+	const tinygltf::Accessor& normalAccessor = model.accessors[primitive.attributes.at("NORMAL")];
+	const tinygltf::Accessor& uvAccessor = model.accessors[primitive.attributes.at("TEXCOORD_0")];
+
+	const std::vector<float> positions = ReadFloats(model, positionAccessor);
+	const std::vector<float> textureCoordinates = ReadFloats(model, uvAccessor);
+	const std::vector<float> normals = ReadFloats(model, normalAccessor);
+	const uint32 vertexCount = static_cast<uint32>(positionAccessor.count);
+
+	SubmeshImport submesh =
+	{
+		.name = mesh.name,
+		.vertexCount = vertexCount,
+		.materialIndex = static_cast<uint32>(primitive.material),
+		.min = glm::vec3(std::numeric_limits<float>::max()),
+		.max = glm::vec3(std::numeric_limits<float>::lowest()),
+		.sourceVertexCount = vertexCount,
+	};
+
+	glm::vec2 uvMin(std::numeric_limits<float>::max());
+	glm::vec2 uvMax(std::numeric_limits<float>::lowest());
+
+	for (uint32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+	{
+		submesh.min = glm::min(submesh.min, glm::make_vec3(&positions[vertexIndex * 3]));
+		submesh.max = glm::max(submesh.max, glm::make_vec3(&positions[vertexIndex * 3]));
+		uvMin = glm::min(uvMin, glm::make_vec2(&textureCoordinates[vertexIndex * 2]));
+		uvMax = glm::max(uvMax, glm::make_vec2(&textureCoordinates[vertexIndex * 2]));
+	}
+
+	const bool isPositionQuantized = layout.GetFormat(EVertexAttribute::Position) != EFormat::R32G32B32_SFLOAT;
+
+	if (isPositionQuantized && vertexCount > 0)
+	{
+		submesh.dequantization.positionScale = submesh.max - submesh.min;
+		submesh.dequantization.positionBias = submesh.min;
+	}
+
+	if (vertexCount > 0)
+	{
+		submesh.dequantization.textureCoordinateScale = uvMax - uvMin;
+		submesh.dequantization.textureCoordinateBias = uvMin;
+	}
+
+	// Vertices are encoded interleaved first, so they can be welded and reordered as a whole, then split into the layout's streams.
+	VertexLayout packedLayout = layout;
+	packedLayout.isInterleaved = true;
+
+	const uint32 vertexSize = packedLayout.GetStride(0);
+	std::array<std::vector<uint8>, numVertexAttributes> packedVertices;
+	std::vector<uint8>& vertices = packedVertices[0];
+
+	vertices.resize(std::size_t(vertexCount) * vertexSize);
+
+	// Map a value to [0, 1] in the range of the scale and bias. Components of an empty range map to 0.
+	auto normalize = [] (float value, float scale, float bias)
+	{
+		return scale > 0.0f ? (value - bias) / scale : 0.0f;
+	};
+
+	const VertexDequantization& dequantization = submesh.dequantization;
+
+	for (uint32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+	{
+		const float* position = &positions[vertexIndex * 3];
+
+		if (isPositionQuantized)
+		{
+			const uint16 quantizedPosition[4] =
+			{
+				QuantizeUnorm16(normalize(position[0], dequantization.positionScale.x, dequantization.positionBias.x)),
+				QuantizeUnorm16(normalize(position[1], dequantization.positionScale.y, dequantization.positionBias.y)),
+				QuantizeUnorm16(normalize(position[2], dequantization.positionScale.z, dequantization.positionBias.z)),
+				0,
+			};
+
+			WriteVertexAttribute(packedVertices, packedLayout, EVertexAttribute::Position, vertexIndex, quantizedPosition);
+		}
+		else
+		{
+			WriteVertexAttribute(packedVertices, packedLayout, EVertexAttribute::Position, vertexIndex, position);
+		}
+
+		const float* uv = &textureCoordinates[vertexIndex * 2];
+		const uint16 quantizedUV[2] =
+		{
+			QuantizeUnorm16(normalize(uv[0], dequantization.textureCoordinateScale.x, dequantization.textureCoordinateBias.x)),
+			QuantizeUnorm16(normalize(uv[1], dequantization.textureCoordinateScale.y, dequantization.textureCoordinateBias.y)),
+		};
+
+		WriteVertexAttribute(packedVertices, packedLayout, EVertexAttribute::TextureCoordinate, vertexIndex, quantizedUV);
+
+		const std::array<int16, 2> encodedNormal = EncodeOctahedral(glm::make_vec3(&normals[vertexIndex * 3]));
+
+		WriteVertexAttribute(packedVertices, packedLayout, EVertexAttribute::Normal, vertexIndex, encodedNormal.data());
+	}
+
+	std::vector<LODImport> lods = { { ReadIndices(model, indexAccessor), 0.0f } };
+
+	submesh.sourceCacheStats = MeshOptimizer::AnalyzeVertexCache(lods[0].indices, vertexCount);
+
+	if (optimize || numLODs > 1)
+	{
+		vertices = BuildSubmeshLODs(lods, submesh.vertexCount, vertices, vertexSize, positions, optimize, numLODs);
+	}
+
+	submesh.cookedCacheStats = MeshOptimizer::AnalyzeVertexCache(lods[0].indices, submesh.vertexCount);
+
+	// The levels are concatenated, from full detail down.
+	std::vector<uint32> indices;
+
+	for (LODImport& lod : lods)
+	{
+		submesh.lods.push_back({
+			.firstIndex = static_cast<uint32>(indices.size()),
+			.indexCount = static_cast<uint32>(lod.indices.size()),
+			.error = lod.error,
+		});
+
+		indices.insert(indices.end(), lod.indices.begin(), lod.indices.end());
+	}
+
+	submesh.indexCount = static_cast<uint32>(indices.size());
+
+	BuildSubmeshMeshlets(submesh, indices, vertices, packedLayout, model.materials[primitive.material].doubleSided);
+
+	for (uint32 stream = 0; stream < layout.GetNumStreams(); stream++)
+	{
+		submesh.vertexStreams[stream].resize(std::size_t(submesh.vertexCount) * layout.GetStride(stream));
+	}
+
+	for (uint32 vertexIndex = 0; vertexIndex < submesh.vertexCount; vertexIndex++)
+	{
+		for (std::size_t attribute = 0; attribute < numVertexAttributes; attribute++)
+		{
+			const uint8* data = vertices.data() + std::size_t(vertexIndex) * vertexSize + packedLayout.GetOffset(static_cast<EVertexAttribute>(attribute));
+
+			WriteVertexAttribute(submesh.vertexStreams, layout, static_cast<EVertexAttribute>(attribute), vertexIndex, data);
+		}
+	}
+
+	// 16-bit indices halve index memory, and are used whenever every vertex can be indexed with them.
+	if (submesh.vertexCount <= std::numeric_limits<uint16>::max() + 1u)
+	{
+		submesh.indexType = EIndexType::UINT16;
+		submesh.indices.resize(indices.size() * sizeof(uint16));
+
+		for (std::size_t i = 0; i < indices.size(); i++)
+		{
+			const uint16 index = static_cast<uint16>(indices[i]);
+			Platform::Memcpy(submesh.indices.data() + i * sizeof(uint16), &index, sizeof(index));
+		}
+	}
+	else
+	{
+		submesh.indexType = EIndexType::UINT32;
+		submesh.indices.resize(indices.size() * sizeof(uint32));
+		Platform::Memcpy(submesh.indices.data(), indices.data(), submesh.indices.size());
+	}
+
+	return submesh;
+}
+
+/** A texture in the texture table, and the image it's cooked from. */
+struct TextureImport
+{
+	int32 imageIndex;
+	std::string name;
+	std::filesystem::path sourcePath;
+	ETextureContent content;
+};
+
+/** Add a material texture to the texture table. Returns -1 if the material doesn't have the texture. */
+static int32 AddTexture(
+	std::vector<TextureImport>& textures,
+	std::unordered_map<std::string, int32>& textureIndices,
+	const std::filesystem::path& path,
+	const tinygltf::Model& model,
+	int32 textureIndex,
+	ETextureContent content)
+{
+	if (textureIndex == -1 || model.textures.empty())
+	{
+		return -1;
+	}
+
+	const tinygltf::Texture& texture = model.textures[textureIndex];
+	const tinygltf::Image& image = model.images[texture.source];
+
+	// Images embedded in the glTF don't have a URI.
+	const std::string imageName = image.uri.empty() ? path.generic_string() + "#" + std::to_string(texture.source) : image.uri;
+	const std::string textureKey = imageName + "#" + std::to_string(static_cast<uint32>(content));
+
+	if (const auto iter = textureIndices.find(textureKey); iter != textureIndices.end())
+	{
+		return iter->second;
+	}
+
+	const int32 cookedIndex = static_cast<int32>(textures.size());
+
+	textures.push_back({
+		.imageIndex = texture.source,
+		.name = imageName,
+		.sourcePath = image.uri.empty() ? path : path.parent_path() / image.uri,
+		.content = content,
+	});
+
+	textureIndices[textureKey] = cookedIndex;
+
+	return cookedIndex;
+}
+
+/** Keeps the encoded bytes of images, so they're decoded in parallel once the glTF is parsed. */
+static bool DeferImageDecode(tinygltf::Image* image, const int imageIndex, std::string* err, std::string* warn,
+	int reqWidth, int reqHeight, const unsigned char* bytes, int size, void* userData)
+{
+	std::vector<std::vector<uint8>>& encodedImages = *static_cast<std::vector<std::vector<uint8>>*>(userData);
+
+	if (encodedImages.size() <= static_cast<std::size_t>(imageIndex))
+	{
+		encodedImages.resize(imageIndex + 1);
+	}
+
+	encodedImages[imageIndex].assign(bytes, bytes + size);
+
+	return true;
+}
+
+static float GetElapsedMs(std::chrono::high_resolution_clock::time_point& startTime)
+{
+	const auto endTime = std::chrono::high_resolution_clock::now();
+	const float elapsedMs = std::chrono::duration<float, std::milli>(endTime - startTime).count();
+	startTime = endTime;
+	return elapsedMs;
+}
+
+void MeshCooker::Cook(const std::filesystem::path& path, const std::filesystem::path& cachePath, uint64 key)
+{
+	JobSystem& jobSystem = JobSystem::Get();
+	auto startTime = std::chrono::high_resolution_clock::now();
+
+	tinygltf::TinyGLTF loader;
+	tinygltf::Model model;
+	std::string err;
+	std::string warn;
+	std::vector<std::vector<uint8>> encodedImages;
+
+	loader.SetImageLoader(DeferImageDecode, &encodedImages);
+
+	const bool isImported = path.extension() == ".gltf" ?
+		loader.LoadASCIIFromFile(&model, &err, &warn, path.generic_string()) :
+		loader.LoadBinaryFromFile(&model, &err, &warn, path.generic_string());
+
+	if (!warn.empty())
+	{
+		LOG("TinyGLTF warning: %s", warn.c_str());
+	}
+
+	// Failed imports aren't cooked, so they're retried on the next load.
+	check(isImported, "TinyGLTF error: %s", err.c_str());
+
+	const float parseMs = GetElapsedMs(startTime);
+
+	CookedMeshWriter writer;
+	std::vector<TextureImport> textures;
+	std::unordered_map<std::string, int32> textureIndices;
+
+	for (const tinygltf::Material& gltfMaterial : model.materials)
+	{
+		writer._Materials.push_back({
+			.mode = gltfMaterial.alphaMode == "MASK" ? EMaterialMode::Masked : EMaterialMode::Opaque,
+			.baseColor = AddTexture(textures, textureIndices, path, model, gltfMaterial.pbrMetallicRoughness.baseColorTexture.index, ETextureContent::Color),
+			.metallicRoughness = AddTexture(textures, textureIndices, path, model, gltfMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index, ETextureContent::MetallicRoughness),
+			.normal = AddTexture(textures, textureIndices, path, model, gltfMaterial.normalTexture.index, ETextureContent::Normal),
+			.emissive = AddTexture(textures, textureIndices, path, model, gltfMaterial.emissiveTexture.index, ETextureContent::Color),
+			.metallic = static_cast<float>(gltfMaterial.pbrMetallicRoughness.metallicFactor),
+			.roughness = static_cast<float>(gltfMaterial.pbrMetallicRoughness.roughnessFactor),
+			.emissiveFactor = gltfMaterial.emissiveFactor.empty() ?
+				glm::vec3(0.0f) :
+				glm::vec3(gltfMaterial.emissiveFactor[0], gltfMaterial.emissiveFactor[1], gltfMaterial.emissiveFactor[2]),
+		});
+	}
+
+	// Only the images of textures that aren't cooked yet are decoded.
+	std::vector<const TextureImport*> uncookedTextures;
+	std::vector<int32> imagesToDecode;
+
+	for (const TextureImport& texture : textures)
+	{
+		if (!TextureCooker::IsCached(texture.sourcePath, texture.name, texture.content))
+		{
+			uncookedTextures.push_back(&texture);
+
+			if (std::find(imagesToDecode.begin(), imagesToDecode.end(), texture.imageIndex) == imagesToDecode.end())
+			{
+				imagesToDecode.push_back(texture.imageIndex);
+			}
+		}
+	}
+
+	struct DecodedImage
+	{
+		uint8* pixels = nullptr;
+		int32 width = 0;
+		int32 height = 0;
+	};
+
+	std::unordered_map<int32, DecodedImage> decodedImages;
+
+	for (int32 imageIndex : imagesToDecode)
+	{
+		decodedImages[imageIndex] = {};
+	}
+
+	jobSystem.ParallelFor(imagesToDecode.size(), [&] (std::size_t i)
+	{
+		const std::vector<uint8>& encodedImage = encodedImages[imagesToDecode[i]];
+		DecodedImage& decodedImage = decodedImages.at(imagesToDecode[i]);
+		int32 numChannels;
+
+		// glTF images may be 16-bit. The mip chain and the block compressor take RGBA8.
+		decodedImage.pixels = Platform::DecodeImage(
+			encodedImage.data(), encodedImage.size(), decodedImage.width, decodedImage.height, numChannels
+		);
+	});
+
+	const float decodeMs = GetElapsedMs(startTime);
+
+	std::vector<std::pair<const tinygltf::Mesh*, const tinygltf::Primitive*>> primitives;
+
+	for (const tinygltf::Mesh& mesh : model.meshes)
+	{
+		for (const tinygltf::Primitive& primitive : mesh.primitives)
+		{
+			primitives.push_back({ &mesh, &primitive });
+		}
+	}
+
+	const VertexLayout vertexLayout = VertexLayout::GetCookedLayout();
+	const bool optimizeMeshes = IsOptimizeMeshesEnabled();
+	const uint32 lodCount = GetLODCount();
+	std::vector<SubmeshImport> submeshes(primitives.size());
+
+	jobSystem.ParallelFor(primitives.size(), [&] (std::size_t i)
+	{
+		submeshes[i] = ImportSubmesh(model, *primitives[i].first, *primitives[i].second, vertexLayout, optimizeMeshes, lodCount);
+	});
+
+	MeshOptimizer::VertexCacheStats sourceCacheStats;
+	MeshOptimizer::VertexCacheStats cookedCacheStats;
+	uint32 sourceVertexCount = 0;
+	uint32 cookedVertexCount = 0;
+	// Submeshes that run out of levels count their coarsest level.
+	std::array<uint32, maxLODs> lodTriangleCounts = {};
+	uint32 numMeshlets = 0;
+	uint64 meshletTriangleCount = 0;
+	uint64 meshletVertexCount = 0;
+
+	for (SubmeshImport& submesh : submeshes)
+	{
+		sourceCacheStats += submesh.sourceCacheStats;
+		cookedCacheStats += submesh.cookedCacheStats;
+		sourceVertexCount += submesh.sourceVertexCount;
+		cookedVertexCount += submesh.vertexCount;
+
+		for (uint32 lodIndex = 0; lodIndex < lodCount; lodIndex++)
+		{
+			lodTriangleCounts[lodIndex] += submesh.lods[std::min<std::size_t>(lodIndex, submesh.lods.size() - 1)].indexCount / 3;
+		}
+
+		numMeshlets += static_cast<uint32>(submesh.meshlets.size());
+		meshletTriangleCount += submesh.indexCount / 3;
+		meshletVertexCount += submesh.meshletVertexCount;
+
+		std::vector<uint8> meshlets(submesh.meshlets.size() * sizeof(CookedMeshlet));
+		Platform::Memcpy(meshlets.data(), submesh.meshlets.data(), meshlets.size());
+
+		CookedSubmesh cookedSubmesh =
+		{
+			.name = writer.AddString(submesh.name),
+			.indices = writer.AddData(std::move(submesh.indices)),
+			.meshlets = writer.AddData(std::move(meshlets)),
+			.vertexLayout = vertexLayout,
+			.dequantization = submesh.dequantization,
+			.vertexCount = submesh.vertexCount,
+			.indexCount = submesh.indexCount,
+			.lods = {},
+			.numLODs = static_cast<uint32>(submesh.lods.size()),
+			.indexType = submesh.indexType,
+			.materialIndex = submesh.materialIndex,
+			.min = submesh.min,
+			.max = submesh.max,
+		};
+
+		for (std::size_t stream = 0; stream < numVertexAttributes; stream++)
+		{
+			cookedSubmesh.vertexStreams[stream] = writer.AddData(std::move(submesh.vertexStreams[stream]));
+		}
+
+		std::copy(submesh.lods.begin(), submesh.lods.end(), cookedSubmesh.lods.begin());
+
+		writer._Submeshes.push_back(cookedSubmesh);
+	}
+
+	const float geometryMs = GetElapsedMs(startTime);
+
+	// ACMR and ATVR of a 16-entry FIFO cache, as authored and as cooked.
+	LOG("Cooked %zu submeshes with %u triangles%s. Vertices: %u -> %u, ACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f.",
+		submeshes.size(),
+		cookedCacheStats.numTriangles,
+		optimizeMeshes ? "" : " without optimization",
+		sourceVertexCount,
+		cookedVertexCount,
+		sourceCacheStats.GetACMR(),
+		cookedCacheStats.GetACMR(),
+		sourceCacheStats.GetATVR(),
+		cookedCacheStats.GetATVR()
+	);
+
+	std::string lodTriangles;
+
+	for (uint32 lodIndex = 0; lodIndex < lodCount; lodIndex++)
+	{
+		lodTriangles += Platform::FormatString(lodIndex == 0 ? "%u" : ", %u", lodTriangleCounts[lodIndex]);
+	}
+
+	LOG("Triangles per LOD: %s.", lodTriangles.c_str());
+
+	LOG("Meshlets: %u, triangles per meshlet: %.1f, vertices per meshlet: %.1f.",
+		numMeshlets,
+		numMeshlets > 0 ? static_cast<float>(meshletTriangleCount) / numMeshlets : 0.0f,
+		numMeshlets > 0 ? static_cast<float>(meshletVertexCount) / numMeshlets : 0.0f
+	);
+
+	for (const TextureImport* texture : uncookedTextures)
+	{
+		check(decodedImages.at(texture->imageIndex).pixels, "Failed to decode %s: %s", texture->name.c_str(), stbi_failure_reason());
+	}
+
+	// Textures are cooked in parallel, and each is block-compressed in parallel too. Waiting workers steal its block rows.
+	// The cooked textures are cached by the texture cooker, and loaded from the cache with the mesh.
+	jobSystem.ParallelFor(uncookedTextures.size(), [&] (std::size_t i)
+	{
+		const TextureImport* texture = uncookedTextures[i];
+		const DecodedImage& decodedImage = decodedImages.at(texture->imageIndex);
+
+		TextureCooker::Cook(
+			texture->sourcePath,
+			texture->name,
+			decodedImage.pixels,
+			decodedImage.width,
+			decodedImage.height,
+			texture->content == ETextureContent::Color,
+			texture->content
+		);
+	}, 1);
+
+	for (const auto& [imageIndex, decodedImage] : decodedImages)
+	{
+		Platform::FreeImage(decodedImage.pixels);
+	}
+
+	for (const TextureImport& texture : textures)
+	{
+		writer._Textures.push_back({
+			.name = writer.AddString(texture.name),
+			.sourcePath = writer.AddString(texture.sourcePath.generic_string()),
+			.content = texture.content,
+		});
+	}
+
+	const float textureMs = GetElapsedMs(startTime);
+
+	writer.Write(cachePath, key, path.generic_string());
+
+	LOG("Imported %s on %u workers. Parse: %.1f ms, decode %zu images: %.1f ms, geometry: %.1f ms, cook %zu textures: %.1f ms.",
+		path.generic_string().c_str(),
+		jobSystem.GetNumWorkers(),
+		parseMs,
+		imagesToDecode.size(),
+		decodeMs,
+		geometryMs,
+		uncookedTextures.size(),
+		textureMs
+	);
+}
@@ -0,0 +1,151 @@
+#pragma once
+#include "Material.h"
+#include "TextureCooker.h"
+#include "VertexLayout.h"
+
+/** A range of bytes in a cooked mesh file. */
+struct CookedRange
+{
+	uint64 offset;
+	uint64 size;
+};
+
+/** Most levels of detail a cooked submesh can have, including full detail. */
+static constexpr uint32 maxLODs = 6;
+
+/** A level of detail: a range of the submesh's indices, drawn with its vertices. */
+struct CookedLOD
+{
+	uint32 firstIndex;
+	uint32 indexCount;
+	/** Largest distance of the simplified surface from the full detail surface, in position units. */
+	float error;
+	/** The level's meshlets, which cover its indices in order. */
+	uint32 firstMeshlet;
+	uint32 numMeshlets;
+};
+
+/**
+  * A run of a level's triangles that's culled as a whole, with its bounding sphere and normal cone in the submesh's local space.
+  * The cone culls the meshlet from viewpoints v where dot(center - v, coneAxis) >= coneCutoff * length(center - v) + radius.
+  */
+struct CookedMeshlet
+{
+	glm::vec3 center;
+	float radius;
+	glm::vec3 coneAxis;
+	/** 1 if the meshlet can't be cone culled, like meshlets of double-sided materials. */
+	float coneCutoff;
+	uint32 firstIndex;
+	uint32 indexCount;
+};
+
+struct CookedSubmesh
+{
+	CookedRange name;
+
+	/** Tightly packed index and vertex data, ready to be copied to GPU buffers. Streams past the layout's are empty. */
+	CookedRange indices;
+	std::array<CookedRange, numVertexAttributes> vertexStreams;
+	/** CookedMeshlets of every level of detail. */
+	CookedRange meshlets;
+
+	VertexLayout vertexLayout;
+	VertexDequantization dequantization;
+
+	uint32 vertexCount;
+	/** Indices of every level of detail. */
+	uint32 indexCount;
+	/** Levels of detail from full detail down. They share the vertices. */
+	std::array<CookedLOD, maxLODs> lods;
+	uint32 numLODs;
+	/** UINT16 if the vertex count allows it. */
+	EIndexType indexType;
+	uint32 materialIndex;
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+struct CookedMaterial
+{
+	EMaterialMode mode;
+
+	/** Indices in the texture table, or -1 if the material doesn't have the texture. */
+	int32 baseColor;
+	int32 metallicRoughness;
+	int32 normal;
+	int32 emissive;
+
+	float metallic;
+	float roughness;
+	glm::vec3 emissiveFactor;
+};
+
+/** A texture cooked by the TextureCooker. Cooked textures are cached separately from the mesh. */
+struct CookedTextureRef
+{
+	CookedRange name;
+	CookedRange sourcePath;
+	ETextureContent content;
+};
+
+/**
+  * A cooked mesh file mapped into memory. The file is a header, then the submesh, material and texture tables,
+  * then strings, then 16-byte aligned index and vertex data. Data is copied to staging straight from the mapping.
+  */
+class CookedMesh
+{
+public:
+	CookedMesh(const CookedMesh&) = delete;
+	CookedMesh& operator=(const CookedMesh&) = delete;
+
+	/** Map a cooked mesh. It isn't valid if the file is missing, truncated, or was cooked with another key or from another source. */
+	CookedMesh(const std::filesystem::path& path, uint64 key, const std::filesystem::path& sourcePath);
+
+	inline bool IsValid() const { return _Header != nullptr; }
+
+	uint32 GetNumSubmeshes() const;
+	uint32 GetNumMaterials() const;
+	uint32 GetNumTextures() const;
+
+	const CookedSubmesh& GetSubmesh(uint32 index) const;
+	const CookedMaterial& GetMaterial(uint32 index) const;
+	const CookedTextureRef& GetTexture(uint32 index) const;
+
+	inline const uint8* GetData(const CookedRange& range) const { return _File.GetData() + range.offset; }
+	inline std::string GetString(const CookedRange& range) const { return std::string(reinterpret_cast<const char*>(GetData(range)), range.size); }
+
+private:
+	MappedFile _File;
+	const struct CookedMeshHeader* _Header = nullptr;
+};
+
+/**
+  * Cooks glTF files into cooked meshes, so they load without parsing JSON or decoding images.
+  * Cooked meshes are cached in ../Cooked/Meshes, keyed by the source path, its write time, the vertex layout, whether meshes
+  * are optimized, the number of LODs and the importer version. The source path is also stored in the file and compared when it's mapped. Optimization welds duplicate vertices and reorders triangles and vertices with
+  * the MeshOptimizer. LODs are simplified from the level above, and share the vertices of full detail. Each level is split into meshlets for cluster culling.
+  */
+class MeshCooker
+{
+public:
+	/** Map the cooked mesh of a glTF file. The file is cooked first if it isn't cached, is out of date, or if forced to. */
+	static std::unique_ptr<CookedMesh> Load(const std::filesystem::path& path, bool forceCook = false);
+
+	/** Bump to invalidate cooked meshes after changing the importer or the file layout. */
+	static constexpr uint32 importerVersion = 6;
+
+private:
+	static uint64 GetKey(const std::filesystem::path& path);
+
+	/** OptimizeMeshes in Engine.ini. */
+	static bool IsOptimizeMeshesEnabled();
+
+	/** LODCount in Engine.ini, clamped to [1, maxLODs]. 1 cooks full detail only. */
+	static uint32 GetLODCount();
+
+	static std::filesystem::path GetCachePath(uint64 key);
+
+	/** Import a glTF file, cook its textures, and write the cooked mesh. */
+	static void Cook(const std::filesystem::path& path, const std::filesystem::path& cachePath, uint64 key);
+};
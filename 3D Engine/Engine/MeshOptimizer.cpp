@@ -0,0 +1,1112 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <numeric>
+#include <string_view>
+
+MeshOptimizer::VertexCacheStats& MeshOptimizer::VertexCacheStats::operator+=(const VertexCacheStats& other)
+{
+	numTriangles += other.numTriangles;
+	numVertices += other.numVertices;
+	numMisses += other.numMisses;
+	return *this;
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32>& indices, uint32 vertexCount, uint32 cacheSize)
+{
+	VertexCacheStats stats = { .numTriangles = static_cast<uint32>(indices.size() / 3) };
+
+	// A vertex is in the FIFO if fewer than cacheSize vertices were added since it was.
+	std::vector<uint32> timestamps(vertexCount, 0);
+	std::vector<bool> isReferenced(vertexCount, false);
+	uint32 timestamp = cacheSize + 1;
+
+	for (uint32 index : indices)
+	{
+		if (timestamp - timestamps[index] > cacheSize)
+		{
+			timestamps[index] = timestamp++;
+			stats.numMisses++;
+		}
+
+		if (!isReferenced[index])
+		{
+			isReferenced[index] = true;
+			stats.numVertices++;
+		}
+	}
+
+	return stats;
+}
+
+uint32 MeshOptimizer::GenerateVertexRemap(std::vector<uint32>& remap, const uint8* vertices, uint32 vertexCount, uint32 vertexSize)
+{
+	std::unordered_map<std::string_view, uint32> uniqueVertices;
+	uniqueVertices.reserve(vertexCount);
+
+	remap.resize(vertexCount);
+
+	for (uint32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+	{
+		const std::string_view vertex(reinterpret_cast<const char*>(vertices) + std::size_t(vertexIndex) * vertexSize, vertexSize);
+		const auto [iter, isUnique] = uniqueVertices.try_emplace(vertex, static_cast<uint32>(uniqueVertices.size()));
+
+		remap[vertexIndex] = iter->second;
+	}
+
+	return static_cast<uint32>(uniqueVertices.size());
+}
+
+void MeshOptimizer::RemapIndices(std::vector<uint32>& indices, const std::vector<uint32>& remap)
+{
+	for (uint32& index : indices)
+	{
+		index = remap[index];
+	}
+}
+
+void MeshOptimizer::RemapVertices(uint8* dst, const uint8* src, uint32 vertexCount, uint32 vertexSize, const std::vector<uint32>& remap)
+{
+	for (uint32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+	{
+		if (remap[vertexIndex] != unusedVertex)
+		{
+			Platform::Memcpy(dst + std::size_t(remap[vertexIndex]) * vertexSize, src + std::size_t(vertexIndex) * vertexSize, vertexSize);
+		}
+	}
+}
+
+/** Size of the LRU cache modelled by the vertex cache optimisation. */
+static constexpr uint32 forsythCacheSize = 32;
+
+/** Vertices are scored by their position in the cache, and by how few triangles still use them so lone vertices are finished off. */
+static float GetForsythVertexScore(int32 cachePosition, uint32 numRemainingTriangles)
+{
+	if (numRemainingTriangles == 0)
+	{
+		return -1.0f;
+	}
+
+	float score = 0.0f;
+
+	if (cachePosition >= 0)
+	{
+		// The vertices of the last triangle get a fixed score, so the next triangle doesn't just reuse the same edge.
+		score = cachePosition < 3 ? 0.75f : std::pow(1.0f - static_cast<float>(cachePosition - 3) / (forsythCacheSize - 3), 1.5f);
+	}
+
+	return score + 2.0f / std::sqrt(static_cast<float>(numRemainingTriangles));
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32>& indices, uint32 vertexCount)
+{
+	const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+
+	// Triangles that use each vertex, packed in one array. Emitted triangles are swapped past the vertex's remaining count.
+	std::vector<uint32> adjacencyOffsets(vertexCount + 1, 0);
+	std::vector<uint32> adjacency(indices.size());
+	std::vector<uint32> numRemainingTriangles(vertexCount, 0);
+
+	for (uint32 index : indices)
+	{
+		adjacencyOffsets[index + 1]++;
+	}
+
+	std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+	for (uint32 triangle = 0; triangle < triangleCount; triangle++)
+	{
+		for (uint32 corner = 0; corner < 3; corner++)
+		{
+			const uint32 vertex = indices[triangle * 3 + corner];
+			adjacency[adjacencyOffsets[vertex] + numRemainingTriangles[vertex]++] = triangle;
+		}
+	}
+
+	std::vector<int32> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	std::vector<float> triangleScores(triangleCount, 0.0f);
+	std::vector<bool> isEmitted(triangleCount, false);
+
+	for (uint32 vertex = 0; vertex < vertexCount; vertex++)
+	{
+		vertexScores[vertex] = GetForsythVertexScore(-1, numRemainingTriangles[vertex]);
+	}
+
+	for (uint32 triangle = 0; triangle < triangleCount; triangle++)
+	{
+		for (uint32 corner = 0; corner < 3; corner++)
+		{
+			triangleScores[triangle] += vertexScores[indices[triangle * 3 + corner]];
+		}
+	}
+
+	// Update a vertex's score, and the scores of the triangles that still use it.
+	auto updateVertexScore = [&] (uint32 vertex)
+	{
+		const float score = GetForsythVertexScore(cachePositions[vertex], numRemainingTriangles[vertex]);
+		const float delta = score - vertexScores[vertex];
+
+		vertexScores[vertex] = score;
+
+		for (uint32 i = 0; i < numRemainingTriangles[vertex]; i++)
+		{
+			triangleScores[adjacency[adjacencyOffsets[vertex] + i]] += delta;
+		}
+	};
+
+	std::vector<uint32> optimizedIndices;
+	optimizedIndices.reserve(indices.size());
+
+	// Three more entries than the cache, for the vertices of the emitted triangle before the oldest are evicted.
+	std::array<uint32, forsythCacheSize + 3> cache;
+	std::array<uint32, forsythCacheSize + 3> newCache;
+	uint32 cacheCount = 0;
+
+	int64 bestTriangle = -1;
+	uint32 nextTriangle = 0;
+
+	for (uint32 numEmitted = 0; numEmitted < triangleCount; numEmitted++)
+	{
+		// Once no cached vertex has triangles left, continue with the first triangle that hasn't been emitted.
+		if (bestTriangle < 0)
+		{
+			while (isEmitted[nextTriangle])
+			{
+				nextTriangle++;
+			}
+
+			bestTriangle = nextTriangle;
+		}
+
+		const uint32 triangle = static_cast<uint32>(bestTriangle);
+		const uint32* triangleIndices = &indices[triangle * 3];
+
+		isEmitted[triangle] = true;
+		optimizedIndices.insert(optimizedIndices.end(), triangleIndices, triangleIndices + 3);
+
+		uint32 newCacheCount = 0;
+
+		for (uint32 corner = 0; corner < 3; corner++)
+		{
+			const uint32 vertex = triangleIndices[corner];
+			uint32* vertexAdjacency = &adjacency[adjacencyOffsets[vertex]];
+			uint32* emittedTriangle = std::find(vertexAdjacency, vertexAdjacency + numRemainingTriangles[vertex], triangle);
+
+			std::swap(*emittedTriangle, vertexAdjacency[--numRemainingTriangles[vertex]]);
+
+			// Degenerate triangles use a vertex more than once.
+			if (std::find(newCache.begin(), newCache.begin() + newCacheCount, vertex) == newCache.begin() + newCacheCount)
+			{
+				newCache[newCacheCount++] = vertex;
+			}
+		}
+
+		for (uint32 i = 0; i < cacheCount; i++)
+		{
+			if (std::find(triangleIndices, triangleIndices + 3, cache[i]) == triangleIndices + 3)
+			{
+				newCache[newCacheCount++] = cache[i];
+			}
+		}
+
+		for (uint32 i = forsythCacheSize; i < newCacheCount; i++)
+		{
+			cachePositions[newCache[i]] = -1;
+			updateVertexScore(newCache[i]);
+		}
+
+		cacheCount = std::min(newCacheCount, forsythCacheSize);
+		std::swap(cache, newCache);
+
+		for (uint32 i = 0; i < cacheCount; i++)
+		{
+			cachePositions[cache[i]] = static_cast<int32>(i);
+			updateVertexScore(cache[i]);
+		}
+
+		// The next triangle is the best one that uses a cached vertex.
+		bestTriangle = -1;
+		float bestScore = -std::numeric_limits<float>::max();
+
+		for (uint32 i = 0; i < cacheCount; i++)
+		{
+			const uint32 vertex = cache[i];
+
+			for (uint32 j = 0; j < numRemainingTriangles[vertex]; j++)
+			{
+				const uint32 candidate = adjacency[adjacencyOffsets[vertex] + j];
+
+				if (triangleScores[candidate] > bestScore)
+				{
+					bestScore = triangleScores[candidate];
+					bestTriangle = candidate;
+				}
+			}
+		}
+	}
+
+	indices = std::move(optimizedIndices);
+}
+
+/** A run of triangles that's drawn as a unit, and the sort key that puts the clusters facing outwards first. */
+struct TriangleCluster
+{
+	uint32 begin;
+	uint32 end;
+	float sortKey;
+};
+
+/** Split [begin, end) where the ACMR of the run so far gets within the threshold of the whole range's. Resets the cache at each split. */
+static void SplitSoftClusters(std::vector<TriangleCluster>& clusters, const std::vector<uint32>& indices, uint32 begin, uint32 end, uint32 vertexCount, float threshold)
+{
+	static constexpr uint32 cacheSize = 16;
+
+	std::vector<uint32> timestamps(vertexCount, 0);
+	uint32 timestamp = cacheSize + 1;
+
+	auto countMisses = [&] (uint32 triangle)
+	{
+		uint32 numMisses = 0;
+
+		for (uint32 corner = 0; corner < 3; corner++)
+		{
+			const uint32 vertex = indices[triangle * 3 + corner];
+
+			if (timestamp - timestamps[vertex] > cacheSize)
+			{
+				timestamps[vertex] = timestamp++;
+				numMisses++;
+			}
+		}
+
+		return numMisses;
+	};
+
+	uint32 rangeMisses = 0;
+
+	for (uint32 triangle = begin; triangle < end; triangle++)
+	{
+		rangeMisses += countMisses(triangle);
+	}
+
+	const float maxACMR = threshold * rangeMisses / (end - begin);
+
+	// Flush the cache.
+	timestamp += cacheSize + 1;
+
+	uint32 clusterBegin = begin;
+	uint32 clusterMisses = 0;
+
+	for (uint32 triangle = begin; triangle < end; triangle++)
+	{
+		clusterMisses += countMisses(triangle);
+
+		if (triangle + 1 == end || static_cast<float>(clusterMisses) / (triangle + 1 - clusterBegin) <= maxACMR)
+		{
+			clusters.push_back({ clusterBegin, triangle + 1, 0.0f });
+			clusterBegin = triangle + 1;
+			clusterMisses = 0;
+			timestamp += cacheSize + 1;
+		}
+	}
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32>& indices, const std::vector<glm::vec3>& positions, float threshold)
+{
+	const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+	const uint32 vertexCount = static_cast<uint32>(positions.size());
+
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// Hard boundaries are the triangles that miss on every vertex, where the cache optimisation started over.
+	std::vector<uint32> hardBoundaries;
+	std::vector<uint32> timestamps(vertexCount, 0);
+	static constexpr uint32 cacheSize = 16;
+	uint32 timestamp = cacheSize + 1;
+
+	for (uint32 triangle = 0; triangle < triangleCount; triangle++)
+	{
+		uint32 numMisses = 0;
+
+		for (uint32 corner = 0; corner < 3; corner++)
+		{
+			const uint32 vertex = indices[triangle * 3 + corner];
+
+			if (timestamp - timestamps[vertex] > cacheSize)
+			{
+				timestamps[vertex] = timestamp++;
+				numMisses++;
+			}
+		}
+
+		if (triangle == 0 || numMisses == 3)
+		{
+			hardBoundaries.push_back(triangle);
+		}
+	}
+
+	hardBoundaries.push_back(triangleCount);
+
+	std::vector<TriangleCluster> clusters;
+
+	for (std::size_t i = 0; i + 1 < hardBoundaries.size(); i++)
+	{
+		SplitSoftClusters(clusters, indices, hardBoundaries[i], hardBoundaries[i + 1], vertexCount, threshold);
+	}
+
+	glm::vec3 meshCentroid(0.0f);
+
+	for (uint32 index : indices)
+	{
+		meshCentroid += positions[index];
+	}
+
+	meshCentroid /= static_cast<float>(indices.size());
+
+	for (TriangleCluster& cluster : clusters)
+	{
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+
+		for (uint32 triangle = cluster.begin; triangle < cluster.end; triangle++)
+		{
+			const glm::vec3& p0 = positions[indices[triangle * 3 + 0]];
+			const glm::vec3& p1 = positions[indices[triangle * 3 + 1]];
+			const glm::vec3& p2 = positions[indices[triangle * 3 + 2]];
+			const glm::vec3 areaNormal = glm::cross(p1 - p0, p2 - p0);
+			const float triangleArea = glm::length(areaNormal);
+
+			centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += areaNormal;
+			area += triangleArea;
+		}
+
+		const float normalLength = glm::length(normal);
+
+		// Clusters without area can't occlude anything, so they're drawn last.
+		cluster.sortKey = area > 0.0f && normalLength > 0.0f ?
+			glm::dot(centroid / area - meshCentroid, normal / normalLength) :
+			-std::numeric_limits<float>::max();
+	}
+
+	// Stable, so clusters with equal keys keep their order and the result is deterministic.
+	std::stable_sort(clusters.begin(), clusters.end(), [] (const TriangleCluster& a, const TriangleCluster& b)
+	{
+		return a.sortKey > b.sortKey;
+	});
+
+	std::vector<uint32> sortedIndices;
+	sortedIndices.reserve(indices.size());
+
+	for (const TriangleCluster& cluster : clusters)
+	{
+		sortedIndices.insert(sortedIndices.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+	}
+
+	indices = std::move(sortedIndices);
+}
+
+/** Squared distance to a set of planes, weighted by area. Symmetric, so only the upper triangle is stored. */
+struct Quadric
+{
+	float a00 = 0.0f, a11 = 0.0f, a22 = 0.0f;
+	float a10 = 0.0f, a20 = 0.0f, a21 = 0.0f;
+	float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+	float c = 0.0f;
+	float weight = 0.0f;
+
+	Quadric() = default;
+
+	/** The plane dot(n, p) + d = 0. */
+	Quadric(const glm::vec3& n, float d, float w)
+		: a00(w * n.x * n.x), a11(w * n.y * n.y), a22(w * n.z * n.z)
+		, a10(w * n.y * n.x), a20(w * n.z * n.x), a21(w * n.z * n.y)
+		, b0(w * n.x * d), b1(w * n.y * d), b2(w * n.z * d)
+		, c(w * d * d)
+		, weight(w)
+	{
+	}
+
+	Quadric& operator+=(const Quadric& other)
+	{
+		a00 += other.a00; a11 += other.a11; a22 += other.a22;
+		a10 += other.a10; a20 += other.a20; a21 += other.a21;
+		b0 += other.b0; b1 += other.b1; b2 += other.b2;
+		c += other.c;
+		weight += other.weight;
+		return *this;
+	}
+
+	/** Mean squared distance of a point to the planes. */
+	float GetError(const glm::vec3& p) const
+	{
+		const float rx = a00 * p.x + a10 * p.y + a20 * p.z + b0;
+		const float ry = a10 * p.x + a11 * p.y + a21 * p.z + b1;
+		const float rz = a20 * p.x + a21 * p.y + a22 * p.z + b2;
+		const float error = p.x * rx + p.y * ry + p.z * rz + b0 * p.x + b1 * p.y + b2 * p.z + c;
+
+		return weight > 0.0f ? std::abs(error) / weight : 0.0f;
+	}
+};
+
+enum class EVertexKind : uint8
+{
+	/** Surrounded by triangles. Collapses onto any neighbor. */
+	Manifold,
+	/** On one open border. Collapses onto a neighbor along the border. */
+	Border,
+	/** On one attribute seam, with a wedge on either side. Both wedges collapse along the seam. */
+	Seam,
+	/** On a non-manifold edge, where seams or borders meet, or on a seam and a border. Never collapses. */
+	Locked,
+};
+
+static inline uint64 GetEdgeKey(uint32 a, uint32 b)
+{
+	return (static_cast<uint64>(a) << 32) | b;
+}
+
+/** Border and seam planes are weighted higher than surface planes, so borders and seams don't drift. */
+static constexpr float borderWeight = 10.0f;
+
+std::vector<uint32> MeshOptimizer::Simplify(const std::vector<uint32>& indices, const std::vector<glm::vec3>& positions, uint32 targetIndexCount, float maxError, float& error)
+{
+	const uint32 vertexCount = static_cast<uint32>(positions.size());
+
+	error = 0.0f;
+
+	// Positions are normalized to the unit cube so the quadrics are well conditioned.
+	glm::vec3 min(std::numeric_limits<float>::max());
+	glm::vec3 max(std::numeric_limits<float>::lowest());
+	std::vector<bool> isReferenced(vertexCount, false);
+
+	for (uint32 index : indices)
+	{
+		min = glm::min(min, positions[index]);
+		max = glm::max(max, positions[index]);
+		isReferenced[index] = true;
+	}
+
+	const float extent = indices.empty() ? 0.0f : std::max({ max.x - min.x, max.y - min.y, max.z - min.z });
+	const float invExtent = extent > 0.0f ? 1.0f / extent : 0.0f;
+
+	std::vector<glm::vec3> normalizedPositions(vertexCount);
+
+	for (uint32 vertex = 0; vertex < vertexCount; vertex++)
+	{
+		normalizedPositions[vertex] = (positions[vertex] - min) * invExtent;
+	}
+
+	// Vertices at the same position are wedges of an attribute seam. Topology and quadrics are tracked on the first vertex at each
+	// position, and the wedges of a position are linked in a ring.
+	std::vector<uint32> canonicalVertices(vertexCount);
+	std::vector<uint32> nextWedges(vertexCount);
+	std::vector<uint32> numWedges(vertexCount, 0);
+	std::unordered_map<std::string_view, uint32> lastWedges;
+
+	for (uint32 vertex = 0; vertex < vertexCount; vertex++)
+	{
+		nextWedges[vertex] = vertex;
+
+		if (!isReferenced[vertex])
+		{
+			canonicalVertices[vertex] = vertex;
+			continue;
+		}
+
+		const std::string_view position(reinterpret_cast<const char*>(&positions[vertex]), sizeof(glm::vec3));
+		const auto [iter, isFirstWedge] = lastWedges.try_emplace(position, vertex);
+
+		canonicalVertices[vertex] = isFirstWedge ? vertex : canonicalVertices[iter->second];
+		numWedges[canonicalVertices[vertex]]++;
+
+		if (!isFirstWedge)
+		{
+			// Insert after the last wedge, which links back to the first.
+			nextWedges[vertex] = nextWedges[iter->second];
+			nextWedges[iter->second] = vertex;
+			iter->second = vertex;
+		}
+	}
+
+	auto getTrianglePosition = [&] (const std::vector<uint32>& triangleIndices, uint32 triangle, uint32 corner) -> const glm::vec3&
+	{
+		return normalizedPositions[canonicalVertices[triangleIndices[triangle * 3 + corner]]];
+	};
+
+	std::vector<Quadric> quadrics(vertexCount);
+
+	for (uint32 triangle = 0; triangle < indices.size() / 3; triangle++)
+	{
+		const glm::vec3& p0 = getTrianglePosition(indices, triangle, 0);
+		const glm::vec3 areaNormal = glm::cross(getTrianglePosition(indices, triangle, 1) - p0, getTrianglePosition(indices, triangle, 2) - p0);
+		const float length = glm::length(areaNormal);
+
+		if (length == 0.0f)
+		{
+			continue;
+		}
+
+		const glm::vec3 normal = areaNormal / length;
+		const Quadric quadric(normal, -glm::dot(normal, p0), length * 0.5f);
+
+		for (uint32 corner = 0; corner < 3; corner++)
+		{
+			quadrics[canonicalVertices[indices[triangle * 3 + corner]]] += quadric;
+		}
+	}
+
+	std::vector<uint32> result = indices;
+
+	// Sorted directed edges between positions, and between vertices. An edge without its twin is open: on a border if it's
+	// between positions, and on a border or seam if it's between vertices.
+	std::vector<uint64> positionEdges;
+	std::vector<uint64> vertexEdges;
+
+	std::vector<EVertexKind> kinds(vertexCount);
+	std::vector<uint32> numOpenEdgesOut(vertexCount);
+	std::vector<uint32> numOpenEdgesIn(vertexCount);
+	std::vector<uint32> adjacencyOffsets(vertexCount + 1);
+	std::vector<uint32> adjacency;
+	std::vector<uint32> collapseTargets(vertexCount);
+	std::vector<float> collapseCosts(vertexCount);
+	std::vector<uint32> collapseRemap(vertexCount);
+	std::vector<bool> isCollapseLocked(vertexCount);
+	std::vector<uint32> candidates;
+
+	std::iota(collapseRemap.begin(), collapseRemap.end(), 0);
+
+	// Collapses are done in passes. Each pass collapses the cheapest edges whose neighborhoods don't overlap, then rebuilds the topology.
+	for (bool isFirstPass = true; result.size() > targetIndexCount; isFirstPass = false)
+	{
+		const uint32 triangleCount = static_cast<uint32>(result.size() / 3);
+
+		positionEdges.clear();
+		vertexEdges.clear();
+
+		for (uint32 triangle = 0; triangle < triangleCount; triangle++)
+		{
+			for (uint32 corner = 0; corner < 3; corner++)
+			{
+				const uint32 a = result[triangle * 3 + corner];
+				const uint32 b = result[triangle * 3 + (corner + 1) % 3];
+
+				positionEdges.push_back(GetEdgeKey(canonicalVertices[a], canonicalVertices[b]));
+				vertexEdges.push_back(GetEdgeKey(a, b));
+			}
+		}
+
+		std::sort(positionEdges.begin(), positionEdges.end());
+		std::sort(vertexEdges.begin(), vertexEdges.end());
+
+		auto hasPositionEdge = [&] (uint32 a, uint32 b)
+		{
+			return std::binary_search(positionEdges.begin(), positionEdges.end(), GetEdgeKey(a, b));
+		};
+
+		auto hasVertexEdge = [&] (uint32 a, uint32 b)
+		{
+			return std::binary_search(vertexEdges.begin(), vertexEdges.end(), GetEdgeKey(a, b));
+		};
+
+		auto isOpenPositionEdge = [&] (uint32 a, uint32 b)
+		{
+			return !hasPositionEdge(b, a) || !hasPositionEdge(a, b);
+		};
+
+		auto isOpenVertexEdge = [&] (uint32 a, uint32 b)
+		{
+			return !hasVertexEdge(b, a) || !hasVertexEdge(a, b);
+		};
+
+		std::fill(kinds.begin(), kinds.end(), EVertexKind::Manifold);
+		std::fill(numOpenEdgesOut.begin(), numOpenEdgesOut.end(), 0);
+		std::fill(numOpenEdgesIn.begin(), numOpenEdgesIn.end(), 0);
+
+		for (std::size_t i = 0; i < positionEdges.size(); i++)
+		{
+			const uint32 a = static_cast<uint32>(positionEdges[i] >> 32);
+			const uint32 b = static_cast<uint32>(positionEdges[i]);
+
+			// Edges used by more than two triangles.
+			if (i + 1 < positionEdges.size() && positionEdges[i + 1] == positionEdges[i])
+			{
+				kinds[a] = EVertexKind::Locked;
+				kinds[b] = EVertexKind::Locked;
+			}
+			else if (!hasPositionEdge(b, a))
+			{
+				kinds[a] = kinds[a] == EVertexKind::Locked ? EVertexKind::Locked : EVertexKind::Border;
+				kinds[b] = kinds[b] == EVertexKind::Locked ? EVertexKind::Locked : EVertexKind::Border;
+			}
+		}
+
+		for (uint64 edge : vertexEdges)
+		{
+			const uint32 a = static_cast<uint32>(edge >> 32);
+			const uint32 b = static_cast<uint32>(edge);
+
+			if (!hasVertexEdge(b, a))
+			{
+				numOpenEdgesOut[a]++;
+				numOpenEdgesIn[b]++;
+			}
+		}
+
+		// A border or seam vertex has an open edge in and out of each wedge. Anything else is where borders or seams meet.
+		for (uint32 vertex = 0; vertex < vertexCount; vertex++)
+		{
+			if (!isReferenced[vertex] || canonicalVertices[vertex] != vertex || kinds[vertex] == EVertexKind::Locked)
+			{
+				continue;
+			}
+
+			bool isSimple = true;
+			uint32 wedge = vertex;
+
+			do
+			{
+				isSimple &= numOpenEdgesOut[wedge] == numOpenEdgesIn[wedge] && numOpenEdgesOut[wedge] <= 1;
+				wedge = nextWedges[wedge];
+			}
+			while (wedge != vertex);
+
+			if (kinds[vertex] == EVertexKind::Border)
+			{
+				kinds[vertex] = isSimple && numWedges[vertex] == 1 && numOpenEdgesOut[vertex] == 1 ? EVertexKind::Border : EVertexKind::Locked;
+			}
+			else if (numWedges[vertex] == 2)
+			{
+				kinds[vertex] = isSimple && numOpenEdgesOut[vertex] == 1 && numOpenEdgesOut[nextWedges[vertex]] == 1 ? EVertexKind::Seam : EVertexKind::Locked;
+			}
+			else if (numWedges[vertex] > 2)
+			{
+				kinds[vertex] = EVertexKind::Locked;
+			}
+		}
+
+		// Planes through border and seam edges, perpendicular to their triangles, keep collapses from pulling them in.
+		if (isFirstPass)
+		{
+			for (uint32 triangle = 0; triangle < triangleCount; triangle++)
+			{
+				const glm::vec3& p0 = getTrianglePosition(result, triangle, 0);
+				const glm::vec3 triangleNormal = glm::cross(getTrianglePosition(result, triangle, 1) - p0, getTrianglePosition(result, triangle, 2) - p0);
+
+				for (uint32 corner = 0; corner < 3; corner++)
+				{
+					const uint32 a = result[triangle * 3 + corner];
+					const uint32 b = result[triangle * 3 + (corner + 1) % 3];
+
+					if (hasVertexEdge(b, a))
+					{
+						continue;
+					}
+
+					const glm::vec3 edge = normalizedPositions[canonicalVertices[b]] - normalizedPositions[canonicalVertices[a]];
+					const glm::vec3 planeNormal = glm::cross(edge, triangleNormal);
+					const float length = glm::length(planeNormal);
+
+					if (length == 0.0f)
+					{
+						continue;
+					}
+
+					const glm::vec3 normal = planeNormal / length;
+					const Quadric quadric(normal, -glm::dot(normal, normalizedPositions[canonicalVertices[a]]), glm::dot(edge, edge) * borderWeight);
+
+					quadrics[canonicalVertices[a]] += quadric;
+					quadrics[canonicalVertices[b]] += quadric;
+				}
+			}
+		}
+
+		// Triangles around each vertex.
+		std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+
+		for (uint32 index : result)
+		{
+			adjacencyOffsets[index + 1]++;
+		}
+
+		std::partial_sum(adjacencyOffsets.begin(), adjacencyOffsets.end(), adjacencyOffsets.begin());
+
+		adjacency.resize(result.size());
+
+		{
+			std::vector<uint32> adjacencyCounts(vertexCount, 0);
+
+			for (uint32 triangle = 0; triangle < triangleCount; triangle++)
+			{
+				for (uint32 corner = 0; corner < 3; corner++)
+				{
+					const uint32 vertex = result[triangle * 3 + corner];
+					adjacency[adjacencyOffsets[vertex] + adjacencyCounts[vertex]++] = triangle;
+				}
+			}
+		}
+
+		// The wedge of the target's position that shares an edge with a vertex, other than the target itself. Used to carry
+		// the other side of a seam along with a seam collapse.
+		auto findOtherSideTarget = [&] (uint32 vertex, uint32 target) -> uint32
+		{
+			for (uint32 i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; i++)
+			{
+				for (uint32 corner = 0; corner < 3; corner++)
+				{
+					const uint32 neighbor = result[adjacency[i] * 3 + corner];
+
+					if (neighbor != target && canonicalVertices[neighbor] == canonicalVertices[target])
+					{
+						return neighbor;
+					}
+				}
+			}
+
+			return unusedVertex;
+		};
+
+		// The cheapest collapse of each vertex. Ties go to the lowest target so the result is deterministic.
+		std::fill(collapseCosts.begin(), collapseCosts.end(), std::numeric_limits<float>::max());
+
+		for (uint32 i = 0; i < result.size(); i++)
+		{
+			const uint32 triangle = i / 3;
+			const uint32 v0 = result[i];
+			const uint32 v1 = result[triangle * 3 + (i + 1) % 3];
+
+			for (const auto& [source, target] : { std::pair(v0, v1), std::pair(v1, v0) })
+			{
+				const uint32 canonicalSource = canonicalVertices[source];
+				const uint32 canonicalTarget = canonicalVertices[target];
+				const EVertexKind kind = kinds[canonicalSource];
+
+				if (canonicalSource == canonicalTarget ||
+					kind == EVertexKind::Locked ||
+					(kind == EVertexKind::Border && !isOpenPositionEdge(canonicalSource, canonicalTarget)) ||
+					(kind == EVertexKind::Seam && (!isOpenVertexEdge(source, target) || numWedges[canonicalTarget] < 2)))
+				{
+					continue;
+				}
+
+				const float cost = quadrics[canonicalSource].GetError(normalizedPositions[canonicalTarget]);
+
+				if (cost < collapseCosts[source] || (cost == collapseCosts[source] && target < collapseTargets[source]))
+				{
+					collapseCosts[source] = cost;
+					collapseTargets[source] = target;
+				}
+			}
+		}
+
+		candidates.clear();
+
+		for (uint32 vertex = 0; vertex < vertexCount; vertex++)
+		{
+			if (collapseCosts[vertex] < std::numeric_limits<float>::max())
+			{
+				candidates.push_back(vertex);
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end(), [&] (uint32 a, uint32 b)
+		{
+			return collapseCosts[a] < collapseCosts[b] || (collapseCosts[a] == collapseCosts[b] && a < b);
+		});
+
+		const uint32 numTrianglesToRemove = DivideAndRoundUp<uint32>(static_cast<uint32>(result.size()) - targetIndexCount, 3);
+
+		// Most collapses remove two triangles. Many are skipped because their neighborhoods overlap, so collapses up to a bit
+		// more than the cost of the collapse that would reach the target are allowed. Near the target, a few more candidates
+		// are considered so the last passes don't collapse one edge at a time.
+		const std::size_t goalCandidate = std::max<std::size_t>(numTrianglesToRemove / 2, 64);
+		const float maxCost = std::min(
+			goalCandidate < candidates.size() ? 1.5f * collapseCosts[candidates[goalCandidate]] : std::numeric_limits<float>::max(),
+			maxError * maxError
+		);
+
+		uint32 numRemovedTriangles = 0;
+		uint32 numCollapses = 0;
+
+		std::fill(isCollapseLocked.begin(), isCollapseLocked.end(), false);
+
+		// Check that moving a vertex to the target doesn't flip any of its triangles, and count the triangles that collapse.
+		auto isCollapseValid = [&] (uint32 source, uint32 target, uint32& numCollapsedTriangles)
+		{
+			const uint32 canonicalTarget = canonicalVertices[target];
+
+			for (uint32 i = adjacencyOffsets[source]; i < adjacencyOffsets[source + 1]; i++)
+			{
+				const uint32 triangle = adjacency[i];
+				std::array<glm::vec3, 3> trianglePositions;
+				bool hasTarget = false;
+
+				for (uint32 corner = 0; corner < 3; corner++)
+				{
+					trianglePositions[corner] = getTrianglePosition(result, triangle, corner);
+					hasTarget |= canonicalVertices[result[triangle * 3 + corner]] == canonicalTarget;
+				}
+
+				if (hasTarget)
+				{
+					numCollapsedTriangles++;
+					continue;
+				}
+
+				const glm::vec3 oldNormal = glm::cross(trianglePositions[1] - trianglePositions[0], trianglePositions[2] - trianglePositions[0]);
+
+				for (uint32 corner = 0; corner < 3; corner++)
+				{
+					if (result[triangle * 3 + corner] == source)
+					{
+						trianglePositions[corner] = normalizedPositions[canonicalTarget];
+					}
+				}
+
+				const glm::vec3 newNormal = glm::cross(trianglePositions[1] - trianglePositions[0], trianglePositions[2] - trianglePositions[0]);
+
+				if (glm::dot(oldNormal, newNormal) <= 0.0f)
+				{
+					return false;
+				}
+			}
+
+			return true;
+		};
+
+		// The triangles around a collapsed vertex change, so nothing else touching them collapses in this pass.
+		auto lockNeighborhood = [&] (uint32 vertex)
+		{
+			for (uint32 i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; i++)
+			{
+				for (uint32 corner = 0; corner < 3; corner++)
+				{
+					isCollapseLocked[canonicalVertices[result[adjacency[i] * 3 + corner]]] = true;
+				}
+			}
+		};
+
+		for (uint32 source : candidates)
+		{
+			if (numRemovedTriangles >= numTrianglesToRemove ||
+				collapseCosts[source] > maxError * maxError ||
+				(collapseCosts[source] > maxCost && numRemovedTriangles > numTrianglesToRemove / 10))
+			{
+				break;
+			}
+
+			const uint32 target = collapseTargets[source];
+			const uint32 canonicalSource = canonicalVertices[source];
+			const uint32 canonicalTarget = canonicalVertices[target];
+
+			if (isCollapseLocked[canonicalSource] || isCollapseLocked[canonicalTarget])
+			{
+				continue;
+			}
+
+			uint32 numCollapsedTriangles = 0;
+
+			if (!isCollapseValid(source, target, numCollapsedTriangles))
+			{
+				continue;
+			}
+
+			// Seam vertices collapse on both sides of the seam, each onto the target's wedge on its side.
+			if (kinds[canonicalSource] == EVertexKind::Seam)
+			{
+				const uint32 otherSource = nextWedges[source];
+				const uint32 otherTarget = findOtherSideTarget(otherSource, target);
+
+				if (otherTarget == unusedVertex || !isCollapseValid(otherSource, otherTarget, numCollapsedTriangles))
+				{
+					continue;
+				}
+
+				collapseRemap[otherSource] = otherTarget;
+				lockNeighborhood(otherSource);
+			}
+
+			collapseRemap[source] = target;
+			quadrics[canonicalTarget] += quadrics[canonicalSource];
+			error = std::max(error, collapseCosts[source]);
+
+			lockNeighborhood(source);
+			isCollapseLocked[canonicalTarget] = true;
+
+			// Triangles along the edge are counted once from each side of a seam.
+			numRemovedTriangles += kinds[canonicalSource] == EVertexKind::Seam ? numCollapsedTriangles / 2 + numCollapsedTriangles % 2 : numCollapsedTriangles;
+			numCollapses++;
+		}
+
+		if (numCollapses == 0)
+		{
+			break;
+		}
+
+		// Collapsed triangles are degenerate, and removed.
+		uint32 numIndices = 0;
+
+		for (uint32 triangle = 0; triangle < triangleCount; triangle++)
+		{
+			const uint32 i0 = collapseRemap[result[triangle * 3 + 0]];
+			const uint32 i1 = collapseRemap[result[triangle * 3 + 1]];
+			const uint32 i2 = collapseRemap[result[triangle * 3 + 2]];
+
+			if (i0 != i1 && i1 != i2 && i2 != i0)
+			{
+				result[numIndices++] = i0;
+				result[numIndices++] = i1;
+				result[numIndices++] = i2;
+			}
+		}
+
+		result.resize(numIndices);
+	}
+
+	error = std::sqrt(error) * extent;
+
+	return result;
+}
+
+std::vector<MeshOptimizer::Meshlet> MeshOptimizer::BuildMeshlets(
+	const std::vector<uint32>& indices,
+	uint32 firstIndex,
+	uint32 indexCount,
+	uint32 vertexCount,
+	uint32 maxVertices,
+	uint32 maxTriangles)
+{
+	std::vector<Meshlet> meshlets;
+
+	// The meshlet each vertex was last added to, so vertices shared by its triangles are counted once.
+	std::vector<uint32> vertexMeshlets(vertexCount, unusedVertex);
+
+	Meshlet meshlet = { firstIndex, 0, 0 };
+
+	for (uint32 i = firstIndex; i < firstIndex + indexCount; i += 3)
+	{
+		const uint32 a = indices[i + 0];
+		const uint32 b = indices[i + 1];
+		const uint32 c = indices[i + 2];
+
+		auto isNew = [&] (uint32 vertex)
+		{
+			return vertexMeshlets[vertex] != static_cast<uint32>(meshlets.size());
+		};
+
+		const uint32 numNewVertices = (isNew(a) ? 1 : 0) + (isNew(b) && b != a ? 1 : 0) + (isNew(c) && c != a && c != b ? 1 : 0);
+
+		if (meshlet.vertexCount + numNewVertices > maxVertices || meshlet.indexCount / 3 == maxTriangles)
+		{
+			meshlets.push_back(meshlet);
+			meshlet = { i, 0, 0 };
+		}
+
+		for (uint32 vertex : { a, b, c })
+		{
+			if (isNew(vertex))
+			{
+				vertexMeshlets[vertex] = static_cast<uint32>(meshlets.size());
+				meshlet.vertexCount++;
+			}
+		}
+
+		meshlet.indexCount += 3;
+	}
+
+	if (meshlet.indexCount > 0)
+	{
+		meshlets.push_back(meshlet);
+	}
+
+	return meshlets;
+}
+
+MeshOptimizer::MeshletBounds MeshOptimizer::ComputeMeshletBounds(const std::vector<uint32>& indices, const Meshlet& meshlet, const std::vector<glm::vec3>& positions)
+{
+	glm::vec3 min(std::numeric_limits<float>::max());
+	glm::vec3 max(std::numeric_limits<float>::lowest());
+
+	for (uint32 i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++)
+	{
+		min = glm::min(min, positions[indices[i]]);
+		max = glm::max(max, positions[indices[i]]);
+	}
+
+	MeshletBounds bounds = {};
+	bounds.center = (min + max) * 0.5f;
+
+	for (uint32 i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++)
+	{
+		bounds.radius = std::max(bounds.radius, glm::distance(bounds.center, positions[indices[i]]));
+	}
+
+	std::vector<glm::vec3> normals;
+	normals.reserve(meshlet.indexCount / 3);
+
+	glm::vec3 normalSum(0.0f);
+
+	for (uint32 i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i += 3)
+	{
+		const glm::vec3& p0 = positions[indices[i + 0]];
+		const glm::vec3 normal = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+		const float length = glm::length(normal);
+
+		// Degenerate triangles aren't rasterized, so they don't widen the cone.
+		if (length > 0.0f)
+		{
+			normals.push_back(normal / length);
+			normalSum += normals.back();
+		}
+	}
+
+	bounds.coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+	bounds.coneCutoff = 1.0f;
+
+	const float normalSumLength = glm::length(normalSum);
+
+	if (normals.empty() || normalSumLength < 1e-6f)
+	{
+		return bounds;
+	}
+
+	bounds.coneAxis = normalSum / normalSumLength;
+
+	float minDot = 1.0f;
+
+	for (const glm::vec3& normal : normals)
+	{
+		minDot = std::min(minDot, glm::dot(normal, bounds.coneAxis));
+	}
+
+	// Cones of 90 degrees or wider have a triangle facing every viewpoint.
+	if (minDot > 0.0f)
+	{
+		bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+	}
+
+	return bounds;
+}
+
+uint32 MeshOptimizer::OptimizeVertexFetch(std::vector<uint32>& indices, std::vector<uint32>& remap, uint32 vertexCount)
+{
+	remap.assign(vertexCount, unusedVertex);
+
+	uint32 numUsedVertices = 0;
+
+	for (uint32& index : indices)
+	{
+		if (remap[index] == unusedVertex)
+		{
+			remap[index] = numUsedVertices++;
+		}
+
+		index = remap[index];
+	}
+
+	return numUsedVertices;
+}
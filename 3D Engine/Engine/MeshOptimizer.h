@@ -0,0 +1,97 @@
+#pragma once
+#include <Platform/Platform.h>
+
+/**
+  * Reorders triangle lists at import so they're drawn with fewer vertex shader invocations and less overdraw.
+  * Everything runs on the CPU and is deterministic, so the same source always cooks to the same mesh.
+  * Marks unused vertices in remaps with unusedVertex.
+  */
+class MeshOptimizer
+{
+public:
+	static constexpr uint32 unusedVertex = std::numeric_limits<uint32>::max();
+
+	/** Post-transform cache misses of an index buffer. */
+	struct VertexCacheStats
+	{
+		uint32 numTriangles = 0;
+		uint32 numVertices = 0;
+		uint32 numMisses = 0;
+
+		/** Average cache miss ratio: vertices transformed per triangle. 0.5 is ideal for large grids, and 3 is the worst. */
+		inline float GetACMR() const { return numTriangles > 0 ? static_cast<float>(numMisses) / numTriangles : 0.0f; }
+
+		/** Average transform to vertex ratio: vertices transformed per vertex referenced. 1 is ideal. */
+		inline float GetATVR() const { return numVertices > 0 ? static_cast<float>(numMisses) / numVertices : 0.0f; }
+
+		VertexCacheStats& operator+=(const VertexCacheStats& other);
+	};
+
+	/** Simulate a FIFO post-transform cache. Sixteen entries is about what GPUs have for the vertices we draw. */
+	static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32>& indices, uint32 vertexCount, uint32 cacheSize = 16);
+
+	/** Weld vertices with identical bytes. Returns the number of unique vertices, and the remap from each vertex to its unique vertex. */
+	static uint32 GenerateVertexRemap(std::vector<uint32>& remap, const uint8* vertices, uint32 vertexCount, uint32 vertexSize);
+
+	static void RemapIndices(std::vector<uint32>& indices, const std::vector<uint32>& remap);
+
+	/** Copy vertices to where the remap moves them. Vertices mapped to the same place must be identical. */
+	static void RemapVertices(uint8* dst, const uint8* src, uint32 vertexCount, uint32 vertexSize, const std::vector<uint32>& remap);
+
+	/**
+	  * Reorder triangles so vertices are reused while they're in the post-transform cache.
+	  * Reference: Tom Forsyth, "Linear-Speed Vertex Cache Optimisation"
+	  */
+	static void OptimizeVertexCache(std::vector<uint32>& indices, uint32 vertexCount);
+
+	/**
+	  * Split cache-optimized triangles into clusters, and draw the clusters that face away from the center first so they occlude the rest.
+	  * Clusters are split where the cache was flushed anyway, and where the cluster's ACMR is within the threshold of its whole run's.
+	  * Splits reset the cache, so a higher threshold trades vertex cache hits for finer sorting.
+	  * Reference: Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw"
+	  */
+	static void OptimizeOverdraw(std::vector<uint32>& indices, const std::vector<glm::vec3>& positions, float threshold = 1.0f);
+
+	/**
+	  * Collapse edges in order of quadric error until there are at most the target number of indices, or the next collapse would
+	  * cost more than the max error, relative to the mesh's extent. Border vertices slide along their border and seam vertices along
+	  * their seam, taking the wedges on both sides with them. Vertices where borders or seams meet, or on non-manifold edges, are
+	  * locked. Sets the error to the largest collapse error, as a distance in position units.
+	  * Reference: Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics"
+	  */
+	static std::vector<uint32> Simplify(const std::vector<uint32>& indices, const std::vector<glm::vec3>& positions, uint32 targetIndexCount, float maxError, float& error);
+
+	/** A run of consecutive triangles of an index buffer that's culled as a whole. */
+	struct Meshlet
+	{
+		uint32 firstIndex;
+		uint32 indexCount;
+		uint32 vertexCount;
+	};
+
+	/** Bounding sphere and normal cone of a meshlet. */
+	struct MeshletBounds
+	{
+		glm::vec3 center;
+		float radius;
+		glm::vec3 coneAxis;
+		/** Sine of the cone's half angle. 1 if the cone is too wide to cull. */
+		float coneCutoff;
+	};
+
+	/**
+	  * Split a range of an index buffer into meshlets of at most maxVertices unique vertices and maxTriangles triangles.
+	  * Meshlets are runs of consecutive triangles, so the index buffer is drawn as is. Cache-optimized triangles are local, so the runs are compact.
+	  * The defaults are what mesh shading hardware is built around: 64 vertices, and 124 triangles so the primitive indices fit in 372 bytes.
+	  */
+	static std::vector<Meshlet> BuildMeshlets(const std::vector<uint32>& indices, uint32 firstIndex, uint32 indexCount, uint32 vertexCount, uint32 maxVertices = 64, uint32 maxTriangles = 124);
+
+	/**
+	  * Compute a meshlet's bounding sphere and the cone around its triangle normals. Every triangle faces away from a viewpoint v if
+	  * dot(center - v, coneAxis) >= coneCutoff * length(center - v) + radius.
+	  */
+	static MeshletBounds ComputeMeshletBounds(const std::vector<uint32>& indices, const Meshlet& meshlet, const std::vector<glm::vec3>& positions);
+
+	/** Number vertices in the order they're first used, so they're fetched in order. Returns the number of used vertices. */
+	static uint32 OptimizeVertexFetch(std::vector<uint32>& indices, std::vector<uint32>& remap, uint32 vertexCount);
+};
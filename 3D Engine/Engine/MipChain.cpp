@@ -0,0 +1,103 @@
+#include "MipChain.h"
+#include <algorithm>
+
+static constexpr uint32 numChannels = 4;
+
+static const std::array<float, 256> gSRGBToLinear = [] ()
+{
+	std::array<float, 256> table;
+
+	for (uint32 i = 0; i < table.size(); i++)
+	{
+		const float srgb = i / 255.0f;
+		table[i] = srgb <= 0.04045f ? srgb / 12.92f : std::pow((srgb + 0.055f) / 1.055f, 2.4f);
+	}
+
+	return table;
+}();
+
+static uint8 LinearToSRGB(float linear)
+{
+	const float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+	return static_cast<uint8>(std::clamp(srgb * 255.0f + 0.5f, 0.0f, 255.0f));
+}
+
+uint32 MipChain::GetNumMips(uint32 width, uint32 height)
+{
+	uint32 numMips = 1;
+
+	while ((std::max(width, height) >> numMips) > 0)
+	{
+		numMips++;
+	}
+
+	return numMips;
+}
+
+std::size_t MipChain::GetMipOffset(uint32 mip) const
+{
+	std::size_t offset = 0;
+
+	for (uint32 i = 0; i < mip; i++)
+	{
+		offset += std::max(_Width >> i, 1u) * std::max(_Height >> i, 1u) * numChannels;
+	}
+
+	return offset;
+}
+
+MipChain::MipChain(const uint8* pixels, uint32 width, uint32 height, bool isSRGB)
+	: _Width(width)
+	, _Height(height)
+	, _NumMips(GetNumMips(width, height))
+{
+	_Data.resize(GetMipOffset(_NumMips));
+
+	Platform::Memcpy(_Data.data(), pixels, width * height * numChannels);
+
+	const uint8* src = _Data.data();
+	uint8* dst = _Data.data() + width * height * numChannels;
+	uint32 srcWidth = width;
+	uint32 srcHeight = height;
+
+	for (uint32 mip = 1; mip < _NumMips; mip++)
+	{
+		const uint32 dstWidth = std::max(srcWidth / 2, 1u);
+		const uint32 dstHeight = std::max(srcHeight / 2, 1u);
+
+		for (uint32 y = 0; y < dstHeight; y++)
+		{
+			// Odd texels at the edge of a non-power-of-two mip are clamped.
+			const uint8* row0 = src + std::min(2 * y, srcHeight - 1) * srcWidth * numChannels;
+			const uint8* row1 = src + std::min(2 * y + 1, srcHeight - 1) * srcWidth * numChannels;
+
+			for (uint32 x = 0; x < dstWidth; x++)
+			{
+				const uint32 x0 = std::min(2 * x, srcWidth - 1) * numChannels;
+				const uint32 x1 = std::min(2 * x + 1, srcWidth - 1) * numChannels;
+
+				for (uint32 channel = 0; channel < numChannels; channel++)
+				{
+					const uint8 texels[] = { row0[x0 + channel], row0[x1 + channel], row1[x0 + channel], row1[x1 + channel] };
+
+					if (isSRGB && channel < 3)
+					{
+						const float linear =
+							(gSRGBToLinear[texels[0]] + gSRGBToLinear[texels[1]] + gSRGBToLinear[texels[2]] + gSRGBToLinear[texels[3]]) * 0.25f;
+						dst[channel] = LinearToSRGB(linear);
+					}
+					else
+					{
+						dst[channel] = static_cast<uint8>((texels[0] + texels[1] + texels[2] + texels[3] + 2) / 4);
+					}
+				}
+
+				dst += numChannels;
+			}
+		}
+
+		src += srcWidth * srcHeight * numChannels;
+		srcWidth = dstWidth;
+		srcHeight = dstHeight;
+	}
+}
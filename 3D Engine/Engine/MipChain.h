@@ -0,0 +1,31 @@
+#pragma once
+#include <Platform/Platform.h>
+
+/** Mip chain of an RGBA8 image, generated at import with a box filter. Mips are packed from the largest to the smallest. */
+class MipChain
+{
+public:
+	/**
+	  * Build the chain down to 1x1 from the top mip, given as RGBA8. Convert other formats first, e.g. with Platform::DecodeImage().
+	  * sRGB-encoded color is filtered in linear space. Alpha is always linear.
+	  */
+	MipChain(const uint8* pixels, uint32 width, uint32 height, bool isSRGB);
+
+	inline uint32 GetWidth() const { return _Width; }
+	inline uint32 GetHeight() const { return _Height; }
+	inline uint32 GetNumMips() const { return _NumMips; }
+	inline const uint8* GetData() const { return _Data.data(); }
+	inline std::size_t GetSize() const { return _Data.size(); }
+
+	/** Offset of a mip in the packed data. The mips from there on form the chain of an image starting at that mip. */
+	std::size_t GetMipOffset(uint32 mip) const;
+
+	/** Number of mips in a full chain. */
+	static uint32 GetNumMips(uint32 width, uint32 height);
+
+private:
+	std::vector<uint8> _Data;
+	uint32 _Width;
+	uint32 _Height;
+	uint32 _NumMips;
+};
@@ -18,12 +18,15 @@ const std::string Skybox::_CubemapStems[6] = {
 	"nz",
 };
 
-Skybox::Skybox(gpu::Device& device, const std::array<gpu::Image*, 6>& images, EFormat format)
+Skybox::Skybox(gpu::Device& device, const std::array<gpu::Image*, 6>& images, EFormat format, gpu::UploadTicket uploadTicket)
 	: _Images(images)
 {
 	_Image = device.CreateImage(_Images.front()->GetWidth(), _Images.front()->GetHeight(), 1, format, EImageUsage::Sampled | EImageUsage::Cubemap | EImageUsage::TransferDst);
 
-	gpu::CommandBuffer cmdBuf = device.CreateCommandBuffer(EQueue::Transfer);
+	// Uploaded faces are owned by the graphics queue, so the copy is too.
+	device.WaitForUpload(uploadTicket);
+
+	gpu::CommandBuffer cmdBuf = device.CreateCommandBuffer(EQueue::Graphics);
 
 	std::vector<ImageMemoryBarrier> srcImageBarriers;
 	srcImageBarriers.reserve(_Images.size());
@@ -34,7 +37,7 @@ Skybox::Skybox(gpu::Device& device, const std::array<gpu::Image*, 6>& images, EF
 			*srcImage,
 			EAccess::None,
 			EAccess::TransferRead,
-			EImageLayout::Undefined,
+			EImageLayout::ShaderReadOnlyOptimal,
 			EImageLayout::TransferSrcOptimal
 		});
 	}
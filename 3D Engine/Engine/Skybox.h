@@ -16,7 +16,8 @@ enum CubemapFace
 class Skybox
 {
 public:
-	Skybox(gpu::Device& device, const std::array<gpu::Image*, 6>& images, EFormat format);
+	/** Copies the faces into a cubemap once their upload has completed. */
+	Skybox(gpu::Device& device, const std::array<gpu::Image*, 6>& images, EFormat format, gpu::UploadTicket uploadTicket);
 	
 	inline gpu::Image& GetImage() { return _Image; }
 	inline std::array<gpu::Image*, 6>& GetFaces() { return _Images; }
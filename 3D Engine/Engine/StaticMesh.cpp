@@ -1,10 +1,7 @@
 #include "StaticMesh.h"
 #include "AssetManager.h"
-#define TINYGLTF_IMPLEMENTATION
-#define STB_IMAGE_IMPLEMENTATION
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#define STBI_MSC_SECURE_CRT
-#include <tiny_gltf.h>
+#include "MeshCooker.h"
+#include <chrono>
 
 StaticMesh::StaticMesh(const std::string& assetName, AssetManager& assets, gpu::Device& device, const std::filesystem::path& path)
 	: _Name(assetName)
@@ -12,7 +9,26 @@ StaticMesh::StaticMesh(const std::string& assetName, AssetManager& assets, gpu::
 {
 	if (_Path.extension() == ".gltf" || _Path.extension() == ".glb")
 	{
-		GLTFLoad(assetName, assets, device);
+		const auto startTime = std::chrono::high_resolution_clock::now();
+
+		std::unique_ptr<CookedMesh> cookedMesh = MeshCooker::Load(_Path);
+		std::vector<const Material*> materials;
+
+		// Cooked textures are cached separately from the mesh. If one is missing, the mesh is cooked again, which cooks its textures.
+		if (!LoadMaterials(assetName, assets, *cookedMesh, device, materials))
+		{
+			cookedMesh = MeshCooker::Load(_Path, true);
+
+			const bool isLoaded = LoadMaterials(assetName, assets, *cookedMesh, device, materials);
+
+			check(isLoaded, "Failed to load the cooked textures of %s.", _Path.generic_string().c_str());
+		}
+
+		LoadSubmeshes(*cookedMesh, materials, device);
+
+		const float loadMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+		LOG("Loaded %s in %.1f ms.", _Path.generic_string().c_str(), loadMs);
 	}
 	else
 	{
@@ -37,203 +53,147 @@ StaticMesh::StaticMesh(const std::string& assetName, StaticMesh& staticMesh, uin
 	_Submeshes.emplace_back(std::move(staticMesh._Submeshes[submeshIndex]));
 }
 
-tinygltf::TinyGLTF gLoader;
-
-void StaticMesh::GLTFLoad(const std::string& assetName, AssetManager& assets, gpu::Device& device)
+void StaticMesh::LoadSubmeshes(const CookedMesh& cookedMesh, const std::vector<const Material*>& materials, gpu::Device& device)
 {
-	tinygltf::Model model;
-	std::string err;
-	std::string warn;
-
-	if (_Path.extension() == ".gltf")
+	for (uint32 submeshIndex = 0; submeshIndex < cookedMesh.GetNumSubmeshes(); submeshIndex++)
 	{
-		gLoader.LoadASCIIFromFile(&model, &err, &warn, _Path.generic_string());
-	}
-	else
-	{
-		gLoader.LoadBinaryFromFile(&model, &err, &warn, _Path.generic_string());
-	}
+		const CookedSubmesh& submesh = cookedMesh.GetSubmesh(submeshIndex);
 
-	if (!err.empty())
-	{
-		LOG("TinyGLTF error: %s", err.c_str());
-	}
-	if (!warn.empty())
-	{
-		LOG("TinyGLTF warning: %s", warn.c_str());
-	}
+		gpu::Buffer indexBuffer = device.CreateBuffer(EBufferUsage::Index, EMemoryUsage::GPU_ONLY, submesh.indices.size);
 
-	for (auto& mesh : model.meshes)
-	{
-		for (auto& primitive : mesh.primitives)
+		// Copied to staging straight from the mapped file, then on the transfer queue in the background.
+		// Surfaces wait for the copies when they're first drawn.
+		gpu::UploadTicket uploadTicket = device.UploadBufferData(indexBuffer, 0, submesh.indices.size, cookedMesh.GetData(submesh.indices));
+
+		std::array<gpu::Buffer, numVertexAttributes> vertexBuffers;
+
+		for (uint32 stream = 0; stream < submesh.vertexLayout.GetNumStreams(); stream++)
 		{
-			GLTFLoadGeometry(model, mesh, primitive, device);
-			GLTFLoadMaterial(assetName, assets, model, primitive, device);
-			_SubmeshNames.push_back(mesh.name);
+			const CookedRange& vertexStream = submesh.vertexStreams[stream];
+
+			vertexBuffers[stream] = device.CreateBuffer(EBufferUsage::Vertex, EMemoryUsage::GPU_ONLY, vertexStream.size);
+
+			uploadTicket = std::max(uploadTicket, device.UploadBufferData(vertexBuffers[stream], 0, vertexStream.size, cookedMesh.GetData(vertexStream)));
 		}
+
+		std::vector<SubmeshLOD> lods;
+		lods.reserve(submesh.numLODs);
+
+		for (uint32 lodIndex = 0; lodIndex < submesh.numLODs; lodIndex++)
+		{
+			const CookedLOD& lod = submesh.lods[lodIndex];
+			lods.push_back({ lod.firstIndex, lod.indexCount, lod.error, lod.firstMeshlet, lod.numMeshlets });
+		}
+
+		static_assert(sizeof(SubmeshMeshlet) == sizeof(CookedMeshlet));
+
+		const uint32 numMeshlets = static_cast<uint32>(submesh.meshlets.size / sizeof(CookedMeshlet));
+		std::vector<SubmeshMeshlet> meshlets(numMeshlets);
+
+		Platform::Memcpy(meshlets.data(), cookedMesh.GetData(submesh.meshlets), submesh.meshlets.size);
+
+		_Submeshes.emplace_back(Submesh(
+			std::move(lods)
+			, std::move(meshlets)
+			, submesh.indexType
+			, std::move(indexBuffer)
+			, std::move(vertexBuffers)
+			, submesh.vertexLayout
+			, submesh.dequantization
+			, uploadTicket
+		));
+
+		_Materials.push_back(materials[submesh.materialIndex]);
+		_SubmeshBounds.push_back(BoundingBox(submesh.min, submesh.max));
+		_SubmeshNames.push_back(cookedMesh.GetString(submesh.name));
 	}
 }
 
-void StaticMesh::GLTFLoadGeometry(tinygltf::Model& model, tinygltf::Mesh& Mesh, tinygltf::Primitive& Primitive, gpu::Device& device)
+bool StaticMesh::LoadMaterials(const std::string& assetName, AssetManager& assets, const CookedMesh& cookedMesh, gpu::Device& device, std::vector<const Material*>& materials)
 {
-	auto& indexAccessor = model.accessors[Primitive.indices];
-	auto& positionAccessor = model.accessors[Primitive.attributes["POSITION"]];
-	auto& normalAccessor = model.accessors[Primitive.attributes["NORMAL"]];
-	auto& uvAccessor = model.accessors[Primitive.attributes["TEXCOORD_0"]];
-
-	auto& indexView = model.bufferViews[indexAccessor.bufferView];
-	auto& positionView = model.bufferViews[positionAccessor.bufferView];
-	auto& normalView = model.bufferViews[normalAccessor.bufferView];
-	auto& uvView = model.bufferViews[uvAccessor.bufferView];
-
-	auto& indexData = model.buffers[indexView.buffer];
-	auto& positionData = model.buffers[positionView.buffer];
-	auto& normalData = model.buffers[normalView.buffer];
-	auto& uvData = model.buffers[uvView.buffer];
-	
-	gpu::Buffer indexBuffer = device.CreateBuffer(EBufferUsage::Index, EMemoryUsage::GPU_ONLY, indexView.byteLength);
-	gpu::Buffer positionBuffer = device.CreateBuffer(EBufferUsage::Vertex, EMemoryUsage::GPU_ONLY, positionView.byteLength);
-	gpu::Buffer textureCoordinateBuffer = device.CreateBuffer(EBufferUsage::Vertex, EMemoryUsage::GPU_ONLY, uvView.byteLength);
-	gpu::Buffer normalBuffer = device.CreateBuffer(EBufferUsage::Vertex, EMemoryUsage::GPU_ONLY, normalView.byteLength);
-
-	gpu::CommandBuffer cmdBuf = device.CreateCommandBuffer(EQueue::Transfer);
-
-	uint64 srcOffset = 0;
-
-	auto stagingBuffer = cmdBuf.CreateStagingBuffer(indexView.byteLength + positionView.byteLength + uvView.byteLength + normalView.byteLength);
-
-	uint8* data = static_cast<uint8*>(stagingBuffer->GetData());
-
-	Platform::Memcpy(data, indexData.data.data() + indexView.byteOffset, indexView.byteLength);
-	cmdBuf.CopyBuffer(*stagingBuffer, indexBuffer, srcOffset, 0, indexView.byteLength);
-	data += indexView.byteLength;
-	srcOffset += indexView.byteLength;
-
-	Platform::Memcpy(data, positionData.data.data() + positionView.byteOffset, positionView.byteLength);
-	cmdBuf.CopyBuffer(*stagingBuffer, positionBuffer, srcOffset, 0, positionView.byteLength);
-	data += positionView.byteLength;
-	srcOffset += positionView.byteLength;
-
-	Platform::Memcpy(data, uvData.data.data() + uvView.byteOffset, uvView.byteLength);
-	cmdBuf.CopyBuffer(*stagingBuffer, textureCoordinateBuffer, srcOffset, 0, uvView.byteLength);
-	data += uvView.byteLength;
-	srcOffset += uvView.byteLength;
-
-	Platform::Memcpy(data, normalData.data.data() + normalView.byteOffset, normalView.byteLength);
-	cmdBuf.CopyBuffer(*stagingBuffer, normalBuffer, srcOffset, 0, normalView.byteLength);
-	data += normalView.byteLength;
-	srcOffset += normalView.byteLength;
-
-	device.SubmitCommands(cmdBuf);
-
-	_Submeshes.emplace_back(Submesh(
-		static_cast<uint32>(indexAccessor.count)
-		, tinygltf::GetComponentSizeInBytes(indexAccessor.componentType) == 2 ? EIndexType::UINT16 : EIndexType::UINT32
-		, std::move(indexBuffer)
-		, std::move(positionBuffer)
-		, std::move(textureCoordinateBuffer)
-		, std::move(normalBuffer)
-	));
-
-	const glm::vec3 min(positionAccessor.minValues[0], positionAccessor.minValues[1], positionAccessor.minValues[2]);
-	const glm::vec3 max(positionAccessor.maxValues[0], positionAccessor.maxValues[1], positionAccessor.maxValues[2]);
-
-	_SubmeshBounds.push_back(BoundingBox(min, max));
-}
+	materials.resize(cookedMesh.GetNumMaterials());
 
-void StaticMesh::GLTFLoadMaterial(const std::string& assetName, AssetManager& assets, tinygltf::Model& model, tinygltf::Primitive& primitive, gpu::Device& device)
-{
-	auto& gltfMaterial = model.materials[primitive.material];
-	const EMaterialMode materialMode = [] (const std::string& alphaMode)
+	for (uint32 materialIndex = 0; materialIndex < cookedMesh.GetNumMaterials(); materialIndex++)
 	{
-		if (alphaMode == "MASK")
-		{
-			return EMaterialMode::Masked;
-		}
-		else
+		const std::string materialAssetName = assetName + "_Material_" + std::to_string(materialIndex);
+
+		if (const Material* material = assets.GetMaterial(materialAssetName); material)
 		{
-			return EMaterialMode::Opaque;
+			materials[materialIndex] = material;
+			continue;
 		}
-	}(gltfMaterial.alphaMode);
-	const std::string materialAssetName = assetName + "_Material_" + std::to_string(primitive.material);
-	const Material* material = assets.GetMaterial(materialAssetName);
 
-	if (!material)
-	{
-		gpu::Image* baseColor = GLTFLoadImage(assets, device, model, gltfMaterial.pbrMetallicRoughness.baseColorTexture.index);
-		gpu::Image* metallicRoughness = GLTFLoadImage(assets, device, model, gltfMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index);
-		gpu::Image* normal = GLTFLoadImage(assets, device, model, gltfMaterial.normalTexture.index);
-		gpu::Image* emissive = GLTFLoadImage(assets, device, model, gltfMaterial.emissiveTexture.index);
-		const glm::vec3 emissiveFactor = 
-			gltfMaterial.emissiveFactor.empty() ? 
-			glm::vec3(0.0) : 
-			glm::vec3(static_cast<float>(gltfMaterial.emissiveFactor[0]),
-			static_cast<float>(gltfMaterial.emissiveFactor[1]),
-			static_cast<float>(gltfMaterial.emissiveFactor[2]));
-
-		if (!baseColor)
+		const CookedMaterial& cookedMaterial = cookedMesh.GetMaterial(materialIndex);
+
+		StreamedTexture* baseColor;
+		StreamedTexture* metallicRoughness;
+		StreamedTexture* normal;
+		StreamedTexture* emissive;
+
+		if (!LoadTexture(assets, cookedMesh, device, cookedMaterial.baseColor, baseColor) ||
+			!LoadTexture(assets, cookedMesh, device, cookedMaterial.metallicRoughness, metallicRoughness) ||
+			!LoadTexture(assets, cookedMesh, device, cookedMaterial.normal, normal) ||
+			!LoadTexture(assets, cookedMesh, device, cookedMaterial.emissive, emissive))
 		{
-			baseColor = &AssetManager::_Red;
+			return false;
 		}
 
-		material = assets.LoadMaterial(
+		// Streamed textures are drawn with their mip tail until finer mips are streamed in.
+		const gpu::UploadTicket uploadTicket = std::max({
+			baseColor ? baseColor->GetUploadTicket() : assets.GetUploadTicket(&AssetManager::_Red),
+			metallicRoughness ? metallicRoughness->GetUploadTicket() : 0,
+			normal ? normal->GetUploadTicket() : 0,
+			emissive ? emissive->GetUploadTicket() : 0,
+		});
+
+		materials[materialIndex] = assets.LoadMaterial(
 			materialAssetName,
 			std::make_unique<Material>
 			(
 				device,
-				materialMode,
+				cookedMaterial.mode,
 				baseColor,
 				metallicRoughness,
 				normal,
 				emissive,
-				static_cast<float>(gltfMaterial.pbrMetallicRoughness.roughnessFactor),
-				static_cast<float>(gltfMaterial.pbrMetallicRoughness.metallicFactor),
-				emissiveFactor
+				cookedMaterial.metallic,
+				cookedMaterial.roughness,
+				cookedMaterial.emissiveFactor,
+				uploadTicket
 			)
 		);
 	}
 
-	_Materials.push_back(material);
+	return true;
 }
 
-static EFormat GetFormat(int32 bits, int32 components, int32 pixelType)
+bool StaticMesh::LoadTexture(AssetManager& assets, const CookedMesh& cookedMesh, gpu::Device& device, int32 textureIndex, StreamedTexture*& texture)
 {
-	if (pixelType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE && bits == 8 && components == 4)
+	texture = nullptr;
+
+	if (textureIndex == -1)
 	{
-		return EFormat::R8G8B8A8_UNORM;
+		return true;
 	}
-	else
+
+	const CookedTextureRef& textureRef = cookedMesh.GetTexture(textureIndex);
+	const std::string textureName = cookedMesh.GetString(textureRef.name);
+	TextureStreamer& textureStreamer = assets.GetTextureStreamer();
+
+	if (StreamedTexture* loadedTexture = textureStreamer.GetTexture(textureName); loadedTexture)
 	{
-		signal_unimplemented();
+		texture = loadedTexture;
+		return true;
 	}
-}
 
-gpu::Image* StaticMesh::GLTFLoadImage(AssetManager& assets, gpu::Device& device, tinygltf::Model& model, int32 textureIndex)
-{
-	if (textureIndex == -1 || model.textures.empty())
+	std::unique_ptr<CookedTexture> cookedTexture = TextureCooker::LoadCached(cookedMesh.GetString(textureRef.sourcePath), textureName, textureRef.content);
+
+	if (!cookedTexture)
 	{
-		return nullptr;
+		return false;
 	}
-	else
-	{
-		auto& texture = model.textures[textureIndex];
-		auto& image = model.images[texture.source];
 
-		if (gpu::Image* loadedImage = assets.GetImage(image.uri); loadedImage != nullptr)
-		{
-			return loadedImage;
-		}
-		else
-		{
-#undef LoadImage
-			std::unique_ptr<gpu::Image> NewImage = std::make_unique<gpu::Image>(device.CreateImage(
-				image.width, 
-				image.height,
-				1, 
-				GetFormat(image.bits, image.component, image.pixel_type),
-				EImageUsage::Sampled | EImageUsage::TransferDst));
-			gpu::UploadImageData(device, image.image.data(), *NewImage);
-			return assets.LoadImage(image.uri, std::move(NewImage));
-		}
-	}
-}
\ No newline at end of file
+	texture = textureStreamer.LoadTexture(textureName, std::move(cookedTexture), Material::CreateSampler(device));
+
+	return true;
+}
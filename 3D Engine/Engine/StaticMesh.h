@@ -2,65 +2,115 @@
 #include <Physics/Physics.h>
 #include <GPU/GPU.h>
 #include "Material.h"
+#include "VertexLayout.h"
 #include <filesystem>
 
 class AssetManager;
 
+/** A level of detail of a submesh: a range of its index buffer, drawn with all of its vertices. */
+struct SubmeshLOD
+{
+	uint32 firstIndex;
+	uint32 indexCount;
+	/** Largest distance from the full detail surface, in local units. */
+	float error;
+	/** The level's meshlets, which cover its index range in order. */
+	uint32 firstMeshlet;
+	uint32 numMeshlets;
+};
+
+/** A run of a level's triangles that's culled as a whole on the GPU. Bounds are in local units. See CookedMeshlet. */
+struct SubmeshMeshlet
+{
+	glm::vec3 center;
+	float radius;
+	glm::vec3 coneAxis;
+	float coneCutoff;
+	uint32 firstIndex;
+	uint32 indexCount;
+};
+
 class Submesh
 {
-	// Must match StaticMeshVS.glsl
-	enum VertexBufferLocation : uint32
-	{
-		Positions,
-		TextureCoordinates,
-		Normals,
-		NumLocations
-	};
 public:
-	Submesh(uint32 indexCount
+	Submesh(std::vector<SubmeshLOD>&& lods
+		, std::vector<SubmeshMeshlet>&& meshlets
 		, EIndexType indexType
 		, gpu::Buffer&& indexBuffer
-		, gpu::Buffer&& positionBuffer
-		, gpu::Buffer&& textureCoordinateBuffer
-		, gpu::Buffer&& normalBuffer) 
-		: _IndexCount(indexCount)
+		, std::array<gpu::Buffer, numVertexAttributes>&& vertexBuffers
+		, const VertexLayout& vertexLayout
+		, const VertexDequantization& dequantization
+		, gpu::UploadTicket uploadTicket) 
+		: _LODs(std::move(lods))
+		, _Meshlets(std::move(meshlets))
 		, _IndexType(indexType)
 		, _IndexBuffer(std::move(indexBuffer))
+		, _VertexBuffers(std::move(vertexBuffers))
+		, _VertexLayout(vertexLayout)
+		, _Dequantization(dequantization)
+		, _UploadTicket(uploadTicket)
 	{
-		_VertexBuffers[Positions] = std::move(positionBuffer);
-		_VertexBuffers[TextureCoordinates] = std::move(textureCoordinateBuffer);
-		_VertexBuffers[Normals] = std::move(normalBuffer);
 	}
 
 	Submesh(Submesh&& other)
-		: _IndexCount(other._IndexCount)
+		: _LODs(std::move(other._LODs))
+		, _Meshlets(std::move(other._Meshlets))
 		, _IndexType(other._IndexType)
 		, _IndexBuffer(std::move(other._IndexBuffer))
 		, _VertexBuffers(std::move(other._VertexBuffers))
+		, _VertexLayout(other._VertexLayout)
+		, _Dequantization(other._Dequantization)
+		, _UploadTicket(other._UploadTicket)
 	{}
 
 	Submesh& operator=(Submesh&& other)
 	{
-		_IndexCount = other._IndexCount;
+		_LODs = std::move(other._LODs);
+		_Meshlets = std::move(other._Meshlets);
 		_IndexType = other._IndexType;
 		_IndexBuffer = std::move(other._IndexBuffer);
 		_VertexBuffers = std::move(other._VertexBuffers);
+		_VertexLayout = other._VertexLayout;
+		_Dequantization = other._Dequantization;
+		_UploadTicket = other._UploadTicket;
+		return *this;
 	}
 
-	inline uint32 GetIndexCount() const { return _IndexCount; }
+	/** Index count of full detail. */
+	inline uint32 GetIndexCount() const { return _LODs.front().indexCount; }
+
+	/** Levels of detail from full detail down. Their errors increase. */
+	inline const std::vector<SubmeshLOD>& GetLODs() const { return _LODs; }
+
+	/** Meshlets of every level. Kept on the CPU, and uploaded as cluster culling candidates for the levels that are drawn. */
+	inline const std::vector<SubmeshMeshlet>& GetMeshlets() const { return _Meshlets; }
+
 	inline EIndexType GetIndexType() const { return _IndexType; }
 	inline const gpu::Buffer& GetIndexBuffer() const { return _IndexBuffer; }
-	inline const std::array<gpu::Buffer, NumLocations>& GetVertexBuffers() const { return _VertexBuffers; }
-	inline const gpu::Buffer& GetPositionBuffer() const { return _VertexBuffers[Positions]; }
+
+	/** One vertex buffer per stream of the layout. */
+	inline uint32 GetNumVertexBuffers() const { return _VertexLayout.GetNumStreams(); }
+	inline const gpu::Buffer* GetVertexBuffers() const { return _VertexBuffers.data(); }
+	inline const gpu::Buffer& GetPositionBuffer() const { return _VertexBuffers[_VertexLayout.GetStream(EVertexAttribute::Position)]; }
+
+	inline const VertexLayout& GetVertexLayout() const { return _VertexLayout; }
+	inline const VertexDequantization& GetDequantization() const { return _Dequantization; }
+	inline gpu::UploadTicket GetUploadTicket() const { return _UploadTicket; }
 
 private:
-	uint32 _IndexCount;
+	std::vector<SubmeshLOD> _LODs;
+	std::vector<SubmeshMeshlet> _Meshlets;
 	EIndexType _IndexType;
 	gpu::Buffer _IndexBuffer;
-	std::array<gpu::Buffer, NumLocations> _VertexBuffers;
+	std::array<gpu::Buffer, numVertexAttributes> _VertexBuffers;
+	VertexLayout _VertexLayout;
+	VertexDequantization _Dequantization;
+
+	/** Upload of the index and vertex buffers. */
+	gpu::UploadTicket _UploadTicket;
 };
 
-namespace tinygltf { class Model; struct Mesh; struct Primitive; }
+class CookedMesh;
 
 class StaticMesh
 {
@@ -89,8 +139,14 @@ private:
 	/** Local-space bounds of the mesh. */
 	BoundingBox _Bounds;
 
-	void GLTFLoad(const std::string& assetName, AssetManager& assets, gpu::Device& device);
-	void GLTFLoadGeometry(tinygltf::Model& model, tinygltf::Mesh& mesh, tinygltf::Primitive& primitive, gpu::Device& device);
-	void GLTFLoadMaterial(const std::string& assetName, AssetManager& assets, tinygltf::Model& model, tinygltf::Primitive& primitive, gpu::Device& device);
-	gpu::Image* GLTFLoadImage(AssetManager& assets, gpu::Device& device, tinygltf::Model& model, int32 textureIndex);
+	void LoadSubmeshes(const CookedMesh& cookedMesh, const std::vector<const Material*>& materials, gpu::Device& device);
+
+	/** Load the materials of a cooked mesh. Returns false if a cooked texture is missing from the cache. */
+	bool LoadMaterials(const std::string& assetName, AssetManager& assets, const CookedMesh& cookedMesh, gpu::Device& device, std::vector<const Material*>& materials);
+
+	/** 
+	  * Load a streamed texture from the texture cache. The texture is null if the material doesn't have it.
+	  * Returns false if the cooked texture is missing from the cache.
+	  */
+	bool LoadTexture(AssetManager& assets, const CookedMesh& cookedMesh, gpu::Device& device, int32 textureIndex, StreamedTexture*& texture);
 };
\ No newline at end of file
@@ -0,0 +1,652 @@
+#include "TextureCooker.h"
+#include "BlockCompression.h"
+#include "JobSystem.h"
+#include "MeshCooker.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+static constexpr uint32 numChannels = 4;
+static constexpr uint32 cookedTextureMagic = 0x58455443; // "CTEX"
+
+/** A cooked texture is a header, then the source path and image name, then the mips. */
+struct CookedTextureHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint64 key;
+	uint64 lastWriteTime;
+	ETextureContent content;
+	EFormat format;
+	uint32 width;
+	uint32 height;
+	uint32 numMips;
+	uint32 sourcePathSize;
+	uint32 nameSize;
+	/** Pads the header to the size's alignment, so no byte of it is left uninitialized. */
+	uint32 reserved;
+	uint64 size;
+};
+
+CookedTexture::CookedTexture(EFormat format, uint32 width, uint32 height, uint32 numMips, std::vector<uint8>&& data)
+	: _Data(std::move(data))
+	, _Format(format)
+	, _Width(width)
+	, _Height(height)
+	, _NumMips(numMips)
+{
+	check(_Data.size() == GetMipOffset(_NumMips), "Cooked texture has %zu bytes, but its mips take %zu.", _Data.size(), GetMipOffset(_NumMips));
+}
+
+std::size_t CookedTexture::GetMipOffset(uint32 mip) const
+{
+	std::size_t offset = 0;
+
+	for (uint32 i = 0; i < mip; i++)
+	{
+		offset += gpu::ImagePrivate::GetMipSize(_Format, std::max(_Width >> i, 1u), std::max(_Height >> i, 1u));
+	}
+
+	return offset;
+}
+
+static void RepackChannels(std::vector<uint8>& pixels, ETextureContent content)
+{
+	if (content == ETextureContent::MetallicRoughness)
+	{
+		for (std::size_t i = 0; i < pixels.size(); i += numChannels)
+		{
+			pixels[i + 0] = pixels[i + 1];
+			pixels[i + 1] = pixels[i + 2];
+			pixels[i + 2] = 0;
+			pixels[i + 3] = 255;
+		}
+	}
+}
+
+static void GetChannelMask(EFormat format, ETextureContent content, bool channelMask[4])
+{
+	const bool hasAlpha = format == EFormat::BC3_UNORM_BLOCK || format == EFormat::BC7_UNORM_BLOCK || format == EFormat::R8G8B8A8_UNORM;
+
+	channelMask[0] = true;
+	channelMask[1] = content != ETextureContent::Mask;
+	channelMask[2] = content == ETextureContent::Color;
+	channelMask[3] = content == ETextureContent::Color && hasAlpha;
+}
+
+std::unique_ptr<CookedTexture> TextureCooker::Cook(
+	const std::filesystem::path& sourcePath,
+	const std::string& name,
+	const uint8* pixels,
+	uint32 width,
+	uint32 height,
+	bool isSRGB,
+	ETextureContent content)
+{
+	const Source source = GetSource(sourcePath, name, content);
+	const uint64 key = GetKey(source);
+	const std::filesystem::path cachePath = GetCachePath(key);
+
+	if (std::unique_ptr<CookedTexture> cachedTexture = LoadCache(cachePath, key, source); cachedTexture)
+	{
+		return cachedTexture;
+	}
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	std::vector<uint8> topMip(pixels, pixels + std::size_t(width) * height * numChannels);
+	RepackChannels(topMip, content);
+
+	const MipChain mipChain(topMip.data(), width, height, isSRGB);
+
+	if (!IsCompressionEnabled())
+	{
+		std::vector<uint8> data(mipChain.GetData(), mipChain.GetData() + mipChain.GetSize());
+		std::unique_ptr<CookedTexture> texture = std::make_unique<CookedTexture>(EFormat::R8G8B8A8_UNORM, width, height, mipChain.GetNumMips(), std::move(data));
+
+		SaveCache(cachePath, key, source, *texture);
+
+		return texture;
+	}
+
+	const EFormat format = ChooseFormat(mipChain, content);
+
+	std::unique_ptr<CookedTexture> texture = Compress(mipChain, format);
+
+	const float cookMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	bool channelMask[4];
+	GetChannelMask(format, content, channelMask);
+
+	const std::vector<uint8> decodedMip = Decode(*texture, 0);
+	const float psnr = ComputePSNR(decodedMip.data(), mipChain.GetData(), std::size_t(width) * height, channelMask);
+
+	LOG("Cooked %s (%ux%u) to %.1f KB from %.1f KB in %.1f ms. PSNR: %.1f dB.",
+		name.c_str(), width, height, texture->GetSize() / 1024.0f, mipChain.GetSize() / 1024.0f, cookMs, psnr);
+
+	if (psnr < minPSNR)
+	{
+		LOG("Cooked %s is lossy: %.1f dB is below %.1f dB.", name.c_str(), psnr, minPSNR);
+	}
+
+	SaveCache(cachePath, key, source, *texture);
+
+	return texture;
+}
+
+std::unique_ptr<CookedTexture> TextureCooker::LoadCached(const std::filesystem::path& sourcePath, const std::string& name, ETextureContent content)
+{
+	const Source source = GetSource(sourcePath, name, content);
+	const uint64 key = GetKey(source);
+	return LoadCache(GetCachePath(key), key, source);
+}
+
+bool TextureCooker::IsCached(const std::filesystem::path& sourcePath, const std::string& name, ETextureContent content)
+{
+	const Source source = GetSource(sourcePath, name, content);
+	const uint64 key = GetKey(source);
+	const MappedFile file(GetCachePath(key));
+
+	return FindCachedHeader(file, key, source) != nullptr;
+}
+
+EFormat TextureCooker::ChooseFormat(const MipChain& mipChain, ETextureContent content)
+{
+	switch (content)
+	{
+	case ETextureContent::Normal:
+	case ETextureContent::MetallicRoughness:
+		return EFormat::BC5_UNORM_BLOCK;
+	case ETextureContent::Mask:
+		return EFormat::BC4_UNORM_BLOCK;
+	default:
+		break;
+	}
+
+	const uint8* pixels = mipChain.GetData();
+	const std::size_t numTexels = std::size_t(mipChain.GetWidth()) * mipChain.GetHeight();
+
+	for (std::size_t i = 0; i < numTexels; i++)
+	{
+		if (pixels[i * numChannels + 3] != 255)
+		{
+			return EFormat::BC7_UNORM_BLOCK;
+		}
+	}
+
+	return EFormat::BC1_RGBA_UNORM_BLOCK;
+}
+
+static void EncodeBlock(EFormat format, const uint8 texels[64], uint8* block)
+{
+	switch (format)
+	{
+	case EFormat::BC1_RGBA_UNORM_BLOCK:
+		BlockCompression::EncodeBC1(texels, block);
+		break;
+	case EFormat::BC3_UNORM_BLOCK:
+		BlockCompression::EncodeBC3(texels, block);
+		break;
+	case EFormat::BC4_UNORM_BLOCK:
+	{
+		uint8 values[16];
+
+		for (uint32 i = 0; i < 16; i++)
+		{
+			values[i] = texels[i * numChannels];
+		}
+
+		BlockCompression::EncodeBC4(values, block);
+		break;
+	}
+	case EFormat::BC5_UNORM_BLOCK:
+		BlockCompression::EncodeBC5(texels, block);
+		break;
+	case EFormat::BC7_UNORM_BLOCK:
+		BlockCompression::EncodeBC7(texels, block);
+		break;
+	default:
+		signal_unimplemented();
+	}
+}
+
+static void DecodeBlock(EFormat format, const uint8* block, uint8 texels[64])
+{
+	switch (format)
+	{
+	case EFormat::BC1_RGBA_UNORM_BLOCK:
+		BlockCompression::DecodeBC1(block, texels);
+		break;
+	case EFormat::BC3_UNORM_BLOCK:
+		BlockCompression::DecodeBC3(block, texels);
+		break;
+	case EFormat::BC4_UNORM_BLOCK:
+	{
+		uint8 values[16];
+		BlockCompression::DecodeBC4(block, values);
+
+		for (uint32 i = 0; i < 16; i++)
+		{
+			texels[i * numChannels + 0] = values[i];
+			texels[i * numChannels + 1] = 0;
+			texels[i * numChannels + 2] = 0;
+			texels[i * numChannels + 3] = 255;
+		}
+		break;
+	}
+	case EFormat::BC5_UNORM_BLOCK:
+		BlockCompression::DecodeBC5(block, texels);
+		break;
+	case EFormat::BC7_UNORM_BLOCK:
+		BlockCompression::DecodeBC7(block, texels);
+		break;
+	default:
+		signal_unimplemented();
+	}
+}
+
+std::unique_ptr<CookedTexture> TextureCooker::Compress(const MipChain& mipChain, EFormat format)
+{
+	const uint32 blockSize = gpu::ImagePrivate::GetSize(format);
+	const uint32 numMips = mipChain.GetNumMips();
+
+	struct BlockRow
+	{
+		uint32 mip;
+		uint32 y;
+		std::size_t dstOffset;
+	};
+
+	// Rows of every mip are handed out together, so workers stay busy through the small mips.
+	std::vector<BlockRow> blockRows;
+	std::size_t size = 0;
+
+	for (uint32 mip = 0; mip < numMips; mip++)
+	{
+		const uint32 width = std::max(mipChain.GetWidth() >> mip, 1u);
+		const uint32 height = std::max(mipChain.GetHeight() >> mip, 1u);
+		const uint32 numBlocksX = DivideAndRoundUp(width, BlockCompression::blockDim);
+		const uint32 numBlocksY = DivideAndRoundUp(height, BlockCompression::blockDim);
+
+		for (uint32 y = 0; y < numBlocksY; y++)
+		{
+			blockRows.push_back({ mip, y, size });
+			size += std::size_t(numBlocksX) * blockSize;
+		}
+	}
+
+	std::vector<uint8> data(size);
+
+	JobSystem::Get().ParallelFor(blockRows.size(), [&] (std::size_t rowIndex)
+	{
+		const BlockRow& blockRow = blockRows[rowIndex];
+		const uint32 width = std::max(mipChain.GetWidth() >> blockRow.mip, 1u);
+		const uint32 height = std::max(mipChain.GetHeight() >> blockRow.mip, 1u);
+		const uint8* src = mipChain.GetData() + mipChain.GetMipOffset(blockRow.mip);
+		uint8* dst = data.data() + blockRow.dstOffset;
+
+		for (uint32 blockX = 0; blockX < DivideAndRoundUp(width, BlockCompression::blockDim); blockX++)
+		{
+			// Blocks past the edge of the mip repeat its last row and column.
+			uint8 texels[64];
+
+			for (uint32 i = 0; i < BlockCompression::numBlockTexels; i++)
+			{
+				const uint32 x = std::min(blockX * BlockCompression::blockDim + i % BlockCompression::blockDim, width - 1);
+				const uint32 y = std::min(blockRow.y * BlockCompression::blockDim + i / BlockCompression::blockDim, height - 1);
+				Platform::Memcpy(&texels[i * numChannels], src + (std::size_t(y) * width + x) * numChannels, numChannels);
+			}
+
+			EncodeBlock(format, texels, dst + std::size_t(blockX) * blockSize);
+		}
+	});
+
+	return std::make_unique<CookedTexture>(format, mipChain.GetWidth(), mipChain.GetHeight(), numMips, std::move(data));
+}
+
+std::vector<uint8> TextureCooker::Decode(const CookedTexture& texture, uint32 mip)
+{
+	const uint32 width = std::max(texture.GetWidth() >> mip, 1u);
+	const uint32 height = std::max(texture.GetHeight() >> mip, 1u);
+	const uint8* src = texture.GetData() + texture.GetMipOffset(mip);
+
+	std::vector<uint8> pixels(std::size_t(width) * height * numChannels);
+
+	if (!gpu::ImagePrivate::IsBlockCompressed(texture.GetFormat()))
+	{
+		Platform::Memcpy(pixels.data(), src, pixels.size());
+		return pixels;
+	}
+
+	const uint32 blockSize = gpu::ImagePrivate::GetSize(texture.GetFormat());
+	const uint32 numBlocksX = DivideAndRoundUp(width, BlockCompression::blockDim);
+	const uint32 numBlocksY = DivideAndRoundUp(height, BlockCompression::blockDim);
+
+	for (uint32 blockY = 0; blockY < numBlocksY; blockY++)
+	{
+		for (uint32 blockX = 0; blockX < numBlocksX; blockX++)
+		{
+			uint8 texels[64];
+			DecodeBlock(texture.GetFormat(), src + (std::size_t(blockY) * numBlocksX + blockX) * blockSize, texels);
+
+			for (uint32 i = 0; i < BlockCompression::numBlockTexels; i++)
+			{
+				const uint32 x = blockX * BlockCompression::blockDim + i % BlockCompression::blockDim;
+				const uint32 y = blockY * BlockCompression::blockDim + i / BlockCompression::blockDim;
+
+				if (x < width && y < height)
+				{
+					Platform::Memcpy(&pixels[(std::size_t(y) * width + x) * numChannels], &texels[i * numChannels], numChannels);
+				}
+			}
+		}
+	}
+
+	return pixels;
+}
+
+float TextureCooker::ComputePSNR(const uint8* pixels, const uint8* reference, std::size_t numTexels, const bool channelMask[4])
+{
+	float64 squaredError = 0.0;
+	std::size_t numValues = 0;
+
+	for (std::size_t i = 0; i < numTexels; i++)
+	{
+		for (uint32 c = 0; c < numChannels; c++)
+		{
+			if (channelMask[c])
+			{
+				const float64 error = float64(pixels[i * numChannels + c]) - float64(reference[i * numChannels + c]);
+				squaredError += error * error;
+				numValues++;
+			}
+		}
+	}
+
+	const float64 meanSquaredError = squaredError / std::max<std::size_t>(numValues, 1);
+
+	// Identical images are reported at the PSNR of an error of one value in a million.
+	return static_cast<float>(10.0 * std::log10(255.0 * 255.0 / std::max(meanSquaredError, 1e-6)));
+}
+
+void TextureCooker::CookDirectory(const std::filesystem::path& directory)
+{
+	check(std::filesystem::is_directory(directory), "%s isn't a directory.", directory.generic_string().c_str());
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	uint32 numFiles = 0;
+	uint32 numTextures = 0;
+
+	for (const std::filesystem::directory_entry& entry : std::filesystem::recursive_directory_iterator(directory))
+	{
+		const std::filesystem::path& path = entry.path();
+
+		if (path.extension() != ".gltf" && path.extension() != ".glb")
+		{
+			continue;
+		}
+
+		// Cooking a mesh cooks its textures. As when a static mesh is loaded, a cached mesh is cooked again if its textures aren't cached.
+		std::unique_ptr<CookedMesh> cookedMesh = MeshCooker::Load(path);
+
+		for (uint32 textureIndex = 0; textureIndex < cookedMesh->GetNumTextures(); textureIndex++)
+		{
+			const CookedTextureRef& textureRef = cookedMesh->GetTexture(textureIndex);
+
+			if (!IsCached(cookedMesh->GetString(textureRef.sourcePath), cookedMesh->GetString(textureRef.name), textureRef.content))
+			{
+				cookedMesh = MeshCooker::Load(path, true);
+				break;
+			}
+		}
+
+		numFiles++;
+		numTextures += cookedMesh->GetNumTextures();
+	}
+
+	const float cookMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	LOG("Cooked %u textures of %u glTF files in %.1f ms.", numTextures, numFiles, cookMs);
+}
+
+bool TextureCooker::CheckRoundTrip()
+{
+	struct TestImage
+	{
+		const char* name;
+		uint32 width;
+		uint32 height;
+		std::vector<uint8> pixels;
+		/** Number of mips from the top whose 4x4 blocks are each one color. */
+		uint32 numUniformMips;
+	};
+
+	auto createImage = [] (const char* name, uint32 width, uint32 height, uint32 numUniformMips, auto&& getTexel)
+	{
+		TestImage image = { name, width, height, std::vector<uint8>(std::size_t(width) * height * numChannels), numUniformMips };
+
+		for (uint32 y = 0; y < height; y++)
+		{
+			for (uint32 x = 0; x < width; x++)
+			{
+				const glm::uvec4 texel = getTexel(x, y);
+
+				for (uint32 c = 0; c < numChannels; c++)
+				{
+					image.pixels[(std::size_t(y) * width + x) * numChannels + c] = static_cast<uint8>(texel[c]);
+				}
+			}
+		}
+
+		return image;
+	};
+
+	const TestImage images[] =
+	{
+		// One block per value, so every 8-bit value is encoded as a uniform block.
+		createImage("uniform blocks", 64, 64, 1, [] (uint32 x, uint32 y)
+		{
+			const uint32 block = (y / 4) * 16 + x / 4;
+			return glm::uvec4(block, 255 - block, (block * 7) & 255, (block * 3) & 255);
+		}),
+		// Every mip is one color, down to the mips smaller than a block.
+		createImage("constant", 64, 64, ~0u, [] (uint32 x, uint32 y)
+		{
+			return glm::uvec4(37, 201, 118, 90);
+		}),
+		createImage("gradient", 64, 64, 0, [] (uint32 x, uint32 y)
+		{
+			return glm::uvec4(x * 4, y * 4, (x + y) * 2, 255 - x * 2);
+		}),
+		// Isn't a multiple of the block size, so the edge blocks repeat the last row and column.
+		createImage("odd-sized gradient", 30, 18, 0, [] (uint32 x, uint32 y)
+		{
+			return glm::uvec4(255 - x * 8, y * 14, 128, y * 14);
+		}),
+		createImage("edge", 64, 64, 0, [] (uint32 x, uint32 y)
+		{
+			return x > y ? glm::uvec4(200, 40, 90, 255) : glm::uvec4(30, 180, 220, 64);
+		}),
+	};
+
+	struct TestFormat
+	{
+		EFormat format;
+		const char* name;
+		bool channelMask[4];
+	};
+
+	static constexpr TestFormat formats[] =
+	{
+		{ EFormat::BC1_RGBA_UNORM_BLOCK, "BC1", { true, true, true, false } },
+		{ EFormat::BC3_UNORM_BLOCK, "BC3", { true, true, true, true } },
+		{ EFormat::BC4_UNORM_BLOCK, "BC4", { true, false, false, false } },
+		{ EFormat::BC5_UNORM_BLOCK, "BC5", { true, true, false, false } },
+		{ EFormat::BC7_UNORM_BLOCK, "BC7", { true, true, true, true } },
+	};
+
+	uint32 numChecks = 0;
+	uint32 numFailures = 0;
+
+	for (const TestFormat& format : formats)
+	{
+		for (const TestImage& image : images)
+		{
+			const MipChain mipChain(image.pixels.data(), image.width, image.height, false);
+			const std::unique_ptr<CookedTexture> texture = Compress(mipChain, format.format);
+
+			for (uint32 mip = 0; mip < mipChain.GetNumMips(); mip++)
+			{
+				const std::vector<uint8> decodedMip = Decode(*texture, mip);
+				const uint8* sourceMip = mipChain.GetData() + mipChain.GetMipOffset(mip);
+				const std::size_t numTexels = decodedMip.size() / numChannels;
+
+				// The top mip is measured, as when a texture is cooked. A block's colors are interpolated along one line, so the
+				// smallest mips of the gradients, where each channel varies on its own across a block, are lossy by design.
+				if (mip == 0)
+				{
+					const float psnr = ComputePSNR(decodedMip.data(), sourceMip, numTexels, format.channelMask);
+
+					numChecks++;
+
+					if (psnr < minPSNR)
+					{
+						LOG("%s round trip of %s: %.1f dB is below %.1f dB.", format.name, image.name, psnr, minPSNR);
+						numFailures++;
+					}
+				}
+
+				if (mip < image.numUniformMips)
+				{
+					int32 maxError = 0;
+
+					for (std::size_t i = 0; i < decodedMip.size(); i++)
+					{
+						if (format.channelMask[i % numChannels])
+						{
+							maxError = std::max(maxError, std::abs(int32(decodedMip[i]) - int32(sourceMip[i])));
+						}
+					}
+
+					numChecks++;
+
+					if (maxError > 1)
+					{
+						LOG("%s round trip of %s, mip %u: a texel is %d off.", format.name, image.name, mip, maxError);
+						numFailures++;
+					}
+				}
+			}
+		}
+	}
+
+	LOG("Texture round trip: %u of %u checks passed.", numChecks - numFailures, numChecks);
+
+	return numFailures == 0;
+}
+
+bool TextureCooker::IsCompressionEnabled()
+{
+	return Platform::GetBool("Engine.ini", "Renderer", "TextureCompression", true);
+}
+
+TextureCooker::Source TextureCooker::GetSource(const std::filesystem::path& sourcePath, const std::string& name, ETextureContent content)
+{
+	const std::string sourceName = sourcePath.generic_string();
+	const uint64 lastWriteTime = Platform::FileExists(sourceName) ? Platform::GetLastWriteTime(sourcePath) : 0;
+
+	return { sourceName, name, lastWriteTime, content };
+}
+
+uint64 TextureCooker::GetKey(const Source& source)
+{
+	std::string keyBytes;
+	AppendKeyBytes(keyBytes, source.path);
+	AppendKeyBytes(keyBytes, source.name);
+	AppendKeyBytes(keyBytes, source.lastWriteTime);
+	AppendKeyBytes(keyBytes, source.content);
+	AppendKeyBytes(keyBytes, IsCompressionEnabled());
+	AppendKeyBytes(keyBytes, cookerVersion);
+
+	return Platform::Hash64(keyBytes.data(), keyBytes.size());
+}
+
+std::filesystem::path TextureCooker::GetCachePath(uint64 key)
+{
+	return std::filesystem::path("../Cooked/Textures") / Platform::FormatString("%016llx.tex", key);
+}
+
+const CookedTextureHeader* TextureCooker::FindCachedHeader(const MappedFile& file, uint64 key, const Source& source)
+{
+	if (!file.IsOpen() || file.GetSize() < sizeof(CookedTextureHeader))
+	{
+		return nullptr;
+	}
+
+	const CookedTextureHeader* header = reinterpret_cast<const CookedTextureHeader*>(file.GetData());
+
+	if (header->magic != cookedTextureMagic || header->version != cookerVersion || header->key != key ||
+		file.GetSize() != sizeof(*header) + header->sourcePathSize + header->nameSize + header->size)
+	{
+		return nullptr;
+	}
+
+	// The key is a hash, so the source is compared too.
+	const char* sourcePath = reinterpret_cast<const char*>(header + 1);
+	const char* name = sourcePath + header->sourcePathSize;
+
+	if (std::string_view(sourcePath, header->sourcePathSize) != source.path || std::string_view(name, header->nameSize) != source.name ||
+		header->lastWriteTime != source.lastWriteTime || header->content != source.content)
+	{
+		return nullptr;
+	}
+
+	return header;
+}
+
+std::unique_ptr<CookedTexture> TextureCooker::LoadCache(const std::filesystem::path& path, uint64 key, const Source& source)
+{
+	const MappedFile file(path);
+	const CookedTextureHeader* header = FindCachedHeader(file, key, source);
+
+	if (header == nullptr)
+	{
+		return nullptr;
+	}
+
+	const uint8* data = file.GetData() + file.GetSize() - header->size;
+
+	return std::make_unique<CookedTexture>(header->format, header->width, header->height, header->numMips, std::vector<uint8>(data, data + header->size));
+}
+
+void TextureCooker::SaveCache(const std::filesystem::path& path, uint64 key, const Source& source, const CookedTexture& texture)
+{
+	std::filesystem::create_directories(path.parent_path());
+
+	const CookedTextureHeader header =
+	{
+		.magic = cookedTextureMagic,
+		.version = cookerVersion,
+		.key = key,
+		.lastWriteTime = source.lastWriteTime,
+		.content = source.content,
+		.format = texture.GetFormat(),
+		.width = texture.GetWidth(),
+		.height = texture.GetHeight(),
+		.numMips = texture.GetNumMips(),
+		.sourcePathSize = static_cast<uint32>(source.path.size()),
+		.nameSize = static_cast<uint32>(source.name.size()),
+		.reserved = 0,
+		.size = texture.GetSize(),
+	};
+
+	std::string file;
+	file.reserve(sizeof(header) + source.path.size() + source.name.size() + texture.GetSize());
+	file.append(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.append(source.path);
+	file.append(source.name);
+	file.append(reinterpret_cast<const char*>(texture.GetData()), texture.GetSize());
+
+	Platform::FileWrite(path, file);
+}
@@ -0,0 +1,123 @@
+#pragma once
+#include "MipChain.h"
+#include <GPU/GPUResource.h>
+
+/** What a texture holds. It decides the channels that are kept and the format they're compressed to. */
+enum class ETextureContent
+{
+	/** RGB color, with alpha if any texel isn't opaque. */
+	Color,
+	/** Tangent-space XY. Z is reconstructed in the shader. */
+	Normal,
+	/** glTF roughness in G and metallic in B. Repacked to roughness in R and metallic in G. */
+	MetallicRoughness,
+	/** One channel in R. */
+	Mask,
+};
+
+/** Mip chain of an image in its GPU format. Mips are packed from the largest to the smallest. */
+class CookedTexture
+{
+public:
+	CookedTexture(EFormat format, uint32 width, uint32 height, uint32 numMips, std::vector<uint8>&& data);
+
+	inline EFormat GetFormat() const { return _Format; }
+	inline uint32 GetWidth() const { return _Width; }
+	inline uint32 GetHeight() const { return _Height; }
+	inline uint32 GetNumMips() const { return _NumMips; }
+	inline const uint8* GetData() const { return _Data.data(); }
+	inline std::size_t GetSize() const { return _Data.size(); }
+
+	/** Offset of a mip in the packed data. The mips from there on form the chain of an image starting at that mip. */
+	std::size_t GetMipOffset(uint32 mip) const;
+
+private:
+	std::vector<uint8> _Data;
+	EFormat _Format;
+	uint32 _Width;
+	uint32 _Height;
+	uint32 _NumMips;
+};
+
+/**
+  * Cooks imported RGBA8 images into block-compressed mip chains, so textures take 4-8x less memory and bandwidth.
+  * Color is BC1, or BC7 with alpha. Normals and metallic-roughness are BC5, and masks are BC4.
+  * Cooked textures are cached in ../Cooked/Textures, keyed by the source image, its write time, the content and the cooker version.
+  * The source is also stored in the file and compared on load, so a key collision can't load another texture.
+  * Compression is disabled with TextureCompression=False in Engine.ini, in which case textures are repacked but stay RGBA8.
+  */
+class TextureCooker
+{
+public:
+	/** Cook an image, or load it from the cache. The source path and name identify the image, e.g. a glTF file and an image in it. */
+	static std::unique_ptr<CookedTexture> Cook(
+		const std::filesystem::path& sourcePath,
+		const std::string& name,
+		const uint8* pixels,
+		uint32 width,
+		uint32 height,
+		bool isSRGB,
+		ETextureContent content
+	);
+
+	/** Load a texture cooked before, without its source pixels. Returns null if it isn't in the cache or is out of date. */
+	static std::unique_ptr<CookedTexture> LoadCached(const std::filesystem::path& sourcePath, const std::string& name, ETextureContent content);
+
+	/** Whether an up-to-date cooked texture is in the cache. Only reads its header. */
+	static bool IsCached(const std::filesystem::path& sourcePath, const std::string& name, ETextureContent content);
+
+	/** Format of a mip chain with the content. */
+	static EFormat ChooseFormat(const MipChain& mipChain, ETextureContent content);
+
+	/** Compress every mip of the chain. Block rows are encoded on the job system. */
+	static std::unique_ptr<CookedTexture> Compress(const MipChain& mipChain, EFormat format);
+
+	/** Decode a mip to tightly packed RGBA8. */
+	static std::vector<uint8> Decode(const CookedTexture& texture, uint32 mip);
+
+	/** Peak signal-to-noise ratio in dB between two RGBA8 images, over the channels in the mask. */
+	static float ComputePSNR(const uint8* pixels, const uint8* reference, std::size_t numTexels, const bool channelMask[4]);
+
+	/**
+	  * Cook the textures of every glTF file under a directory, so shipping builds load them from the cache. The meshes are cooked along
+	  * with them, since that's where their contents are decided. Doesn't need a device.
+	  * Textures are keyed by their paths, so pass the directory as the engine loads it, e.g. ../Assets/Meshes.
+	  */
+	static void CookDirectory(const std::filesystem::path& directory);
+
+	/**
+	  * Compress and decode synthetic images in every block-compressed format, on the CPU. The top mip of each must reach minPSNR,
+	  * and blocks of one color must decode within one value of it. Failures are logged. Returns true if all pass.
+	  */
+	static bool CheckRoundTrip();
+
+	/** Cooked textures below this PSNR are logged as lossy, and fail the round-trip check. */
+	static constexpr float minPSNR = 30.0f;
+
+private:
+	/** Bump to invalidate cooked textures after changing the encoders or the cache layout. */
+	static constexpr uint32 cookerVersion = 4;
+
+	/** What a texture is cooked from. */
+	struct Source
+	{
+		std::string path;
+		std::string name;
+		uint64 lastWriteTime;
+		ETextureContent content;
+	};
+
+	static bool IsCompressionEnabled();
+
+	static Source GetSource(const std::filesystem::path& sourcePath, const std::string& name, ETextureContent content);
+
+	/** Key of a cooked texture in the cache. Covers the source, whether it's compressed and the cooker version. */
+	static uint64 GetKey(const Source& source);
+	static std::filesystem::path GetCachePath(uint64 key);
+
+	/** Header of a cached texture, if it was cooked from the source with the key and the file is complete. */
+	static const struct CookedTextureHeader* FindCachedHeader(const MappedFile& file, uint64 key, const Source& source);
+
+	static std::unique_ptr<CookedTexture> LoadCache(const std::filesystem::path& path, uint64 key, const Source& source);
+	static void SaveCache(const std::filesystem::path& path, uint64 key, const Source& source, const CookedTexture& texture);
+};
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "TextureStreamer.h"
+#include <algorithm>
+#include <cmath>
+
+static constexpr EImageUsage streamedImageUsage = EImageUsage::Sampled | EImageUsage::TransferDst;
+
+TextureStreamer::TextureStreamer(gpu::Device& device)
+	: _Device(device)
+{
+	_Stats.budgetBytes = Platform::GetInt("Engine.ini", "Renderer", "TextureStreamingBudget", 256) * 1024ull * 1024ull;
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	for (const auto& [assetName, texture] : _Textures)
+	{
+		_Device.ReleaseTextureID(texture->_TextureID);
+	}
+}
+
+StreamedTexture* TextureStreamer::LoadTexture(const std::string& assetName, std::unique_ptr<CookedTexture> cookedTexture, const gpu::Sampler& sampler)
+{
+	check(_Textures.find(assetName) == _Textures.end(), "Texture %s already exists.", assetName.c_str());
+
+	std::unique_ptr<StreamedTexture> texture = std::make_unique<StreamedTexture>();
+
+	const uint32 width = cookedTexture->GetWidth();
+	const uint32 height = cookedTexture->GetHeight();
+	const uint32 numMips = cookedTexture->GetNumMips();
+	const EFormat format = cookedTexture->GetFormat();
+
+	texture->_ImageSizes.resize(numMips);
+
+	for (uint32 mip = 0; mip < numMips; mip++)
+	{
+		texture->_ImageSizes[mip] = _Device.GetImageMemoryRequirements(
+			std::max(width >> mip, 1u), std::max(height >> mip, 1u), 1, format, streamedImageUsage, numMips - mip
+		).size;
+	}
+
+	while (texture->_TailMip + 1 < numMips && (std::max(width, height) >> texture->_TailMip) > tailSize)
+	{
+		texture->_TailMip++;
+	}
+
+	const uint32 tailMip = texture->_TailMip;
+
+	texture->_TailImage = _Device.CreateImage(
+		std::max(width >> tailMip, 1u), std::max(height >> tailMip, 1u), 1, format, streamedImageUsage, numMips - tailMip
+	);
+
+	texture->_UploadTicket = _Device.UploadImageData(texture->_TailImage, cookedTexture->GetData() + cookedTexture->GetMipOffset(tailMip));
+	texture->_TextureID = _Device.CreateTextureID(texture->_TailImage, sampler);
+	texture->_CookedTexture = std::move(cookedTexture);
+	texture->_Sampler = sampler;
+	texture->_ResidentMip = tailMip;
+	texture->_RequestedMip = tailMip;
+
+	_Stats.residentBytes += texture->_ImageSizes[tailMip];
+	_Stats.numTextures++;
+
+	_Textures[assetName] = std::move(texture);
+
+	return _Textures[assetName].get();
+}
+
+StreamedTexture* TextureStreamer::GetTexture(const std::string& assetName) const
+{
+	const auto iter = _Textures.find(assetName);
+	return iter == _Textures.end() ? nullptr : iter->second.get();
+}
+
+void TextureStreamer::RequestScreenSize(StreamedTexture& texture, float screenSize)
+{
+	// One mip per halving of the texels per pixel.
+	const float texelsPerPixel = std::max(texture.GetWidth(), texture.GetHeight()) / std::max(screenSize, 1.0f);
+	const uint32 mip = std::min(static_cast<uint32>(std::log2(std::max(texelsPerPixel, 1.0f))), texture._TailMip);
+
+	if (texture._LastRequestFrame != _FrameNumber)
+	{
+		texture._LastRequestFrame = _FrameNumber;
+		texture._RequestedMip = mip;
+	}
+	else
+	{
+		texture._RequestedMip = std::min(texture._RequestedMip, mip);
+	}
+}
+
+void TextureStreamer::Update()
+{
+	// Sets of descriptors are updated as their frames retire, so a replaced image is only free once every frame in flight has moved on.
+	while (!_RetiredImages.empty() && _RetiredImages.front().first + _Device.GetNumFramesInFlight() <= _FrameNumber)
+	{
+		_RetiredImages.pop_front();
+	}
+
+	std::vector<StreamedTexture*> requests;
+
+	for (auto& [assetName, texture] : _Textures)
+	{
+		if (texture->IsUploadPending() && _Device.IsUploadComplete(texture->_PendingUpload))
+		{
+			if (texture->_ResidentMip < texture->_TailMip)
+			{
+				_Stats.residentBytes -= texture->_ImageSizes[texture->_ResidentMip];
+				Retire(std::move(texture->_Image));
+			}
+
+			const uint64 size = texture->_ImageSizes[texture->_PendingMip];
+			_Stats.pendingBytes -= size;
+			_Stats.residentBytes += size;
+
+			texture->_Image = std::move(texture->_PendingImage);
+			texture->_ResidentMip = texture->_PendingMip;
+			texture->_PendingUpload = 0;
+
+			// Completed uploads are acquired by the graphics queue before its next submission, which is before the texture is sampled.
+			_Device.UpdateTextureID(texture->_TextureID, texture->_Image, texture->_Sampler);
+		}
+
+		if (!texture->IsUploadPending() && texture->_LastRequestFrame == _FrameNumber && texture->_RequestedMip < texture->_ResidentMip)
+		{
+			requests.push_back(texture.get());
+		}
+	}
+
+	// Textures furthest from their requested mip go first.
+	std::sort(requests.begin(), requests.end(), [] (const StreamedTexture* a, const StreamedTexture* b)
+	{
+		return a->_ResidentMip - a->_RequestedMip > b->_ResidentMip - b->_RequestedMip;
+	});
+
+	uint64 uploadBytes = 0;
+
+	for (StreamedTexture* texture : requests)
+	{
+		if (uploadBytes >= maxUploadBytesPerFrame)
+		{
+			break;
+		}
+
+		// Settle for a coarser mip than requested if the requested one doesn't fit in the budget.
+		uint32 mip = texture->_RequestedMip;
+
+		while (mip < texture->_ResidentMip && !MakeRoom(texture->_ImageSizes[mip]))
+		{
+			mip++;
+		}
+
+		if (mip == texture->_ResidentMip)
+		{
+			continue;
+		}
+
+		const uint64 size = texture->_ImageSizes[mip];
+		const CookedTexture& cookedTexture = *texture->_CookedTexture;
+
+		texture->_PendingImage = _Device.CreateImage(
+			std::max(cookedTexture.GetWidth() >> mip, 1u),
+			std::max(cookedTexture.GetHeight() >> mip, 1u),
+			1,
+			cookedTexture.GetFormat(),
+			streamedImageUsage,
+			cookedTexture.GetNumMips() - mip
+		);
+
+		texture->_PendingMip = mip;
+		texture->_PendingUpload = _Device.UploadImageData(texture->_PendingImage, cookedTexture.GetData() + cookedTexture.GetMipOffset(mip));
+
+		uploadBytes += size;
+
+		_Stats.pendingBytes += size;
+		_Stats.numUploads++;
+		_Stats.uploadedBytes += cookedTexture.GetSize() - cookedTexture.GetMipOffset(mip);
+	}
+
+	_Stats.numStreamedIn = 0;
+	_Stats.numPendingUploads = 0;
+
+	for (const auto& [assetName, texture] : _Textures)
+	{
+		_Stats.numStreamedIn += texture->_ResidentMip < texture->_TailMip;
+		_Stats.numPendingUploads += texture->IsUploadPending();
+	}
+
+	_FrameNumber++;
+}
+
+void TextureStreamer::Evict(StreamedTexture& texture)
+{
+	_Stats.residentBytes -= texture._ImageSizes[texture._ResidentMip];
+	_Stats.numEvictions++;
+
+	_Device.UpdateTextureID(texture._TextureID, texture._TailImage, texture._Sampler);
+
+	Retire(std::move(texture._Image));
+
+	texture._ResidentMip = texture._TailMip;
+}
+
+bool TextureStreamer::MakeRoom(uint64 bytes)
+{
+	const uint64 usedBytes = _Stats.residentBytes + _Stats.pendingBytes;
+
+	if (usedBytes + bytes <= _Stats.budgetBytes)
+	{
+		return true;
+	}
+
+	std::vector<StreamedTexture*> candidates;
+	uint64 evictableBytes = 0;
+
+	for (const auto& [assetName, texture] : _Textures)
+	{
+		if (texture->_LastRequestFrame != _FrameNumber && texture->_ResidentMip < texture->_TailMip && !texture->IsUploadPending())
+		{
+			candidates.push_back(texture.get());
+			evictableBytes += texture->_ImageSizes[texture->_ResidentMip];
+		}
+	}
+
+	// Don't evict anything if it wouldn't make enough room.
+	if (usedBytes - evictableBytes + bytes > _Stats.budgetBytes)
+	{
+		return false;
+	}
+
+	std::sort(candidates.begin(), candidates.end(), [] (const StreamedTexture* a, const StreamedTexture* b)
+	{
+		return a->_LastRequestFrame < b->_LastRequestFrame;
+	});
+
+	for (StreamedTexture* texture : candidates)
+	{
+		if (_Stats.residentBytes + _Stats.pendingBytes + bytes <= _Stats.budgetBytes)
+		{
+			break;
+		}
+
+		Evict(*texture);
+	}
+
+	return true;
+}
+
+void TextureStreamer::Retire(gpu::Image&& image)
+{
+	_RetiredImages.push_back({ _FrameNumber, std::move(image) });
+}
@@ -0,0 +1,133 @@
+#pragma once
+#include "TextureCooker.h"
+#include <GPU/GPU.h>
+#include <deque>
+
+/**
+  * A texture whose mips are streamed in as they're needed. The mip tail is always resident,
+  * and finer mips are uploaded from the cooked mip chain. The texture ID doesn't change while residency does.
+  */
+class StreamedTexture
+{
+public:
+	StreamedTexture(const StreamedTexture&) = delete;
+	StreamedTexture& operator=(const StreamedTexture&) = delete;
+	StreamedTexture() = default;
+
+	inline gpu::TextureID GetTextureID() const { return _TextureID; }
+
+	/** Upload of the mip tail. */
+	inline gpu::UploadTicket GetUploadTicket() const { return _UploadTicket; }
+
+	inline uint32 GetWidth() const { return _CookedTexture->GetWidth(); }
+	inline uint32 GetHeight() const { return _CookedTexture->GetHeight(); }
+	inline uint32 GetNumMips() const { return _CookedTexture->GetNumMips(); }
+
+	/** Finest mip that can be sampled. */
+	inline uint32 GetResidentMip() const { return _ResidentMip; }
+
+	inline bool IsUploadPending() const { return _PendingUpload != 0; }
+
+private:
+	friend class TextureStreamer;
+
+	std::unique_ptr<CookedTexture> _CookedTexture;
+	gpu::Sampler _Sampler;
+	gpu::TextureID _TextureID;
+	gpu::UploadTicket _UploadTicket = 0;
+
+	/** Image of the mip tail. It's sampled when nothing finer is resident. */
+	gpu::Image _TailImage;
+	uint32 _TailMip = 0;
+
+	/** Image of the resident mips finer than the tail. */
+	gpu::Image _Image;
+	uint32 _ResidentMip = 0;
+
+	/** Image being uploaded. It replaces _Image once the upload completes. */
+	gpu::Image _PendingImage;
+	uint32 _PendingMip = 0;
+	gpu::UploadTicket _PendingUpload = 0;
+
+	/** Finest mip requested this frame. */
+	uint32 _RequestedMip = 0;
+	uint64 _LastRequestFrame = 0;
+
+	/** Memory size of an image starting at each mip. */
+	std::vector<uint64> _ImageSizes;
+};
+
+/**
+  * Keeps the mips of streamed textures resident within a memory budget.
+  * Surfaces request mips each frame from their size on screen, and the streamer uploads the requested mips on the transfer queue.
+  * When the budget is exceeded, the least recently requested textures fall back to their mip tail.
+  */
+class TextureStreamer
+{
+public:
+	struct Stats
+	{
+		uint64 budgetBytes = 0;
+
+		/** Memory of the resident mips, including mip tails. */
+		uint64 residentBytes = 0;
+
+		/** Memory of the images being uploaded. */
+		uint64 pendingBytes = 0;
+
+		uint32 numTextures = 0;
+
+		/** Textures with mips finer than their tail resident. */
+		uint32 numStreamedIn = 0;
+
+		uint32 numPendingUploads = 0;
+
+		/** Totals since the streamer was created. */
+		uint64 numUploads = 0;
+		uint64 numEvictions = 0;
+		uint64 uploadedBytes = 0;
+	};
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+	TextureStreamer(gpu::Device& device);
+	~TextureStreamer();
+
+	/** Create a streamed texture with only its mip tail resident. */
+	StreamedTexture* LoadTexture(const std::string& assetName, std::unique_ptr<CookedTexture> cookedTexture, const gpu::Sampler& sampler);
+	StreamedTexture* GetTexture(const std::string& assetName) const;
+
+	/** Request the mips needed to draw the texture at a size in pixels. The finest request of the frame wins. */
+	void RequestScreenSize(StreamedTexture& texture, float screenSize);
+
+	/** Called once a frame after mips have been requested. Swaps in completed uploads, evicts and starts new uploads. */
+	void Update();
+
+	inline const Stats& GetStats() const { return _Stats; }
+
+private:
+	/** Textures are at most this many texels wide in their mip tail. */
+	static constexpr uint32 tailSize = 64;
+
+	/** Limits how much is uploaded in a frame, so streaming doesn't starve other uploads of staging memory. */
+	static constexpr uint64 maxUploadBytesPerFrame = 16ull * 1024ull * 1024ull;
+
+	gpu::Device& _Device;
+
+	std::unordered_map<std::string, std::unique_ptr<StreamedTexture>> _Textures;
+
+	/** Images that were replaced, and the frame they were replaced in. Frames in flight may still be sampling them. */
+	std::deque<std::pair<uint64, gpu::Image>> _RetiredImages;
+
+	uint64 _FrameNumber = 1;
+
+	Stats _Stats;
+
+	/** Sample the texture's tail and free the finer mips. */
+	void Evict(StreamedTexture& texture);
+
+	/** Free memory for the number of bytes by evicting textures that weren't requested this frame, least recently requested first. */
+	bool MakeRoom(uint64 bytes);
+
+	void Retire(gpu::Image&& image);
+};
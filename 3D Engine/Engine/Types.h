@@ -12,6 +12,7 @@
 #define ENTRY(Key, Value) { Key, Value },
 
 using uint8 = uint8_t;
+using int16 = int16_t;
 using uint16 = uint16_t;
 using int32 = int32_t;
 using uint32 = uint32_t;
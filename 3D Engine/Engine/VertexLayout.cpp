@@ -0,0 +1,96 @@
+#include "VertexLayout.h"
+#include <Platform/Platform.h>
+
+uint32 VertexLayout::GetNumStreams() const
+{
+	return isInterleaved ? 1 : static_cast<uint32>(numVertexAttributes);
+}
+
+uint32 VertexLayout::GetStream(EVertexAttribute attribute) const
+{
+	return isInterleaved ? 0 : static_cast<uint32>(attribute);
+}
+
+uint32 VertexLayout::GetOffset(EVertexAttribute attribute) const
+{
+	if (!isInterleaved)
+	{
+		return 0;
+	}
+
+	uint32 offset = 0;
+
+	for (std::size_t i = 0; i < static_cast<std::size_t>(attribute); i++)
+	{
+		offset += gpu::ImagePrivate::GetSize(formats[i]);
+	}
+
+	return offset;
+}
+
+uint32 VertexLayout::GetStride(uint32 stream) const
+{
+	if (!isInterleaved)
+	{
+		return gpu::ImagePrivate::GetSize(formats[stream]);
+	}
+
+	uint32 stride = 0;
+
+	for (EFormat format : formats)
+	{
+		stride += gpu::ImagePrivate::GetSize(format);
+	}
+
+	return stride;
+}
+
+VertexAttributeDescription VertexLayout::GetAttribute(EVertexAttribute attribute) const
+{
+	return VertexAttributeDescription
+	{
+		.location = static_cast<uint32>(attribute),
+		.binding = GetStream(attribute),
+		.format = GetFormat(attribute),
+		.offset = GetOffset(attribute),
+	};
+}
+
+std::vector<VertexAttributeDescription> VertexLayout::GetAttributes() const
+{
+	std::vector<VertexAttributeDescription> attributes;
+	attributes.reserve(numVertexAttributes);
+
+	for (std::size_t i = 0; i < numVertexAttributes; i++)
+	{
+		attributes.push_back(GetAttribute(static_cast<EVertexAttribute>(i)));
+	}
+
+	return attributes;
+}
+
+std::vector<VertexBindingDescription> VertexLayout::GetBindings() const
+{
+	std::vector<VertexBindingDescription> bindings;
+	bindings.reserve(GetNumStreams());
+
+	for (uint32 stream = 0; stream < GetNumStreams(); stream++)
+	{
+		bindings.push_back({ stream, GetStride(stream) });
+	}
+
+	return bindings;
+}
+
+VertexLayout VertexLayout::GetCookedLayout()
+{
+	const bool quantizePositions = Platform::GetBool("Engine.ini", "Renderer", "QuantizePositions", true);
+
+	VertexLayout layout;
+	layout.formats[static_cast<std::size_t>(EVertexAttribute::Position)] = quantizePositions ? EFormat::R16G16B16A16_UNORM : EFormat::R32G32B32_SFLOAT;
+	layout.formats[static_cast<std::size_t>(EVertexAttribute::TextureCoordinate)] = EFormat::R16G16_UNORM;
+	layout.formats[static_cast<std::size_t>(EVertexAttribute::Normal)] = EFormat::R16G16_SNORM;
+	layout.isInterleaved = Platform::GetBool("Engine.ini", "Renderer", "InterleaveVertices", false);
+
+	return layout;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <GPU/GPUResource.h>
+
+/** Vertex attributes of static meshes. Must match the locations in StaticMeshCommon.glsl. */
+enum class EVertexAttribute : uint32
+{
+	Position,
+	TextureCoordinate,
+	Normal,
+	Num,
+};
+
+static constexpr std::size_t numVertexAttributes = static_cast<std::size_t>(EVertexAttribute::Num);
+
+/**
+  * How static mesh vertices are laid out in vertex buffers. Attributes are in a stream each, or interleaved in a single stream.
+  * Positions are float3, or unorm16x4 dequantized with the submesh bounds. Texture coordinates are unorm16x2 dequantized
+  * with the submesh UV bounds. Normals are octahedral snorm16x2.
+  */
+struct VertexLayout
+{
+	std::array<EFormat, numVertexAttributes> formats;
+	bool isInterleaved;
+
+	inline EFormat GetFormat(EVertexAttribute attribute) const { return formats[static_cast<std::size_t>(attribute)]; }
+
+	uint32 GetNumStreams() const;
+	uint32 GetStream(EVertexAttribute attribute) const;
+
+	/** Offset of an attribute in a vertex of its stream. */
+	uint32 GetOffset(EVertexAttribute attribute) const;
+
+	uint32 GetStride(uint32 stream) const;
+
+	/** Vertex input of pipelines that draw the layout. Set in GraphicsPipelineDesc::vertexAttributes and vertexBindings. */
+	VertexAttributeDescription GetAttribute(EVertexAttribute attribute) const;
+	std::vector<VertexAttributeDescription> GetAttributes() const;
+	std::vector<VertexBindingDescription> GetBindings() const;
+
+	/** Layout that meshes are cooked with. QuantizePositions and InterleaveVertices in Engine.ini. */
+	static VertexLayout GetCookedLayout();
+};
+
+/** Scale and bias that map quantized attributes back to their range. Attributes that aren't quantized have a scale of 1 and a bias of 0. */
+struct VertexDequantization
+{
+	glm::vec3 positionScale = glm::vec3(1.0f);
+	glm::vec3 positionBias = glm::vec3(0.0f);
+	glm::vec2 textureCoordinateScale = glm::vec2(1.0f);
+	glm::vec2 textureCoordinateBias = glm::vec2(0.0f);
+};
@@ -16,6 +16,15 @@ namespace gpu
 
 		virtual void EndFrame() = 0;
 
+		/** Block until the GPU has finished all submitted work. */
+		virtual void WaitIdle() = 0;
+
+		/** Index of the current frame in the frames-in-flight ring. */
+		virtual uint32 GetFrameIndex() const = 0;
+
+		/** Number of frames the CPU may record ahead of the GPU. */
+		virtual uint32 GetNumFramesInFlight() const = 0;
+
 		virtual void SubmitCommands(gpu::CommandBuffer& cmdBuf) = 0;
 
 		virtual void SubmitCommands(
@@ -24,11 +33,54 @@ namespace gpu
 			const gpu::Semaphore& signalSemaphore
 		) = 0;
 
+		/**
+		  * Submit once everything submitted so far to waitQueue has completed on the GPU.
+		  * Resources handed between queue families also need release and acquire barriers; see ImageMemoryBarrier::srcQueue.
+		  */
+		virtual void SubmitCommands(
+			gpu::CommandBuffer& cmdBuf,
+			EQueue waitQueue,
+			const gpu::Semaphore& waitSemaphore,
+			const gpu::Semaphore& signalSemaphore
+		) = 0;
+
+		/** Whether EQueue::Compute is a separate queue family that runs alongside graphics. If not, compute commands go to the graphics queue. */
+		virtual bool HasAsyncCompute() const = 0;
+
 		virtual gpu::CommandBuffer CreateCommandBuffer(EQueue queue) = 0;
 
-		virtual gpu::Pipeline CreatePipeline(const GraphicsPipelineDesc& graphicsDesc) = 0;
+		/** Intern a pipeline description. Equal descriptions get the same key. Hashes the whole description, so keep keys that are reused. */
+		virtual GraphicsPipelineKey GetPipelineKey(const GraphicsPipelineDesc& graphicsDesc) = 0;
+
+		virtual ComputePipelineKey GetPipelineKey(const ComputePipelineDesc& computeDesc) = 0;
+
+		virtual const GraphicsPipelineDesc& GetPipelineDesc(GraphicsPipelineKey graphicsKey) const = 0;
+
+		virtual gpu::Pipeline CreatePipeline(GraphicsPipelineKey graphicsKey) = 0;
 
-		virtual gpu::Pipeline CreatePipeline(const ComputePipelineDesc& computePipelineDesc) = 0;
+		virtual gpu::Pipeline CreatePipeline(ComputePipelineKey computeKey) = 0;
+
+		inline gpu::Pipeline CreatePipeline(const GraphicsPipelineDesc& graphicsDesc) { return CreatePipeline(GetPipelineKey(graphicsDesc)); }
+
+		inline gpu::Pipeline CreatePipeline(const ComputePipelineDesc& computeDesc) { return CreatePipeline(GetPipelineKey(computeDesc)); }
+
+		/**
+		  * Get a graphics pipeline without waiting for it to be created. While it's created in the background, the pipeline without
+		  * specialization constants is returned in its place, or an invalid pipeline if that's pending too, and the draw should be skipped.
+		  * Finished pipelines are swapped in at the end of a frame.
+		  */
+		virtual gpu::Pipeline CreatePipelineAsync(GraphicsPipelineKey graphicsKey) = 0;
+
+		inline gpu::Pipeline CreatePipelineAsync(const GraphicsPipelineDesc& graphicsDesc) { return CreatePipelineAsync(GetPipelineKey(graphicsDesc)); }
+
+		/** Time interning and looking up pipelines, and the hash rate of pipeline keys. */
+		virtual PipelineKeyBenchmark MeasurePipelineKeys(uint32 numIterations) = 0;
+
+		/** Hits, misses, evictions and sizes of the pipeline, render pass, layout and sampler caches. */
+		virtual std::vector<ResourceCacheStats> GetResourceCacheStats() = 0;
+
+		/** Create pipelines ahead of the frames that use them, in parallel. Pipelines that already exist are skipped. */
+		virtual void WarmUpPipelines(const std::vector<GraphicsPipelineDesc>& graphicsDescs, const std::vector<ComputePipelineDesc>& computeDescs) = 0;
 
 		virtual gpu::Buffer CreateBuffer(
 			EBufferUsage bufferUsage, 
@@ -37,7 +89,69 @@ namespace gpu
 			const void* data = nullptr
 		) = 0;
 
+		/** Allocate transient memory from the upload ring. It's only valid until the end of the frame. */
+		virtual gpu::UploadAllocation AllocateUpload(uint64 size, const void* data = nullptr, uint64 alignment = 0) = 0;
+
+		/** Get the buffer that upload allocations are made from. */
+		virtual const gpu::Buffer& GetUploadBuffer() const = 0;
+
+		/** 
+		  * Copy data to a range of a GPU buffer on the transfer queue. Doesn't block. 
+		  * The range must not be in use by the GPU. Call WaitForUpload() with the returned ticket before the buffer is used.
+		  */
+		virtual gpu::UploadTicket UploadBufferData(const gpu::Buffer& dstBuffer, uint64 dstOffset, uint64 size, const void* data) = 0;
+
+		/** 
+		  * Copy tightly packed pixels to every mip and layer of an image on the transfer queue. The image ends up in the shader read-only layout.
+		  * Mips are packed from the largest to the smallest, and the layers of each mip one after the other.
+		  */
+		virtual gpu::UploadTicket UploadImageData(const gpu::Image& dstImage, const void* srcPixels) = 0;
+
+		/** Make the next graphics submission wait on the GPU for an upload, and take ownership of the uploaded resource. */
+		virtual void WaitForUpload(gpu::UploadTicket ticket) = 0;
+
+		/** Whether an upload has completed. Doesn't block. */
+		virtual bool IsUploadComplete(gpu::UploadTicket ticket) const = 0;
+
+		/** Submit the uploads recorded so far. Uploads are also submitted at the end of the frame. */
+		virtual void FlushUploads() = 0;
+
+		/** Write a GPU timestamp once all prior commands have completed. Returns its index in the frame, or uint32 max if the frame is out of queries. */
+		virtual uint32 WriteTimestamp(gpu::CommandBuffer& cmdBuf) = 0;
+
+		/** Timestamps in milliseconds, indexed as returned by WriteTimestamp(), of the last completed frame that used the current frame index. */
+		virtual const std::vector<double>& GetCompletedTimestamps() const = 0;
+
+		virtual gpu::Image CreateImage(
+			uint32 width,
+			uint32 height,
+			uint32 depth,
+			EFormat format,
+			EImageUsage usageFlags,
+			uint32 mipLevels = 1
+		) = 0;
+
+		/** Size, alignment and memory types of an image, for placing it in a memory block. */
+		virtual gpu::MemoryRequirements GetImageMemoryRequirements(
+			uint32 width,
+			uint32 height,
+			uint32 depth,
+			EFormat format,
+			EImageUsage usageFlags,
+			uint32 mipLevels = 1
+		) = 0;
+
+		/** Allocate device memory for images to be placed in. */
+		virtual gpu::MemoryBlock AllocateMemory(const gpu::MemoryRequirements& memReqs) = 0;
+
+		/**
+		  * Create an image placed at an offset in a memory block. Images placed in overlapping ranges alias, 
+		  * so only one of them may be in use at a time, and its contents are undefined when it's first used.
+		  * The memory block must outlive the image.
+		  */
 		virtual gpu::Image CreateImage(
+			const gpu::MemoryBlock& memory,
+			uint64 offset,
 			uint32 width,
 			uint32 height,
 			uint32 depth,
@@ -60,6 +174,15 @@ namespace gpu
 
 		virtual VkDescriptorSet& GetTextures() = 0;
 
+		/** Create a texture ID that isn't owned by the image's view, so it can be pointed at other images. */
+		virtual gpu::TextureID CreateTextureID(const gpu::Image& image, const gpu::Sampler& sampler) = 0;
+
+		/** Point a texture ID at another image. Frames in flight may still sample the previous image, so it must outlive them. */
+		virtual void UpdateTextureID(gpu::TextureID textureID, const gpu::Image& image, const gpu::Sampler& sampler) = 0;
+
+		/** Release a texture ID created with CreateTextureID(). */
+		virtual void ReleaseTextureID(gpu::TextureID textureID) = 0;
+
 		virtual VkDescriptorSet& GetImages() = 0;
 
 		virtual gpu::Semaphore CreateSemaphore() = 0;
@@ -84,6 +207,9 @@ namespace gpu
 			return static_cast<ShaderType*>(_Shaders[typeIndex]);
 		}
 
+		/** Every compiled shader. */
+		inline const std::unordered_map<std::type_index, gpu::Shader*>& GetShaders() const { return _Shaders; }
+
 		/** Recompile cached shaders. */
 		virtual void RecompileShaders() = 0;
 
@@ -109,6 +235,4 @@ namespace gpu
 		virtual void Resize(gpu::Device& device, uint32 screenWidth, uint32 screenHeight, EImageUsage imageUsage) = 0;
 		virtual const std::vector<gpu::Image>& GetImages() = 0;
 	};
-
-	void UploadImageData(gpu::Device& device, const void* srcPixels, const gpu::Image& dstImage);
 }
\ No newline at end of file
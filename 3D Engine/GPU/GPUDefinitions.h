@@ -5,6 +5,8 @@
 #include "Vulkan/VulkanRenderPass.h"
 #include "Vulkan/VulkanImage.h"
 #include "Vulkan/VulkanBuffer.h"
+#include "Vulkan/VulkanUploadRing.h"
+#include "Vulkan/VulkanUploadService.h"
 #include "Vulkan/VulkanPipeline.h"
 #include "Vulkan/VulkanSemaphore.h"
 
@@ -64,10 +66,12 @@ struct RenderPassDesc
 	std::vector<AttachmentView>	colorAttachments;
 	AttachmentView				depthAttachment;
 	RenderArea					renderArea;
-	EPipelineStage				srcStageMask;
-	EPipelineStage				dstStageMask;
-	EAccess						srcAccessMask;
-	EAccess						dstAccessMask;
+
+	/** External dependencies. Leave as None when barriers are recorded outside of the render pass, e.g. by the frame graph. */
+	EPipelineStage				srcStageMask = EPipelineStage::None;
+	EPipelineStage				dstStageMask = EPipelineStage::None;
+	EAccess						srcAccessMask = EAccess::None;
+	EAccess						dstAccessMask = EAccess::None;
 };
 
 struct GraphicsPipelineDesc
@@ -107,11 +111,64 @@ struct ComputePipelineDesc
 	SpecializationInfo specInfo;
 };
 
+/**
+  * Handle to a pipeline description interned with gpu::Device::GetPipelineKey(). The description is hashed once, when it's interned,
+  * so getting its pipeline is an index and keys compare as integers. Keys stay valid for the device's lifetime.
+  */
+template<typename PipelineDescType>
+class PipelineKey
+{
+public:
+	PipelineKey() = default;
+	explicit PipelineKey(uint32 index) : _Index(index) {}
+
+	inline uint32 GetIndex() const { return _Index; }
+	inline bool IsValid() const { return _Index != invalidIndex; }
+
+	bool operator==(const PipelineKey&) const = default;
+
+private:
+	static constexpr uint32 invalidIndex = ~0u;
+
+	uint32 _Index = invalidIndex;
+};
+
+using GraphicsPipelineKey = PipelineKey<GraphicsPipelineDesc>;
+using ComputePipelineKey = PipelineKey<ComputePipelineDesc>;
+
+/** See gpu::Device::MeasurePipelineKeys(). */
+struct PipelineKeyBenchmark
+{
+	/** Interning a description and getting its pipeline, as when a pass builds its description every draw. */
+	float descLookupNs;
+	/** Getting a pipeline by key. */
+	float keyLookupNs;
+	/** Platform::Hash64(), and the byte-at-a-time CRC32C that keys used to be hashed with. */
+	float hash64GBps;
+	float crc32u8GBps;
+};
+
+/** Counters of one of the device's resource caches. See gpu::Device::GetResourceCacheStats(). */
+struct ResourceCacheStats
+{
+	const char* name;
+	uint64 numHits;
+	uint64 numMisses;
+	uint64 numEvictions;
+	std::size_t size;
+	/** 0 if the cache never evicts. */
+	std::size_t capacity;
+};
+
 struct BufferMemoryBarrier
 {
 	const gpu::Buffer& buffer;
 	EAccess srcAccessMask;
 	EAccess dstAccessMask;
+
+	/** Queue ownership transfer, recorded as a release on srcQueue and a matching acquire on dstQueue. Num if there's no transfer. */
+	EQueue srcQueue = EQueue::Num;
+	EQueue dstQueue = EQueue::Num;
 };
 
 struct ImageMemoryBarrier
@@ -123,6 +180,10 @@ struct ImageMemoryBarrier
 	EImageLayout newLayout;
 	uint32 baseMipLevel = 0;
 	uint32 levelCount = 1;
+
+	/** Queue ownership transfer, recorded as a release on srcQueue and a matching acquire on dstQueue. Num if there's no transfer. */
+	EQueue srcQueue = EQueue::Num;
+	EQueue dstQueue = EQueue::Num;
 };
 
 #include "Vulkan/VulkanCommandBuffer.h"
\ No newline at end of file
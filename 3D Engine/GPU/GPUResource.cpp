@@ -55,6 +55,16 @@ namespace gpu
 		return IsDepth(_Format);
 	}
 
+	bool ImagePrivate::IsBlockCompressed(EFormat format)
+	{
+		static const std::unordered_set<EFormat> blockFormats =
+		{
+			EFormat::BC1_RGBA_UNORM_BLOCK, EFormat::BC2_UNORM_BLOCK, EFormat::BC3_UNORM_BLOCK,
+			EFormat::BC4_UNORM_BLOCK, EFormat::BC5_UNORM_BLOCK, EFormat::BC7_UNORM_BLOCK
+		};
+		return blockFormats.find(format) != blockFormats.end();
+	}
+
 	uint32 ImagePrivate::GetSize(EFormat format)
 	{
 		static std::unordered_map<EFormat, uint32> engineFormatStrides =
@@ -64,10 +74,24 @@ namespace gpu
 			ENTRY(EFormat::R32_SFLOAT, 4)
 			ENTRY(EFormat::R32_SINT, 4)
 			ENTRY(EFormat::R32_UINT, 4)
+			ENTRY(EFormat::R16G16_SFLOAT, 4)
+			ENTRY(EFormat::R16G16_UNORM, 4)
+			ENTRY(EFormat::R16G16_SNORM, 4)
 			ENTRY(EFormat::R16G16B16A16_SFLOAT, 8) 
+			ENTRY(EFormat::R16G16B16A16_UNORM, 8)
+			ENTRY(EFormat::R16G16B16A16_SNORM, 8)
 			ENTRY(EFormat::R32G32B32A32_SFLOAT, 16)
 			ENTRY(EFormat::R32G32B32_SFLOAT, 12)
 			ENTRY(EFormat::R32G32_SFLOAT, 8)
+			ENTRY(EFormat::D32_SFLOAT, 4)
+			ENTRY(EFormat::A2B10G10R10_UNORM_PACK32, 4)
+			ENTRY(EFormat::B10G11R11_UFLOAT_PACK32, 4)
+			ENTRY(EFormat::BC1_RGBA_UNORM_BLOCK, 8)
+			ENTRY(EFormat::BC2_UNORM_BLOCK, 16)
+			ENTRY(EFormat::BC3_UNORM_BLOCK, 16)
+			ENTRY(EFormat::BC4_UNORM_BLOCK, 8)
+			ENTRY(EFormat::BC5_UNORM_BLOCK, 16)
+			ENTRY(EFormat::BC7_UNORM_BLOCK, 16)
 		};
 
 		return engineFormatStrides[format];
@@ -77,4 +101,15 @@ namespace gpu
 	{
 		return GetSize(_Format);
 	}
+
+	uint64 ImagePrivate::GetMipSize(EFormat format, uint32 width, uint32 height)
+	{
+		// The size of a block-compressed format is the size of a block.
+		if (IsBlockCompressed(format))
+		{
+			return uint64(DivideAndRoundUp(width, 4u)) * DivideAndRoundUp(height, 4u) * GetSize(format);
+		}
+
+		return uint64(width) * height * GetSize(format);
+	}
 }
\ No newline at end of file
@@ -35,12 +35,16 @@ enum class EFormat
 	R16G16_UINT,
 	R16G16_SINT,
 	R16G16_SFLOAT,
+	R16G16_UNORM,
+	R16G16_SNORM,
 	R16G16B16_UINT,
 	R16G16B16_SINT,
 	R16G16B16_SFLOAT,
 	R16G16B16A16_UINT,
 	R16G16B16A16_SINT,
 	R16G16B16A16_SFLOAT,
+	R16G16B16A16_UNORM,
+	R16G16B16A16_SNORM,
 	R32_UINT,
 	R32_SINT,
 	R32_SFLOAT,
@@ -59,7 +63,14 @@ enum class EFormat
 	S8_UINT,
 	D32_SFLOAT_S8_UINT,
 	D24_UNORM_S8_UINT,
+	BC1_RGBA_UNORM_BLOCK,
 	BC2_UNORM_BLOCK,
+	BC3_UNORM_BLOCK,
+	BC4_UNORM_BLOCK,
+	BC5_UNORM_BLOCK,
+	BC7_UNORM_BLOCK,
+	A2B10G10R10_UNORM_PACK32,
+	B10G11R11_UFLOAT_PACK32,
 };
 
 struct DrawIndirectCommand
@@ -70,6 +81,15 @@ struct DrawIndirectCommand
 	uint32 firstInstance;
 };
 
+struct DrawIndexedIndirectCommand
+{
+	uint32 indexCount;
+	uint32 instanceCount;
+	uint32 firstIndex;
+	int32 vertexOffset;
+	uint32 firstInstance;
+};
+
 enum class EAccess
 {
 	None = 0,
@@ -209,6 +229,12 @@ struct SamplerDesc
 	ESamplerMipmapMode smm = ESamplerMipmapMode::Linear;
 	float minLod = 0.0f;
 	float maxLod = 0.0f;
+
+	/** Anisotropic filtering is enabled above 1. Clamped to the device limit. */
+	float maxAnisotropy = 1.0f;
+
+	/** Use every mip of the image. */
+	static constexpr float lodClampNone = 1000.0f;
 };
 
 namespace gpu
@@ -244,8 +270,12 @@ namespace gpu
 		static bool IsStencil(EFormat format);
 		static bool IsDepthStencil(EFormat format);
 		static bool IsDepth(EFormat format);
+		static bool IsBlockCompressed(EFormat format);
 		static uint32 GetSize(EFormat format);
 
+		/** Size of a tightly packed 2D mip. Block-compressed mips are padded to whole 4x4 blocks. */
+		static uint64 GetMipSize(EFormat format, uint32 width, uint32 height);
+
 	protected:
 		EFormat _Format;
 		uint32 _Width;
@@ -522,9 +552,10 @@ private:
 	std::vector<uint8> _Data;
 };
 
+/** Hashed by the pipeline cache, so it mustn't have padding. */
 struct VertexAttributeDescription
 {
-	uint64	location = 0;
+	uint32	location = 0;
 	uint32	binding = 0;
 	EFormat	format = EFormat::UNDEFINED;
 	uint32	offset = 0;
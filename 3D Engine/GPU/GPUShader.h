@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 #include <typeindex>
 #include <map>
+#include <functional>
 
 /** Reflects C++ types to shader types. */
 class ShaderTypeReflector
@@ -206,6 +207,9 @@ struct ShaderCompilationTask
 	ShaderCompilerWorker	worker;
 };
 
+/** Called as shaders finish compiling. Calls are serialized, but come from any thread. */
+using ShaderCompilationProgress = std::function<void(uint32 numCompiled, uint32 numShaders)>;
+
 /** Result of shader compilation. */
 class ShaderCompilationResult
 {
@@ -219,9 +223,12 @@ public:
 	/** Shader stage. */
 	EShaderStage stage;
 
-	/** Last time the shader file was written, Platform::GetLastWriteTime(). */
+	/** Last time the shader file or any of its includes was written, Platform::GetLastWriteTime(). */
 	uint64 lastWriteTime;
 
+	/** Files the shader includes, directly or not. */
+	std::vector<std::filesystem::path> includes;
+
 	/** Result of SetEnvironmentVariables. */
 	ShaderCompilerWorker worker;
 
@@ -5,6 +5,9 @@
 #include <iostream>
 #include <algorithm>
 #include <cctype>
+#include <utility>
+#include <cstring>
+#include <nmmintrin.h>
 
 #include <stb_image.h>
 
@@ -64,6 +67,15 @@ std::string WindowsPlatform::FileRead(const std::filesystem::path& path, const s
 	return buffer;
 }
 
+void WindowsPlatform::FileWrite(const std::filesystem::path& path, const std::string& text)
+{
+	std::ofstream file(path, std::ios::binary);
+
+	check(file.is_open(), "Failed to open file %s", path.string().c_str());
+
+	file.write(text.data(), text.size());
+}
+
 void WindowsPlatform::FileDelete(const std::string& filename)
 {
 	check(std::filesystem::remove(filename), "Failed to remove file...");
@@ -86,6 +98,156 @@ uint64 WindowsPlatform::GetLastWriteTime(const std::filesystem::path& path)
 	return lastWriteTime;
 }
 
+MappedFile::MappedFile(const std::filesystem::path& path)
+{
+	_File = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (_File == INVALID_HANDLE_VALUE)
+	{
+		_File = nullptr;
+		return;
+	}
+
+	LARGE_INTEGER size;
+
+	if (!GetFileSizeEx(_File, &size) || size.QuadPart == 0)
+	{
+		return;
+	}
+
+	_Mapping = CreateFileMappingW(_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+	if (_Mapping == nullptr)
+	{
+		return;
+	}
+
+	_Data = static_cast<const uint8*>(MapViewOfFile(_Mapping, FILE_MAP_READ, 0, 0, 0));
+	_Size = _Data ? static_cast<std::size_t>(size.QuadPart) : 0;
+}
+
+MappedFile::~MappedFile()
+{
+	if (_Data)
+	{
+		UnmapViewOfFile(_Data);
+	}
+
+	if (_Mapping)
+	{
+		CloseHandle(_Mapping);
+	}
+
+	if (_File)
+	{
+		CloseHandle(_File);
+	}
+}
+
+DirectoryWatcher::DirectoryWatcher(const std::filesystem::path& directory)
+	: _DirectoryPath(directory)
+{
+	_Directory = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+		OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+
+	if (_Directory == INVALID_HANDLE_VALUE)
+	{
+		_Directory = nullptr;
+		return;
+	}
+
+	_StopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+	_Thread = std::thread([this] () { ThreadMain(); });
+}
+
+DirectoryWatcher::~DirectoryWatcher()
+{
+	if (_Directory)
+	{
+		SetEvent(_StopEvent);
+
+		_Thread.join();
+
+		CloseHandle(_StopEvent);
+		CloseHandle(_Directory);
+	}
+}
+
+std::vector<std::filesystem::path> DirectoryWatcher::TakeChangedFiles()
+{
+	static constexpr std::chrono::milliseconds settleTime(100);
+
+	std::lock_guard lock(_Mutex);
+
+	if (_ChangedFiles.empty() || std::chrono::steady_clock::now() - _LastChangeTime < settleTime)
+	{
+		return {};
+	}
+
+	return std::exchange(_ChangedFiles, {});
+}
+
+void DirectoryWatcher::ThreadMain()
+{
+	// Changes are lost if the buffer overflows between reads, which takes far more than saving a few files.
+	alignas(DWORD) uint8 buffer[16 * 1024];
+
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+	const HANDLE events[] = { overlapped.hEvent, _StopEvent };
+
+	while (ReadDirectoryChangesW(_Directory, buffer, sizeof(buffer), TRUE, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME, nullptr, &overlapped, nullptr))
+	{
+		DWORD numBytes = 0;
+
+		if (WaitForMultipleObjects(static_cast<DWORD>(std::size(events)), events, FALSE, INFINITE) != WAIT_OBJECT_0)
+		{
+			// Stopped. The read must finish before the buffer goes away.
+			CancelIoEx(_Directory, &overlapped);
+			GetOverlappedResult(_Directory, &overlapped, &numBytes, TRUE);
+			break;
+		}
+
+		if (!GetOverlappedResult(_Directory, &overlapped, &numBytes, FALSE))
+		{
+			break;
+		}
+
+		ResetEvent(overlapped.hEvent);
+
+		std::lock_guard lock(_Mutex);
+
+		for (DWORD offset = 0; offset < numBytes; )
+		{
+			const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(buffer + offset);
+
+			// Editors that save by renaming a temporary file over the original show up as the original's new name.
+			if (info->Action != FILE_ACTION_REMOVED && info->Action != FILE_ACTION_RENAMED_OLD_NAME)
+			{
+				const std::filesystem::path path = _DirectoryPath / std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR));
+
+				if (std::find(_ChangedFiles.begin(), _ChangedFiles.end(), path) == _ChangedFiles.end())
+				{
+					_ChangedFiles.push_back(path);
+				}
+
+				_LastChangeTime = std::chrono::steady_clock::now();
+			}
+
+			if (info->NextEntryOffset == 0)
+			{
+				break;
+			}
+
+			offset += info->NextEntryOffset;
+		}
+	}
+
+	CloseHandle(overlapped.hEvent);
+}
+
 void WindowsPlatform::WriteLog(const std::string& log)
 {
 	printf("%s\n", log.c_str());
@@ -199,13 +361,48 @@ void WindowsPlatform::Memcpy(void* dst, const void* src, size_t size)
 	memcpy(dst, src, size);
 }
 
+/** Convert 16-bit RGBA to RGBA8 in place, rounding to the nearest value. stb_image's 8-bit loads truncate instead. */
+static uint8* ConvertToRGBA8(uint16* pixels, int32 width, int32 height)
+{
+	if (pixels == nullptr)
+	{
+		return nullptr;
+	}
+
+	uint8* dst = reinterpret_cast<uint8*>(pixels);
+	const std::size_t numValues = static_cast<std::size_t>(width) * height * STBI_rgb_alpha;
+
+	// Each value is read before the byte it's packed into is written.
+	for (std::size_t i = 0; i < numValues; i++)
+	{
+		dst[i] = static_cast<uint8>((pixels[i] * 255u + 32767u) / 65535u);
+	}
+
+	return dst;
+}
+
 #undef LoadImage
 uint8* WindowsPlatform::LoadImage(const std::filesystem::path& path, int32& width, int32& height, int32& numChannels)
 {
+	if (stbi_is_16_bit(path.string().c_str()))
+	{
+		return ConvertToRGBA8(stbi_load_16(path.string().c_str(), &width, &height, &numChannels, STBI_rgb_alpha), width, height);
+	}
+
 	uint8* image = stbi_load(path.string().c_str(), &width, &height, &numChannels, STBI_rgb_alpha);
 	return image;
 }
 
+uint8* WindowsPlatform::DecodeImage(const uint8* data, std::size_t size, int32& width, int32& height, int32& numChannels)
+{
+	if (stbi_is_16_bit_from_memory(data, static_cast<int32>(size)))
+	{
+		return ConvertToRGBA8(stbi_load_16_from_memory(data, static_cast<int32>(size), &width, &height, &numChannels, STBI_rgb_alpha), width, height);
+	}
+
+	return stbi_load_from_memory(data, static_cast<int32>(size), &width, &height, &numChannels, STBI_rgb_alpha);
+}
+
 void WindowsPlatform::FreeImage(uint8* pixels)
 {
 	stbi_image_free(pixels);
@@ -360,4 +557,34 @@ void Platform::crc32_u32(Crc& crc, const void* data, std::size_t numBytes)
 	{
 		crc = _mm_crc32_u32(crc, dwords[i]);
 	}
+}
+
+uint64 Platform::Hash64(const void* data, std::size_t numBytes)
+{
+	const uint8* bytes = static_cast<const uint8*>(data);
+
+	// Different nonzero seeds, so zeros don't hash to zero and data with equal halves doesn't hash to equal halves.
+	uint64 lo = 0xffffffff;
+	uint64 hi = 0x9e3779b9;
+
+	std::size_t i = 0;
+
+	for (; i + 2 * sizeof(uint64) <= numBytes; i += 2 * sizeof(uint64))
+	{
+		uint64 words[2];
+		std::memcpy(words, bytes + i, sizeof(words));
+
+		lo = _mm_crc32_u64(lo, words[0]);
+		hi = _mm_crc32_u64(hi, words[1]);
+	}
+
+	for (; i < numBytes; ++i)
+	{
+		lo = _mm_crc32_u8(static_cast<uint32>(lo), bytes[i]);
+	}
+
+	// The length tells apart data that only differs by trailing zeros.
+	hi = _mm_crc32_u64(hi, numBytes);
+
+	return (hi << 32) | (lo & 0xffffffff);
 }
\ No newline at end of file
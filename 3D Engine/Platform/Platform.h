@@ -1,6 +1,9 @@
 #pragma once
 #include <Engine/Types.h>
 #include <filesystem>
+#include <chrono>
+#include <mutex>
+#include <thread>
 
 using Crc = uint32;
 
@@ -72,6 +75,7 @@ public:
 
 	// File I/O
 	static std::string FileRead(const std::filesystem::path& path, const std::string& prependText = "");
+	static void FileWrite(const std::filesystem::path& path, const std::string& text);
 	static void FileDelete(const std::string& filename);
 	static void FileRename(const std::string& oldName, const std::string& newNew);
 	static bool FileExists(const std::string& filename);
@@ -91,7 +95,10 @@ public:
 
 	// Loading
 #undef LoadImage
+	/** Load an image as RGBA8. 16-bit images are rounded to 8 bits. numChannels is the number of channels in the file. */
 	static uint8* LoadImage(const std::filesystem::path& path, int32& width, int32& height, int32& numChannels);
+	/** Decode an encoded image in memory as RGBA8, like LoadImage(). */
+	static uint8* DecodeImage(const uint8* data, std::size_t size, int32& width, int32& height, int32& numChannels);
 	static void FreeImage(uint8* pixels);
 
 	// .ini
@@ -103,10 +110,91 @@ public:
 
 	static void crc32_u8(Crc& crc, const void* data, std::size_t numBytes);
 	static void crc32_u32(Crc& crc, const void* data, std::size_t numBytes);
+
+	/** 64-bit hash from two CRC32C lanes over alternating 8-byte words, one lane per half. The lanes keep two crc32 instructions in flight. */
+	static uint64 Hash64(const void* data, std::size_t numBytes);
 };
 
 using Platform = WindowsPlatform;
 
+/** Append the bytes of a table, after its size, so neighbouring tables can't shift into each other. Keys built from them are hashed with Platform::Hash64(). */
+template<typename T>
+inline void AppendKeyBytes(std::string& keyBytes, const std::vector<T>& table)
+{
+	const uint32 size = static_cast<uint32>(table.size());
+	keyBytes.append(reinterpret_cast<const char*>(&size), sizeof(size));
+	keyBytes.append(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(T));
+}
+
+inline void AppendKeyBytes(std::string& keyBytes, const std::string& string)
+{
+	const uint32 size = static_cast<uint32>(string.size());
+	keyBytes.append(reinterpret_cast<const char*>(&size), sizeof(size));
+	keyBytes.append(string);
+}
+
+template<typename T>
+inline void AppendKeyBytes(std::string& keyBytes, const T& state)
+{
+	keyBytes.append(reinterpret_cast<const char*>(&state), sizeof(state));
+}
+
+/** A file mapped read-only into memory. The file is unmapped when the mapping is destroyed. */
+class MappedFile
+{
+public:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/** Map the whole file. The mapping isn't open if the file doesn't exist or is empty. */
+	MappedFile(const std::filesystem::path& path);
+	~MappedFile();
+
+	inline bool IsOpen() const { return _Data != nullptr; }
+	inline const uint8* GetData() const { return _Data; }
+	inline std::size_t GetSize() const { return _Size; }
+
+private:
+	/** HANDLE */
+	void* _File = nullptr;
+	void* _Mapping = nullptr;
+	const uint8* _Data = nullptr;
+	std::size_t _Size = 0;
+};
+
+/** Watches a directory and its subdirectories for files that are written, on a thread of its own. */
+class DirectoryWatcher
+{
+public:
+	DirectoryWatcher(const DirectoryWatcher&) = delete;
+	DirectoryWatcher& operator=(const DirectoryWatcher&) = delete;
+
+	/** The watcher does nothing if the directory doesn't exist. */
+	DirectoryWatcher(const std::filesystem::path& directory);
+	~DirectoryWatcher();
+
+	/**
+	  * Take the files written since the last call, as paths in the watched directory.
+	  * Editors may write a file more than once per save, so nothing is returned until the directory has been quiet for a moment.
+	  */
+	std::vector<std::filesystem::path> TakeChangedFiles();
+
+private:
+	std::filesystem::path _DirectoryPath;
+
+	/** HANDLE */
+	void* _Directory = nullptr;
+	void* _StopEvent = nullptr;
+
+	std::mutex _Mutex;
+	std::vector<std::filesystem::path> _ChangedFiles;
+	std::chrono::steady_clock::time_point _LastChangeTime;
+
+	std::thread _Thread;
+
+	void ThreadMain();
+};
+
 // Log.
 #define LOG(fmt, ...) { Platform::WriteLog(Platform::FormatString(fmt, __VA_ARGS__)); }
 
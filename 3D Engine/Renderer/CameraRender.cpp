@@ -1,26 +1,135 @@
 #include "CameraRender.h"
 #include <Components/Camera.h>
+#include <Systems/CameraSystem.h>
+#include <numeric>
 
-void CameraRender::Resize(gpu::Device& device, uint32 width, uint32 height)
+/** Assign offsets so that targets with overlapping lifetimes don't overlap in memory. Returns the size of the memory block. */
+static uint64 PlaceTransientTargets(const std::vector<const gpu::MemoryRequirements*>& memReqs, const std::vector<FrameGraph::Lifetime>& lifetimes, std::vector<uint64>& offsets)
 {
-	_DirectLighting = device.CreateImage(width, height, 1, EFormat::R16G16B16A16_SFLOAT, EImageUsage::Attachment | EImageUsage::Storage);
+	std::vector<std::size_t> order(memReqs.size());
+	std::iota(order.begin(), order.end(), 0);
 
-	_SceneColor = device.CreateImage(width, height, 1, EFormat::R16G16B16A16_SFLOAT, EImageUsage::Attachment | EImageUsage::Storage | EImageUsage::TransferDst);
-	_SceneDepth = device.CreateImage(width, height, 1, EFormat::D32_SFLOAT, EImageUsage::Attachment | EImageUsage::Sampled);
+	// Largest first, so smaller targets fill the gaps.
+	std::sort(order.begin(), order.end(), [&] (std::size_t a, std::size_t b) { return memReqs[a]->size > memReqs[b]->size; });
+
+	std::vector<std::size_t> placed;
+	uint64 memorySize = 0;
+
+	offsets.resize(memReqs.size());
+
+	for (auto target : order)
+	{
+		const uint64 size = memReqs[target]->size;
+		const uint64 alignment = memReqs[target]->alignment;
+
+		// The lowest offset is either the start of the block or the end of a live target.
+		std::vector<uint64> candidates = { 0 };
+
+		for (auto other : placed)
+		{
+			if (lifetimes[target].Overlaps(lifetimes[other]))
+			{
+				candidates.push_back(DivideAndRoundUp(offsets[other] + memReqs[other]->size, alignment) * alignment);
+			}
+		}
+
+		std::sort(candidates.begin(), candidates.end());
+
+		for (auto candidate : candidates)
+		{
+			const bool fits = std::none_of(placed.begin(), placed.end(), [&] (std::size_t other)
+			{
+				return lifetimes[target].Overlaps(lifetimes[other]) && candidate < offsets[other] + memReqs[other]->size && offsets[other] < candidate + size;
+			});
+
+			if (fits)
+			{
+				offsets[target] = candidate;
+				break;
+			}
+		}
+
+		memorySize = std::max(memorySize, offsets[target] + size);
+		placed.push_back(target);
+	}
 
-	_GBuffer0 = device.CreateImage(width, height, 1, EFormat::R32G32B32A32_SFLOAT, EImageUsage::Attachment | EImageUsage::Sampled);
-	_GBuffer1 = device.CreateImage(width, height, 1, EFormat::R8G8B8A8_UNORM, EImageUsage::Attachment | EImageUsage::Sampled);
+	return memorySize;
+}
+
+void CameraRender::Resize(gpu::Device& device, uint32 width, uint32 height)
+{
+	// Frames in flight may still be using the old render targets.
+	device.WaitIdle();
 
+	_SceneColor = device.CreateImage(width, height, 1, EFormat::R16G16B16A16_SFLOAT, EImageUsage::Attachment | EImageUsage::Storage | EImageUsage::TransferDst);
 	_SSRHistory = device.CreateImage(width, height, 1, EFormat::R16G16B16A16_SFLOAT, EImageUsage::Storage);
 	_SSGIHistory = device.CreateImage(width, height, 1, EFormat::R16G16B16A16_SFLOAT, EImageUsage::Storage);
 
-	CreateGBufferRP(device);
+	const uint32 hiZWidth = std::max(width / 2, 1u);
+	const uint32 hiZHeight = std::max(height / 2, 1u);
+	const uint32 hiZMipLevels = static_cast<uint32>(std::floor(std::log2(std::max(hiZWidth, hiZHeight)))) + 1;
 
-	CreateSkyboxRP(device);
+	_HiZ = device.CreateImage(hiZWidth, hiZHeight, 1, EFormat::R32_SFLOAT, EImageUsage::Storage | EImageUsage::Sampled, hiZMipLevels);
+	_HiZMips.clear();
 
-	gpu::CommandBuffer cmdBuf = device.CreateCommandBuffer(EQueue::Transfer);
+	for (uint32 mipLevel = 0; mipLevel < hiZMipLevels; mipLevel++)
+	{
+		_HiZMips.push_back(device.CreateImageView(_HiZ, mipLevel, 1, 0, 1));
+	}
+
+	_IsHiZValid = false;
+
+	_TransientTargets =
+	{
+		// See GBufferCommon.glsl for the encoding.
+		{ &CameraRender::_GBuffer0, EFormat::A2B10G10R10_UNORM_PACK32, EImageUsage::Attachment | EImageUsage::Sampled },
+		{ &CameraRender::_GBuffer1, EFormat::R8G8B8A8_UNORM, EImageUsage::Attachment | EImageUsage::Sampled },
+		{ &CameraRender::_SceneDepth, EFormat::D32_SFLOAT, EImageUsage::Attachment | EImageUsage::Sampled },
+		{ &CameraRender::_DirectLighting, EFormat::B10G11R11_UFLOAT_PACK32, EImageUsage::Attachment | EImageUsage::Storage },
+	};
 
-	ImageMemoryBarrier barriers[] = { { _SSRHistory }, { _SSGIHistory } };
+	_MemoryStats = {};
+
+	for (const auto* image : { &_SceneColor, &_SSRHistory, &_SSGIHistory })
+	{
+		_MemoryStats.persistentBytes += device.GetImageMemoryRequirements(width, height, 1, image->GetFormat(), image->GetUsage()).size;
+	}
+
+	_MemoryStats.persistentBytes += device.GetImageMemoryRequirements(_HiZ.GetWidth(), _HiZ.GetHeight(), 1, _HiZ.GetFormat(), _HiZ.GetUsage(), hiZMipLevels).size;
+
+	// Until the frame graph has been compiled, assume every transient target is live at once.
+	std::vector<const gpu::MemoryRequirements*> memReqs;
+	std::vector<FrameGraph::Lifetime> lifetimes;
+	std::vector<uint64> offsets;
+
+	for (auto& target : _TransientTargets)
+	{
+		target.memReqs = device.GetImageMemoryRequirements(width, height, 1, target.format, target.usage);
+		target.lifetime = FrameGraph::Lifetime{ 0, 0 };
+
+		_MemoryStats.transientBytes += target.memReqs.size;
+		_MemoryStats.transientBytesPerPixel += gpu::Image::GetSize(target.format);
+
+		memReqs.push_back(&target.memReqs);
+		lifetimes.push_back(target.lifetime);
+	}
+
+	const uint64 memorySize = PlaceTransientTargets(memReqs, lifetimes, offsets);
+
+	for (std::size_t targetIndex = 0; targetIndex < _TransientTargets.size(); targetIndex++)
+	{
+		_TransientTargets[targetIndex].offset = offsets[targetIndex];
+	}
+
+	_Width = width;
+	_Height = height;
+
+	CreateTransientTargets(device, memorySize);
+
+	gpu::CommandBuffer cmdBuf = device.CreateCommandBuffer(EQueue::Graphics);
+
+	// The histories, ray traced scene color and Hi-Z persist across frames, so the frame graph imports them in the general layout.
+	ImageMemoryBarrier barriers[] = { { _SceneColor }, { _SSRHistory }, { _SSGIHistory }, { _HiZ } };
 
 	for (auto& barrier : barriers)
 	{
@@ -28,6 +137,7 @@ void CameraRender::Resize(gpu::Device& device, uint32 width, uint32 height)
 		barrier.dstAccessMask = EAccess::MemoryRead | EAccess::MemoryWrite;
 		barrier.oldLayout = EImageLayout::Undefined;
 		barrier.newLayout = EImageLayout::General;
+		barrier.levelCount = barrier.image.GetMipLevels();
 	}
 
 	cmdBuf.PipelineBarrier(EPipelineStage::TopOfPipe, EPipelineStage::TopOfPipe, 0, nullptr, std::size(barriers), barriers);
@@ -35,26 +145,129 @@ void CameraRender::Resize(gpu::Device& device, uint32 width, uint32 height)
 	device.SubmitCommands(cmdBuf);
 }
 
+bool CameraRender::UpdateTransientTargets(gpu::Device& device, const FrameGraph& graph)
+{
+	std::vector<const gpu::MemoryRequirements*> memReqs;
+	std::vector<FrameGraph::Lifetime> lifetimes;
+	bool lifetimesChanged = false;
+
+	for (auto& target : _TransientTargets)
+	{
+		memReqs.push_back(&target.memReqs);
+		lifetimes.push_back(graph.GetLifetime(this->*target.image));
+		lifetimesChanged |= !(lifetimes.back() == target.lifetime);
+	}
+
+	if (!lifetimesChanged)
+	{
+		return false;
+	}
+
+	// The current placement is only safe if targets that share memory aren't used at the same time.
+	bool isPlacementValid = true;
+
+	for (std::size_t a = 0; a < _TransientTargets.size(); a++)
+	{
+		for (std::size_t b = a + 1; b < _TransientTargets.size(); b++)
+		{
+			const bool sharesMemory = 
+				_TransientTargets[a].offset < _TransientTargets[b].offset + memReqs[b]->size && 
+				_TransientTargets[b].offset < _TransientTargets[a].offset + memReqs[a]->size;
+
+			isPlacementValid &= !(sharesMemory && lifetimes[a].Overlaps(lifetimes[b]));
+		}
+	}
+
+	std::vector<uint64> offsets;
+	const uint64 memorySize = PlaceTransientTargets(memReqs, lifetimes, offsets);
+
+	for (std::size_t targetIndex = 0; targetIndex < _TransientTargets.size(); targetIndex++)
+	{
+		_TransientTargets[targetIndex].lifetime = lifetimes[targetIndex];
+	}
+
+	if (isPlacementValid && memorySize >= _TransientMemory.GetSize())
+	{
+		return false;
+	}
+
+	for (std::size_t targetIndex = 0; targetIndex < _TransientTargets.size(); targetIndex++)
+	{
+		_TransientTargets[targetIndex].offset = offsets[targetIndex];
+	}
+
+	// Frames in flight may still be using the old placement.
+	device.WaitIdle();
+
+	CreateTransientTargets(device, memorySize);
+
+	return true;
+}
+
+void CameraRender::CreateTransientTargets(gpu::Device& device, uint64 memorySize)
+{
+	// Free the old targets before their memory.
+	for (const auto& target : _TransientTargets)
+	{
+		this->*target.image = gpu::Image();
+	}
+
+	_TransientMemory = gpu::MemoryBlock();
+
+	gpu::MemoryRequirements blockMemReqs = { memorySize, 1, ~0u };
+
+	for (const auto& target : _TransientTargets)
+	{
+		blockMemReqs.alignment = std::max(blockMemReqs.alignment, target.memReqs.alignment);
+		blockMemReqs.memoryTypeBits &= target.memReqs.memoryTypeBits;
+	}
+
+	check(blockMemReqs.memoryTypeBits != 0, "Transient render targets have no memory type in common.");
+
+	_TransientMemory = device.AllocateMemory(blockMemReqs);
+
+	for (const auto& target : _TransientTargets)
+	{
+		this->*target.image = device.CreateImage(_TransientMemory, target.offset, _Width, _Height, 1, target.format, target.usage);
+	}
+
+	_MemoryStats.transientMemoryBytes = memorySize;
+
+	const uint64 budget = static_cast<uint64>(Platform::GetInt("Engine.ini", "Renderer", "RenderTargetBudget", 512)) << 20;
+	const uint64 totalBytes = _MemoryStats.persistentBytes + _MemoryStats.transientMemoryBytes;
+
+	LOG("Camera render targets: %.1f MB persistent, %.1f MB transient (%u bytes/pixel) in %.1f MB of shared memory, saving %.1f MB.",
+		_MemoryStats.persistentBytes / 1048576.0, _MemoryStats.transientBytes / 1048576.0, _MemoryStats.transientBytesPerPixel, _MemoryStats.transientMemoryBytes / 1048576.0,
+		_MemoryStats.transientBytes / 1048576.0 - _MemoryStats.transientMemoryBytes / 1048576.0);
+
+	if (totalBytes > budget)
+	{
+		LOG("Camera render targets use %.1f MB, over the %.1f MB budget.", totalBytes / 1048576.0, budget / 1048576.0);
+	}
+
+	CreateGBufferRP(device);
+
+	CreateSkyboxRP(device);
+
+	UpdateDescriptors(device);
+}
+
 void CameraRender::CreateGBufferRP(gpu::Device& device)
 {
 	RenderPassDesc rpDesc = {};
 	rpDesc.colorAttachments =
 	{
-		AttachmentView(&_GBuffer0, ELoadAction::Clear, EStoreAction::Store, std::array<float, 4>{ 0.0f }, EImageLayout::Undefined, EImageLayout::ShaderReadOnlyOptimal),
-		AttachmentView(&_GBuffer1, ELoadAction::Clear, EStoreAction::Store, std::array<float, 4>{ 0.0f }, EImageLayout::Undefined, EImageLayout::ShaderReadOnlyOptimal)
+		AttachmentView(&_GBuffer0, ELoadAction::Clear, EStoreAction::Store, std::array<float, 4>{ 0.0f }, EImageLayout::ColorAttachmentOptimal, EImageLayout::ColorAttachmentOptimal),
+		AttachmentView(&_GBuffer1, ELoadAction::Clear, EStoreAction::Store, std::array<float, 4>{ 0.0f }, EImageLayout::ColorAttachmentOptimal, EImageLayout::ColorAttachmentOptimal)
 	};
 	rpDesc.depthAttachment = AttachmentView(
 		&_SceneDepth,
 		ELoadAction::Clear,
 		EStoreAction::Store,
 		ClearDepthStencilValue{},
-		EImageLayout::Undefined,
-		EImageLayout::DepthReadStencilWrite);
+		EImageLayout::DepthWriteStencilWrite,
+		EImageLayout::DepthWriteStencilWrite);
 	rpDesc.renderArea = RenderArea{ glm::ivec2(), glm::uvec2(_SceneDepth.GetWidth(), _SceneDepth.GetHeight()) };
-	rpDesc.srcStageMask = EPipelineStage::TopOfPipe;
-	rpDesc.dstStageMask = EPipelineStage::ComputeShader;
-	rpDesc.srcAccessMask = EAccess::None;
-	rpDesc.dstAccessMask = EAccess::ShaderRead | EAccess::ShaderWrite;
 
 	_GBufferRP = device.CreateRenderPass(rpDesc);
 }
@@ -63,19 +276,34 @@ void CameraRender::CreateSkyboxRP(gpu::Device& device)
 {
 	RenderPassDesc rpDesc = {};
 	rpDesc.colorAttachments.push_back(
-		AttachmentView(&_DirectLighting, ELoadAction::Load, EStoreAction::Store, std::array<float, 4>{ 0.0f }, EImageLayout::General, EImageLayout::General));
+		AttachmentView(&_DirectLighting, ELoadAction::Load, EStoreAction::Store, std::array<float, 4>{ 0.0f }, EImageLayout::ColorAttachmentOptimal, EImageLayout::ColorAttachmentOptimal));
 	rpDesc.depthAttachment = AttachmentView(
 		&_SceneDepth,
 		ELoadAction::Load,
 		EStoreAction::Store,
 		ClearDepthStencilValue{},
-		EImageLayout::DepthReadStencilWrite,
-		EImageLayout::DepthReadStencilWrite);
+		EImageLayout::DepthWriteStencilWrite,
+		EImageLayout::DepthWriteStencilWrite);
 	rpDesc.renderArea = RenderArea{ glm::ivec2(), glm::uvec2(_SceneDepth.GetWidth(), _SceneDepth.GetHeight()) };
-	rpDesc.srcStageMask = EPipelineStage::ComputeShader;
-	rpDesc.dstStageMask = EPipelineStage::ComputeShader;
-	rpDesc.srcAccessMask = EAccess::ShaderRead | EAccess::ShaderWrite;
-	rpDesc.dstAccessMask = EAccess::ShaderRead | EAccess::ShaderWrite;
 
 	_SkyboxRP = device.CreateRenderPass(rpDesc);
+}
+
+void CameraRender::UpdateDescriptors(gpu::Device& device)
+{
+	const gpu::Sampler sampler = device.CreateSampler({ EFilter::Nearest });
+
+	// The camera uniform lives in the upload ring and is selected with a dynamic offset, 
+	// so the descriptor set only changes when the render targets do.
+	CameraDescriptors descriptors;
+	descriptors._CameraUniform = { device.GetUploadBuffer(), 0, sizeof(CameraUniform) };
+	descriptors._SceneDepth = { _SceneDepth, sampler };
+	descriptors._GBuffer0 = { _GBuffer0, sampler };
+	descriptors._GBuffer1 = { _GBuffer1, sampler };
+	descriptors._SceneColor = _SceneColor;
+	descriptors._SSRHistory = _SSRHistory;
+	descriptors._SSGIHistory = _SSGIHistory;
+	descriptors._DirectLighting = _DirectLighting;
+
+	device.UpdateDescriptorSet(descriptors);
 }
\ No newline at end of file
@@ -1,9 +1,13 @@
 #pragma once
 #include <ECS/Component.h>
 #include <GPU/GPU.h>
+#include "FrameGraph.h"
 
 class CameraRender : public Component
 {
+	/** Memory shared by the transient targets. Declared first so it's freed after them. */
+	gpu::MemoryBlock _TransientMemory;
+
 public:
 	CameraRender() = default;
 
@@ -18,15 +22,72 @@ public:
 	gpu::Image _SSGIHistory;
 	gpu::Image _DirectLighting;
 
+	/** Mip chain of the farthest depth at half resolution. Built from the scene depth after the GBuffer, and tested by the next frame's cluster culling. */
+	gpu::Image _HiZ;
+	/** Storage view of each mip, written one pass at a time. */
+	std::vector<gpu::ImageView> _HiZMips;
+	/** Whether _HiZ holds the last frame's depth. It doesn't after a resize, or after a frame that didn't rasterize. */
+	bool _IsHiZValid = false;
+
+	/** Render target memory of the camera. */
+	struct MemoryStats
+	{
+		/** Targets that persist across frames. */
+		uint64 persistentBytes = 0;
+
+		/** Transient targets if each had its own memory. */
+		uint64 transientBytes = 0;
+
+		/**
+		  * Memory actually backing the transient targets. It's only less than transientBytes when some of them aren't used at the same time.
+		  * SSGI reads all four, so in raster mode none of them share memory. In ray tracing mode the raster passes are culled and they all do.
+		  */
+		uint64 transientMemoryBytes = 0;
+
+		/** Bytes written and read per pixel across the transient targets, e.g. by the GBuffer and lighting passes. */
+		uint32 transientBytesPerPixel = 0;
+	};
+
 	void Resize(gpu::Device& device, uint32 width, uint32 height);
 
+	/**
+	  * Transient targets are placed in shared memory by their lifetimes in the frame graph.
+	  * Re-place them if the compiled graph uses targets that share memory at the same time, or if they'd fit in less memory.
+	  * Returns true if the targets were recreated.
+	  */
+	bool UpdateTransientTargets(gpu::Device& device, const FrameGraph& graph);
+
 	void SetDynamicOffset(uint32 dynamicOffset) { _DynamicOffset = dynamicOffset; }
 	inline uint32 GetDynamicOffset() const { return _DynamicOffset; }
+	inline const MemoryStats& GetMemoryStats() const { return _MemoryStats; }
 
 private:
+	/** A render target that's rewritten every frame, so its memory may alias other transient targets. */
+	struct TransientTarget
+	{
+		gpu::Image CameraRender::* image;
+		EFormat format;
+		EImageUsage usage;
+		gpu::MemoryRequirements memReqs = {};
+		FrameGraph::Lifetime lifetime = {};
+		uint64 offset = 0;
+	};
+
+	std::vector<TransientTarget> _TransientTargets;
+
+	MemoryStats _MemoryStats;
+
+	uint32 _Width = 0;
+
+	uint32 _Height = 0;
+
+	uint32 _DynamicOffset;
+
+	void CreateTransientTargets(gpu::Device& device, uint64 memorySize);
+
 	void CreateGBufferRP(gpu::Device& device);
 
 	void CreateSkyboxRP(gpu::Device& device);
 
-	uint32 _DynamicOffset;
-};
\ No newline at end of file
+	void UpdateDescriptors(gpu::Device& device);
+};
@@ -0,0 +1,238 @@
+#include "SceneRenderer.h"
+#include <ECS/EntityManager.h>
+#include <Components/RenderSettings.h>
+#include <Systems/CameraSystem.h>
+#include <Systems/SurfaceSystem.h>
+
+/** A meshlet of a drawn level, culled into the indirect command with the same index. Bounds are in the surface's local space. */
+BEGIN_UNIFORM_BUFFER(ClusterCandidate)
+	MEMBER(glm::vec3, center)
+	MEMBER(float, radius)
+	MEMBER(glm::vec3, coneAxis)
+	MEMBER(float, coneCutoff)
+	MEMBER(uint32, firstIndex)
+	MEMBER(uint32, indexCount)
+	MEMBER(uint32, surfaceID)
+	MEMBER(uint32, _pad0)
+END_UNIFORM_BUFFER(ClusterCandidate)
+
+BEGIN_UNIFORM_BUFFER(ClusterCullingView)
+	MEMBER(glm::mat4, worldToClip)
+	MEMBER(glm::mat4, prevWorldToClip)
+	MEMBER(glm::vec3, position)
+	MEMBER(uint32, _pad0)
+END_UNIFORM_BUFFER(ClusterCullingView)
+
+DECLARE_UNIFORM_BUFFER(ClusterCandidate)
+DECLARE_UNIFORM_BUFFER(ClusterCullingView)
+
+BEGIN_PUSH_CONSTANTS(ClusterCullingParams)
+	MEMBER(uint32, _View)
+	MEMBER(uint32, _FirstCandidate)
+	MEMBER(uint32, _NumCandidates)
+	MEMBER(uint32, _FirstCommand)
+	MEMBER(uint32, _ConeCulling)
+	MEMBER(uint32, _OcclusionCulling)
+	MEMBER(gpu::TextureID, _HiZ)
+	MEMBER(uint32, _HiZMipLevels)
+END_PUSH_CONSTANTS(ClusterCullingParams)
+
+BEGIN_DESCRIPTOR_SET(ClusterCullingDescriptors)
+	DESCRIPTOR(gpu::StorageBuffer, _CandidateBuffer)
+	DESCRIPTOR(gpu::StorageBuffer, _ViewBuffer)
+	DESCRIPTOR(gpu::StorageBuffer, _CommandBuffer)
+END_DESCRIPTOR_SET(ClusterCullingDescriptors)
+
+DECLARE_DESCRIPTOR_SET(ClusterCullingDescriptors)
+
+BEGIN_PUSH_CONSTANTS(HiZBuildParams)
+	MEMBER(gpu::ImageID, _Src)
+	MEMBER(gpu::ImageID, _Dst)
+	MEMBER(uint32, _IsFirstMip)
+END_PUSH_CONSTANTS(HiZBuildParams)
+
+class ClusterCullingCS : public gpu::Shader
+{
+public:
+	ClusterCullingCS() = default;
+};
+
+REGISTER_SHADER(ClusterCullingCS, "../Shaders/ClusterCullingCS.glsl", "main", EShaderStage::Compute);
+
+class HiZBuildCS : public gpu::Shader
+{
+public:
+	HiZBuildCS() = default;
+};
+
+REGISTER_SHADER(HiZBuildCS, "../Shaders/HiZBuildCS.glsl", "main", EShaderStage::Compute);
+
+void SceneRenderer::CullClusters(SurfaceDrawList& drawList, const ClusterCullingDesc& desc, ClusterCullingStats& stats, FrameGraph& graph)
+{
+	uint32 numCandidates = 0;
+
+	for (SurfaceDraw& draw : drawList.draws)
+	{
+		draw.firstCommand = _NumClusterCommands + numCandidates;
+		numCandidates += draw.lod->numMeshlets;
+	}
+
+	if (numCandidates == 0)
+	{
+		return;
+	}
+
+	// Align to the element size so the candidates can be indexed as an array in the culling shader.
+	const gpu::UploadAllocation allocation = _Device.AllocateUpload(numCandidates * sizeof(ClusterCandidate), nullptr, sizeof(ClusterCandidate));
+	auto* candidates = static_cast<ClusterCandidate*>(allocation.data);
+
+	for (const SurfaceDraw& draw : drawList.draws)
+	{
+		const std::vector<SubmeshMeshlet>& meshlets = draw.submesh->GetMeshlets();
+
+		for (uint32 meshletIndex = draw.lod->firstMeshlet; meshletIndex < draw.lod->firstMeshlet + draw.lod->numMeshlets; meshletIndex++)
+		{
+			const SubmeshMeshlet& meshlet = meshlets[meshletIndex];
+
+			candidates->center = meshlet.center;
+			candidates->radius = meshlet.radius;
+			candidates->coneAxis = meshlet.coneAxis;
+			candidates->coneCutoff = meshlet.coneCutoff;
+			candidates->firstIndex = meshlet.firstIndex;
+			candidates->indexCount = meshlet.indexCount;
+			candidates->surfaceID = draw.surface->GetSurfaceID();
+			candidates++;
+		}
+	}
+
+	ClusterCullingView view;
+	view.worldToClip = desc.worldToClip;
+	view.prevWorldToClip = desc.prevWorldToClip;
+	view.position = desc.position;
+
+	const gpu::UploadAllocation viewAllocation = _Device.AllocateUpload(sizeof(view), &view, sizeof(view));
+
+	ClusterCullingParams clusterCullingParams;
+	clusterCullingParams._View = static_cast<uint32>(viewAllocation.offset / sizeof(ClusterCullingView));
+	clusterCullingParams._FirstCandidate = static_cast<uint32>(allocation.offset / sizeof(ClusterCandidate));
+	clusterCullingParams._NumCandidates = numCandidates;
+	clusterCullingParams._ConeCulling = desc.coneCulling;
+	clusterCullingParams._OcclusionCulling = desc.occlusionCamera != nullptr;
+	clusterCullingParams._HiZMipLevels = 0;
+
+	if (desc.occlusionCamera)
+	{
+		clusterCullingParams._HiZ = desc.occlusionCamera->_HiZ.GetTextureID(_Device.CreateSampler({ EFilter::Nearest }));
+		clusterCullingParams._HiZMipLevels = desc.occlusionCamera->_HiZ.GetMipLevels();
+	}
+
+	const uint32 firstCommand = _NumClusterCommands;
+
+	_NumClusterCommands += numCandidates;
+
+	if (_NumClusterCommands > _ClusterCommandCapacity)
+	{
+		ResizeClusterCommands(std::max(_NumClusterCommands, _ClusterCommandCapacity * 2));
+	}
+
+	stats.numCandidates += numCandidates;
+	stats.numDraws += static_cast<uint32>(drawList.draws.size());
+
+	graph.AddPass("ClusterCulling", EPassType::Compute, [&] (FrameGraph::PassBuilder& builder)
+	{
+		builder.Write(_ClusterCommands, EResourceUsage::StorageWrite);
+		ReadSurfaces(builder);
+
+		if (desc.occlusionCamera)
+		{
+			builder.Read(desc.occlusionCamera->_HiZ, EResourceUsage::SampledRead);
+		}
+	},
+	[this, clusterCullingParams, firstCommand] (gpu::CommandBuffer& cmdBuf) mutable
+	{
+		const gpu::Shader* shader = _Device.FindShader<ClusterCullingCS>();
+
+		ComputePipelineDesc computeDesc;
+		computeDesc.shader = shader;
+
+		gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
+
+		cmdBuf.BindPipeline(pipeline);
+
+		const VkDescriptorSet descriptorSets[] = { StaticMeshDescriptors::_DescriptorSet, ClusterCullingDescriptors::_DescriptorSet, _Device.GetTextures() };
+
+		cmdBuf.BindDescriptorSets(pipeline, std::size(descriptorSets), descriptorSets, 0, nullptr);
+
+		// The capacity is final once the graph is built.
+		clusterCullingParams._FirstCommand = GetClusterCommandBase() + firstCommand;
+
+		cmdBuf.PushConstants(pipeline, shader, &clusterCullingParams);
+
+		cmdBuf.Dispatch(DivideAndRoundUp(clusterCullingParams._NumCandidates, 64u), 1, 1);
+	});
+}
+
+void SceneRenderer::ResizeClusterCommands(uint32 numCommands)
+{
+	// The cluster culling set can't be updated while a frame in flight is using it.
+	_Device.WaitIdle();
+
+	_ClusterCommandCapacity = numCommands;
+	_ClusterCommands = _Device.CreateBuffer(
+		EBufferUsage::Indirect | EBufferUsage::Storage, EMemoryUsage::GPU_ONLY, _Device.GetNumFramesInFlight() * numCommands * sizeof(DrawIndexedIndirectCommand)
+	);
+
+	ClusterCullingDescriptors descriptors;
+	descriptors._CandidateBuffer = _Device.GetUploadBuffer();
+	descriptors._ViewBuffer = _Device.GetUploadBuffer();
+	descriptors._CommandBuffer = _ClusterCommands;
+
+	_Device.UpdateDescriptorSet(descriptors);
+}
+
+void SceneRenderer::BuildHiZ(CameraRender& cameraRender, FrameGraph& graph)
+{
+	// Each mip is reduced from the one above it, so each is its own pass, and the frame graph puts a barrier between them.
+	for (uint32 mipLevel = 0; mipLevel < cameraRender._HiZMips.size(); mipLevel++)
+	{
+		HiZBuildParams hiZBuildParams;
+		hiZBuildParams._Src = mipLevel > 0 ? cameraRender._HiZMips[mipLevel - 1].GetImageID() : gpu::ImageID();
+		hiZBuildParams._Dst = cameraRender._HiZMips[mipLevel].GetImageID();
+		hiZBuildParams._IsFirstMip = mipLevel == 0;
+
+		graph.AddPass("HiZBuild", EPassType::Compute, [&] (FrameGraph::PassBuilder& builder)
+		{
+			if (mipLevel == 0)
+			{
+				builder.Read(cameraRender._SceneDepth, EResourceUsage::SampledRead);
+			}
+
+			builder.Write(cameraRender._HiZ, EResourceUsage::StorageReadWrite);
+		},
+		[this, &cameraRender, hiZBuildParams, mipLevel] (gpu::CommandBuffer& cmdBuf)
+		{
+			const gpu::Shader* shader = _Device.FindShader<HiZBuildCS>();
+
+			ComputePipelineDesc computeDesc;
+			computeDesc.shader = shader;
+
+			gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
+
+			cmdBuf.BindPipeline(pipeline);
+
+			const VkDescriptorSet descriptorSets[] = { CameraDescriptors::_DescriptorSet, _Device.GetImages() };
+			const uint32 dynamicOffsets[] = { cameraRender.GetDynamicOffset() };
+
+			cmdBuf.BindDescriptorSets(pipeline, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets);
+
+			cmdBuf.PushConstants(pipeline, shader, &hiZBuildParams);
+
+			const uint32 width = std::max(cameraRender._HiZ.GetWidth() >> mipLevel, 1u);
+			const uint32 height = std::max(cameraRender._HiZ.GetHeight() >> mipLevel, 1u);
+
+			cmdBuf.Dispatch(DivideAndRoundUp(width, 8u), DivideAndRoundUp(height, 8u), 1);
+		});
+	}
+
+	cameraRender._IsHiZValid = true;
+}
@@ -26,19 +26,8 @@ public:
 
 REGISTER_SHADER(DirectLightingPassCS, "../Shaders/DirectLightingPassCS.glsl", "main", EShaderStage::Compute);
 
-void SceneRenderer::ComputeDirectLighting(CameraRender& camera, gpu::CommandBuffer& cmdBuf)
+void SceneRenderer::ComputeDirectLighting(CameraRender& camera, FrameGraph& graph)
 {
-	const ImageMemoryBarrier imageBarrier
-	{
-		camera._DirectLighting,
-		EAccess::None,
-		EAccess::ShaderRead | EAccess::ShaderWrite,
-		EImageLayout::Undefined,
-		EImageLayout::General
-	};
-
-	cmdBuf.PipelineBarrier(EPipelineStage::TopOfPipe, EPipelineStage::ComputeShader, 0, nullptr, 1, &imageBarrier);
-
 	bool isFirstLight = true;
 
 	for (auto entity : _ECS.GetEntities<DirectionalLight>())
@@ -53,22 +42,40 @@ void SceneRenderer::ComputeDirectLighting(CameraRender& camera, gpu::CommandBuff
 		light._LightViewProj = shadowRender.GetLightViewProjMatrix();
 		light._ShadowMap = shadowRender.GetShadowMap().GetTextureID(_Device.CreateSampler({}));
 
-		ComputeDirectLighting(camera, cmdBuf, light, isFirstLight);
+		graph.AddPass("DirectLighting", EPassType::AsyncCompute, [&] (FrameGraph::PassBuilder& builder)
+		{
+			builder.Read(camera._GBuffer0, EResourceUsage::SampledRead);
+			builder.Read(camera._GBuffer1, EResourceUsage::SampledRead);
+			builder.Read(camera._SceneDepth, EResourceUsage::SampledRead);
+			builder.Read(shadowRender.GetShadowMap(), EResourceUsage::SampledRead);
+
+			// The first light overwrites direct lighting. The rest accumulate into it.
+			builder.Write(camera._DirectLighting, isFirstLight ? EResourceUsage::StorageWrite : EResourceUsage::StorageReadWrite);
+		},
+		[this, &camera, light, isFirstLight] (gpu::CommandBuffer& cmdBuf)
+		{
+			ComputeDirectLighting(camera, cmdBuf, light, isFirstLight);
+		});
 
 		isFirstLight = false;
 	}
 }
 
-void SceneRenderer::ComputeDirectLighting(CameraRender& camera, gpu::CommandBuffer& cmdBuf, const DirectLightingParams& light, bool isFirstLight)
+ComputePipelineDesc SceneRenderer::GetDirectLightingPipelineDesc(bool isDirectionalLight, bool isFirstLight)
 {
-	const gpu::Shader* shader = _Device.FindShader<DirectLightingPassCS>();
-
 	ComputePipelineDesc computeDesc;
-	computeDesc.shader = shader;
-	computeDesc.specInfo.Add(0, light._L.w == 0.0f ? DirectLightingPassCS::directionalLight : DirectLightingPassCS::pointLight);
+	computeDesc.shader = _Device.FindShader<DirectLightingPassCS>();
+	computeDesc.specInfo.Add(0, isDirectionalLight ? DirectLightingPassCS::directionalLight : DirectLightingPassCS::pointLight);
 	computeDesc.specInfo.Add(1, static_cast<int>(isFirstLight));
 
-	gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
+	return computeDesc;
+}
+
+void SceneRenderer::ComputeDirectLighting(CameraRender& camera, gpu::CommandBuffer& cmdBuf, const DirectLightingParams& light, bool isFirstLight)
+{
+	const gpu::Shader* shader = _Device.FindShader<DirectLightingPassCS>();
+
+	gpu::Pipeline pipeline = _Device.CreatePipeline(GetDirectLightingPipelineDesc(light._L.w == 0.0f, isFirstLight));
 
 	cmdBuf.BindPipeline(pipeline);
 
@@ -98,33 +105,8 @@ public:
 
 REGISTER_SHADER(SSGI, "../Shaders/SSGI.glsl", "main", EShaderStage::Compute);
 
-void SceneRenderer::ComputeSSGI(const Camera& camera, CameraRender& cameraRender, gpu::CommandBuffer& cmdBuf)
+void SceneRenderer::ComputeSSGI(const Camera& camera, CameraRender& cameraRender, FrameGraph& graph)
 {
-	const ImageMemoryBarrier startBarrier
-	{
-		cameraRender._SceneColor,
-		EAccess::None,
-		EAccess::ShaderWrite,
-		EImageLayout::Undefined,
-		EImageLayout::General
-	};
-
-	cmdBuf.PipelineBarrier(EPipelineStage::TopOfPipe, EPipelineStage::ComputeShader, 0, nullptr, 1, &startBarrier);
-
-	const gpu::Shader* shader = _Device.FindShader<SSGI>();
-
-	ComputePipelineDesc computeDesc;
-	computeDesc.shader = shader;
-
-	gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
-
-	cmdBuf.BindPipeline(pipeline);
-
-	const VkDescriptorSet descriptorSets[] = { CameraDescriptors::_DescriptorSet, _Device.GetTextures() };
-	const uint32 dynamicOffsets[] = { cameraRender.GetDynamicOffset() };
-
-	cmdBuf.BindDescriptorSets(pipeline, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets);
-
 	static uint32 frameNumber = 0;
 
 	if (camera.GetPrevPosition() != camera.GetPosition() || camera.GetPrevRotation() != camera.GetRotation())
@@ -139,21 +121,37 @@ void SceneRenderer::ComputeSSGI(const Camera& camera, CameraRender& cameraRender
 	ssgiParams._Skybox = skybox.GetTextureID(skyboxSampler);
 	ssgiParams._FrameNumber = frameNumber++;
 
-	cmdBuf.PushConstants(pipeline, shader, &ssgiParams);
+	graph.AddPass("SSGI", EPassType::AsyncCompute, [&] (FrameGraph::PassBuilder& builder)
+	{
+		builder.Read(cameraRender._GBuffer0, EResourceUsage::SampledRead);
+		builder.Read(cameraRender._GBuffer1, EResourceUsage::SampledRead);
+		builder.Read(cameraRender._SceneDepth, EResourceUsage::SampledRead);
+		builder.Read(cameraRender._DirectLighting, EResourceUsage::StorageRead);
+		builder.Write(cameraRender._SSRHistory, EResourceUsage::StorageReadWrite);
+		builder.Write(cameraRender._SSGIHistory, EResourceUsage::StorageReadWrite);
+		builder.Write(cameraRender._SceneColor, EResourceUsage::StorageWrite);
+	},
+	[this, &cameraRender, ssgiParams] (gpu::CommandBuffer& cmdBuf)
+	{
+		const gpu::Shader* shader = _Device.FindShader<SSGI>();
 
-	const uint32 groupCountX = DivideAndRoundUp(cameraRender._SceneColor.GetWidth(), 8u);
-	const uint32 groupCountY = DivideAndRoundUp(cameraRender._SceneColor.GetHeight(), 8u);
+		ComputePipelineDesc computeDesc;
+		computeDesc.shader = shader;
 
-	cmdBuf.Dispatch(groupCountX, groupCountY, 1);
+		gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
 
-	const ImageMemoryBarrier endBarrier
-	{
-		cameraRender._SceneColor,
-		EAccess::ShaderWrite,
-		EAccess::ShaderRead,
-		EImageLayout::General,
-		EImageLayout::General
-	};
-
-	cmdBuf.PipelineBarrier(EPipelineStage::ComputeShader, EPipelineStage::ComputeShader, 0, nullptr, 1, &endBarrier);
-}
\ No newline at end of file
+		cmdBuf.BindPipeline(pipeline);
+
+		const VkDescriptorSet descriptorSets[] = { CameraDescriptors::_DescriptorSet, _Device.GetTextures() };
+		const uint32 dynamicOffsets[] = { cameraRender.GetDynamicOffset() };
+
+		cmdBuf.BindDescriptorSets(pipeline, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets);
+
+		cmdBuf.PushConstants(pipeline, shader, &ssgiParams);
+
+		const uint32 groupCountX = DivideAndRoundUp(cameraRender._SceneColor.GetWidth(), 8u);
+		const uint32 groupCountY = DivideAndRoundUp(cameraRender._SceneColor.GetHeight(), 8u);
+
+		cmdBuf.Dispatch(groupCountX, groupCountY, 1);
+	});
+}
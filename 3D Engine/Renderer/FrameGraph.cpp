@@ -0,0 +1,826 @@
+#include "FrameGraph.h"
+#include <sstream>
+
+static EImageLayout GetSampledLayout(const gpu::Image& image)
+{
+	// Must match the layouts sampled image descriptors are created with.
+	if (image.IsColor())
+	{
+		return EImageLayout::ShaderReadOnlyOptimal;
+	}
+	else if (image.IsDepthStencil())
+	{
+		return EImageLayout::DepthReadStencilRead;
+	}
+	else if (image.IsDepth())
+	{
+		return EImageLayout::DepthReadStencilWrite;
+	}
+	else
+	{
+		return EImageLayout::DepthWriteStencilRead;
+	}
+}
+
+static const char* GetLayoutName(EImageLayout layout)
+{
+	static const char* layoutNames[] =
+	{
+		"Undefined",
+		"General",
+		"ColorAttachmentOptimal",
+		"DepthWriteStencilWrite",
+		"DepthReadStencilRead",
+		"ShaderReadOnlyOptimal",
+		"TransferSrcOptimal",
+		"TransferDstOptimal",
+		"Preinitialized",
+		"DepthReadStencilWrite",
+		"DepthWriteStencilRead",
+		"Present",
+	};
+
+	return layoutNames[static_cast<uint32>(layout)];
+}
+
+FrameGraph::PassBuilder::PassBuilder(FrameGraph& frameGraph, uint32 passIndex)
+	: _FrameGraph(frameGraph)
+	, _PassIndex(passIndex)
+{
+}
+
+void FrameGraph::PassBuilder::Read(const gpu::Image& image, EResourceUsage usage)
+{
+	AddAccess(&image, usage, false);
+}
+
+void FrameGraph::PassBuilder::Read(const gpu::Buffer& buffer, EResourceUsage usage)
+{
+	AddAccess(&buffer, usage, false);
+}
+
+void FrameGraph::PassBuilder::Write(const gpu::Image& image, EResourceUsage usage)
+{
+	AddAccess(&image, usage, true);
+}
+
+void FrameGraph::PassBuilder::Write(const gpu::Buffer& buffer, EResourceUsage usage)
+{
+	AddAccess(&buffer, usage, true);
+}
+
+void FrameGraph::PassBuilder::SetSideEffects()
+{
+	_FrameGraph._Passes[_PassIndex].hasSideEffects = true;
+}
+
+void FrameGraph::PassBuilder::AddAccess(const void* resource, EResourceUsage usage, bool isWrite)
+{
+	const auto iter = _FrameGraph._ResourceIDs.find(resource);
+
+	check(iter != _FrameGraph._ResourceIDs.end(), "Pass %s uses a resource that wasn't imported.", _FrameGraph._Passes[_PassIndex].name.c_str());
+
+	PassNode& pass = _FrameGraph._Passes[_PassIndex];
+	const ResourceNode& resourceNode = _FrameGraph._Resources[iter->second];
+
+	const EPipelineStage shaderStages = pass.type != EPassType::Graphics ?
+		EPipelineStage::ComputeShader : EPipelineStage::VertexShader | EPipelineStage::FragmentShader;
+
+	ResourceAccess access = { .resource = iter->second, .layout = EImageLayout::General, .isWrite = isWrite };
+
+	switch (usage)
+	{
+	case EResourceUsage::ColorAttachment:
+		access.stage = EPipelineStage::ColorAttachmentOutput;
+		access.access = EAccess::ColorAttachmentRead | EAccess::ColorAttachmentWrite;
+		access.layout = EImageLayout::ColorAttachmentOptimal;
+		break;
+	case EResourceUsage::DepthAttachment:
+		access.stage = EPipelineStage::EarlyFragmentTests | EPipelineStage::LateFragmentTests;
+		access.access = EAccess::DepthStencilAttachmentRead | EAccess::DepthStencilAttachmentWrite;
+		access.layout = EImageLayout::DepthWriteStencilWrite;
+		break;
+	case EResourceUsage::SampledRead:
+		access.stage = shaderStages;
+		access.access = EAccess::ShaderRead;
+		access.layout = resourceNode.image ? GetSampledLayout(*resourceNode.image) : EImageLayout::General;
+		break;
+	case EResourceUsage::StorageRead:
+		access.stage = shaderStages;
+		access.access = EAccess::ShaderRead;
+		break;
+	case EResourceUsage::StorageWrite:
+		access.stage = shaderStages;
+		access.access = EAccess::ShaderWrite;
+		break;
+	case EResourceUsage::StorageReadWrite:
+		access.stage = shaderStages;
+		access.access = EAccess::ShaderRead | EAccess::ShaderWrite;
+		break;
+	case EResourceUsage::IndirectRead:
+		access.stage = EPipelineStage::DrawIndirect;
+		access.access = EAccess::IndirectCommandRead;
+		break;
+	}
+
+	// Merge multiple uses of a resource in the same pass.
+	for (auto& other : pass.accesses)
+	{
+		if (other.resource == access.resource)
+		{
+			check(!resourceNode.image || other.layout == access.layout,
+				"Pass %s uses %s in %s and %s.", pass.name.c_str(), resourceNode.name.c_str(), GetLayoutName(other.layout), GetLayoutName(access.layout));
+
+			other.stage |= access.stage;
+			other.access |= access.access;
+			other.isWrite |= access.isWrite;
+			return;
+		}
+	}
+
+	pass.accesses.push_back(access);
+}
+
+FrameGraph::FrameGraph(gpu::Device& device)
+	: _Device(device)
+	, _PassTimestamps(device.GetNumFramesInFlight())
+{
+}
+
+void FrameGraph::ImportImage(const std::string& name, const gpu::Image& image, EImageLayout layout, EImageLayout finalLayout, bool isOutput)
+{
+	ImportResource(&image, ResourceNode{ .name = name, .image = &image, .layout = layout, .finalLayout = finalLayout, .isOutput = isOutput });
+}
+
+void FrameGraph::ImportBuffer(const std::string& name, const gpu::Buffer& buffer, bool isOutput)
+{
+	ImportResource(&buffer, ResourceNode{ .name = name, .buffer = &buffer, .isOutput = isOutput });
+}
+
+void FrameGraph::ImportResource(const void* resource, ResourceNode&& resourceNode)
+{
+	check(!_ResourceIDs.contains(resource), "%s was imported twice.", resourceNode.name.c_str());
+
+	_ResourceIDs[resource] = static_cast<ResourceID>(_Resources.size());
+	_Resources.push_back(std::move(resourceNode));
+}
+
+void FrameGraph::AddPass(const std::string& name, EPassType type, SetupFunc&& setup, ExecuteFunc&& execute)
+{
+	const EQueue queue = type == EPassType::AsyncCompute && _Device.HasAsyncCompute() ? EQueue::Compute : EQueue::Graphics;
+
+	_Passes.push_back(PassNode{ .name = name, .type = type, .queue = queue, .execute = std::move(execute) });
+
+	PassBuilder builder(*this, static_cast<uint32>(_Passes.size() - 1));
+	setup(builder);
+}
+
+void FrameGraph::Compile()
+{
+	BuildDependencies();
+
+	CullPasses();
+
+	SchedulePasses();
+
+	ComputeLifetimes();
+
+	BuildSubmissions();
+
+	DeriveBarriers();
+}
+
+FrameGraph::Lifetime FrameGraph::GetLifetime(const gpu::Image& image) const
+{
+	const auto iter = _ResourceIDs.find(&image);
+	return iter == _ResourceIDs.end() ? Lifetime{} : _Lifetimes[iter->second];
+}
+
+void FrameGraph::Execute(const gpu::Semaphore& waitSemaphore, const gpu::Semaphore& signalSemaphore)
+{
+	auto recordBarriers = [] (gpu::CommandBuffer& cmdBuf, const BarrierBatch& batch)
+	{
+		if (!batch.IsEmpty())
+		{
+			cmdBuf.PipelineBarrier(
+				batch.srcStageMask, batch.dstStageMask,
+				batch.bufferBarriers.size(), batch.bufferBarriers.data(),
+				batch.imageBarriers.size(), batch.imageBarriers.data());
+		}
+	};
+
+	const uint32 frameIndex = _Device.GetFrameIndex();
+
+	// The last frame that used this frame index has completed, so its timestamps are available.
+	ResolvePassTimings(frameIndex);
+
+	std::vector<PassTimestamps>& passTimestamps = _PassTimestamps[frameIndex];
+	passTimestamps.clear();
+
+	const gpu::Semaphore noSemaphore;
+
+	for (std::size_t submissionIndex = 0; submissionIndex < _Submissions.size(); submissionIndex++)
+	{
+		const Submission& submission = _Submissions[submissionIndex];
+		const bool isFirstSubmission = submissionIndex == 0;
+		const bool isLastSubmission = submissionIndex == _Submissions.size() - 1;
+
+		gpu::CommandBuffer cmdBuf = _Device.CreateCommandBuffer(submission.queue);
+
+		// The first submission always writes a timestamp, since it resets the frame's queries before the other queue writes any.
+		uint32 timestamp = _Device.WriteTimestamp(cmdBuf);
+
+		for (uint32 scheduleIndex = submission.begin; scheduleIndex < submission.end; scheduleIndex++)
+		{
+			const PassNode& pass = _Passes[_Schedule[scheduleIndex]];
+
+			recordBarriers(cmdBuf, _Barriers[scheduleIndex]);
+
+			pass.execute(cmdBuf);
+
+			const uint32 passEnd = _Device.WriteTimestamp(cmdBuf);
+
+			passTimestamps.push_back({ pass.name, timestamp, passEnd });
+
+			timestamp = passEnd;
+		}
+
+		recordBarriers(cmdBuf, submission.releaseBarriers);
+
+		if (isLastSubmission)
+		{
+			recordBarriers(cmdBuf, _FinalBarriers);
+		}
+
+		const gpu::Semaphore& submitWaitSemaphore = isFirstSubmission ? waitSemaphore : noSemaphore;
+		const gpu::Semaphore& submitSignalSemaphore = isLastSubmission ? signalSemaphore : noSemaphore;
+
+		if (submission.waitsOnOtherQueue)
+		{
+			const EQueue otherQueue = submission.queue == EQueue::Graphics ? EQueue::Compute : EQueue::Graphics;
+
+			_Device.SubmitCommands(cmdBuf, otherQueue, submitWaitSemaphore, submitSignalSemaphore);
+		}
+		else
+		{
+			_Device.SubmitCommands(cmdBuf, submitWaitSemaphore, submitSignalSemaphore);
+		}
+	}
+}
+
+void FrameGraph::ResolvePassTimings(uint32 frameIndex)
+{
+	const std::vector<double>& timestamps = _Device.GetCompletedTimestamps();
+
+	_PassTimings.clear();
+
+	for (const auto& [name, begin, end] : _PassTimestamps[frameIndex])
+	{
+		// Passes that ran out of queries aren't timed.
+		if (begin < timestamps.size() && end < timestamps.size())
+		{
+			_PassTimings.push_back({ name, static_cast<float>(timestamps[end] - timestamps[begin]) });
+		}
+	}
+}
+
+void FrameGraph::Reset()
+{
+	_Resources.clear();
+	_ResourceIDs.clear();
+	_Passes.clear();
+	_Schedule.clear();
+	_Lifetimes.clear();
+	_Barriers.clear();
+	_FinalBarriers.imageBarriers.clear();
+	_FinalBarriers.bufferBarriers.clear();
+	_FinalBarriers.srcStageMask = EPipelineStage::None;
+	_FinalBarriers.dstStageMask = EPipelineStage::None;
+	_Submissions.clear();
+}
+
+void FrameGraph::BuildDependencies()
+{
+	// Walk the passes in submission order, tracking the last writer and the readers since then.
+	std::vector<int32> lastWriters(_Resources.size(), -1);
+	std::vector<std::vector<uint32>> readers(_Resources.size());
+
+	auto addUnique = [] (std::vector<uint32>& passes, uint32 passIndex)
+	{
+		if (std::find(passes.begin(), passes.end(), passIndex) == passes.end())
+		{
+			passes.push_back(passIndex);
+		}
+	};
+
+	for (uint32 passIndex = 0; passIndex < _Passes.size(); passIndex++)
+	{
+		PassNode& pass = _Passes[passIndex];
+
+		for (const auto& access : pass.accesses)
+		{
+			const int32 lastWriter = lastWriters[access.resource];
+
+			// Writes are conservatively treated as read-modify-write, so the previous writer is a producer either way.
+			if (lastWriter != -1)
+			{
+				addUnique(pass.producers, lastWriter);
+				addUnique(pass.dependencies, lastWriter);
+			}
+
+			if (access.isWrite)
+			{
+				// Write-after-read only orders the passes. It doesn't keep the readers alive.
+				for (auto reader : readers[access.resource])
+				{
+					addUnique(pass.dependencies, reader);
+				}
+
+				readers[access.resource].clear();
+				lastWriters[access.resource] = passIndex;
+			}
+			else
+			{
+				readers[access.resource].push_back(passIndex);
+			}
+		}
+	}
+}
+
+void FrameGraph::CullPasses()
+{
+	std::vector<int32> lastWriters(_Resources.size(), -1);
+
+	for (uint32 passIndex = 0; passIndex < _Passes.size(); passIndex++)
+	{
+		_Passes[passIndex].isCulled = true;
+
+		for (const auto& access : _Passes[passIndex].accesses)
+		{
+			if (access.isWrite)
+			{
+				lastWriters[access.resource] = passIndex;
+			}
+		}
+	}
+
+	// Flood backwards from passes with side effects and the final writers of outputs.
+	std::vector<uint32> stack;
+
+	for (uint32 passIndex = 0; passIndex < _Passes.size(); passIndex++)
+	{
+		if (_Passes[passIndex].hasSideEffects)
+		{
+			stack.push_back(passIndex);
+		}
+	}
+
+	for (ResourceID resource = 0; resource < _Resources.size(); resource++)
+	{
+		if (_Resources[resource].isOutput && lastWriters[resource] != -1)
+		{
+			stack.push_back(lastWriters[resource]);
+		}
+	}
+
+	while (!stack.empty())
+	{
+		PassNode& pass = _Passes[stack.back()];
+		stack.pop_back();
+
+		if (pass.isCulled)
+		{
+			pass.isCulled = false;
+			stack.insert(stack.end(), pass.producers.begin(), pass.producers.end());
+		}
+	}
+}
+
+void FrameGraph::SchedulePasses()
+{
+	static constexpr uint32 unscheduled = std::numeric_limits<uint32>::max();
+
+	std::vector<uint32> schedulePositions(_Passes.size(), unscheduled);
+	std::size_t numPassesToSchedule = 0;
+
+	for (const auto& pass : _Passes)
+	{
+		numPassesToSchedule += pass.isCulled ? 0 : 1;
+	}
+
+	_Schedule.reserve(numPassesToSchedule);
+
+	// Of the passes whose dependencies have run, pick the one whose inputs have been ready the longest.
+	// This puts independent work between producers and consumers so the GPU can overlap them across barriers.
+	// Async compute passes go first, so the graphics work scheduled after them runs alongside.
+	while (_Schedule.size() < numPassesToSchedule)
+	{
+		uint32 bestPass = unscheduled;
+		uint32 bestReadyPosition = unscheduled;
+		bool bestIsAsync = false;
+
+		for (uint32 passIndex = 0; passIndex < _Passes.size(); passIndex++)
+		{
+			const PassNode& pass = _Passes[passIndex];
+
+			if (pass.isCulled || schedulePositions[passIndex] != unscheduled)
+			{
+				continue;
+			}
+
+			uint32 readyPosition = 0;
+			bool isReady = true;
+
+			for (auto dependency : pass.dependencies)
+			{
+				if (_Passes[dependency].isCulled)
+				{
+					continue;
+				}
+
+				if (schedulePositions[dependency] == unscheduled)
+				{
+					isReady = false;
+					break;
+				}
+
+				readyPosition = std::max(readyPosition, schedulePositions[dependency] + 1);
+			}
+
+			const bool isAsync = pass.queue != EQueue::Graphics;
+
+			if (isReady && (isAsync != bestIsAsync ? isAsync : readyPosition < bestReadyPosition))
+			{
+				bestPass = passIndex;
+				bestReadyPosition = readyPosition;
+				bestIsAsync = isAsync;
+			}
+		}
+
+		check(bestPass != unscheduled, "Frame graph has a cycle.");
+
+		schedulePositions[bestPass] = static_cast<uint32>(_Schedule.size());
+		_Schedule.push_back(bestPass);
+	}
+}
+
+void FrameGraph::ComputeLifetimes()
+{
+	_Lifetimes.assign(_Resources.size(), Lifetime{});
+
+	for (uint32 scheduleIndex = 0; scheduleIndex < _Schedule.size(); scheduleIndex++)
+	{
+		for (const auto& access : _Passes[_Schedule[scheduleIndex]].accesses)
+		{
+			Lifetime& lifetime = _Lifetimes[access.resource];
+			lifetime.first = lifetime.IsUsed() ? lifetime.first : scheduleIndex;
+			lifetime.last = scheduleIndex;
+		}
+	}
+}
+
+void FrameGraph::BuildSubmissions()
+{
+	// Resources are owned by the graphics queue between frames, so the frame starts with a graphics submission,
+	// even if it only releases resources to the compute queue.
+	_Submissions.push_back(Submission{ .queue = EQueue::Graphics, .begin = 0, .end = 0 });
+
+	for (uint32 scheduleIndex = 0; scheduleIndex < _Schedule.size(); scheduleIndex++)
+	{
+		const EQueue queue = _Passes[_Schedule[scheduleIndex]].queue;
+
+		if (_Submissions.back().queue != queue)
+		{
+			// The first compute submission follows the first submission, which waits on the frame's wait semaphore.
+			const bool isFirstComputeSubmission = queue == EQueue::Compute && _Submissions.size() == 1;
+
+			_Submissions.push_back(Submission{ .queue = queue, .begin = scheduleIndex, .end = scheduleIndex, .waitsOnOtherQueue = isFirstComputeSubmission });
+		}
+
+		_Submissions.back().end = scheduleIndex + 1;
+	}
+
+	// The frame ends on the graphics queue for presentation, and after all of the frame's compute work,
+	// so the next frame can't overwrite resources this frame's compute passes are still using.
+	if (_Submissions.size() > 1)
+	{
+		if (_Submissions.back().queue != EQueue::Graphics)
+		{
+			const uint32 end = static_cast<uint32>(_Schedule.size());
+
+			_Submissions.push_back(Submission{ .queue = EQueue::Graphics, .begin = end, .end = end });
+		}
+
+		_Submissions.back().waitsOnOtherQueue = true;
+	}
+}
+
+void FrameGraph::DeriveBarriers()
+{
+	std::vector<ResourceState> states(_Resources.size());
+
+	for (ResourceID resource = 0; resource < _Resources.size(); resource++)
+	{
+		states[resource].layout = _Resources[resource].layout;
+	}
+
+	_Barriers.resize(_Schedule.size());
+
+	// Transient images may share memory with transient images that are no longer used.
+	// Their first barrier also waits on those, so the new contents can't race the old ones.
+	// Barriers can't wait on the other queue's stages, so memory retired there is waited on with a semaphore.
+	std::array<EPipelineStage, 2> retiredStages = { EPipelineStage::None, EPipelineStage::None };
+	std::array<EAccess, 2> retiredWriteAccess = { EAccess::None, EAccess::None };
+
+	for (uint32 submissionIndex = 0; submissionIndex < _Submissions.size(); submissionIndex++)
+	{
+		Submission& submission = _Submissions[submissionIndex];
+		const std::size_t queueIndex = submission.queue == EQueue::Graphics ? 0 : 1;
+
+		for (uint32 scheduleIndex = submission.begin; scheduleIndex < submission.end; scheduleIndex++)
+		{
+			for (const auto& access : _Passes[_Schedule[scheduleIndex]].accesses)
+			{
+				const ResourceNode& resource = _Resources[access.resource];
+				ResourceState& state = states[access.resource];
+
+				if (resource.IsTransient() && _Lifetimes[access.resource].first == scheduleIndex)
+				{
+					if (Any(retiredStages[queueIndex]))
+					{
+						state.writeStages |= retiredStages[queueIndex];
+						state.writeAccess |= retiredWriteAccess[queueIndex];
+					}
+
+					if (Any(retiredStages[1 - queueIndex]))
+					{
+						submission.waitsOnOtherQueue = true;
+					}
+				}
+
+				// Images whose contents are discarded don't need their ownership transferred.
+				if (resource.image && state.layout == EImageLayout::Undefined)
+				{
+					state.queue = submission.queue;
+				}
+
+				if (state.queue != submission.queue)
+				{
+					TransferOwnership(_Barriers[scheduleIndex], resource, state, submission.queue, access.stage, access.access, access.layout);
+
+					if (access.isWrite)
+					{
+						state.writeStages = access.stage;
+						state.writeAccess = access.access;
+						state.readStages = EPipelineStage::None;
+						state.readAccess = EAccess::None;
+					}
+
+					submission.waitsOnOtherQueue = true;
+				}
+				else
+				{
+					AddBarrier(_Barriers[scheduleIndex], resource, state, access);
+				}
+
+				state.submission = submissionIndex;
+			}
+
+			for (const auto& access : _Passes[_Schedule[scheduleIndex]].accesses)
+			{
+				if (_Resources[access.resource].IsTransient() && _Lifetimes[access.resource].last == scheduleIndex)
+				{
+					const ResourceState& state = states[access.resource];
+					retiredStages[queueIndex] |= state.writeStages | state.readStages;
+					retiredWriteAccess[queueIndex] |= state.writeAccess;
+				}
+			}
+		}
+	}
+
+	for (ResourceID resource = 0; resource < _Resources.size(); resource++)
+	{
+		const ResourceNode& resourceNode = _Resources[resource];
+		ResourceState& state = states[resource];
+		const EImageLayout finalLayout = resourceNode.finalLayout != EImageLayout::Undefined ? resourceNode.finalLayout : state.layout;
+
+		// Hand resources the next frame may read back to the graphics queue.
+		if (state.queue != EQueue::Graphics && !resourceNode.IsTransient())
+		{
+			TransferOwnership(_FinalBarriers, resourceNode, state, EQueue::Graphics, EPipelineStage::BottomOfPipe, EAccess::None, finalLayout);
+		}
+		else if (resourceNode.image && finalLayout != state.layout)
+		{
+			_FinalBarriers.imageBarriers.push_back({ *resourceNode.image, state.writeAccess, EAccess::None, state.layout, finalLayout, 0, resourceNode.image->GetMipLevels() });
+			_FinalBarriers.srcStageMask |= Any(state.writeStages | state.readStages) ? state.writeStages | state.readStages : EPipelineStage::TopOfPipe;
+			_FinalBarriers.dstStageMask |= EPipelineStage::BottomOfPipe;
+		}
+	}
+}
+
+void FrameGraph::TransferOwnership(BarrierBatch& acquireBatch, const ResourceNode& resource, ResourceState& state, EQueue queue, EPipelineStage stage, EAccess access, EImageLayout layout)
+{
+	// The release and acquire are the same barrier recorded on both queues, including any layout transition.
+	// The semaphore between the submissions orders them, so neither waits on the other queue's stages.
+	BarrierBatch& releaseBatch = _Submissions[state.submission].releaseBarriers;
+	const EPipelineStage prevStages = state.writeStages | state.readStages;
+	const EImageLayout newLayout = resource.image ? layout : state.layout;
+
+	if (resource.image)
+	{
+		releaseBatch.imageBarriers.push_back({ *resource.image, state.writeAccess, EAccess::None, state.layout, newLayout, 0, resource.image->GetMipLevels(), state.queue, queue });
+		acquireBatch.imageBarriers.push_back({ *resource.image, EAccess::None, access, state.layout, newLayout, 0, resource.image->GetMipLevels(), state.queue, queue });
+	}
+	else
+	{
+		releaseBatch.bufferBarriers.push_back({ *resource.buffer, state.writeAccess, EAccess::None, state.queue, queue });
+		acquireBatch.bufferBarriers.push_back({ *resource.buffer, EAccess::None, access, state.queue, queue });
+	}
+
+	releaseBatch.srcStageMask |= Any(prevStages) ? prevStages : EPipelineStage::TopOfPipe;
+	releaseBatch.dstStageMask |= EPipelineStage::BottomOfPipe;
+	acquireBatch.srcStageMask |= EPipelineStage::TopOfPipe;
+	acquireBatch.dstStageMask |= stage;
+
+	// Later uses on the new queue only wait on the acquire.
+	state.queue = queue;
+	state.layout = newLayout;
+	state.writeStages = stage;
+	state.writeAccess = EAccess::None;
+	state.readStages = stage;
+	state.readAccess = access;
+}
+
+void FrameGraph::AddBarrier(BarrierBatch& batch, const ResourceNode& resource, ResourceState& state, const ResourceAccess& access) const
+{
+	const bool isLayoutTransition = resource.image && state.layout != access.layout;
+	const EPipelineStage prevStages = state.writeStages | state.readStages;
+
+	bool needsBarrier = false;
+
+	if (isLayoutTransition)
+	{
+		// Transitions wait on every previous access, since they write the whole image.
+		needsBarrier = true;
+	}
+	else if (access.isWrite)
+	{
+		// Write-after-write and write-after-read.
+		needsBarrier = Any(prevStages);
+	}
+	else
+	{
+		// Read-after-write, unless an earlier barrier already made the write visible to this stage.
+		needsBarrier = Any(state.writeStages) &&
+			((state.readStages & access.stage) != access.stage || (state.readAccess & access.access) != access.access);
+	}
+
+	if (needsBarrier)
+	{
+		// Write-after-read needs only an execution dependency, so only the last write's access is made available.
+		if (resource.image)
+		{
+			batch.imageBarriers.push_back({ *resource.image, state.writeAccess, access.access, state.layout, access.layout, 0, resource.image->GetMipLevels() });
+		}
+		else
+		{
+			batch.bufferBarriers.push_back({ *resource.buffer, state.writeAccess, access.access });
+		}
+
+		batch.srcStageMask |= Any(prevStages) ? prevStages : EPipelineStage::TopOfPipe;
+		batch.dstStageMask |= access.stage;
+	}
+
+	if (access.isWrite)
+	{
+		state.writeStages = access.stage;
+		state.writeAccess = access.access;
+		state.readStages = EPipelineStage::None;
+		state.readAccess = EAccess::None;
+	}
+	else if (isLayoutTransition)
+	{
+		// Later readers in other stages have to wait on the transition.
+		state.writeStages = access.stage;
+		state.writeAccess = EAccess::None;
+		state.readStages = access.stage;
+		state.readAccess = access.access;
+	}
+	else
+	{
+		state.readStages |= access.stage;
+		state.readAccess |= access.access;
+	}
+
+	state.layout = resource.image ? access.layout : state.layout;
+}
+
+std::size_t FrameGraph::GetNumBarriers() const
+{
+	std::size_t numBarriers = _FinalBarriers.imageBarriers.size() + _FinalBarriers.bufferBarriers.size();
+
+	for (const auto& batch : _Barriers)
+	{
+		numBarriers += batch.imageBarriers.size() + batch.bufferBarriers.size();
+	}
+
+	return numBarriers;
+}
+
+std::string FrameGraph::Dump() const
+{
+	std::stringstream dot;
+
+	dot << "digraph FrameGraph\n{\n\trankdir=LR;\n\tnode [fontname=\"Consolas\"];\n\n";
+
+	std::vector<int32> schedulePositions(_Passes.size(), -1);
+
+	for (std::size_t scheduleIndex = 0; scheduleIndex < _Schedule.size(); scheduleIndex++)
+	{
+		schedulePositions[_Schedule[scheduleIndex]] = static_cast<int32>(scheduleIndex);
+	}
+
+	for (std::size_t passIndex = 0; passIndex < _Passes.size(); passIndex++)
+	{
+		const PassNode& pass = _Passes[passIndex];
+		const int32 schedulePosition = schedulePositions[passIndex];
+
+		dot << "\tpass" << passIndex << " [shape=box, label=\"" << pass.name
+			<< (pass.queue == EQueue::Compute ? "\\n(Async Compute)" : pass.type != EPassType::Graphics ? "\\n(Compute)" : "\\n(Graphics)");
+
+		if (pass.isCulled)
+		{
+			dot << "\\nculled\", style=dashed, color=gray, fontcolor=gray];\n";
+			continue;
+		}
+
+		const BarrierBatch& batch = _Barriers[schedulePosition];
+
+		dot << "\\norder " << schedulePosition;
+
+		if (!batch.IsEmpty())
+		{
+			dot << "\\nbarrier " << Platform::FormatString("0x%x -> 0x%x", static_cast<uint32>(batch.srcStageMask), static_cast<uint32>(batch.dstStageMask));
+
+			for (const auto& barrier : batch.imageBarriers)
+			{
+				const ResourceNode& resource = _Resources[_ResourceIDs.at(&barrier.image)];
+				dot << "\\n  " << resource.name << ": " << GetLayoutName(barrier.oldLayout) << " -> " << GetLayoutName(barrier.newLayout);
+			}
+
+			for (const auto& barrier : batch.bufferBarriers)
+			{
+				dot << "\\n  " << _Resources[_ResourceIDs.at(&barrier.buffer)].name;
+			}
+		}
+
+		dot << "\", style=filled, fillcolor=" << (pass.queue == EQueue::Compute ? "plum" : pass.type != EPassType::Graphics ? "lightblue" : "palegreen") << "];\n";
+	}
+
+	dot << "\n";
+
+	for (std::size_t resource = 0; resource < _Resources.size(); resource++)
+	{
+		const ResourceNode& resourceNode = _Resources[resource];
+
+		dot << "\tresource" << resource << " [shape=ellipse, label=\"" << resourceNode.name;
+
+		if (resourceNode.image)
+		{
+			dot << "\\n" << GetLayoutName(resourceNode.layout);
+
+			if (resourceNode.finalLayout != EImageLayout::Undefined)
+			{
+				dot << " -> " << GetLayoutName(resourceNode.finalLayout);
+			}
+		}
+
+		if (!_Lifetimes.empty() && _Lifetimes[resource].IsUsed())
+		{
+			dot << "\\nlifetime " << _Lifetimes[resource].first << "-" << _Lifetimes[resource].last;
+		}
+
+		dot << "\"" << (resourceNode.isOutput ? ", peripheries=2" : "") << "];\n";
+	}
+
+	dot << "\n";
+
+	for (std::size_t passIndex = 0; passIndex < _Passes.size(); passIndex++)
+	{
+		for (const auto& access : _Passes[passIndex].accesses)
+		{
+			if (access.isWrite)
+			{
+				dot << "\tpass" << passIndex << " -> resource" << access.resource << " [color=red];\n";
+			}
+			else
+			{
+				dot << "\tresource" << access.resource << " -> pass" << passIndex << ";\n";
+			}
+		}
+	}
+
+	dot << "}\n";
+
+	return dot.str();
+}
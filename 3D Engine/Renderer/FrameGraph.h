@@ -0,0 +1,267 @@
+#pragma once
+#include <GPU/GPU.h>
+#include <functional>
+
+/** How a pass uses a resource. The frame graph derives pipeline stages, access masks and image layouts from it. */
+enum class EResourceUsage
+{
+	ColorAttachment,	// Render pass color attachment.
+	DepthAttachment,	// Render pass depth attachment.
+	SampledRead,		// Read through a sampler.
+	StorageRead,		// Storage image or buffer read.
+	StorageWrite,		// Storage image or buffer write.
+	StorageReadWrite,	// Storage image or buffer read-modify-write.
+	IndirectRead,		// Indirect draw or dispatch arguments.
+};
+
+enum class EPassType
+{
+	Graphics,
+	Compute,
+	AsyncCompute,	// Compute pass that runs on the async compute queue if the device has one.
+};
+
+/**
+  * The frame graph records the passes of a frame and the resources each pass reads and writes.
+  * Compile() culls passes whose outputs are never used, orders the rest to put distance between producers and consumers,
+  * and derives the barriers and layout transitions between them. Passes never issue their own barriers.
+  * Async compute passes are submitted to the compute queue, with queue ownership transfers and semaphore waits where the queues share resources.
+  */
+class FrameGraph
+{
+public:
+	using ResourceID = uint32;
+	using ExecuteFunc = std::function<void(gpu::CommandBuffer&)>;
+
+	/** Declares the resources a pass uses. Every resource must be imported before it's used. */
+	class PassBuilder
+	{
+	public:
+		void Read(const gpu::Image& image, EResourceUsage usage);
+		void Read(const gpu::Buffer& buffer, EResourceUsage usage);
+		void Write(const gpu::Image& image, EResourceUsage usage);
+		void Write(const gpu::Buffer& buffer, EResourceUsage usage);
+
+		/** The pass has effects outside of the graph and is never culled. */
+		void SetSideEffects();
+
+	private:
+		friend class FrameGraph;
+		PassBuilder(FrameGraph& frameGraph, uint32 passIndex);
+
+		FrameGraph& _FrameGraph;
+		uint32 _PassIndex;
+
+		void AddAccess(const void* resource, EResourceUsage usage, bool isWrite);
+	};
+
+	using SetupFunc = std::function<void(PassBuilder&)>;
+
+	/** First and last scheduled pass that uses a resource. */
+	struct Lifetime
+	{
+		static constexpr uint32 unused = std::numeric_limits<uint32>::max();
+
+		uint32 first = unused;
+		uint32 last = unused;
+
+		inline bool IsUsed() const { return first != unused; }
+
+		/** Unused resources don't overlap anything. */
+		inline bool Overlaps(const Lifetime& other) const
+		{
+			return IsUsed() && other.IsUsed() && first <= other.last && other.first <= last;
+		}
+
+		inline bool operator==(const Lifetime& other) const { return first == other.first && last == other.last; }
+	};
+
+	/** GPU time of a pass in milliseconds, including the barriers recorded before it. */
+	using PassTiming = std::pair<std::string, float>;
+
+	FrameGraph(gpu::Device& device);
+	FrameGraph(const FrameGraph&) = delete;
+	FrameGraph& operator=(const FrameGraph&) = delete;
+
+	/**
+	  * Import an image into the graph.
+	  * @param layout Layout of the image when the frame starts. Undefined discards the image's contents.
+	  * @param finalLayout Layout to transition the image to at the end of the frame, or Undefined to leave it as is.
+	  * @param isOutput Whether the image is used after the frame. Passes contributing to outputs aren't culled.
+	  */
+	void ImportImage(const std::string& name, const gpu::Image& image, EImageLayout layout, EImageLayout finalLayout = EImageLayout::Undefined, bool isOutput = false);
+
+	/** Import a buffer into the graph. */
+	void ImportBuffer(const std::string& name, const gpu::Buffer& buffer, bool isOutput = false);
+
+	/** Add a pass. Setup is called immediately; execute is called by Execute() if the pass survives culling. */
+	void AddPass(const std::string& name, EPassType type, SetupFunc&& setup, ExecuteFunc&& execute);
+
+	/** Cull, schedule and derive barriers. */
+	void Compile();
+
+	/** Lifetime of an image in the compiled graph. */
+	Lifetime GetLifetime(const gpu::Image& image) const;
+
+	/**
+	  * Record and submit the scheduled passes and their barriers. Each pass is timestamped.
+	  * Consecutive passes on the same queue share a submission. The frame starts and ends with a graphics submission.
+	  * @param waitSemaphore Waited on by the first submission.
+	  * @param signalSemaphore Signaled by the last submission.
+	  */
+	void Execute(const gpu::Semaphore& waitSemaphore, const gpu::Semaphore& signalSemaphore);
+
+	/** Clear all passes and resources for the next frame. */
+	void Reset();
+
+	/** Dump the compiled graph in Graphviz format. */
+	std::string Dump() const;
+
+	inline std::size_t GetNumPasses() const { return _Passes.size(); }
+	inline std::size_t GetNumScheduledPasses() const { return _Schedule.size(); }
+	inline std::size_t GetNumSubmissions() const { return _Submissions.size(); }
+	std::size_t GetNumBarriers() const;
+
+	/** Pass timings of the last frame that used the current frame index. */
+	inline const std::vector<PassTiming>& GetPassTimings() const { return _PassTimings; }
+
+private:
+	struct ResourceNode
+	{
+		std::string name;
+		const gpu::Image* image = nullptr;
+		const gpu::Buffer* buffer = nullptr;
+		EImageLayout layout = EImageLayout::Undefined;
+		EImageLayout finalLayout = EImageLayout::Undefined;
+		bool isOutput = false;
+
+		/** Transient images are discarded at the start of the frame and may alias other transient images. */
+		inline bool IsTransient() const { return image && layout == EImageLayout::Undefined && !isOutput; }
+	};
+
+	struct ResourceAccess
+	{
+		ResourceID resource;
+		EPipelineStage stage;
+		EAccess access;
+		EImageLayout layout;
+		bool isWrite;
+	};
+
+	struct PassNode
+	{
+		std::string name;
+		EPassType type;
+		EQueue queue;
+		ExecuteFunc execute;
+		std::vector<ResourceAccess> accesses;
+		bool hasSideEffects = false;
+		bool isCulled = false;
+
+		/** Passes that produce data this pass consumes. */
+		std::vector<uint32> producers;
+
+		/** Passes that must run before this pass, including readers of resources this pass overwrites. */
+		std::vector<uint32> dependencies;
+	};
+
+	/** Barriers batched into a single vkCmdPipelineBarrier. */
+	struct BarrierBatch
+	{
+		EPipelineStage srcStageMask = EPipelineStage::None;
+		EPipelineStage dstStageMask = EPipelineStage::None;
+		std::vector<ImageMemoryBarrier> imageBarriers;
+		std::vector<BufferMemoryBarrier> bufferBarriers;
+
+		inline bool IsEmpty() const { return imageBarriers.empty() && bufferBarriers.empty(); }
+	};
+
+	/** Synchronization state of a resource while barriers are derived. */
+	struct ResourceState
+	{
+		EImageLayout layout = EImageLayout::Undefined;
+		EPipelineStage writeStages = EPipelineStage::None;
+		EAccess writeAccess = EAccess::None;
+
+		/** Stages and accesses that have waited on the last write. */
+		EPipelineStage readStages = EPipelineStage::None;
+		EAccess readAccess = EAccess::None;
+
+		/** Queue that owns the resource. Resources are owned by the graphics queue between frames. */
+		EQueue queue = EQueue::Graphics;
+
+		/** Submission that last used the resource. */
+		uint32 submission = 0;
+	};
+
+	/** Consecutive scheduled passes on the same queue, recorded into one command buffer. */
+	struct Submission
+	{
+		EQueue queue;
+
+		/** Range of scheduled passes. */
+		uint32 begin;
+		uint32 end;
+
+		/** Wait on everything submitted to the other queue before this submission. */
+		bool waitsOnOtherQueue = false;
+
+		/** Hands resources to the other queue after the last pass. */
+		BarrierBatch releaseBarriers;
+	};
+
+	/** Timestamps written around a pass. */
+	struct PassTimestamps
+	{
+		std::string name;
+		uint32 begin;
+		uint32 end;
+	};
+
+	gpu::Device& _Device;
+
+	std::vector<ResourceNode> _Resources;
+
+	std::unordered_map<const void*, ResourceID> _ResourceIDs;
+
+	std::vector<PassNode> _Passes;
+
+	/** Pass indices in execution order. */
+	std::vector<uint32> _Schedule;
+
+	/** Indexed by resource. */
+	std::vector<Lifetime> _Lifetimes;
+
+	/** Barriers recorded before each scheduled pass. */
+	std::vector<BarrierBatch> _Barriers;
+
+	/** Transitions to the final layouts. */
+	BarrierBatch _FinalBarriers;
+
+	std::vector<Submission> _Submissions;
+
+	/** Timestamps of the passes executed in each frame in flight. */
+	std::vector<std::vector<PassTimestamps>> _PassTimestamps;
+
+	std::vector<PassTiming> _PassTimings;
+
+	void ImportResource(const void* resource, ResourceNode&& resourceNode);
+
+	void BuildDependencies();
+
+	void CullPasses();
+
+	void SchedulePasses();
+
+	void ComputeLifetimes();
+
+	void BuildSubmissions();
+
+	void DeriveBarriers();
+
+	void AddBarrier(BarrierBatch& batch, const ResourceNode& resource, ResourceState& state, const ResourceAccess& access) const;
+
+	void TransferOwnership(BarrierBatch& acquireBatch, const ResourceNode& resource, ResourceState& state, EQueue queue, EPipelineStage stage, EAccess access, EImageLayout layout);
+
+	void ResolvePassTimings(uint32 frameIndex);
+};
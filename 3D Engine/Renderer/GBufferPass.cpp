@@ -34,30 +34,82 @@ public:
 
 REGISTER_SHADER(GBufferPassFS, "../Shaders/GBufferFS.glsl", "main", EShaderStage::Fragment);
 
-void SceneRenderer::RenderGBuffer(const Camera& camera, CameraRender& cameraRender, gpu::CommandBuffer& cmdBuf)
+GraphicsPipelineDesc SceneRenderer::GetGBufferPipelineDesc(const CameraRender& cameraRender)
 {
-	cmdBuf.BeginRenderPass(cameraRender._GBufferRP);
+	GraphicsPipelineDesc graphicsDesc = {};
+	graphicsDesc.renderPass = cameraRender._GBufferRP;
+	graphicsDesc.shaderStages.vertex = _Device.FindShader<GBufferPassVS>();
+	graphicsDesc.shaderStages.fragment = _Device.FindShader<GBufferPassFS>();
 
-	cmdBuf.SetViewportAndScissor({ .width = cameraRender._SceneDepth.GetWidth(), .height = cameraRender._SceneDepth.GetHeight() });
-	
+	return graphicsDesc;
+}
+
+void SceneRenderer::RenderGBuffer(const Camera& camera, CameraRender& cameraRender, FrameGraph& graph)
+{
+	RenderSettings& settings = _ECS.GetSingletonComponent<RenderSettings>();
 	const FrustumPlanes viewFrustumPlanes = camera.GetFrustumPlanes();
+	const LODView lodView = LODView::FromCamera(
+		camera, settings._LODErrorPixels, settings._LODCrossFade ? settings._LODCrossFadeRange : 0.0f, &settings._GBufferLODStats
+	);
+
+	// Occlusion culling tests the last frame's Hi-Z, from where the camera was then.
+	const ClusterCullingDesc clusterCullingDesc =
+	{
+		.worldToClip = camera.GetWorldToClip(),
+		.coneCulling = true,
+		.position = camera.GetPosition(),
+		.occlusionCamera = settings._OcclusionCulling && cameraRender._IsHiZValid ? &cameraRender : nullptr,
+		.prevWorldToClip = camera.GetPrevWorldToClip(),
+	};
+
+	const bool cullClusters = settings._ClusterCulling;
+	std::vector<std::pair<SurfaceGroup*, const SurfaceDrawList*>> drawLists;
 
 	for (auto entity : _ECS.GetEntities<SurfaceGroup>())
 	{
 		auto& surfaceGroup = _ECS.GetComponent<SurfaceGroup>(entity);
-		const VkDescriptorSet descriptorSets[] = { CameraDescriptors::_DescriptorSet, surfaceGroup.GetSurfaceSet(), _Device.GetTextures() };
-		const uint32 dynamicOffsets[] = { cameraRender.GetDynamicOffset() };
+		SurfaceDrawList& drawList = _SurfaceDrawLists.emplace_back();
+
+		surfaceGroup.GatherDraws<true>(drawList, lodView, &viewFrustumPlanes);
 
-		surfaceGroup.Draw<true>(_Device, cmdBuf, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets, [&] ()
+		if (cullClusters)
 		{
-			GraphicsPipelineDesc graphicsDesc = {};
-			graphicsDesc.renderPass = cameraRender._GBufferRP;
-			graphicsDesc.shaderStages.vertex = _Device.FindShader<GBufferPassVS>();
-			graphicsDesc.shaderStages.fragment = _Device.FindShader<GBufferPassFS>();
+			CullClusters(drawList, clusterCullingDesc, settings._GBufferClusterStats, graph);
+		}
 
-			return graphicsDesc;
-		}, &viewFrustumPlanes);
+		drawLists.push_back({ &surfaceGroup, &drawList });
 	}
 
-	cmdBuf.EndRenderPass();
-}
\ No newline at end of file
+	graph.AddPass("GBuffer", EPassType::Graphics, [&] (FrameGraph::PassBuilder& builder)
+	{
+		builder.Write(cameraRender._GBuffer0, EResourceUsage::ColorAttachment);
+		builder.Write(cameraRender._GBuffer1, EResourceUsage::ColorAttachment);
+		builder.Write(cameraRender._SceneDepth, EResourceUsage::DepthAttachment);
+		ReadSurfaces(builder);
+
+		if (cullClusters)
+		{
+			builder.Read(_ClusterCommands, EResourceUsage::IndirectRead);
+		}
+	},
+	[this, &cameraRender, drawLists, cullClusters] (gpu::CommandBuffer& cmdBuf)
+	{
+		cmdBuf.BeginRenderPass(cameraRender._GBufferRP);
+
+		cmdBuf.SetViewportAndScissor({ .width = cameraRender._SceneDepth.GetWidth(), .height = cameraRender._SceneDepth.GetHeight() });
+
+		// The pass is hashed once. Surfaces look up their pipelines by its key.
+		const GraphicsPipelineKey passKey = _Device.GetPipelineKey(GetGBufferPipelineDesc(cameraRender));
+
+		for (auto [surfaceGroup, drawList] : drawLists)
+		{
+			const VkDescriptorSet descriptorSets[] = { CameraDescriptors::_DescriptorSet, surfaceGroup->GetSurfaceSet(), _Device.GetTextures() };
+			const uint32 dynamicOffsets[] = { cameraRender.GetDynamicOffset() };
+
+			surfaceGroup->Draw(_Device, cmdBuf, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets, *drawList,
+				passKey, cullClusters ? &_ClusterCommands : nullptr, GetClusterCommandBase());
+		}
+
+		cmdBuf.EndRenderPass();
+	});
+}
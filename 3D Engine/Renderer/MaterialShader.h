@@ -9,5 +9,11 @@ public:
 	static void SetEnvironmentVariables(ShaderCompilerWorker& worker)
 	{
 		worker.SetDefine("STATIC_MESH");
+
+		// Cross-fading levels of detail adds a discard to the GBuffer, so it's only compiled in when it's enabled.
+		if (Platform::GetBool("Engine.ini", "Renderer", "LODCrossFade", false))
+		{
+			worker.SetDefine("LOD_CROSS_FADE");
+		}
 	}
 };
\ No newline at end of file
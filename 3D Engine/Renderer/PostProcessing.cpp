@@ -17,34 +17,42 @@ public:
 
 REGISTER_SHADER(PostProcessingCS, "../Shaders/PostProcessingCS.glsl", "main", EShaderStage::Compute);
 
-void SceneRenderer::ComputePostProcessing(const gpu::Image& displayImage, CameraRender& camera, gpu::CommandBuffer& cmdBuf)
+void SceneRenderer::ComputePostProcessing(const gpu::Image& displayImage, CameraRender& camera, FrameGraph& graph)
 {
 	auto& settings = _ECS.GetSingletonComponent<RenderSettings>();
 
-	const gpu::Shader* shader = _Device.FindShader<PostProcessingCS>();
-
-	ComputePipelineDesc computeDesc;
-	computeDesc.shader = shader;
-
-	gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
-
-	cmdBuf.BindPipeline(pipeline);
-
-	cmdBuf.BindDescriptorSets(pipeline, 1, &_Device.GetImages(), 0, nullptr);
-
 	PostProcessingParams postProcessingParams;
 	postProcessingParams._ExposureAdjustment = settings._ExposureAdjustment;
 	postProcessingParams._ExposureBias = settings._ExposureBias;
 	postProcessingParams._DisplayColor = displayImage.GetImageID();
 	postProcessingParams._HDRColor = camera._SceneColor.GetImageID();
 
-	cmdBuf.PushConstants(pipeline, shader, &postProcessingParams);
+	graph.AddPass("PostProcessing", EPassType::AsyncCompute, [&] (FrameGraph::PassBuilder& builder)
+	{
+		builder.Read(camera._SceneColor, EResourceUsage::StorageRead);
+		builder.Write(displayImage, EResourceUsage::StorageWrite);
+	},
+	[this, &camera, postProcessingParams] (gpu::CommandBuffer& cmdBuf)
+	{
+		const gpu::Shader* shader = _Device.FindShader<PostProcessingCS>();
+
+		ComputePipelineDesc computeDesc;
+		computeDesc.shader = shader;
+
+		gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
+
+		cmdBuf.BindPipeline(pipeline);
+
+		cmdBuf.BindDescriptorSets(pipeline, 1, &_Device.GetImages(), 0, nullptr);
+
+		cmdBuf.PushConstants(pipeline, shader, &postProcessingParams);
 
-	const glm::ivec3 groupCount(
-		DivideAndRoundUp(camera._SceneColor.GetWidth(), 8u),
-		DivideAndRoundUp(camera._SceneColor.GetHeight(), 8u),
-		1
-	);
+		const glm::ivec3 groupCount(
+			DivideAndRoundUp(camera._SceneColor.GetWidth(), 8u),
+			DivideAndRoundUp(camera._SceneColor.GetHeight(), 8u),
+			1
+		);
 
-	cmdBuf.Dispatch(groupCount.x, groupCount.y, groupCount.z);
+		cmdBuf.Dispatch(groupCount.x, groupCount.y, groupCount.z);
+	});
 }
\ No newline at end of file
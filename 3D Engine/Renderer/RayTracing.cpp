@@ -21,19 +21,8 @@ public:
 
 REGISTER_SHADER(RayTracingCS, "../Shaders/RayTracingCS.glsl", "main", EShaderStage::Compute);
 
-void SceneRenderer::ComputeRayTracing(const Camera& camera, CameraRender& cameraRender, gpu::CommandBuffer& cmdBuf)
+void SceneRenderer::ComputeRayTracing(const Camera& camera, CameraRender& cameraRender, FrameGraph& graph)
 {
-	ImageMemoryBarrier imageBarrier
-	{
-		cameraRender._SceneColor,
-		EAccess::None,
-		EAccess::ShaderWrite,
-		EImageLayout::Undefined,
-		EImageLayout::General
-	};
-
-	cmdBuf.PipelineBarrier(EPipelineStage::TopOfPipe, EPipelineStage::ComputeShader, 0, nullptr, 1, &imageBarrier);
-
 	const float theta = glm::radians(camera.GetFieldOfView());
 	const float h = glm::tan(theta / 2.0f);
 	const float viewportHeight = 2.0f * h;
@@ -63,29 +52,30 @@ void SceneRenderer::ComputeRayTracing(const Camera& camera, CameraRender& camera
 	rayTracingParams._Skybox = skybox.GetTextureID(skyboxSampler);
 	rayTracingParams._FrameNumber = frameNumber++;
 
-	ComputePipelineDesc computeDesc = {};
-	computeDesc.shader = _Device.FindShader<RayTracingCS>();
-
-	gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
-
-	cmdBuf.BindPipeline(pipeline);
+	graph.AddPass("RayTracing", EPassType::Compute, [&] (FrameGraph::PassBuilder& builder)
+	{
+		// Accumulates into scene color across frames.
+		builder.Write(cameraRender._SceneColor, EResourceUsage::StorageReadWrite);
+	},
+	[this, &camera, &cameraRender, rayTracingParams] (gpu::CommandBuffer& cmdBuf)
+	{
+		ComputePipelineDesc computeDesc = {};
+		computeDesc.shader = _Device.FindShader<RayTracingCS>();
 
-	const VkDescriptorSet descriptorSets[] = { CameraDescriptors::_DescriptorSet, _Device.GetTextures() };
-	const uint32 dynamicOffsets[] = { cameraRender.GetDynamicOffset() };
+		gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
 
-	cmdBuf.BindDescriptorSets(pipeline, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets);
+		cmdBuf.BindPipeline(pipeline);
 
-	cmdBuf.PushConstants(pipeline, computeDesc.shader, &rayTracingParams);
+		const VkDescriptorSet descriptorSets[] = { CameraDescriptors::_DescriptorSet, _Device.GetTextures() };
+		const uint32 dynamicOffsets[] = { cameraRender.GetDynamicOffset() };
 
-	const uint32 groupCountX = DivideAndRoundUp(camera.GetWidth(), 8u);
-	const uint32 groupCountY = DivideAndRoundUp(camera.GetHeight(), 8u);
+		cmdBuf.BindDescriptorSets(pipeline, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets);
 
-	cmdBuf.Dispatch(groupCountX, groupCountY, 1);
+		cmdBuf.PushConstants(pipeline, computeDesc.shader, &rayTracingParams);
 
-	imageBarrier.srcAccessMask = EAccess::ShaderWrite;
-	imageBarrier.dstAccessMask = EAccess::ShaderRead;
-	imageBarrier.oldLayout = EImageLayout::General;
-	imageBarrier.newLayout = EImageLayout::General;
+		const uint32 groupCountX = DivideAndRoundUp(camera.GetWidth(), 8u);
+		const uint32 groupCountY = DivideAndRoundUp(camera.GetHeight(), 8u);
 
-	cmdBuf.PipelineBarrier(EPipelineStage::ComputeShader, EPipelineStage::ComputeShader, 0, nullptr, 1, &imageBarrier);
+		cmdBuf.Dispatch(groupCountX, groupCountY, 1);
+	});
 }
\ No newline at end of file
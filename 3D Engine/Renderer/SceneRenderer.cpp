@@ -1,12 +1,16 @@
 #include "SceneRenderer.h"
 #include <Engine/Engine.h>
 #include <Components/RenderSettings.h>
+#include <Renderer/ShadowRender.h>
+#include <Renderer/Surface.h>
+#include <chrono>
 
 SceneRenderer::SceneRenderer(Engine& engine)
 	: _Device(engine._Device)
 	, _Compositor(engine._Compositor)
 	, _ECS(engine._ECS)
 	, _Assets(engine._Assets)
+	, _FrameGraph(engine._Device)
 {
 	_ScreenResizeEvent = engine._Screen.OnScreenResize([this] (int32 width, int32 height)
 	{
@@ -19,15 +23,11 @@ SceneRenderer::SceneRenderer(Engine& engine)
 
 		for (const auto& image : images)
 		{
-			// After UI rendering, the image is ready for the present queue.
+			// The frame graph transitions the image for presentation.
 			RenderPassDesc rpDesc = {};
 			rpDesc.colorAttachments.push_back(
-				AttachmentView(&image, ELoadAction::Load, EStoreAction::Store, std::array<float, 4>{ 0.0f }, EImageLayout::ColorAttachmentOptimal, EImageLayout::Present));
+				AttachmentView(&image, ELoadAction::Load, EStoreAction::Store, std::array<float, 4>{ 0.0f }, EImageLayout::ColorAttachmentOptimal, EImageLayout::ColorAttachmentOptimal));
 			rpDesc.renderArea.extent = { image.GetWidth(), image.GetHeight() };
-			rpDesc.srcStageMask = EPipelineStage::ComputeShader;
-			rpDesc.dstStageMask = EPipelineStage::ColorAttachmentOutput;
-			rpDesc.srcAccessMask = EAccess::ShaderRead | EAccess::ShaderWrite;
-			rpDesc.dstAccessMask = EAccess::ColorAttachmentRead | EAccess::ColorAttachmentWrite;
 
 			_UserInterfaceRP.push_back(_Device.CreateRenderPass(rpDesc));
 		}
@@ -35,57 +35,199 @@ SceneRenderer::SceneRenderer(Engine& engine)
 		CreateUserInterfacePipeline();
 	});
 
-	_AcquireNextImageSem = _Device.CreateSemaphore();
-	_EndOfFrameSem = _Device.CreateSemaphore();
+	for (uint32 frameIndex = 0; frameIndex < _Device.GetNumFramesInFlight(); frameIndex++)
+	{
+		_AcquireNextImageSems.push_back(_Device.CreateSemaphore());
+		_EndOfFrameSems.push_back(_Device.CreateSemaphore());
+	}
+
+	ResizeClusterCommands(Platform::GetInt("Engine.ini", "Renderer", "ClusterCapacity", 65536));
 }
 
 void SceneRenderer::Render()
 {
-	const uint32 imageIndex = _Compositor.AcquireNextImage(_Device, _AcquireNextImageSem);
+	const auto startTime = std::chrono::high_resolution_clock::now();
 
-	const RenderSettings& settings = _ECS.GetSingletonComponent<RenderSettings>();
+	gpu::Semaphore& acquireNextImageSem = _AcquireNextImageSems[_Device.GetFrameIndex()];
+	gpu::Semaphore& endOfFrameSem = _EndOfFrameSems[_Device.GetFrameIndex()];
 
-	gpu::CommandBuffer cmdBuf = _Device.CreateCommandBuffer(EQueue::Graphics);
+	const uint32 imageIndex = _Compositor.AcquireNextImage(_Device, acquireNextImageSem);
+
+	RenderSettings& settings = _ECS.GetSingletonComponent<RenderSettings>();
 
 	auto& camera = _ECS.GetComponent<Camera>(_ECS.GetEntities<Camera>().front());
 	auto& cameraRender = _ECS.GetComponent<CameraRender>(_ECS.GetEntities<CameraRender>().front());
-	
-	if (settings._UseRayTracing)
+
+	const gpu::Image& displayImage = _Compositor.GetImages()[imageIndex];
+
+	WarmUpPipelines(cameraRender);
+
+	FrameGraph& graph = _FrameGraph;
+	graph.Reset();
+
+	_SurfaceDrawLists.clear();
+	_NumClusterCommands = 0;
+
+	// The camera's render targets are rewritten every frame, except for the histories and the accumulated scene color.
+	graph.ImportImage("GBuffer0", cameraRender._GBuffer0, EImageLayout::Undefined);
+	graph.ImportImage("GBuffer1", cameraRender._GBuffer1, EImageLayout::Undefined);
+	graph.ImportImage("SceneDepth", cameraRender._SceneDepth, EImageLayout::Undefined);
+	graph.ImportImage("DirectLighting", cameraRender._DirectLighting, EImageLayout::Undefined);
+	graph.ImportImage("SceneColor", cameraRender._SceneColor, EImageLayout::General, EImageLayout::General, true);
+	graph.ImportImage("SSRHistory", cameraRender._SSRHistory, EImageLayout::General, EImageLayout::General, true);
+	graph.ImportImage("SSGIHistory", cameraRender._SSGIHistory, EImageLayout::General, EImageLayout::General, true);
+	graph.ImportImage("HiZ", cameraRender._HiZ, EImageLayout::General, EImageLayout::General, true);
+	graph.ImportBuffer("ClusterCommands", _ClusterCommands);
+	graph.ImportImage("Display", displayImage, EImageLayout::Undefined, EImageLayout::Present, true);
+
+	for (auto entity : _ECS.GetEntities<ShadowRender>())
 	{
-		ComputeRayTracing(camera, cameraRender, cmdBuf);
+		graph.ImportImage("ShadowMap" + std::to_string(entity.GetEntityID()), _ECS.GetComponent<ShadowRender>(entity).GetShadowMap(), EImageLayout::Undefined);
+	}
+
+	for (auto entity : _ECS.GetEntities<SurfaceGroup>())
+	{
+		graph.ImportBuffer("LocalToWorld" + std::to_string(entity.GetEntityID()), _ECS.GetComponent<SurfaceGroup>(entity).GetLocalToWorldBuffer(), true);
+	}
+
+	ScatterSurfaceDeltas(graph);
+
+	// Views pick their levels of detail and cull their clusters while the graph is built.
+	settings._GBufferLODStats = {};
+	settings._ShadowLODStats = {};
+	settings._GBufferClusterStats = {};
+	settings._ShadowClusterStats = {};
+
+	// The raster passes are always added. In ray tracing mode nothing consumes them and they're culled.
+	RenderGBuffer(camera, cameraRender, graph);
+
+	// Hi-Z is only useful to occlusion culling, and is built from the rasterized depth.
+	if (settings._ClusterCulling && settings._OcclusionCulling && !settings._UseRayTracing)
+	{
+		BuildHiZ(cameraRender, graph);
 	}
 	else
 	{
-		RenderGBuffer(camera, cameraRender, cmdBuf);
+		cameraRender._IsHiZValid = false;
+	}
 
-		RenderShadowDepths(cameraRender, cmdBuf);
+	RenderShadowDepths(camera, graph);
 
-		ComputeDirectLighting(cameraRender, cmdBuf);
+	ComputeDirectLighting(cameraRender, graph);
 
-		RenderSkybox(cameraRender, cmdBuf);
+	RenderSkybox(cameraRender, graph);
 
-		ComputeSSGI(camera, cameraRender, cmdBuf);
+	if (settings._UseRayTracing)
+	{
+		ComputeRayTracing(camera, cameraRender, graph);
+	}
+	else
+	{
+		ComputeSSGI(camera, cameraRender, graph);
 	}
 
-	const gpu::Image& displayImage = _Compositor.GetImages()[imageIndex];
-	ImageMemoryBarrier barrier{ displayImage, EAccess::MemoryRead, EAccess::ShaderWrite, EImageLayout::Undefined, EImageLayout::General };
+	ComputePostProcessing(displayImage, cameraRender, graph);
+
+	RenderUserInterface(displayImage, _UserInterfaceRP[imageIndex], graph);
+
+	graph.Compile();
+
+	// Transient targets are placed by their lifetimes, which are only known once the graph is compiled.
+	cameraRender.UpdateTransientTargets(_Device, graph);
 
-	cmdBuf.PipelineBarrier(EPipelineStage::TopOfPipe, EPipelineStage::ComputeShader, 0, nullptr, 1, &barrier);
+	if (settings._DumpFrameGraph)
+	{
+		Platform::FileWrite("FrameGraph.dot", graph.Dump());
+
+		LOG("Frame graph: %zu passes, %zu scheduled, %zu barriers, %zu submissions. Wrote FrameGraph.dot.",
+			graph.GetNumPasses(), graph.GetNumScheduledPasses(), graph.GetNumBarriers(), graph.GetNumSubmissions());
 
-	ComputePostProcessing(displayImage, cameraRender, cmdBuf);
+		settings._DumpFrameGraph = false;
+	}
 
-	barrier.srcAccessMask = EAccess::ShaderWrite;
-	barrier.dstAccessMask = EAccess::ColorAttachmentRead | EAccess::ColorAttachmentWrite;
-	barrier.oldLayout = EImageLayout::General;
-	barrier.newLayout = EImageLayout::ColorAttachmentOptimal;
-	
-	cmdBuf.PipelineBarrier(EPipelineStage::ComputeShader, EPipelineStage::ColorAttachmentOutput, 0, nullptr, 1, &barrier);
+	graph.Execute(acquireNextImageSem, endOfFrameSem);
 
-	RenderUserInterface(cmdBuf, _UserInterfaceRP[imageIndex]);
+	settings._PassTimings = graph.GetPassTimings();
 
-	_Device.SubmitCommands(cmdBuf, _AcquireNextImageSem, _EndOfFrameSem);
+	_Compositor.QueuePresent(_Device, imageIndex, endOfFrameSem);
 
-	_Compositor.QueuePresent(_Device, imageIndex, _EndOfFrameSem);
+	if (_IsFirstFrame)
+	{
+		const float frameMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+		LOG("First frame rendered in %.1f ms.", frameMs);
+
+		_IsFirstFrame = false;
+	}
 
 	_Device.EndFrame();
+}
+
+void SceneRenderer::WarmUpPipelines(CameraRender& cameraRender)
+{
+	std::vector<GraphicsPipelineDesc> graphicsDescs;
+	std::vector<ComputePipelineDesc> computeDescs;
+
+	std::vector<const ShadowRender*> shadowRenders;
+
+	for (auto entity : _ECS.GetEntities<ShadowRender>())
+	{
+		shadowRenders.push_back(&_ECS.GetComponent<ShadowRender>(entity));
+	}
+
+	for (auto entity : _ECS.GetEntities<SurfaceGroup>())
+	{
+		auto& surfaceGroup = _ECS.GetComponent<SurfaceGroup>(entity);
+
+		for (uint32 surfaceID : surfaceGroup.TakeAddedSurfaces())
+		{
+			// Surfaces can be removed in the frame they're added.
+			if (!surfaceGroup.HasSurface(surfaceID))
+			{
+				continue;
+			}
+
+			const Surface& surface = surfaceGroup.GetSurface(surfaceID);
+
+			graphicsDescs.push_back(surface.GetPipelineDesc(GetGBufferPipelineDesc(cameraRender)));
+
+			for (const ShadowRender* shadowRender : shadowRenders)
+			{
+				graphicsDescs.push_back(surface.GetPipelineDesc(GetShadowDepthPipelineDesc(*shadowRender)));
+			}
+		}
+	}
+
+	if (_IsFirstFrame)
+	{
+		// Direct lighting is only used specialized per light type, for the first light and the rest.
+		for (bool isDirectionalLight : { true, false })
+		{
+			for (bool isFirstLight : { true, false })
+			{
+				computeDescs.push_back(GetDirectLightingPipelineDesc(isDirectionalLight, isFirstLight));
+			}
+		}
+
+		const gpu::Shader* directLightingShader = computeDescs.front().shader;
+
+		// The other compute shaders have one pipeline.
+		for (const auto& [typeIndex, shader] : _Device.GetShaders())
+		{
+			if (shader->compilationResult.stage == EShaderStage::Compute && shader != directLightingShader)
+			{
+				computeDescs.push_back({ .shader = shader });
+			}
+		}
+
+		_Device.WarmUpPipelines(graphicsDescs, computeDescs);
+	}
+	else
+	{
+		// Surfaces loaded later are drawn once their pipelines are created in the background, rather than stalling the frame.
+		for (const GraphicsPipelineDesc& graphicsDesc : graphicsDescs)
+		{
+			_Device.CreatePipelineAsync(graphicsDesc);
+		}
+	}
 }
\ No newline at end of file
@@ -2,11 +2,30 @@
 #include <GPU/GPU.h>
 #include <Engine/Screen.h>
 #include "CameraRender.h"
+#include "FrameGraph.h"
+#include "Surface.h"
+#include <deque>
 
 class Engine;
 class Camera;
 class EntityManager;
 class AssetManager;
+class ShadowRender;
+
+/** How a view's meshlets are culled. Every view culls against its frustum. */
+struct ClusterCullingDesc
+{
+	glm::mat4 worldToClip;
+
+	/** Cull meshlets facing away from the position. Only views that see triangles from a point can, so shadow views don't. */
+	bool coneCulling = false;
+	glm::vec3 position;
+
+	/** Camera whose last frame's Hi-Z occludes meshlets, or null to skip occlusion culling. */
+	CameraRender* occlusionCamera = nullptr;
+	/** Transform of the last frame, which the Hi-Z was rendered with. */
+	glm::mat4 prevWorldToClip;
+};
 
 class SceneRenderer
 {
@@ -25,18 +44,62 @@ private:
 
 	std::vector<gpu::RenderPass> _UserInterfaceRP;
 
-	gpu::Semaphore _AcquireNextImageSem;
-	gpu::Semaphore _EndOfFrameSem;
+	/** Binary semaphores can't be reused until their frame completes, so there's one per frame in flight. */
+	std::vector<gpu::Semaphore> _AcquireNextImageSems;
+	std::vector<gpu::Semaphore> _EndOfFrameSems;
+
+	/** Rebuilt every frame. Owns the barriers between passes. */
+	FrameGraph _FrameGraph;
+
+	/** Draw lists of the frame's views. A deque, so passes can keep references to lists while more are added. */
+	std::deque<SurfaceDrawList> _SurfaceDrawLists;
+
+	/** Indirect commands written by cluster culling, one per candidate meshlet. Each frame in flight has its own range of the capacity. */
+	gpu::Buffer _ClusterCommands;
+	uint32 _ClusterCommandCapacity = 0;
+	/** Commands taken by this frame's views. */
+	uint32 _NumClusterCommands = 0;
 
-	void RenderGBuffer(const Camera& camera, CameraRender& cameraRender, gpu::CommandBuffer& cmdBuf);
-	void RenderShadowDepths(CameraRender& camera, gpu::CommandBuffer& cmdBuf);
-	void ComputeDirectLighting(CameraRender& camera, gpu::CommandBuffer& cmdBuf);
+	/** Compute pipelines are warmed up with the first frame's surfaces. */
+	bool _IsFirstFrame = true;
+
+	/**
+	  * Create the GBuffer and shadow depth pipelines of surfaces added since the last frame, and on the first frame every compute pipeline,
+	  * in parallel before the frame that uses them. After the first frame, graphics pipelines are queued in the background instead.
+	  */
+	void WarmUpPipelines(CameraRender& cameraRender);
+	GraphicsPipelineDesc GetGBufferPipelineDesc(const CameraRender& cameraRender);
+	GraphicsPipelineDesc GetShadowDepthPipelineDesc(const ShadowRender& shadowRender);
+	ComputePipelineDesc GetDirectLightingPipelineDesc(bool isDirectionalLight, bool isFirstLight);
+
+	void ScatterSurfaceDeltas(FrameGraph& graph);
+	void RenderGBuffer(const Camera& camera, CameraRender& cameraRender, FrameGraph& graph);
+	void RenderShadowDepths(const Camera& camera, FrameGraph& graph);
+	void ComputeDirectLighting(CameraRender& camera, FrameGraph& graph);
 	void ComputeDirectLighting(CameraRender& camera, gpu::CommandBuffer& cmdBuf, const struct DirectLightingParams& light, bool isFirstLight);
-	void ComputeSSGI(const Camera& camera, CameraRender& cameraRender, gpu::CommandBuffer& cmdBuf);
-	void ComputeRayTracing(const Camera& camera, CameraRender& cameraRender, gpu::CommandBuffer& cmdBuf);
-	void RenderSkybox(CameraRender& camera, gpu::CommandBuffer& cmdBuf);
-	void ComputePostProcessing(const gpu::Image& displayImage, CameraRender& camera, gpu::CommandBuffer& cmdBuf);
-	void RenderUserInterface(gpu::CommandBuffer& cmdBuf, const gpu::RenderPass& renderPass);
+	void ComputeSSGI(const Camera& camera, CameraRender& cameraRender, FrameGraph& graph);
+	void ComputeRayTracing(const Camera& camera, CameraRender& cameraRender, FrameGraph& graph);
+	void RenderSkybox(CameraRender& camera, FrameGraph& graph);
+	void ComputePostProcessing(const gpu::Image& displayImage, CameraRender& camera, FrameGraph& graph);
+	void RenderUserInterface(const gpu::Image& displayImage, const gpu::RenderPass& renderPass, FrameGraph& graph);
+
+	/** Surface buffers read by the raster passes. */
+	void ReadSurfaces(FrameGraph::PassBuilder& builder);
+
+	/**
+	  * Upload the meshlets of a view's draws as cluster candidates, and add a pass that culls them into indirect commands.
+	  * Sets the first command of each draw, relative to the frame's range.
+	  */
+	void CullClusters(SurfaceDrawList& drawList, const ClusterCullingDesc& desc, ClusterCullingStats& stats, FrameGraph& graph);
+
+	/** First command of the current frame's range. */
+	inline uint32 GetClusterCommandBase() const { return _Device.GetFrameIndex() * _ClusterCommandCapacity; }
+
+	/** Grow the cluster commands so each frame in flight has room for at least this many. */
+	void ResizeClusterCommands(uint32 numCommands);
+
+	/** Build the Hi-Z from the camera's depth, for the next frame's occlusion culling. */
+	void BuildHiZ(CameraRender& cameraRender, FrameGraph& graph);
 
 	void CreateUserInterfacePipeline();
 };
\ No newline at end of file
@@ -20,13 +20,9 @@ ShadowRender::ShadowRender(gpu::Device& device, const DirectionalLight& directio
 		&_ShadowMap,
 		ELoadAction::Clear, EStoreAction::Store,
 		ClearDepthStencilValue{},
-		EImageLayout::Undefined,
-		EImageLayout::DepthReadStencilWrite);
+		EImageLayout::DepthWriteStencilWrite,
+		EImageLayout::DepthWriteStencilWrite);
 	rpDesc.renderArea = RenderArea{ glm::ivec2{}, glm::uvec2(_ShadowMap.GetWidth(), _ShadowMap.GetHeight()) };
-	rpDesc.srcStageMask = EPipelineStage::TopOfPipe;
-	rpDesc.dstStageMask = EPipelineStage::ComputeShader;
-	rpDesc.srcAccessMask = EAccess::None;
-	rpDesc.dstAccessMask = EAccess::ShaderRead;
 	
 	_RenderPass = device.CreateRenderPass(rpDesc);
 }
@@ -74,35 +70,79 @@ public:
 
 REGISTER_SHADER(ShadowDepthFS, "../Shaders/ShadowDepthFS.glsl", "main", EShaderStage::Fragment);
 
-void SceneRenderer::RenderShadowDepths(CameraRender& camera, gpu::CommandBuffer& cmdBuf)
+GraphicsPipelineDesc SceneRenderer::GetShadowDepthPipelineDesc(const ShadowRender& shadowRender)
 {
+	GraphicsPipelineDesc graphicsDesc = {};
+	graphicsDesc.renderPass = shadowRender.GetRenderPass();
+	graphicsDesc.shaderStages.vertex = _Device.FindShader<ShadowDepthVS>();
+	graphicsDesc.shaderStages.fragment = _Device.FindShader<ShadowDepthFS>();
+	graphicsDesc.rasterizationState.depthBiasEnable = true;
+	graphicsDesc.rasterizationState.depthBiasConstantFactor = shadowRender.GetDepthBiasConstantFactor();
+	graphicsDesc.rasterizationState.depthBiasSlopeFactor = shadowRender.GetDepthBiasSlopeFactor();
+	return graphicsDesc;
+}
+
+void SceneRenderer::RenderShadowDepths(const Camera& camera, FrameGraph& graph)
+{
+	RenderSettings& settings = _ECS.GetSingletonComponent<RenderSettings>();
+
+	// Shadow casters pick their levels as the camera sees them, with a coarser threshold. The shadow depth shaders don't cross-fade.
+	const LODView lodView = LODView::FromCamera(camera, settings._ShadowLODErrorPixels, 0.0f, &settings._ShadowLODStats);
+	const bool cullClusters = settings._ClusterCulling;
+
 	for (auto entity : _ECS.GetEntities<ShadowRender>())
 	{
 		ShadowRender& shadowRender = _ECS.GetComponent<ShadowRender>(entity);
 
-		cmdBuf.BeginRenderPass(shadowRender.GetRenderPass());
+		// Shadow maps see both sides of casters, so only the light's frustum culls clusters.
+		const ClusterCullingDesc clusterCullingDesc = { .worldToClip = shadowRender.GetLightViewProjMatrix() };
 
-		cmdBuf.SetViewportAndScissor({ .width = shadowRender.GetShadowMap().GetWidth(), .height = shadowRender.GetShadowMap().GetHeight() });
-		
-		for (auto entity : _ECS.GetEntities<SurfaceGroup>())
+		std::vector<std::pair<SurfaceGroup*, const SurfaceDrawList*>> drawLists;
+
+		for (auto surfaceGroupEntity : _ECS.GetEntities<SurfaceGroup>())
 		{
-			auto& surfaceGroup = _ECS.GetComponent<SurfaceGroup>(entity);
-			const VkDescriptorSet descriptorSets[] = { ShadowDescriptors::_DescriptorSet, surfaceGroup.GetSurfaceSet(), _Device.GetTextures() };
-			const uint32 dynamicOffsets[] = { shadowRender.GetDynamicOffset() };
+			auto& surfaceGroup = _ECS.GetComponent<SurfaceGroup>(surfaceGroupEntity);
+			SurfaceDrawList& drawList = _SurfaceDrawLists.emplace_back();
+
+			surfaceGroup.GatherDraws<false>(drawList, lodView);
 
-			surfaceGroup.Draw<false>(_Device, cmdBuf, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets, [&] ()
+			if (cullClusters)
 			{
-				GraphicsPipelineDesc graphicsDesc = {};
-				graphicsDesc.renderPass = shadowRender.GetRenderPass();
-				graphicsDesc.shaderStages.vertex = _Device.FindShader<ShadowDepthVS>();
-				graphicsDesc.shaderStages.fragment = _Device.FindShader<ShadowDepthFS>();
-				graphicsDesc.rasterizationState.depthBiasEnable = true;
-				graphicsDesc.rasterizationState.depthBiasConstantFactor = shadowRender.GetDepthBiasConstantFactor();
-				graphicsDesc.rasterizationState.depthBiasSlopeFactor = shadowRender.GetDepthBiasSlopeFactor();
-				return graphicsDesc;
-			});
+				CullClusters(drawList, clusterCullingDesc, settings._ShadowClusterStats, graph);
+			}
+
+			drawLists.push_back({ &surfaceGroup, &drawList });
 		}
 
-		cmdBuf.EndRenderPass();
+		graph.AddPass("ShadowDepth", EPassType::Graphics, [&] (FrameGraph::PassBuilder& builder)
+		{
+			builder.Write(shadowRender.GetShadowMap(), EResourceUsage::DepthAttachment);
+			ReadSurfaces(builder);
+
+			if (cullClusters)
+			{
+				builder.Read(_ClusterCommands, EResourceUsage::IndirectRead);
+			}
+		},
+		[this, &shadowRender, drawLists, cullClusters] (gpu::CommandBuffer& cmdBuf)
+		{
+			cmdBuf.BeginRenderPass(shadowRender.GetRenderPass());
+
+			cmdBuf.SetViewportAndScissor({ .width = shadowRender.GetShadowMap().GetWidth(), .height = shadowRender.GetShadowMap().GetHeight() });
+
+			// The pass is hashed once. Surfaces look up their pipelines by its key.
+			const GraphicsPipelineKey passKey = _Device.GetPipelineKey(GetShadowDepthPipelineDesc(shadowRender));
+
+			for (auto [surfaceGroup, drawList] : drawLists)
+			{
+				const VkDescriptorSet descriptorSets[] = { ShadowDescriptors::_DescriptorSet, surfaceGroup->GetSurfaceSet(), _Device.GetTextures() };
+				const uint32 dynamicOffsets[] = { shadowRender.GetDynamicOffset() };
+
+				surfaceGroup->Draw(_Device, cmdBuf, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets, *drawList,
+					passKey, cullClusters ? &_ClusterCommands : nullptr, GetClusterCommandBase());
+			}
+
+			cmdBuf.EndRenderPass();
+		});
 	}
-}
\ No newline at end of file
+}
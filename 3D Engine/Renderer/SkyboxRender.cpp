@@ -16,6 +16,15 @@ public:
 
 REGISTER_SHADER(SkyboxVS, "../Shaders/SkyboxVS.glsl", "main", EShaderStage::Vertex);
 
+/** Dequantizes the cube's positions. */
+BEGIN_PUSH_CONSTANTS(SkyboxVertexParams)
+	MEMBER(glm::vec3, _PositionScale)
+	MEMBER(float, _pad0)
+	MEMBER(glm::vec3, _PositionBias)
+	MEMBER(float, _pad1)
+END_PUSH_CONSTANTS(SkyboxVertexParams)
+
+/** After SkyboxVertexParams. */
 BEGIN_PUSH_CONSTANTS(SkyboxParams)
 	MEMBER(gpu::TextureID, _Skybox)
 END_PUSH_CONSTANTS(SkyboxParams)
@@ -28,49 +37,70 @@ public:
 
 REGISTER_SHADER(SkyboxFS, "../Shaders/SkyboxFS.glsl", "main", EShaderStage::Fragment);
 
-void SceneRenderer::RenderSkybox(CameraRender& camera, gpu::CommandBuffer& cmdBuf)
+void SceneRenderer::RenderSkybox(CameraRender& camera, FrameGraph& graph)
 {
-	cmdBuf.BeginRenderPass(camera._SkyboxRP);
+	graph.AddPass("Skybox", EPassType::Graphics, [&] (FrameGraph::PassBuilder& builder)
+	{
+		builder.Write(camera._DirectLighting, EResourceUsage::ColorAttachment);
+		builder.Write(camera._SceneDepth, EResourceUsage::DepthAttachment);
+	},
+	[this, &camera] (gpu::CommandBuffer& cmdBuf)
+	{
+		cmdBuf.BeginRenderPass(camera._SkyboxRP);
 
-	cmdBuf.SetViewportAndScissor({ .width = camera._SceneDepth.GetWidth(), .height = camera._SceneDepth.GetHeight() });
+		cmdBuf.SetViewportAndScissor({ .width = camera._SceneDepth.GetWidth(), .height = camera._SceneDepth.GetHeight() });
 
-	const SkyboxVS* vertShader = _Device.FindShader<SkyboxVS>();
-	const SkyboxFS* fragShader = _Device.FindShader<SkyboxFS>();
+		const SkyboxVS* vertShader = _Device.FindShader<SkyboxVS>();
+		const SkyboxFS* fragShader = _Device.FindShader<SkyboxFS>();
+		const StaticMesh* cube = _Assets.GetStaticMesh("Cube");
 
-	GraphicsPipelineDesc graphicsDesc = {};
-	graphicsDesc.renderPass = camera._SkyboxRP;
-	graphicsDesc.depthStencilState.depthTestEnable = true;
-	graphicsDesc.depthStencilState.depthWriteEnable = true;
-	graphicsDesc.depthStencilState.depthCompareTest = ECompareOp::LessOrEqual;
-	graphicsDesc.shaderStages = { vertShader, nullptr, nullptr, nullptr, fragShader };
+		// Only the cube's positions are read. They're the first attribute, so they're in the first vertex buffer.
+		const VertexLayout& vertexLayout = cube->_Submeshes.front().GetVertexLayout();
+		const VertexAttributeDescription positionAttribute = vertexLayout.GetAttribute(EVertexAttribute::Position);
 
-	gpu::Pipeline pipeline = _Device.CreatePipeline(graphicsDesc);
+		GraphicsPipelineDesc graphicsDesc = {};
+		graphicsDesc.renderPass = camera._SkyboxRP;
+		graphicsDesc.depthStencilState.depthTestEnable = true;
+		graphicsDesc.depthStencilState.depthWriteEnable = true;
+		graphicsDesc.depthStencilState.depthCompareTest = ECompareOp::LessOrEqual;
+		graphicsDesc.shaderStages = { vertShader, nullptr, nullptr, nullptr, fragShader };
+		graphicsDesc.vertexAttributes = { positionAttribute };
+		graphicsDesc.vertexBindings = { { positionAttribute.binding, vertexLayout.GetStride(positionAttribute.binding) } };
 
-	cmdBuf.BindPipeline(pipeline);
+		gpu::Pipeline pipeline = _Device.CreatePipeline(graphicsDesc);
 
-	const VkDescriptorSet descriptorSets[] = { CameraDescriptors::_DescriptorSet, _Device.GetTextures() };
-	const uint32 dynamicOffsets[] = { camera.GetDynamicOffset() };
+		cmdBuf.BindPipeline(pipeline);
 
-	cmdBuf.BindDescriptorSets(pipeline, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets);
+		const VkDescriptorSet descriptorSets[] = { CameraDescriptors::_DescriptorSet, _Device.GetTextures() };
+		const uint32 dynamicOffsets[] = { camera.GetDynamicOffset() };
 
-	for (auto& entity : _ECS.GetEntities<SkyboxComponent>())
-	{
-		auto& skybox = _ECS.GetComponent<SkyboxComponent>(entity)._Skybox->GetImage();
-		const auto skyboxSampler = _Device.CreateSampler({ EFilter::Linear, ESamplerAddressMode::ClampToEdge, ESamplerMipmapMode::Linear });
+		cmdBuf.BindDescriptorSets(pipeline, std::size(descriptorSets), descriptorSets, std::size(dynamicOffsets), dynamicOffsets);
 
-		SkyboxParams skyboxParams;
-		skyboxParams._Skybox = skybox.GetTextureID(skyboxSampler);
+		for (auto& entity : _ECS.GetEntities<SkyboxComponent>())
+		{
+			auto& skybox = _ECS.GetComponent<SkyboxComponent>(entity)._Skybox->GetImage();
+			const auto skyboxSampler = _Device.CreateSampler({ EFilter::Linear, ESamplerAddressMode::ClampToEdge, ESamplerMipmapMode::Linear });
 
-		cmdBuf.PushConstants(pipeline, fragShader, &skyboxParams);
+			SkyboxParams skyboxParams;
+			skyboxParams._Skybox = skybox.GetTextureID(skyboxSampler);
 
-		const StaticMesh* cube = _Assets.GetStaticMesh("Cube");
+			cmdBuf.PushConstants(pipeline, fragShader, &skyboxParams);
 
-		for (const auto& submesh : cube->_Submeshes)
-		{
-			cmdBuf.BindVertexBuffers(1, &submesh.GetPositionBuffer());
-			cmdBuf.DrawIndexed(submesh.GetIndexBuffer(), submesh.GetIndexCount(), 1, 0, 0, 0, submesh.GetIndexType());
+			for (const auto& submesh : cube->_Submeshes)
+			{
+				_Device.WaitForUpload(submesh.GetUploadTicket());
+
+				SkyboxVertexParams vertexParams;
+				vertexParams._PositionScale = submesh.GetDequantization().positionScale;
+				vertexParams._PositionBias = submesh.GetDequantization().positionBias;
+
+				cmdBuf.PushConstants(pipeline, vertShader, &vertexParams);
+
+				cmdBuf.BindVertexBuffers(1, &submesh.GetPositionBuffer());
+				cmdBuf.DrawIndexed(submesh.GetIndexBuffer(), submesh.GetIndexCount(), 1, 0, 0, 0, submesh.GetIndexType());
+			}
 		}
-	}
 
-	cmdBuf.EndRenderPass();
+		cmdBuf.EndRenderPass();
+	});
 }
\ No newline at end of file
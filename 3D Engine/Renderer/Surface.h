@@ -2,7 +2,39 @@
 #include <ECS/Component.h>
 #include <GPU/GPU.h>
 #include <Engine/StaticMesh.h>
+#include <Systems/SurfaceSystem.h>
 #include <Physics/Physics.h>
+#include <Components/Camera.h>
+#include <Components/RenderSettings.h>
+#include <utility>
+
+/** How a view picks the levels of detail of the surfaces it draws. */
+struct LODView
+{
+	/** Where errors are projected from. */
+	glm::vec3 position;
+	/** Pixels covered by a unit one unit away. */
+	float pixelsPerUnit;
+	/** The coarsest level whose error projects to at most this many pixels is drawn. */
+	float maxErrorPixels;
+	/** Past the switch to a coarser level, it fades in over this fraction of the switch distance. 0 switches without fading. */
+	float crossFadeRange;
+	/** Triangles drawn by the view are added to the stats. */
+	LODStats* stats;
+
+	/** Select levels by their error as seen by a camera. */
+	static LODView FromCamera(const Camera& camera, float maxErrorPixels, float crossFadeRange, LODStats* stats)
+	{
+		return LODView
+		{
+			.position = camera.GetPosition(),
+			.pixelsPerUnit = camera.GetHeight() / (2.0f * std::tan(glm::radians(camera.GetFieldOfView()) / 2.0f)),
+			.maxErrorPixels = maxErrorPixels,
+			.crossFadeRange = crossFadeRange,
+			.stats = stats,
+		};
+	}
+};
 
 class Surface
 {
@@ -20,12 +52,71 @@ public:
 	inline const Material* GetMaterial() const { return _Material; }
 	inline const SpecializationInfo& GetMaterialInfo() const { return _Material->GetSpecializationInfo(); }
 	inline const BoundingBox& GetBoundingBox() const { return _BoundingBox; }
+
+	/** Add the material's specialization and the vertex layout to a pass's pipeline. */
+	inline GraphicsPipelineDesc GetPipelineDesc(GraphicsPipelineDesc graphicsDesc) const
+	{
+		graphicsDesc.specInfo = GetMaterialInfo();
+
+		// Submeshes of a mesh are cooked with the same vertex layout.
+		const VertexLayout& vertexLayout = GetSubmeshes().front().GetVertexLayout();
+		graphicsDesc.vertexAttributes = vertexLayout.GetAttributes();
+		graphicsDesc.vertexBindings = vertexLayout.GetBindings();
+
+		return graphicsDesc;
+	}
+
+	/** The pipeline of a pass for this surface. Keys are cached per pass, so drawing looks them up by comparing pass keys. */
+	inline GraphicsPipelineKey GetPipelineKey(gpu::Device& device, GraphicsPipelineKey passKey) const
+	{
+		for (const auto& [cachedPassKey, pipelineKey] : _PipelineKeys)
+		{
+			if (cachedPassKey == passKey)
+			{
+				return pipelineKey;
+			}
+		}
+
+		const GraphicsPipelineKey pipelineKey = device.GetPipelineKey(GetPipelineDesc(device.GetPipelineDesc(passKey)));
+
+		_PipelineKeys.push_back({ passKey, pipelineKey });
+
+		return pipelineKey;
+	}
+
+	inline void SetBoundingBox(const BoundingBox& boundingBox) { _BoundingBox = boundingBox; }
+
+	/** Largest scale of the local-to-world transform. LOD errors are in local units. */
+	inline float GetScale() const { return _Scale; }
+	inline void SetScale(float scale) { _Scale = scale; }
 	
 private:
 	uint32 _SurfaceID;
 	const std::vector<Submesh>* _Submeshes;
 	const Material* _Material;
 	BoundingBox _BoundingBox;
+	float _Scale = 1.0f;
+
+	/** Pipeline keys of the passes that drew the surface. The material and submeshes don't change, so neither do the keys. */
+	mutable std::vector<std::pair<GraphicsPipelineKey, GraphicsPipelineKey>> _PipelineKeys;
+};
+
+/** A level of detail of a submesh that a view draws. */
+struct SurfaceDraw
+{
+	const Surface* surface;
+	const Submesh* submesh;
+	const SubmeshLOD* lod;
+	/** See SurfaceParams. */
+	float lodFade;
+	/** Index of the indirect command of the level's first meshlet if its clusters are culled, relative to the frame's first command. */
+	uint32 firstCommand = 0;
+};
+
+/** What a view draws in a frame. Gathered while the frame graph is built, so the view's clusters can be culled before it's drawn. */
+struct SurfaceDrawList
+{
+	std::vector<SurfaceDraw> draws;
 };
 
 class SurfaceGroup : public Component
@@ -38,10 +129,92 @@ public:
 
 	void AddSurface(const Surface& surface)
 	{
+		_SurfaceIDToIndex[surface.GetSurfaceID()] = _Surfaces.size();
 		_Surfaces.push_back(surface);
+		_AddedSurfaceIDs.push_back(surface.GetSurfaceID());
 	}
 
+	void RemoveSurface(uint32 surfaceID)
+	{
+		const std::size_t index = _SurfaceIDToIndex.at(surfaceID);
+
+		_SurfaceIDToIndex[_Surfaces.back().GetSurfaceID()] = index;
+		_Surfaces[index] = _Surfaces.back();
+
+		_Surfaces.pop_back();
+		_SurfaceIDToIndex.erase(surfaceID);
+	}
+
+	inline Surface& GetSurface(uint32 surfaceID) { return _Surfaces[_SurfaceIDToIndex.at(surfaceID)]; }
+	inline bool HasSurface(uint32 surfaceID) const { return _SurfaceIDToIndex.contains(surfaceID); }
+	inline const std::vector<Surface>& GetSurfaces() const { return _Surfaces; }
+
+	/** Surfaces added since the last call, whose pipelines haven't been warmed up. */
+	inline std::vector<uint32> TakeAddedSurfaces() { return std::exchange(_AddedSurfaceIDs, {}); }
+
+	/**
+	  * Pick the levels of detail a view draws. Surfaces outside the frustum are skipped if frustum culling.
+	  * Draws of a surface are consecutive, so its pipeline is bound once.
+	  */
 	template<bool doFrustumCulling>
+	void GatherDraws(SurfaceDrawList& drawList, const LODView& lodView, const FrustumPlanes* viewFrustumPlanes = nullptr) const
+	{
+		for (const auto& surface : _Surfaces)
+		{
+			if constexpr (doFrustumCulling)
+			{
+				if (Physics::IsBoxInsideFrustum(*viewFrustumPlanes, surface.GetBoundingBox()) == false)
+				{
+					continue;
+				}
+			}
+
+			// Errors are projected at the nearest point of the surface's bounds.
+			const glm::vec3 nearestPoint = glm::clamp(lodView.position, surface.GetBoundingBox().GetMin(), surface.GetBoundingBox().GetMax());
+			const float distance = glm::distance(lodView.position, nearestPoint);
+			const float errorToPixels = surface.GetScale() * lodView.pixelsPerUnit / std::max(distance, std::numeric_limits<float>::min());
+
+			for (const auto& submesh : surface.GetSubmeshes())
+			{
+				const std::vector<SubmeshLOD>& lods = submesh.GetLODs();
+				std::size_t lodIndex = 0;
+
+				while (lodIndex + 1 < lods.size() && lods[lodIndex + 1].error * errorToPixels <= lodView.maxErrorPixels)
+				{
+					lodIndex++;
+				}
+
+				float lodFade = 0.0f;
+
+				// Just past the switch to a coarser level, it's dithered in as the finer level is dithered out.
+				// The fade is the fraction of pixels the coarser level covers, and the finer level covers the rest.
+				if (lodIndex > 0 && lodView.crossFadeRange > 0.0f && lods[lodIndex].error > 0.0f)
+				{
+					const float fade = (lodView.maxErrorPixels / (lods[lodIndex].error * errorToPixels) - 1.0f) / lodView.crossFadeRange;
+
+					if (fade > 0.0f && fade < 1.0f)
+					{
+						drawList.draws.push_back({ &surface, &submesh, &lods[lodIndex - 1], -fade });
+
+						lodView.stats->numTriangles += lods[lodIndex - 1].indexCount / 3;
+						lodView.stats->numCrossFades++;
+
+						lodFade = fade;
+					}
+				}
+
+				drawList.draws.push_back({ &surface, &submesh, &lods[lodIndex], lodFade });
+
+				lodView.stats->numTriangles += lods[lodIndex].indexCount / 3;
+				lodView.stats->numFullDetailTriangles += lods.front().indexCount / 3;
+			}
+		}
+	}
+
+	/**
+	  * Draw a view's draw list. If its clusters were culled, each level is drawn with one indirect command per meshlet,
+	  * and culled meshlets have no instances. Commands of the draws are relative to the first cluster command.
+	  */
 	void Draw(
 		gpu::Device& device, 
 		gpu::CommandBuffer& cmdBuf,
@@ -49,47 +222,102 @@ public:
 		const VkDescriptorSet* descriptorSets,
 		std::size_t numDynamicOffsets,
 		const uint32* dynamicOffsets,
-		std::function<GraphicsPipelineDesc()> getPsoDesc,
-		const FrustumPlanes* viewFrustumPlanes = nullptr)
+		const SurfaceDrawList& drawList,
+		GraphicsPipelineKey passKey,
+		const gpu::Buffer* clusterCommands = nullptr,
+		uint32 firstClusterCommand = 0)
 	{
 		// @todo Everything in a SurfaceGroup has the same pipeline layout. */
 		//cmdBuf.BindDescriptorSets(pipeline, numDescriptorSets, descriptorSets, numDynamicOffsets, dynamicOffsets);
 
-		for (const auto& surface : _Surfaces)
+		const Surface* boundSurface = nullptr;
+		gpu::Pipeline pipeline;
+
+		// Surfaces only add specialization and vertex input to the pass's shaders. Copied, since interning may move the descriptions.
+		const ShaderStages shaderStages = device.GetPipelineDesc(passKey).shaderStages;
+
+		for (const SurfaceDraw& draw : drawList.draws)
 		{
-			if constexpr (doFrustumCulling)
+			const Surface& surface = *draw.surface;
+			const Submesh& submesh = *draw.submesh;
+
+			if (draw.surface != boundSurface)
 			{
-				if (Physics::IsBoxInsideFrustum(*viewFrustumPlanes, surface.GetBoundingBox()) == false)
+				boundSurface = draw.surface;
+
+				// Surfaces whose pipelines are still being created are skipped this frame.
+				pipeline = device.CreatePipelineAsync(surface.GetPipelineKey(device, passKey));
+
+				if (!pipeline.IsValid())
 				{
 					continue;
 				}
+
+				// Only surfaces that are drawn wait on their uploads.
+				device.WaitForUpload(surface.GetMaterial()->GetUploadTicket());
+
+				cmdBuf.BindPipeline(pipeline);
+
+				cmdBuf.BindDescriptorSets(pipeline, numDescriptorSets, descriptorSets, numDynamicOffsets, dynamicOffsets);
+
+				cmdBuf.PushConstants(pipeline, shaderStages.fragment, &surface.GetMaterial()->GetPushConstants());
+			}
+			else if (!pipeline.IsValid())
+			{
+				continue;
 			}
 
-			GraphicsPipelineDesc graphicsDesc = getPsoDesc();
-			graphicsDesc.specInfo = surface.GetMaterialInfo();
+			device.WaitForUpload(submesh.GetUploadTicket());
 
-			gpu::Pipeline pipeline = device.CreatePipeline(graphicsDesc);
-			
-			cmdBuf.BindPipeline(pipeline);
+			const VertexDequantization& dequantization = submesh.GetDequantization();
 
-			cmdBuf.BindDescriptorSets(pipeline, numDescriptorSets, descriptorSets, numDynamicOffsets, dynamicOffsets);
+			SurfaceParams surfaceParams;
+			surfaceParams._UVScale = dequantization.textureCoordinateScale;
+			surfaceParams._UVBias = dequantization.textureCoordinateBias;
+			surfaceParams._PositionScale = dequantization.positionScale;
+			surfaceParams._SurfaceID = surface.GetSurfaceID();
+			surfaceParams._PositionBias = dequantization.positionBias;
+			surfaceParams._LODFade = draw.lodFade;
 
-			cmdBuf.PushConstants(pipeline, graphicsDesc.shaderStages.vertex, &surface.GetSurfaceID());
+			cmdBuf.PushConstants(pipeline, shaderStages.vertex, &surfaceParams);
 
-			cmdBuf.PushConstants(pipeline, graphicsDesc.shaderStages.fragment, &surface.GetMaterial()->GetPushConstants());
+			cmdBuf.BindVertexBuffers(submesh.GetNumVertexBuffers(), submesh.GetVertexBuffers());
 
-			for (const auto& submesh : surface.GetSubmeshes())
+			if (clusterCommands)
 			{
-				cmdBuf.BindVertexBuffers(static_cast<uint32>(submesh.GetVertexBuffers().size()), submesh.GetVertexBuffers().data());
-
-				cmdBuf.DrawIndexed(submesh.GetIndexBuffer(), submesh.GetIndexCount(), 1, 0, 0, 0, submesh.GetIndexType());
+				cmdBuf.DrawIndexedIndirect(
+					submesh.GetIndexBuffer(), submesh.GetIndexType(), *clusterCommands, (firstClusterCommand + draw.firstCommand) * sizeof(DrawIndexedIndirectCommand), draw.lod->numMeshlets
+				);
+			}
+			else
+			{
+				cmdBuf.DrawIndexed(submesh.GetIndexBuffer(), draw.lod->indexCount, 1, draw.lod->firstIndex, 0, 0, submesh.GetIndexType());
 			}
 		}
 	}
 
 	inline const VkDescriptorSet& GetSurfaceSet() const { return _SurfaceSet; }
 
+	inline void SetLocalToWorldBuffer(gpu::Buffer&& localToWorldBuffer) { _LocalToWorldBuffer = std::move(localToWorldBuffer); }
+	inline const gpu::Buffer& GetLocalToWorldBuffer() const { return _LocalToWorldBuffer; }
+
+	/** Set the surface deltas uploaded this frame. They're scattered into the surface buffer before any surfaces are drawn. */
+	inline void SetDeltas(uint32 firstDelta, uint32 numDeltas) { _FirstDelta = firstDelta; _NumDeltas = numDeltas; }
+	inline uint32 GetFirstDelta() const { return _FirstDelta; }
+	inline uint32 GetNumDeltas() const { return _NumDeltas; }
+
 private:
 	VkDescriptorSet _SurfaceSet;
 	std::vector<Surface> _Surfaces;
+
+	/** Transforms of all surfaces, indexed by surface id. */
+	gpu::Buffer _LocalToWorldBuffer;
+
+	/** Maps a surface id to its index in _Surfaces. */
+	std::unordered_map<uint32, std::size_t> _SurfaceIDToIndex;
+
+	std::vector<uint32> _AddedSurfaceIDs;
+
+	uint32 _FirstDelta = 0;
+	uint32 _NumDeltas = 0;
 };
\ No newline at end of file
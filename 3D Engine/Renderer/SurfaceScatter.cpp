@@ -0,0 +1,64 @@
+#include "SceneRenderer.h"
+#include <ECS/EntityManager.h>
+#include <Renderer/Surface.h>
+#include <Systems/SurfaceSystem.h>
+
+BEGIN_PUSH_CONSTANTS(SurfaceScatterParams)
+	MEMBER(uint32, _FirstDelta)
+	MEMBER(uint32, _NumDeltas)
+END_PUSH_CONSTANTS(SurfaceScatterParams)
+
+class SurfaceScatterCS : public gpu::Shader
+{
+public:
+	SurfaceScatterCS() = default;
+};
+
+REGISTER_SHADER(SurfaceScatterCS, "../Shaders/SurfaceScatterCS.glsl", "main", EShaderStage::Compute);
+
+void SceneRenderer::ScatterSurfaceDeltas(FrameGraph& graph)
+{
+	for (auto entity : _ECS.GetEntities<SurfaceGroup>())
+	{
+		const auto& surfaceGroup = _ECS.GetComponent<SurfaceGroup>(entity);
+
+		if (surfaceGroup.GetNumDeltas() == 0)
+		{
+			continue;
+		}
+
+		graph.AddPass("SurfaceScatter", EPassType::Compute, [&] (FrameGraph::PassBuilder& builder)
+		{
+			builder.Write(surfaceGroup.GetLocalToWorldBuffer(), EResourceUsage::StorageWrite);
+		},
+		[this, &surfaceGroup] (gpu::CommandBuffer& cmdBuf)
+		{
+			const gpu::Shader* shader = _Device.FindShader<SurfaceScatterCS>();
+
+			ComputePipelineDesc computeDesc;
+			computeDesc.shader = shader;
+
+			gpu::Pipeline pipeline = _Device.CreatePipeline(computeDesc);
+
+			cmdBuf.BindPipeline(pipeline);
+
+			cmdBuf.BindDescriptorSets(pipeline, 1, &SurfaceScatterDescriptors::_DescriptorSet, 0, nullptr);
+
+			SurfaceScatterParams surfaceScatterParams;
+			surfaceScatterParams._FirstDelta = surfaceGroup.GetFirstDelta();
+			surfaceScatterParams._NumDeltas = surfaceGroup.GetNumDeltas();
+
+			cmdBuf.PushConstants(pipeline, shader, &surfaceScatterParams);
+
+			cmdBuf.Dispatch(DivideAndRoundUp(surfaceGroup.GetNumDeltas(), 64u), 1, 1);
+		});
+	}
+}
+
+void SceneRenderer::ReadSurfaces(FrameGraph::PassBuilder& builder)
+{
+	for (auto entity : _ECS.GetEntities<SurfaceGroup>())
+	{
+		builder.Read(_ECS.GetComponent<SurfaceGroup>(entity).GetLocalToWorldBuffer(), EResourceUsage::StorageRead);
+	}
+}
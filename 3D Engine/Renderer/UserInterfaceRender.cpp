@@ -55,65 +55,74 @@ void SceneRenderer::CreateUserInterfacePipeline()
 	userInterfaceRender.pipeline = _Device.CreatePipeline(graphicsDesc);
 }
 
-void SceneRenderer::RenderUserInterface(gpu::CommandBuffer& cmdBuf, const gpu::RenderPass& renderPass)
+void SceneRenderer::RenderUserInterface(const gpu::Image& displayImage, const gpu::RenderPass& renderPass, FrameGraph& graph)
 {
-	auto& userInterfaceRender = _ECS.GetSingletonComponent<UserInterfaceRender>();
+	graph.AddPass("UserInterface", EPassType::Graphics, [&] (FrameGraph::PassBuilder& builder)
+	{
+		builder.Write(displayImage, EResourceUsage::ColorAttachment);
+	},
+	[this, &renderPass] (gpu::CommandBuffer& cmdBuf)
+	{
+		auto& userInterfaceRender = _ECS.GetSingletonComponent<UserInterfaceRender>();
 
-	cmdBuf.BeginRenderPass(renderPass);
+		cmdBuf.BeginRenderPass(renderPass);
 
-	cmdBuf.SetViewport({ .width = renderPass.GetRenderArea().extent.width, .height = renderPass.GetRenderArea().extent.height });
+		cmdBuf.SetViewport({ .width = renderPass.GetRenderArea().extent.width, .height = renderPass.GetRenderArea().extent.height });
 
-	const ImDrawData* drawData = ImGui::GetDrawData();
-	const auto* vertex = _Device.FindShader<UserInterfaceVS>();
-	const auto* fragment = _Device.FindShader<UserInterfaceFS>();
+		const ImDrawData* drawData = ImGui::GetDrawData();
+		const auto* vertex = _Device.FindShader<UserInterfaceVS>();
+		const auto* fragment = _Device.FindShader<UserInterfaceFS>();
 	
-	if (drawData->CmdListsCount > 0)
-	{
-		cmdBuf.BindPipeline(userInterfaceRender.pipeline);
+		if (drawData->CmdListsCount > 0 && userInterfaceRender.vertices.buffer)
+		{
+			_Device.WaitForUpload(userInterfaceRender.fontUploadTicket);
 
-		cmdBuf.PushConstants(userInterfaceRender.pipeline, vertex, &userInterfaceRender.scaleAndTranslation);
+			cmdBuf.BindPipeline(userInterfaceRender.pipeline);
 
-		const VkDescriptorSet descriptorSets[] = { _Device.GetTextures() };
+			cmdBuf.PushConstants(userInterfaceRender.pipeline, vertex, &userInterfaceRender.scaleAndTranslation);
 
-		cmdBuf.BindDescriptorSets(userInterfaceRender.pipeline, std::size(descriptorSets), descriptorSets, 0, nullptr);
+			const VkDescriptorSet descriptorSets[] = { _Device.GetTextures() };
 
-		cmdBuf.BindVertexBuffers(1, &userInterfaceRender.vertexBuffer);
+			cmdBuf.BindDescriptorSets(userInterfaceRender.pipeline, std::size(descriptorSets), descriptorSets, 0, nullptr);
 
-		const ImVec2 clipOff = drawData->DisplayPos;         // (0,0) unless using multi-viewports
-		const ImVec2 clipScale = drawData->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
+			cmdBuf.BindVertexBuffers(1, userInterfaceRender.vertices.buffer, &userInterfaceRender.vertices.offset);
 
-		int32 vertexOffset = 0;
-		int32 indexOffset = 0;
+			const ImVec2 clipOff = drawData->DisplayPos;         // (0,0) unless using multi-viewports
+			const ImVec2 clipScale = drawData->FramebufferScale; // (1,1) unless using retina display which are often (2,2)
 
-		for (int32 cmdListIndex = 0; cmdListIndex < drawData->CmdListsCount; cmdListIndex++)
-		{
-			const ImDrawList* drawList = drawData->CmdLists[cmdListIndex];
+			int32 vertexOffset = 0;
+			int32 indexOffset = 0;
 
-			for (int32 drawCmdIndex = 0; drawCmdIndex < drawList->CmdBuffer.Size; drawCmdIndex++)
+			for (int32 cmdListIndex = 0; cmdListIndex < drawData->CmdListsCount; cmdListIndex++)
 			{
-				const ImDrawCmd* drawCmd = &drawList->CmdBuffer[drawCmdIndex];
+				const ImDrawList* drawList = drawData->CmdLists[cmdListIndex];
 
-				ImVec4 clipRect;
-				clipRect.x = std::max((drawCmd->ClipRect.x - clipOff.x) * clipScale.x, 0.0f);
-				clipRect.y = std::max((drawCmd->ClipRect.y - clipOff.y) * clipScale.y, 0.0f);
-				clipRect.z = (drawCmd->ClipRect.z - clipOff.x) * clipScale.x;
-				clipRect.w = (drawCmd->ClipRect.w - clipOff.y) * clipScale.y;
+				for (int32 drawCmdIndex = 0; drawCmdIndex < drawList->CmdBuffer.Size; drawCmdIndex++)
+				{
+					const ImDrawCmd* drawCmd = &drawList->CmdBuffer[drawCmdIndex];
 
-				cmdBuf.SetScissor({
-					.offset = { static_cast<int32_t>(clipRect.x), static_cast<int32_t>(clipRect.y)},
-					.extent = { static_cast<uint32_t>(clipRect.z - clipRect.x), static_cast<uint32_t>(clipRect.w - clipRect.y) }
-					});
+					ImVec4 clipRect;
+					clipRect.x = std::max((drawCmd->ClipRect.x - clipOff.x) * clipScale.x, 0.0f);
+					clipRect.y = std::max((drawCmd->ClipRect.y - clipOff.y) * clipScale.y, 0.0f);
+					clipRect.z = (drawCmd->ClipRect.z - clipOff.x) * clipScale.x;
+					clipRect.w = (drawCmd->ClipRect.w - clipOff.y) * clipScale.y;
 
-				const uint32 pushConstants(*static_cast<uint32*>(drawCmd->TextureId));
-				cmdBuf.PushConstants(userInterfaceRender.pipeline, fragment, &pushConstants);
+					cmdBuf.SetScissor({
+						.offset = { static_cast<int32_t>(clipRect.x), static_cast<int32_t>(clipRect.y)},
+						.extent = { static_cast<uint32_t>(clipRect.z - clipRect.x), static_cast<uint32_t>(clipRect.w - clipRect.y) }
+						});
 
-				cmdBuf.DrawIndexed(userInterfaceRender.indexBuffer, drawCmd->ElemCount, 1, drawCmd->IdxOffset + indexOffset, drawCmd->VtxOffset + vertexOffset, 0, EIndexType::UINT16);
-			}
+					const uint32 pushConstants(*static_cast<uint32*>(drawCmd->TextureId));
+					cmdBuf.PushConstants(userInterfaceRender.pipeline, fragment, &pushConstants);
+
+					cmdBuf.DrawIndexed(*userInterfaceRender.indices.buffer, drawCmd->ElemCount, 1, drawCmd->IdxOffset + indexOffset, drawCmd->VtxOffset + vertexOffset, 0, EIndexType::UINT16, userInterfaceRender.indices.offset);
+				}
 
-			indexOffset += drawList->IdxBuffer.Size;
-			vertexOffset += drawList->VtxBuffer.Size;
+				indexOffset += drawList->IdxBuffer.Size;
+				vertexOffset += drawList->VtxBuffer.Size;
+			}
 		}
-	}
 
-	cmdBuf.EndRenderPass();
+		cmdBuf.EndRenderPass();
+	});
 }
\ No newline at end of file
@@ -33,14 +33,6 @@ void CameraSystem::Update(Engine& engine)
 	auto& ecs = engine._ECS;
 	auto& device = engine._Device;
 
-	auto entities = ecs.GetEntities<Camera>();
-
-	_CameraUniform = device.CreateBuffer(EBufferUsage::Uniform, EMemoryUsage::CPU_TO_GPU, entities.size() * sizeof(CameraUniform));
-
-	auto cameraUniformData = static_cast<CameraUniform*>(_CameraUniform.GetData());
-
-	int i = 0;
-
 	for (auto entity : ecs.GetEntities<Camera>())
 	{
 		auto& camera = ecs.GetComponent<Camera>(entity);
@@ -69,24 +61,8 @@ void CameraSystem::Update(Engine& engine)
 			0.0f,
 		};
 
-		cameraUniformData[i] = cameraUniform;
-
-		cameraRender.SetDynamicOffset(i * sizeof(CameraUniform));
-
-		const gpu::Sampler sampler = device.CreateSampler({ EFilter::Nearest });
-
-		CameraDescriptors descriptors;
-		descriptors._CameraUniform = { _CameraUniform };
-		descriptors._SceneDepth = { cameraRender._SceneDepth, sampler };
-		descriptors._GBuffer0 = { cameraRender._GBuffer0, sampler };
-		descriptors._GBuffer1 = { cameraRender._GBuffer1, sampler };
-		descriptors._SceneColor = cameraRender._SceneColor;
-		descriptors._SSRHistory = cameraRender._SSRHistory;
-		descriptors._SSGIHistory = cameraRender._SSGIHistory;
-		descriptors._DirectLighting = cameraRender._DirectLighting;
-
-		device.UpdateDescriptorSet(descriptors);
+		const gpu::UploadAllocation allocation = device.AllocateUpload(sizeof(cameraUniform), &cameraUniform);
 
-		i++;
+		cameraRender.SetDynamicOffset(static_cast<uint32>(allocation.offset));
 	}
 }
\ No newline at end of file
@@ -37,6 +37,4 @@ public:
 
 private:
 	std::shared_ptr<ScreenResizeEvent> _ScreenResizeEvent;
-
-	gpu::Buffer _CameraUniform;
 };
\ No newline at end of file
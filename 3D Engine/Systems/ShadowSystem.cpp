@@ -17,6 +17,12 @@ void ShadowSystem::Start(Engine& engine)
 	{
 		ecs.AddComponent(entity, ShadowRender(device, directionalLight));
 	});
+
+	// Shadow uniforms are written to the upload ring and selected with a dynamic offset.
+	ShadowDescriptors descriptors;
+	descriptors._ShadowUniform = { device.GetUploadBuffer(), 0, sizeof(ShadowUniform) };
+
+	device.UpdateDescriptorSet(descriptors);
 }
 
 void ShadowSystem::Update(Engine& engine)
@@ -24,30 +30,18 @@ void ShadowSystem::Update(Engine& engine)
 	auto& ecs = engine._ECS;
 	auto& device = engine._Device;
 
-	auto entities = ecs.GetEntities<ShadowRender>();
-
-	_ShadowUniform = device.CreateBuffer(EBufferUsage::Uniform, EMemoryUsage::CPU_TO_GPU, entities.size() * sizeof(ShadowUniform));
-
-	ShadowDescriptors descriptors;
-	descriptors._ShadowUniform = _ShadowUniform;
-
-	device.UpdateDescriptorSet(descriptors);
-
-	auto shadowUniformData = static_cast<ShadowUniform*>(_ShadowUniform.GetData());
-
-	int i = 0;
-
-	for (auto entity : entities)
+	for (auto entity : ecs.GetEntities<ShadowRender>())
 	{
 		const auto& directionalLight = ecs.GetComponent<DirectionalLight>(entity);
 		const auto& transform = ecs.GetComponent<Transform>(entity);
 		auto& shadowRender = ecs.GetComponent<ShadowRender>(entity);
 
-		shadowRender.Update(device, directionalLight, transform, i * sizeof(ShadowUniform));
+		const gpu::UploadAllocation allocation = device.AllocateUpload(sizeof(ShadowUniform));
 
-		shadowUniformData[i].lightViewProj = shadowRender.GetLightViewProjMatrix();
-		shadowUniformData[i].invLightViewProj = shadowRender.GetLightViewProjMatrixInv();
+		shadowRender.Update(device, directionalLight, transform, static_cast<uint32>(allocation.offset));
 
-		i++;
+		auto shadowUniformData = static_cast<ShadowUniform*>(allocation.data);
+		shadowUniformData->lightViewProj = shadowRender.GetLightViewProjMatrix();
+		shadowUniformData->invLightViewProj = shadowRender.GetLightViewProjMatrixInv();
 	}
 }
\ No newline at end of file
@@ -16,7 +16,4 @@ class ShadowSystem : public ISystem
 public:
 	void Start(Engine& engine) override;
 	void Update(Engine& engine) override;
-
-private:
-	gpu::Buffer _ShadowUniform;
 };
\ No newline at end of file
@@ -5,49 +5,135 @@
 #include <Renderer/Surface.h>
 
 DECLARE_UNIFORM_BUFFER(LocalToWorldUniform)
+DECLARE_UNIFORM_BUFFER(SurfaceDelta)
+DECLARE_UNIFORM_BLOCK(SurfaceParams)
 
 DECLARE_DESCRIPTOR_SET(StaticMeshDescriptors)
+DECLARE_DESCRIPTOR_SET(SurfaceScatterDescriptors)
 
 void SurfaceSystem::Start(Engine& engine)
 {
+	auto& ecs = engine._ECS;
 	auto& device = engine._Device;
+
+	_SurfaceGroupEntity = ecs.CreateEntity("SurfaceGroup");
+	auto& surfaceGroup = ecs.AddComponent(_SurfaceGroupEntity, SurfaceGroup(StaticMeshDescriptors::_DescriptorSet));
+
+	ResizeLocalToWorldBuffer(device, surfaceGroup, Platform::GetInt("Engine.ini", "Renderer", "SurfaceCapacity", 1024));
+
+	ecs.OnComponentCreated<StaticMeshComponent>([&] (Entity& entity, StaticMeshComponent& staticMeshComponent)
+	{
+		uint32 surfaceID;
+
+		if (!_FreeSurfaceIDs.empty())
+		{
+			surfaceID = _FreeSurfaceIDs.back();
+			_FreeSurfaceIDs.pop_back();
+		}
+		else
+		{
+			surfaceID = _NumSurfaceIDs++;
+		}
+
+		// The bounding box is set when the transform is uploaded.
+		auto& surfaceGroup = ecs.GetComponent<SurfaceGroup>(_SurfaceGroupEntity);
+		surfaceGroup.AddSurface(Surface(surfaceID, staticMeshComponent._Material, staticMeshComponent._StaticMesh->_Submeshes, BoundingBox()));
+
+		_Instances[entity.GetEntityID()] = SurfaceInstance{ entity, surfaceID, invalidTransformVersion };
+	});
+
+	ecs.OnComponentDestroyed<StaticMeshComponent>([&] (Entity& entity, StaticMeshComponent& staticMeshComponent)
+	{
+		if (auto iter = _Instances.find(entity.GetEntityID()); iter != _Instances.end())
+		{
+			auto& surfaceGroup = ecs.GetComponent<SurfaceGroup>(_SurfaceGroupEntity);
+			surfaceGroup.RemoveSurface(iter->second.surfaceID);
+
+			_FreeSurfaceIDs.push_back(iter->second.surfaceID);
+			_Instances.erase(iter);
+		}
+	});
 }
 
 void SurfaceSystem::Update(Engine& engine)
 {
 	auto& ecs = engine._ECS;
 	auto& device = engine._Device;
+	auto& surfaceGroup = ecs.GetComponent<SurfaceGroup>(_SurfaceGroupEntity);
+
+	surfaceGroup.SetDeltas(0, 0);
 
-	for (auto entity : ecs.GetEntities<SurfaceGroup>())
+	const uint32 capacity = static_cast<uint32>(surfaceGroup.GetLocalToWorldBuffer().GetSize() / sizeof(LocalToWorldUniform));
+
+	if (_NumSurfaceIDs > capacity)
 	{
-		ecs.Destroy(entity);
+		ResizeLocalToWorldBuffer(device, surfaceGroup, std::max(_NumSurfaceIDs, capacity * 2));
 	}
 
-	auto entities = ecs.GetEntities<StaticMeshComponent>();
+	_DirtyInstances.clear();
 
-	_SurfaceBuffer = device.CreateBuffer(EBufferUsage::Storage, EMemoryUsage::CPU_TO_GPU, entities.size() * sizeof(LocalToWorldUniform));
-	
-	StaticMeshDescriptors descriptors;
-	descriptors._LocalToWorldBuffer = _SurfaceBuffer;
+	for (auto& [entityID, instance] : _Instances)
+	{
+		const auto& transform = ecs.GetComponent<Transform>(instance.entity);
 
-	device.UpdateDescriptorSet(descriptors);
+		if (transform.GetVersion() != instance.transformVersion)
+		{
+			_DirtyInstances.push_back(&instance);
+		}
+	}
 
-	auto surfaceGroupEntity = ecs.CreateEntity();
-	auto& surfaceGroup = ecs.AddComponent(surfaceGroupEntity, SurfaceGroup(StaticMeshDescriptors::_DescriptorSet));
+	if (_DirtyInstances.empty())
+	{
+		return;
+	}
 
-	uint32 surfaceIdx = 0;
+	// Align to the element size so the deltas can be indexed as an array in the scatter shader.
+	const gpu::UploadAllocation allocation = device.AllocateUpload(_DirtyInstances.size() * sizeof(SurfaceDelta), nullptr, sizeof(SurfaceDelta));
+	auto* surfaceDeltas = static_cast<SurfaceDelta*>(allocation.data);
 
-	for (auto& entity : entities)
+	for (auto instance : _DirtyInstances)
 	{
-		const auto& staticMeshComponent = ecs.GetComponent<StaticMeshComponent>(entity);
-		const auto& transform = ecs.GetComponent<Transform>(entity);
-		const BoundingBox boundingBox = staticMeshComponent._StaticMesh->GetBounds().Transform(transform.GetLocalToWorld());
+		const auto& staticMeshComponent = ecs.GetComponent<StaticMeshComponent>(instance->entity);
+		const auto& transform = ecs.GetComponent<Transform>(instance->entity);
+
+		// The inverse and inverse transpose are computed in the scatter shader.
+		surfaceDeltas->transform = transform.GetLocalToWorld();
+		surfaceDeltas->surfaceID = instance->surfaceID;
+		surfaceDeltas++;
+
+		const glm::mat4& localToWorld = transform.GetLocalToWorld();
+		Surface& surface = surfaceGroup.GetSurface(instance->surfaceID);
+
+		surface.SetBoundingBox(staticMeshComponent._StaticMesh->GetBounds().Transform(localToWorld));
+		surface.SetScale(std::max({ glm::length(glm::vec3(localToWorld[0])), glm::length(glm::vec3(localToWorld[1])), glm::length(glm::vec3(localToWorld[2])) }));
+
+		instance->transformVersion = transform.GetVersion();
+	}
+
+	surfaceGroup.SetDeltas(static_cast<uint32>(allocation.offset / sizeof(SurfaceDelta)), static_cast<uint32>(_DirtyInstances.size()));
+}
 
-		auto* localToWorldUniformBuffer = reinterpret_cast<LocalToWorldUniform*>(_SurfaceBuffer.GetData()) + surfaceIdx;
-		localToWorldUniformBuffer->transform = transform.GetLocalToWorld();
-		localToWorldUniformBuffer->inverse = glm::inverse(transform.GetLocalToWorld());
-		localToWorldUniformBuffer->inverseTranspose = glm::transpose(localToWorldUniformBuffer->inverse);
+void SurfaceSystem::ResizeLocalToWorldBuffer(gpu::Device& device, SurfaceGroup& surfaceGroup, uint32 numSurfaces)
+{
+	// The surface sets can't be updated while a frame in flight is using them.
+	device.WaitIdle();
+
+	surfaceGroup.SetLocalToWorldBuffer(device.CreateBuffer(EBufferUsage::Storage, EMemoryUsage::GPU_ONLY, numSurfaces * sizeof(LocalToWorldUniform)));
+
+	StaticMeshDescriptors staticMeshDescriptors;
+	staticMeshDescriptors._LocalToWorldBuffer = surfaceGroup.GetLocalToWorldBuffer();
+
+	device.UpdateDescriptorSet(staticMeshDescriptors);
 
-		surfaceGroup.AddSurface(Surface(surfaceIdx++, staticMeshComponent._Material, staticMeshComponent._StaticMesh->_Submeshes, boundingBox));
+	SurfaceScatterDescriptors surfaceScatterDescriptors;
+	surfaceScatterDescriptors._LocalToWorldBuffer = surfaceGroup.GetLocalToWorldBuffer();
+	surfaceScatterDescriptors._SurfaceDeltaBuffer = device.GetUploadBuffer();
+
+	device.UpdateDescriptorSet(surfaceScatterDescriptors);
+
+	// The new buffer is empty, so every surface has to be uploaded again.
+	for (auto& [entityID, instance] : _Instances)
+	{
+		instance.transformVersion = invalidTransformVersion;
 	}
-}
\ No newline at end of file
+}
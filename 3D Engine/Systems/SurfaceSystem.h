@@ -1,5 +1,6 @@
 #pragma once
 #include <ECS/System.h>
+#include <ECS/Entity.h>
 #include <GPU/GPU.h>
 
 BEGIN_UNIFORM_BUFFER(LocalToWorldUniform)
@@ -8,10 +9,41 @@ BEGIN_UNIFORM_BUFFER(LocalToWorldUniform)
 	MEMBER(glm::mat4, inverseTranspose)
 END_UNIFORM_BUFFER(LocalToWorldUniform)
 
+/** 
+  * Vertex push constants of static meshes. Surfaces push them per submesh to dequantize its vertices.
+  * The LOD fade is the fraction of pixels a level covers while cross-fading: positive for the coarser level, and negative for the finer.
+  */
+BEGIN_UNIFORM_BLOCK(SurfaceParams)
+	MEMBER(glm::vec2, _UVScale)
+	MEMBER(glm::vec2, _UVBias)
+	MEMBER(glm::vec3, _PositionScale)
+	MEMBER(uint32, _SurfaceID)
+	MEMBER(glm::vec3, _PositionBias)
+	MEMBER(float, _LODFade)
+END_UNIFORM_BLOCK(SurfaceParams)
+
+/** A dirty transform, scattered into the surface buffer on the GPU. */
+BEGIN_UNIFORM_BUFFER(SurfaceDelta)
+	MEMBER(glm::mat4, transform)
+	MEMBER(uint32, surfaceID)
+	MEMBER(uint32, _pad0)
+	MEMBER(uint32, _pad1)
+	MEMBER(uint32, _pad2)
+END_UNIFORM_BUFFER(SurfaceDelta)
+
 BEGIN_DESCRIPTOR_SET(StaticMeshDescriptors)
 	DESCRIPTOR(gpu::StorageBuffer, _LocalToWorldBuffer)
 END_DESCRIPTOR_SET(StaticMeshDescriptors)
 
+BEGIN_DESCRIPTOR_SET(SurfaceScatterDescriptors)
+	DESCRIPTOR(gpu::StorageBuffer, _LocalToWorldBuffer)
+	DESCRIPTOR(gpu::StorageBuffer, _SurfaceDeltaBuffer)
+END_DESCRIPTOR_SET(SurfaceScatterDescriptors)
+
+/** 
+  * Maintains a persistent GPU scene. Each static mesh gets a stable surface id when it's created, 
+  * and only transforms that changed since the last upload are sent to the GPU.
+  */
 class SurfaceSystem : public ISystem
 {
 public:
@@ -19,5 +51,30 @@ public:
 	void Update(Engine& engine) override;
 
 private:
-	gpu::Buffer _SurfaceBuffer;
-};
\ No newline at end of file
+	/** Version of an instance whose transform hasn't been uploaded. */
+	static constexpr uint64 invalidTransformVersion = std::numeric_limits<uint64>::max();
+
+	struct SurfaceInstance
+	{
+		Entity entity;
+		uint32 surfaceID;
+		uint64 transformVersion;
+	};
+
+	/** The entity holding the SurfaceGroup. */
+	Entity _SurfaceGroupEntity;
+
+	/** Maps an entity id to its surface instance. */
+	std::unordered_map<std::size_t, SurfaceInstance> _Instances;
+
+	/** Surface ids released by destroyed static meshes. */
+	std::vector<uint32> _FreeSurfaceIDs;
+
+	/** Number of surface ids handed out. */
+	uint32 _NumSurfaceIDs = 0;
+
+	/** Instances with dirty transforms. Kept around to avoid reallocating every frame. */
+	std::vector<SurfaceInstance*> _DirtyInstances;
+
+	void ResizeLocalToWorldBuffer(gpu::Device& device, class SurfaceGroup& surfaceGroup, uint32 numSurfaces);
+};
@@ -0,0 +1,48 @@
+#include "TextureStreamingSystem.h"
+#include <Engine/Engine.h>
+#include <Renderer/Surface.h>
+
+void TextureStreamingSystem::Update(Engine& engine)
+{
+	auto& ecs = engine._ECS;
+	TextureStreamer& textureStreamer = engine._Assets.GetTextureStreamer();
+
+	for (auto cameraEntity : ecs.GetEntities<Camera>())
+	{
+		const auto& camera = ecs.GetComponent<Camera>(cameraEntity);
+		const FrustumPlanes viewFrustumPlanes = camera.GetFrustumPlanes();
+
+		// Height in pixels of something one unit tall, one unit away from the camera.
+		const float pixelsPerUnit = camera.GetHeight() / (2.0f * std::tan(glm::radians(camera.GetFieldOfView()) * 0.5f));
+
+		for (auto entity : ecs.GetEntities<SurfaceGroup>())
+		{
+			const auto& surfaceGroup = ecs.GetComponent<SurfaceGroup>(entity);
+
+			for (const auto& surface : surfaceGroup.GetSurfaces())
+			{
+				const BoundingBox& boundingBox = surface.GetBoundingBox();
+
+				if (Physics::IsBoxInsideFrustum(viewFrustumPlanes, boundingBox) == false)
+				{
+					continue;
+				}
+
+				// Project the bounding sphere, assuming textures are mapped once across a surface.
+				const float radius = glm::length(boundingBox.GetMax() - boundingBox.GetMin()) * 0.5f;
+				const float distance = std::max(glm::distance(camera.GetPosition(), boundingBox.GetCenter()) - radius, camera.GetNearPlane());
+				const float screenSize = 2.0f * radius * pixelsPerUnit / distance;
+
+				for (StreamedTexture* texture : surface.GetMaterial()->GetTextures())
+				{
+					if (texture)
+					{
+						textureStreamer.RequestScreenSize(*texture, screenSize);
+					}
+				}
+			}
+		}
+	}
+
+	textureStreamer.Update();
+}
@@ -0,0 +1,9 @@
+#pragma once
+#include <ECS/System.h>
+
+/** Requests the mips of streamed textures from the size of visible surfaces on screen, then updates the texture streamer. */
+class TextureStreamingSystem : public ISystem
+{
+public:
+	void Update(Engine& engine) override;
+};
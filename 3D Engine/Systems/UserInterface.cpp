@@ -2,6 +2,7 @@
 #include <imgui/imgui.h>
 #include <imgui/examples/imgui_impl_glfw.h>
 #include <Engine/Engine.h>
+#include <Engine/JobSystem.h>
 #include <Engine/Screen.h>
 #include <Engine/Input.h>
 #include <Components/RenderSettings.h>
@@ -11,6 +12,7 @@
 #include <Components/SkyboxComponent.h>
 #include <Systems/SceneSystem.h>
 #include <Renderer/ShadowRender.h>
+#include <Renderer/CameraRender.h>
 
 #define SHOW_COMPONENT(type, ecs, entity, callback)					\
 	if (ecs.HasComponent<type>(entity) && ImGui::TreeNode(#type))	\
@@ -112,6 +114,155 @@ void UserInterface::ShowRenderSettings(Engine& engine)
 		ImGui::TreePop();
 	}
 
+	if (ImGui::TreeNode("Level of Detail"))
+	{
+		ImGui::DragFloat("Max Error (Pixels)", &settings._LODErrorPixels, 0.05f, 0.0f, 64.0f);
+		ImGui::DragFloat("Max Shadow Error (Pixels)", &settings._ShadowLODErrorPixels, 0.05f, 0.0f, 64.0f);
+
+		if (settings._LODCrossFade)
+		{
+			ImGui::DragFloat("Cross-Fade Range", &settings._LODCrossFadeRange, 0.01f, 0.0f, 1.0f);
+		}
+
+		auto showLODStats = [] (const char* view, const LODStats& stats)
+		{
+			const double savedPercent = stats.numFullDetailTriangles > 0 ?
+				100.0 * (1.0 - static_cast<double>(stats.numTriangles) / stats.numFullDetailTriangles) : 0.0;
+
+			ImGui::Text("%s: %llu of %llu triangles, %.1f%% saved", view, stats.numTriangles, stats.numFullDetailTriangles, savedPercent);
+			ImGui::Text("  Cross-fades: %u", stats.numCrossFades);
+		};
+
+		showLODStats("GBuffer", settings._GBufferLODStats);
+		showLODStats("Shadows", settings._ShadowLODStats);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Cluster Culling"))
+	{
+		ImGui::Checkbox("Cluster Culling", &settings._ClusterCulling);
+
+		if (settings._ClusterCulling)
+		{
+			ImGui::Checkbox("Occlusion Culling", &settings._OcclusionCulling);
+		}
+
+		ImGui::Text("GBuffer: %u meshlets in %u draws", settings._GBufferClusterStats.numCandidates, settings._GBufferClusterStats.numDraws);
+		ImGui::Text("Shadows: %u meshlets in %u draws", settings._ShadowClusterStats.numCandidates, settings._ShadowClusterStats.numDraws);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Frame Graph"))
+	{
+		if (ImGui::Button("Dump Frame Graph"))
+		{
+			settings._DumpFrameGraph = true;
+		}
+
+		float totalMilliseconds = 0.0f;
+
+		for (const auto& [name, milliseconds] : settings._PassTimings)
+		{
+			ImGui::Text("%s: %.3f ms", name.c_str(), milliseconds);
+			totalMilliseconds += milliseconds;
+		}
+
+		ImGui::Text("Total: %.3f ms", totalMilliseconds);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Render Target Memory"))
+	{
+		for (auto entity : ecs.GetEntities<CameraRender>())
+		{
+			const CameraRender::MemoryStats& stats = ecs.GetComponent<CameraRender>(entity).GetMemoryStats();
+
+			ImGui::Text("Camera %zu", entity.GetEntityID());
+			ImGui::Text("  Persistent: %.1f MB", stats.persistentBytes / 1048576.0);
+			ImGui::Text("  Transient: %.1f MB in %.1f MB", stats.transientBytes / 1048576.0, stats.transientMemoryBytes / 1048576.0);
+			ImGui::Text("  Transient: %u bytes/pixel", stats.transientBytesPerPixel);
+			ImGui::Text("  Total: %.1f MB", (stats.persistentBytes + stats.transientMemoryBytes) / 1048576.0);
+		}
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Texture Streaming"))
+	{
+		const TextureStreamer::Stats& stats = engine._Assets.GetTextureStreamer().GetStats();
+
+		ImGui::Text("Resident: %.1f MB of %.1f MB", stats.residentBytes / 1048576.0, stats.budgetBytes / 1048576.0);
+		ImGui::Text("Uploading: %.1f MB in %u uploads", stats.pendingBytes / 1048576.0, stats.numPendingUploads);
+		ImGui::Text("Streamed in: %u of %u textures", stats.numStreamedIn, stats.numTextures);
+		ImGui::Text("Uploads: %llu (%.1f MB)", stats.numUploads, stats.uploadedBytes / 1048576.0);
+		ImGui::Text("Evictions: %llu", stats.numEvictions);
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Job System"))
+	{
+		JobSystem& jobSystem = engine._JobSystem;
+		const std::vector<JobSystem::WorkerStats> stats = jobSystem.GetStats();
+
+		for (uint32 workerIndex = 0; workerIndex < stats.size(); workerIndex++)
+		{
+			ImGui::Text("Worker %u: %.1f%%, %llu jobs, %llu steals",
+				workerIndex, stats[workerIndex].utilization * 100.0f, stats[workerIndex].numJobs, stats[workerIndex].numSteals);
+		}
+
+		if (ImGui::Button("Reset"))
+		{
+			jobSystem.ResetStats();
+		}
+
+		ImGui::SameLine();
+
+		if (ImGui::Button("Measure Overhead"))
+		{
+			_JobOverheadNs = jobSystem.MeasureOverhead(100000);
+		}
+
+		if (_JobOverheadNs > 0.0f)
+		{
+			ImGui::Text("Overhead: %.1f ns/job", _JobOverheadNs);
+		}
+
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Pipelines"))
+	{
+		if (ImGui::Button("Measure Keys"))
+		{
+			_PipelineKeyBenchmark = engine._Device.MeasurePipelineKeys(100000);
+		}
+
+		if (_PipelineKeyBenchmark.hash64GBps > 0.0f)
+		{
+			ImGui::Text("Lookup by description: %.1f ns", _PipelineKeyBenchmark.descLookupNs);
+			ImGui::Text("Lookup by key: %.1f ns", _PipelineKeyBenchmark.keyLookupNs);
+			ImGui::Text("Hash64: %.2f GB/s, crc32_u8: %.2f GB/s", _PipelineKeyBenchmark.hash64GBps, _PipelineKeyBenchmark.crc32u8GBps);
+		}
+
+		ImGui::TreePop();
+	}
+
+	if (ImGui::TreeNode("Caches"))
+	{
+		for (const ResourceCacheStats& stats : engine._Device.GetResourceCacheStats())
+		{
+			if (stats.capacity > 0)
+			{
+				ImGui::Text("%s: %zu/%zu, %llu hits, %llu misses, %llu evicted", stats.name, stats.size, stats.capacity, stats.numHits, stats.numMisses, stats.numEvictions);
+			}
+			else
+			{
+				ImGui::Text("%s: %zu, %llu hits, %llu misses", stats.name, stats.size, stats.numHits, stats.numMisses);
+			}
+		}
+
+		ImGui::TreePop();
+	}
+
 	ImGui::End();
 }
 
@@ -317,7 +468,7 @@ UserInterfaceRender::UserInterfaceRender(gpu::Device& device)
 
 	fontImage = device.CreateImage(width, height, 1, EFormat::R8G8B8A8_UNORM, EImageUsage::Sampled | EImageUsage::TransferDst);
 	
-	gpu::UploadImageData(device, pixels, fontImage);
+	fontUploadTicket = device.UploadImageData(fontImage, pixels);
 
 	fontTexture = fontImage.GetTextureID(device.CreateSampler({}));
 
@@ -332,13 +483,15 @@ void UserInterfaceRender::Update(gpu::Device& device)
 
 	if ((vertexBufferSize == 0) || (indexBufferSize == 0))
 	{
+		vertices = {};
+		indices = {};
 		return;
 	}
 
-	vertexBuffer = device.CreateBuffer(EBufferUsage::Vertex, EMemoryUsage::CPU_TO_GPU, vertexBufferSize);
-	ImDrawVert* vertexData = static_cast<ImDrawVert*>(vertexBuffer.GetData());
-	indexBuffer = device.CreateBuffer(EBufferUsage::Index, EMemoryUsage::CPU_TO_GPU, indexBufferSize);
-	ImDrawIdx* indexData = static_cast<ImDrawIdx*>(indexBuffer.GetData());
+	vertices = device.AllocateUpload(vertexBufferSize);
+	ImDrawVert* vertexData = static_cast<ImDrawVert*>(vertices.data);
+	indices = device.AllocateUpload(indexBufferSize);
+	ImDrawIdx* indexData = static_cast<ImDrawIdx*>(indices.data);
 
 	for (int32 cmdListIndex = 0; cmdListIndex < drawData->CmdListsCount; cmdListIndex++)
 	{
@@ -8,11 +8,12 @@ struct UserInterfaceRender : public Component
 {
 	gpu::Image fontImage;
 	gpu::TextureID fontTexture;
+	gpu::UploadTicket fontUploadTicket;
 
 	glm::vec4 scaleAndTranslation;
 
-	gpu::Buffer vertexBuffer;
-	gpu::Buffer indexBuffer;
+	gpu::UploadAllocation vertices;
+	gpu::UploadAllocation indices;
 
 	gpu::Pipeline pipeline;
 
@@ -33,6 +34,12 @@ private:
 	std::shared_ptr<ScreenResizeEvent> _ScreenResizeEvent;
 	std::list<gpu::TextureID> _UserTextures;
 
+	/** Scheduling overhead per job, from the last time it was measured. */
+	float _JobOverheadNs = 0.0f;
+
+	/** Pipeline key timings, from the last time they were measured. */
+	PipelineKeyBenchmark _PipelineKeyBenchmark = {};
+
 	void ShowUI(Engine& engine);
 	void ShowMainMenu(Engine& engine);
 	void ShowRenderSettings(Engine& engine);
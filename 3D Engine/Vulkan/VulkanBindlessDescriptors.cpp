@@ -1,13 +1,19 @@
 #include "VulkanBindlessDescriptors.h"
 #include "VulkanDevice.h"
 
-VulkanBindlessDescriptors::VulkanBindlessDescriptors(VkDevice device, VkDescriptorType descriptorType, uint32 descriptorCount)
+VulkanBindlessDescriptors::VulkanBindlessDescriptors(VkDevice device, VkDescriptorType descriptorType, uint32 descriptorCount, uint32 numFramesInFlight)
 	: _Device(device)
+	, _DescriptorType(descriptorType)
 	, _MaxDescriptorCount(descriptorCount)
+	, _DescriptorSets(numFramesInFlight)
+	, _Released(numFramesInFlight)
+	, _PendingUpdates(numFramesInFlight)
 {
+	// IDs are created while the frame's earlier submissions are pending, and write descriptors those submissions don't use.
 	constexpr VkDescriptorBindingFlags bindingFlags = 
 		VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
-		VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT;
+		VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT |
+		VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
 
 	const VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo = 
 	{ 
@@ -46,24 +52,27 @@ VulkanBindlessDescriptors::VulkanBindlessDescriptors(VkDevice device, VkDescript
 	const VkDescriptorPoolSize descriptorPoolSize =
 	{
 		.type = descriptorType,
-		.descriptorCount = descriptorCount,
+		.descriptorCount = descriptorCount * numFramesInFlight,
 	};
 	
 	const VkDescriptorPoolCreateInfo descriptorPoolInfo = 
 	{ 
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-		.maxSets = 1,
+		.maxSets = numFramesInFlight,
 		.poolSizeCount = 1,
 		.pPoolSizes = &descriptorPoolSize,
 	};
 
 	vulkan(vkCreateDescriptorPool(device, &descriptorPoolInfo, nullptr, &_DescriptorPool));
 
+	const std::vector<uint32> descriptorCounts(numFramesInFlight, descriptorCount);
+	const std::vector<VkDescriptorSetLayout> setLayouts(numFramesInFlight, _DescriptorSetLayout);
+
 	const VkDescriptorSetVariableDescriptorCountAllocateInfo variableDescriptorCountInfo = 
 	{ 
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_VARIABLE_DESCRIPTOR_COUNT_ALLOCATE_INFO,
-		.descriptorSetCount = 1,
-		.pDescriptorCounts = &descriptorCount
+		.descriptorSetCount = numFramesInFlight,
+		.pDescriptorCounts = descriptorCounts.data()
 	};
 		
 	const VkDescriptorSetAllocateInfo setAllocateInfo = 
@@ -71,11 +80,11 @@ VulkanBindlessDescriptors::VulkanBindlessDescriptors(VkDevice device, VkDescript
 		.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
 		.pNext = &variableDescriptorCountInfo,
 		.descriptorPool = _DescriptorPool,
-		.descriptorSetCount = 1,
-		.pSetLayouts = &_DescriptorSetLayout
+		.descriptorSetCount = numFramesInFlight,
+		.pSetLayouts = setLayouts.data()
 	};
 
-	vulkan(vkAllocateDescriptorSets(device, &setAllocateInfo, &_DescriptorSet));
+	vulkan(vkAllocateDescriptorSets(device, &setAllocateInfo, _DescriptorSets.data()));
 }
 
 VulkanBindlessDescriptors::~VulkanBindlessDescriptors()
@@ -84,7 +93,7 @@ VulkanBindlessDescriptors::~VulkanBindlessDescriptors()
 	vkDestroyDescriptorPool(_Device, _DescriptorPool, nullptr);
 }
 
-gpu::TextureID VulkanBindlessDescriptors::CreateTextureID(const gpu::ImageView& imageView, const gpu::Sampler& sampler)
+VkDescriptorImageInfo VulkanBindlessDescriptors::GetTextureInfo(const gpu::ImageView& imageView, const gpu::Sampler& sampler)
 {
 	static auto chooseImageLayout = [] (EFormat format)
 	{
@@ -106,42 +115,54 @@ gpu::TextureID VulkanBindlessDescriptors::CreateTextureID(const gpu::ImageView&
 		}
 	};
 
-	const VkDescriptorImageInfo imageInfo = { sampler, imageView, chooseImageLayout(imageView.GetFormat()) };
+	return { sampler, imageView, chooseImageLayout(imageView.GetFormat()) };
+}
 
-	const VkWriteDescriptorSet writeDescriptorSet = 
-	{ 
-		.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-		.dstSet = _DescriptorSet,
-		.dstBinding = 0,
-		.dstArrayElement = Allocate(),
-		.descriptorCount = 1,
-		.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
-		.pImageInfo = &imageInfo,
-	};
+gpu::TextureID VulkanBindlessDescriptors::CreateTextureID(const gpu::ImageView& imageView, const gpu::Sampler& sampler)
+{
+	const uint32 descriptorIndex = Allocate();
 
-	vkUpdateDescriptorSets(_Device, 1, &writeDescriptorSet, 0, nullptr);
+	Write(descriptorIndex, GetTextureInfo(imageView, sampler));
 
-	return gpu::TextureID(writeDescriptorSet.dstArrayElement);
+	return gpu::TextureID(descriptorIndex);
 }
 
 gpu::ImageID VulkanBindlessDescriptors::CreateImageID(const gpu::ImageView& imageView)
 {
-	const VkDescriptorImageInfo imageInfo = { nullptr, imageView, VK_IMAGE_LAYOUT_GENERAL };
+	const uint32 descriptorIndex = Allocate();
 
+	Write(descriptorIndex, { nullptr, imageView, VK_IMAGE_LAYOUT_GENERAL });
+
+	return gpu::ImageID(descriptorIndex);
+}
+
+void VulkanBindlessDescriptors::UpdateTextureID(gpu::TextureID textureID, const gpu::ImageView& imageView, const gpu::Sampler& sampler)
+{
+	Write(textureID, GetTextureInfo(imageView, sampler));
+}
+
+void VulkanBindlessDescriptors::Write(uint32 descriptorIndex, const VkDescriptorImageInfo& imageInfo)
+{
 	const VkWriteDescriptorSet writeDescriptorSet =
 	{
 		.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
-		.dstSet = _DescriptorSet,
+		.dstSet = _DescriptorSets[_FrameIndex],
 		.dstBinding = 0,
-		.dstArrayElement = Allocate(),
+		.dstArrayElement = descriptorIndex,
 		.descriptorCount = 1,
-		.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
+		.descriptorType = _DescriptorType,
 		.pImageInfo = &imageInfo,
 	};
 
 	vkUpdateDescriptorSets(_Device, 1, &writeDescriptorSet, 0, nullptr);
 
-	return gpu::ImageID(writeDescriptorSet.dstArrayElement);
+	for (uint32 frameIndex = 0; frameIndex < _DescriptorSets.size(); frameIndex++)
+	{
+		if (frameIndex != _FrameIndex)
+		{
+			_PendingUpdates[frameIndex].push_back({ descriptorIndex, imageInfo });
+		}
+	}
 }
 
 uint32 VulkanBindlessDescriptors::Allocate()
@@ -164,15 +185,42 @@ uint32 VulkanBindlessDescriptors::Allocate()
 
 void VulkanBindlessDescriptors::Release(uint32 descriptorIndex)
 {
-	_Released.push_back(descriptorIndex);
+	_Released[_FrameIndex].push_back(descriptorIndex);
 }
 
-void VulkanBindlessDescriptors::EndFrame()
+void VulkanBindlessDescriptors::EndFrame(uint32 frameIndex)
 {
-	for (auto id : _Released)
+	_FrameIndex = frameIndex;
+
+	// The frame's set is idle now. Pending updates are applied before released indexes are recycled, 
+	// so they can't overwrite a descriptor allocated after its index was released.
+	std::vector<VkWriteDescriptorSet> writeDescriptorSets;
+	writeDescriptorSets.reserve(_PendingUpdates[_FrameIndex].size());
+
+	for (const auto& [descriptorIndex, imageInfo] : _PendingUpdates[_FrameIndex])
+	{
+		writeDescriptorSets.push_back({
+			.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+			.dstSet = _DescriptorSets[_FrameIndex],
+			.dstBinding = 0,
+			.dstArrayElement = descriptorIndex,
+			.descriptorCount = 1,
+			.descriptorType = _DescriptorType,
+			.pImageInfo = &imageInfo,
+		});
+	}
+
+	if (!writeDescriptorSets.empty())
+	{
+		vkUpdateDescriptorSets(_Device, static_cast<uint32>(writeDescriptorSets.size()), writeDescriptorSets.data(), 0, nullptr);
+	}
+
+	_PendingUpdates[_FrameIndex].clear();
+
+	for (auto id : _Released[_FrameIndex])
 	{
 		_Available.push_back(id);
 	}
 
-	_Released.clear();
+	_Released[_FrameIndex].clear();
 }
\ No newline at end of file
@@ -22,13 +22,17 @@ namespace gpu
 	class Sampler;
 }
 
+/**
+  * A descriptor set per frame in flight, so descriptors can be updated without touching a set the GPU may be reading.
+  * Indexes are the same in every set.
+  */
 class VulkanBindlessDescriptors
 {
 public:
 	VulkanBindlessDescriptors(const VulkanBindlessDescriptors&) = delete;
 	VulkanBindlessDescriptors& operator=(const VulkanBindlessDescriptors&) = delete;
 	VulkanBindlessDescriptors() = default;
-	VulkanBindlessDescriptors(VkDevice device, VkDescriptorType descriptorType, uint32 descriptorCount);
+	VulkanBindlessDescriptors(VkDevice device, VkDescriptorType descriptorType, uint32 descriptorCount, uint32 numFramesInFlight);
 	~VulkanBindlessDescriptors();
 
 	/** Create a texture ID for indexing into the texture2D array. */
@@ -37,25 +41,44 @@ public:
 	/** Create an image ID for indexing into the storage image array. */
 	gpu::ImageID CreateImageID(const gpu::ImageView& imageView);
 
-	/** Called in VulkanDevice::EndFrame(). */
-	void EndFrame();
+	/**
+	  * Point a texture ID at another image view. The current frame's set is updated immediately,
+	  * and the other sets when their frames are no longer in flight, so the previous image view must outlive those frames.
+	  */
+	void UpdateTextureID(gpu::TextureID textureID, const gpu::ImageView& imageView, const gpu::Sampler& sampler);
+
+	/** Called in VulkanDevice::EndFrame(). Applies pending updates and recycles the indexes released the last time frameIndex was in flight. */
+	void EndFrame(uint32 frameIndex);
 
 	/** Release a descriptor index. */
 	void Release(uint32 descriptorIndex);
 
 	inline VkDescriptorSetLayout GetLayout() const { return _DescriptorSetLayout; }
-	inline operator VkDescriptorSet&() { return _DescriptorSet; }
+	inline operator VkDescriptorSet&() { return _DescriptorSets[_FrameIndex]; }
 
 private:
 	VkDevice				_Device;
+	VkDescriptorType		_DescriptorType;
 	uint32					_MaxDescriptorCount;
 	VkDescriptorSetLayout	_DescriptorSetLayout;
 	VkDescriptorPool		_DescriptorPool;
-	VkDescriptorSet			_DescriptorSet;
+	std::vector<VkDescriptorSet> _DescriptorSets;
 	uint32					_NumDescriptors = 0;
 	std::list<uint32>		_Available;
-	std::list<uint32>		_Released;
+	uint32					_FrameIndex = 0;
+	std::vector<std::list<uint32>> _Released;
+
+	/** Updates waiting for each frame's set to go idle. */
+	std::vector<std::vector<std::pair<uint32, VkDescriptorImageInfo>>> _PendingUpdates;
 
 	/** Allocate an index into the bindless descriptor table. */
 	uint32 Allocate();
+
+	/**
+	  * Write an image descriptor to the current frame's set, and to the other sets when their frames are no longer in flight.
+	  * The current set may be bound by the frame's pending submissions, which don't use the descriptor.
+	  */
+	void Write(uint32 descriptorIndex, const VkDescriptorImageInfo& imageInfo);
+
+	static VkDescriptorImageInfo GetTextureInfo(const gpu::ImageView& imageView, const gpu::Sampler& sampler);
 };
\ No newline at end of file
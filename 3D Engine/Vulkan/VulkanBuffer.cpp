@@ -6,13 +6,13 @@
 namespace gpu
 {
 	Buffer::Buffer(
-		VmaAllocator allocator,
+		VulkanDevice& device,
 		VkBuffer buffer,
 		VmaAllocation allocation,
 		const VmaAllocationInfo& allocationInfo,
 		VkDeviceSize size,
 		EBufferUsage usage)
-		: _Allocator(allocator)
+		: _Device(&device)
 		, _Allocation(allocation)
 		, _AllocationInfo(allocationInfo)
 		, _Buffer(buffer)
@@ -28,7 +28,7 @@ namespace gpu
 	Buffer& Buffer::operator=(Buffer&& other)
 	{
 		Destroy();
-		_Allocator = std::exchange(other._Allocator, nullptr);
+		_Device = std::exchange(other._Device, nullptr);
 		_Allocation = std::exchange(other._Allocation, nullptr);
 		_AllocationInfo = other._AllocationInfo;
 		_Buffer = std::exchange(other._Buffer, nullptr);
@@ -45,7 +45,8 @@ namespace gpu
 	{
 		if (_Allocation)
 		{
-			vmaDestroyBuffer(_Allocator, _Buffer, _Allocation);
+			// The buffer may still be referenced by frames in flight.
+			_Device->ReleaseBuffer(_Buffer, _Allocation);
 			_Allocation = nullptr;
 		}
 	}
@@ -56,4 +57,11 @@ namespace gpu
 		_DescriptorBufferInfo.offset = 0;
 		_DescriptorBufferInfo.range = buffer.GetSize();
 	}
+
+	DescriptorBufferInfo::DescriptorBufferInfo(const Buffer& buffer, uint64 offset, uint64 range)
+	{
+		_DescriptorBufferInfo.buffer = buffer;
+		_DescriptorBufferInfo.offset = offset;
+		_DescriptorBufferInfo.range = range;
+	}
 };
\ No newline at end of file
@@ -13,7 +13,7 @@ namespace gpu
 		Buffer& operator=(const Buffer&) = delete;
 
 		Buffer() = default;
-		Buffer(VmaAllocator allocator, VkBuffer buffer, VmaAllocation allocation, const VmaAllocationInfo& allocationInfo, VkDeviceSize size, EBufferUsage usage);
+		Buffer(VulkanDevice& device, VkBuffer buffer, VmaAllocation allocation, const VmaAllocationInfo& allocationInfo, VkDeviceSize size, EBufferUsage usage);
 		Buffer(Buffer&& other);
 		Buffer& operator=(Buffer&& other);
 		~Buffer();
@@ -23,7 +23,7 @@ namespace gpu
 		inline operator const VkBuffer&() const { return _Buffer; }
 
 	private:
-		VmaAllocator		_Allocator = nullptr;
+		VulkanDevice*		_Device = nullptr;
 		VmaAllocation		_Allocation = nullptr;
 		VmaAllocationInfo	_AllocationInfo;
 		VkBuffer			_Buffer = nullptr;
@@ -37,6 +37,7 @@ namespace gpu
 	public:
 		DescriptorBufferInfo() = default;
 		DescriptorBufferInfo(const Buffer& buffer);
+		DescriptorBufferInfo(const Buffer& buffer, uint64 offset, uint64 range);
 
 	private:
 		VkDescriptorBufferInfo _DescriptorBufferInfo;
@@ -48,6 +49,7 @@ namespace gpu
 	public:
 		UniformBuffer() = default;
 		UniformBuffer(const Buffer& buffer) : DescriptorBufferInfo(buffer) {}
+		UniformBuffer(const Buffer& buffer, uint64 offset, uint64 range) : DescriptorBufferInfo(buffer, offset, range) {}
 
 		static VkDescriptorType GetDescriptorType() { return VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC; }
 	};
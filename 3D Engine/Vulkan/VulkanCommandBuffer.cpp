@@ -95,17 +95,18 @@ namespace gpu
 		);
 	}
 
-	void CommandBuffer::BindVertexBuffers(std::size_t numVertexBuffers, const Buffer* vertexBuffers)
+	void CommandBuffer::BindVertexBuffers(std::size_t numVertexBuffers, const Buffer* vertexBuffers, const uint64* offsets)
 	{
-		std::vector<VkDeviceSize> offsets(numVertexBuffers, 0);
+		std::vector<VkDeviceSize> vkOffsets(numVertexBuffers, 0);
 		std::vector<VkBuffer> buffers(numVertexBuffers);
 
 		for (uint32 location = 0; location < numVertexBuffers; location++)
 		{
 			buffers[location] = vertexBuffers[location];
+			vkOffsets[location] = offsets ? offsets[location] : 0;
 		}
 
-		vkCmdBindVertexBuffers(_CommandBuffer, 0, static_cast<uint32>(buffers.size()), buffers.data(), offsets.data());
+		vkCmdBindVertexBuffers(_CommandBuffer, 0, static_cast<uint32>(buffers.size()), buffers.data(), vkOffsets.data());
 	}
 
 	void CommandBuffer::DrawIndexed(
@@ -115,9 +116,10 @@ namespace gpu
 		uint32 firstIndex,
 		uint32 vertexOffset,
 		uint32 firstInstance,
-		EIndexType indexType)
+		EIndexType indexType,
+		uint64 indexBufferOffset)
 	{
-		vkCmdBindIndexBuffer(_CommandBuffer, indexBuffer, 0, static_cast<VkIndexType>(indexType));
+		vkCmdBindIndexBuffer(_CommandBuffer, indexBuffer, indexBufferOffset, static_cast<VkIndexType>(indexType));
 		vkCmdDrawIndexed(_CommandBuffer, indexCount, instanceCount, firstIndex, vertexOffset, firstInstance);
 	}
 
@@ -137,6 +139,18 @@ namespace gpu
 		);
 	}
 
+	void CommandBuffer::DrawIndexedIndirect(const Buffer& indexBuffer, EIndexType indexType, const Buffer& buffer, uint64 offset, uint32 drawCount)
+	{
+		vkCmdBindIndexBuffer(_CommandBuffer, indexBuffer, 0, static_cast<VkIndexType>(indexType));
+		vkCmdDrawIndexedIndirect(
+			_CommandBuffer,
+			buffer,
+			offset,
+			drawCount,
+			sizeof(VkDrawIndexedIndirectCommand)
+		);
+	}
+
 	void CommandBuffer::Dispatch(uint32 groupCountX, uint32 groupCountY, uint32 groupCountZ)
 	{
 		vkCmdDispatch(_CommandBuffer, groupCountX, groupCountY, groupCountZ);
@@ -178,18 +192,39 @@ namespace gpu
 		std::size_t numImageBarriers,
 		const ImageMemoryBarrier* imageBarriers)
 	{
+		// Ownership only moves between queue families. Queues of the same family share their resources.
+		auto getQueueFamilyIndices = [this] (EQueue srcQueue, EQueue dstQueue) -> std::pair<uint32, uint32>
+		{
+			if (srcQueue == EQueue::Num || dstQueue == EQueue::Num)
+			{
+				return { VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED };
+			}
+
+			const uint32 srcQueueFamilyIndex = static_cast<uint32>(_Device.GetQueue(srcQueue).GetQueueFamilyIndex());
+			const uint32 dstQueueFamilyIndex = static_cast<uint32>(_Device.GetQueue(dstQueue).GetQueueFamilyIndex());
+
+			if (srcQueueFamilyIndex == dstQueueFamilyIndex)
+			{
+				return { VK_QUEUE_FAMILY_IGNORED, VK_QUEUE_FAMILY_IGNORED };
+			}
+
+			return { srcQueueFamilyIndex, dstQueueFamilyIndex };
+		};
+
 		std::vector<VkBufferMemoryBarrier> vulkanBufferBarriers;
 		vulkanBufferBarriers.reserve(numBufferBarriers);
 
 		for (std::size_t i = 0; i < numBufferBarriers; i++)
 		{
+			const auto [srcQueueFamilyIndex, dstQueueFamilyIndex] = getQueueFamilyIndices(bufferBarriers[i].srcQueue, bufferBarriers[i].dstQueue);
+
 			const VkBufferMemoryBarrier bufferBarrier = 
 			{ 
 				.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
 				.srcAccessMask = VulkanDevice::GetAccessFlags(bufferBarriers[i].srcAccessMask),
 				.dstAccessMask = VulkanDevice::GetAccessFlags(bufferBarriers[i].dstAccessMask),
-				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.srcQueueFamilyIndex = srcQueueFamilyIndex,
+				.dstQueueFamilyIndex = dstQueueFamilyIndex,
 				.buffer = bufferBarriers[i].buffer,
 				.offset = 0,
 				.size = bufferBarriers[i].buffer.GetSize(),
@@ -203,6 +238,8 @@ namespace gpu
 
 		for (std::size_t i = 0; i < numImageBarriers; i++)
 		{
+			const auto [srcQueueFamilyIndex, dstQueueFamilyIndex] = getQueueFamilyIndices(imageBarriers[i].srcQueue, imageBarriers[i].dstQueue);
+
 			const VkImageMemoryBarrier imageBarrier = 
 			{ 
 				.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
@@ -210,8 +247,8 @@ namespace gpu
 				.dstAccessMask = VulkanDevice::GetAccessFlags(imageBarriers[i].dstAccessMask),
 				.oldLayout = Image::GetLayout(imageBarriers[i].oldLayout),
 				.newLayout = Image::GetLayout(imageBarriers[i].newLayout),
-				.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
-				.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+				.srcQueueFamilyIndex = srcQueueFamilyIndex,
+				.dstQueueFamilyIndex = dstQueueFamilyIndex,
 				.image = imageBarriers[i].image,
 				.subresourceRange = 
 				{
@@ -427,11 +464,4 @@ namespace gpu
 			&region
 		);
 	}
-
-	std::shared_ptr<gpu::Buffer> CommandBuffer::CreateStagingBuffer(uint64 size, const void* data)
-	{
-		auto stagingBuffer = std::make_shared<gpu::Buffer>(_Device.CreateBuffer(EBufferUsage::None, EMemoryUsage::CPU_ONLY, size, data));
-		_Queue.AddInFlightStagingBuffer(stagingBuffer);
-		return stagingBuffer;
-	}
 };
\ No newline at end of file
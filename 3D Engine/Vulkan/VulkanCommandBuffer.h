@@ -47,7 +47,8 @@ namespace gpu
 
 		void BindVertexBuffers(
 			std::size_t numVertexBuffers, 
-			const Buffer* vertexBuffers
+			const Buffer* vertexBuffers,
+			const uint64* offsets = nullptr
 		);
 
 		void DrawIndexed(
@@ -57,7 +58,8 @@ namespace gpu
 			uint32 firstIndex,
 			uint32 vertexOffset,
 			uint32 firstInstance,
-			EIndexType indexType
+			EIndexType indexType,
+			uint64 indexBufferOffset = 0
 		);
 
 		void Draw(
@@ -73,6 +75,14 @@ namespace gpu
 			uint32 drawCount
 		);
 
+		void DrawIndexedIndirect(
+			const Buffer& indexBuffer,
+			EIndexType indexType,
+			const Buffer& buffer,
+			uint64 offset,
+			uint32 drawCount
+		);
+
 		void Dispatch(
 			uint32 groupCountX, 
 			uint32 groupCountY, 
@@ -131,11 +141,6 @@ namespace gpu
 			uint32 dstArrayLayer
 		);
 
-		std::shared_ptr<Buffer> CreateStagingBuffer(
-			uint64 size, 
-			const void* data = nullptr
-		);
-
 		void SetViewport(const Viewport& viewport);
 
 		void SetScissor(const Scissor& scissor);
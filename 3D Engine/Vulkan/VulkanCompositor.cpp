@@ -147,10 +147,6 @@ void VulkanCompositor::QueuePresent(gpu::Device& device, uint32 imageIndex, gpu:
 	{
 		vulkan(result);
 	}
-
-	vulkan(vkQueueWaitIdle(_PresentQueue));
-
-	_Device.GetGraphicsQueue().GiveUpInFlightResources(_Device);
 }
 
 struct SwapchainSupportDetails
@@ -184,6 +180,10 @@ struct SwapchainSupportDetails
 void VulkanCompositor::Resize(gpu::Device& device, uint32 screenWidth, uint32 screenHeight, EImageUsage imageUsage)
 {
 	auto& _Device = static_cast<VulkanDevice&>(device);
+
+	// Frames in flight may still be rendering to the old swapchain.
+	_Device.WaitIdle();
+
 	const SwapchainSupportDetails swapchainSupport(_Device.GetPhysicalDevice(), _Surface);
 
 	_SurfaceFormat = ChooseSwapSurfaceFormat(swapchainSupport.formats, { VK_FORMAT_B8G8R8A8_UNORM, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR });
@@ -1,11 +1,80 @@
 #include "VulkanDevice.h"
 #include "VulkanRenderPass.h"
+#include <Engine/JobSystem.h>
 #include <unordered_set>
+#include <chrono>
 
 void VulkanDevice::EndFrame()
 {
-	_BindlessTextures->EndFrame();
-	_BindlessImages->EndFrame();
+	_FrameIndex = (_FrameIndex + 1) % _NumFramesInFlight;
+	_FrameNumber++;
+
+	// Wait for the frame that last used this slot before recycling its resources.
+	_GraphicsQueue.BeginFrame(_Device, _FrameIndex);
+	_TransferQueue.BeginFrame(_Device, _FrameIndex);
+
+	if (HasAsyncCompute())
+	{
+		_ComputeQueue.BeginFrame(_Device, _FrameIndex);
+	}
+
+	for (const auto& [buffer, allocation] : _ReleasedBuffers[_FrameIndex])
+	{
+		vmaDestroyBuffer(_Allocator, buffer, allocation);
+	}
+
+	_ReleasedBuffers[_FrameIndex].clear();
+
+	for (const auto& [renderPass, framebuffer] : _ReleasedRenderPasses[_FrameIndex])
+	{
+		vkDestroyFramebuffer(_Device, framebuffer, nullptr);
+
+		_RenderPassReferences[renderPass]--;
+	}
+
+	_ReleasedRenderPasses[_FrameIndex].clear();
+
+	EvictRenderPasses();
+
+	_UploadRing->EndFrame(_FrameIndex);
+
+	_UploadService->EndFrame();
+
+	_TimestampQueries->EndFrame(_FrameIndex);
+
+	_BindlessTextures->EndFrame(_FrameIndex);
+	_BindlessImages->EndFrame(_FrameIndex);
+
+	CollectCompiledPipelines();
+
+	if (_ShaderWatcher)
+	{
+		RecompileShaders(_ShaderWatcher->TakeChangedFiles());
+	}
+
+	// Pipelines created while recording stall the frame. Each one is a permutation the warm-up missed.
+	if (_NumPipelinesCreatedThisFrame > 0)
+	{
+		LOG("Hitch: created %u pipelines on demand in %.1f ms.", _NumPipelinesCreatedThisFrame, _PipelineCreationMsThisFrame);
+
+		_NumPipelinesCreatedThisFrame = 0;
+		_PipelineCreationMsThisFrame = 0.0f;
+	}
+}
+
+void VulkanDevice::WaitIdle()
+{
+	vulkan(vkDeviceWaitIdle(_Device));
+}
+
+void VulkanDevice::ReleaseBuffer(VkBuffer buffer, VmaAllocation allocation)
+{
+	_ReleasedBuffers[_FrameIndex].push_back({ buffer, allocation });
+}
+
+void VulkanDevice::ReleaseRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer)
+{
+	_ReleasedRenderPasses[_FrameIndex].push_back({ renderPass, framebuffer });
 }
 
 void VulkanDevice::SubmitCommands(gpu::CommandBuffer& cmdBuf)
@@ -18,121 +87,401 @@ void VulkanDevice::SubmitCommands(
 	const gpu::Semaphore& waitSemaphore, 
 	const gpu::Semaphore& signalSemaphore)
 {
-	if (cmdBuf._Queue.GetQueue() == _GraphicsQueue.GetQueue())
+	if (&cmdBuf._Queue == &_GraphicsQueue)
 	{
-		_TransferQueue.WaitSemaphores(_Device);
+		_UploadService->BeginGraphicsSubmit();
 	}
 
 	cmdBuf._Queue.Submit(cmdBuf, waitSemaphore, signalSemaphore);
 }
 
+void VulkanDevice::SubmitCommands(
+	gpu::CommandBuffer& cmdBuf,
+	EQueue waitQueue,
+	const gpu::Semaphore& waitSemaphore,
+	const gpu::Semaphore& signalSemaphore)
+{
+	if (&cmdBuf._Queue == &_GraphicsQueue)
+	{
+		_UploadService->BeginGraphicsSubmit();
+	}
+
+	VulkanQueue& queue = GetQueue(waitQueue);
+
+	// Submissions to the same queue are already ordered.
+	cmdBuf._Queue.Submit(cmdBuf, waitSemaphore, signalSemaphore, &queue != &cmdBuf._Queue ? &queue : nullptr);
+}
+
 gpu::CommandBuffer VulkanDevice::CreateCommandBuffer(EQueue queueType)
 {
-	VulkanQueue& queue = queueType == EQueue::Transfer ? _TransferQueue : _GraphicsQueue;
-
-	return gpu::CommandBuffer(*this, queue);
-}
-
-gpu::Pipeline VulkanDevice::CreatePipeline(const GraphicsPipelineDesc& graphicsDesc)
-{
-	const uint64 renderPass = *reinterpret_cast<uint64*>(graphicsDesc.renderPass.GetRenderPass());
-
-	int i = 0;
-	std::array<uint64, 5> shaders({ 0 });
-	auto addShader = [&] (const gpu::Shader* shader) { if (shader) shaders[i++] = *reinterpret_cast<uint64*>(shader->compilationResult.shaderModule); };
-	addShader(graphicsDesc.shaderStages.vertex);
-	addShader(graphicsDesc.shaderStages.tessControl);
-	addShader(graphicsDesc.shaderStages.tessEval);
-	addShader(graphicsDesc.shaderStages.geometry);
-	addShader(graphicsDesc.shaderStages.fragment);
-
-	Crc crc = 0;
-	Platform::crc32_u32(crc, &renderPass, sizeof(renderPass));
-	Platform::crc32_u32(crc, &graphicsDesc.depthStencilState, sizeof(graphicsDesc.depthStencilState));
-	Platform::crc32_u32(crc, &graphicsDesc.rasterizationState, sizeof(graphicsDesc.rasterizationState));
-	Platform::crc32_u32(crc, &graphicsDesc.multisampleState, sizeof(graphicsDesc.multisampleState));
-	Platform::crc32_u32(crc, &graphicsDesc.inputAssemblyState, sizeof(graphicsDesc.inputAssemblyState));
-	Platform::crc32_u32(crc, shaders.data(), shaders.size() * sizeof(shaders[0]));
-	Platform::crc32_u32(crc, graphicsDesc.specInfo.GetMapEntries().data(), graphicsDesc.specInfo.GetMapEntries().size() * sizeof(graphicsDesc.specInfo.GetMapEntries()[0]));
-	Platform::crc32_u8(crc, graphicsDesc.specInfo.GetData().data(), graphicsDesc.specInfo.GetData().size() * sizeof(graphicsDesc.specInfo.GetData()[0]));
-	Platform::crc32_u32(crc, graphicsDesc.colorBlendAttachmentStates.data(), graphicsDesc.colorBlendAttachmentStates.size() * sizeof(graphicsDesc.colorBlendAttachmentStates[0]));
-	Platform::crc32_u32(crc, graphicsDesc.vertexAttributes.data(), graphicsDesc.vertexAttributes.size() * sizeof(graphicsDesc.vertexAttributes[0]));
-	Platform::crc32_u32(crc, graphicsDesc.vertexBindings.data(), graphicsDesc.vertexBindings.size() * sizeof(graphicsDesc.vertexBindings[0]));
-
-	if (auto iter = _GraphicsPipelineCache.find(crc); iter == _GraphicsPipelineCache.end())
-	{
-		std::map<uint32, VkDescriptorSetLayout> layoutsMap;
-		auto getLayouts = [&] (const gpu::Shader* shader) 
-			{ if (shader) { for (const auto& [set, layout] : shader->compilationResult.layouts) { layoutsMap.insert({ set, layout }); } } };
-		getLayouts(graphicsDesc.shaderStages.vertex);
-		getLayouts(graphicsDesc.shaderStages.tessControl);
-		getLayouts(graphicsDesc.shaderStages.tessEval);
-		getLayouts(graphicsDesc.shaderStages.geometry);
-		getLayouts(graphicsDesc.shaderStages.fragment);
-
-		std::vector<VkDescriptorSetLayout> layouts;
-		layouts.reserve(layoutsMap.size());
-		for (const auto& [set, layout] : layoutsMap)
+	return gpu::CommandBuffer(*this, GetQueue(queueType));
+}
+
+VulkanQueue& VulkanDevice::GetQueue(EQueue queue)
+{
+	switch (queue)
+	{
+	case EQueue::Transfer:
+		return _TransferQueue;
+	case EQueue::Compute:
+		return HasAsyncCompute() ? _ComputeQueue : _GraphicsQueue;
+	default: // EQueue::Graphics
+		return _GraphicsQueue;
+	}
+}
+
+/**
+  * The state that identifies a pipeline. Shaders are identified by their gpu::Shader, which keeps its address when its module
+  * is recompiled, so keys survive hot reloads. The key bytes go to a reused buffer, so looking up a pipeline doesn't allocate.
+  */
+const std::string& VulkanDevice::GetPipelineKeyBytes(const GraphicsPipelineDesc& graphicsDesc)
+{
+	thread_local std::string keyBytes;
+	keyBytes.clear();
+
+	AppendKeyBytes(keyBytes, graphicsDesc.renderPass.GetRenderPass());
+	AppendKeyBytes(keyBytes, graphicsDesc.depthStencilState);
+	AppendKeyBytes(keyBytes, graphicsDesc.rasterizationState);
+	AppendKeyBytes(keyBytes, graphicsDesc.multisampleState);
+	AppendKeyBytes(keyBytes, graphicsDesc.inputAssemblyState);
+	AppendKeyBytes(keyBytes, graphicsDesc.shaderStages);
+	AppendKeyBytes(keyBytes, graphicsDesc.specInfo.GetMapEntries());
+	AppendKeyBytes(keyBytes, graphicsDesc.specInfo.GetData());
+	AppendKeyBytes(keyBytes, graphicsDesc.colorBlendAttachmentStates);
+	AppendKeyBytes(keyBytes, graphicsDesc.vertexAttributes);
+	AppendKeyBytes(keyBytes, graphicsDesc.vertexBindings);
+
+	return keyBytes;
+}
+
+const std::string& VulkanDevice::GetPipelineKeyBytes(const ComputePipelineDesc& computeDesc)
+{
+	thread_local std::string keyBytes;
+	keyBytes.clear();
+
+	AppendKeyBytes(keyBytes, computeDesc.shader);
+	AppendKeyBytes(keyBytes, computeDesc.specInfo.GetMapEntries());
+	AppendKeyBytes(keyBytes, computeDesc.specInfo.GetData());
+
+	return keyBytes;
+}
+
+GraphicsPipelineKey VulkanDevice::GetPipelineKey(const GraphicsPipelineDesc& graphicsDesc)
+{
+	const std::string& keyBytes = GetPipelineKeyBytes(graphicsDesc);
+
+	if (const uint32* index = _GraphicsPipelineIndices.Find(keyBytes, _FrameNumber))
+	{
+		return GraphicsPipelineKey(*index);
+	}
+
+	const uint32 index = _GraphicsPipelineIndices.Add(keyBytes, static_cast<uint32>(_GraphicsPipelines.size()), _FrameNumber);
+	_GraphicsPipelines.push_back({ graphicsDesc });
+
+	return GraphicsPipelineKey(index);
+}
+
+ComputePipelineKey VulkanDevice::GetPipelineKey(const ComputePipelineDesc& computeDesc)
+{
+	const std::string& keyBytes = GetPipelineKeyBytes(computeDesc);
+
+	if (const uint32* index = _ComputePipelineIndices.Find(keyBytes, _FrameNumber))
+	{
+		return ComputePipelineKey(*index);
+	}
+
+	const uint32 index = _ComputePipelineIndices.Add(keyBytes, static_cast<uint32>(_ComputePipelines.size()), _FrameNumber);
+	_ComputePipelines.push_back({ computeDesc });
+
+	return ComputePipelineKey(index);
+}
+
+VkPipelineLayout VulkanDevice::GetOrCreatePipelineLayout(const GraphicsPipelineDesc& graphicsDesc)
+{
+	std::map<uint32, VkDescriptorSetLayout> layoutsMap;
+	auto getLayouts = [&] (const gpu::Shader* shader) 
+		{ if (shader) { for (const auto& [set, layout] : shader->compilationResult.layouts) { layoutsMap.insert({ set, layout }); } } };
+	getLayouts(graphicsDesc.shaderStages.vertex);
+	getLayouts(graphicsDesc.shaderStages.tessControl);
+	getLayouts(graphicsDesc.shaderStages.tessEval);
+	getLayouts(graphicsDesc.shaderStages.geometry);
+	getLayouts(graphicsDesc.shaderStages.fragment);
+
+	std::vector<VkDescriptorSetLayout> layouts;
+	layouts.reserve(layoutsMap.size());
+	for (const auto& [set, layout] : layoutsMap)
+	{
+		layouts.push_back(layout);
+	}
+
+	std::vector<VkPushConstantRange> pushConstantRanges;
+	auto getPushConstantRange = [&] (const gpu::Shader* shader) 
+	{ if (shader && shader->compilationResult.pushConstantRange.size > 0) { pushConstantRanges.push_back(shader->compilationResult.pushConstantRange); } };
+	getPushConstantRange(graphicsDesc.shaderStages.vertex);
+	getPushConstantRange(graphicsDesc.shaderStages.tessControl);
+	getPushConstantRange(graphicsDesc.shaderStages.tessEval);
+	getPushConstantRange(graphicsDesc.shaderStages.geometry);
+	getPushConstantRange(graphicsDesc.shaderStages.fragment);
+
+	return GetOrCreatePipelineLayout(layouts, pushConstantRanges);
+}
+
+VkPipelineLayout VulkanDevice::GetOrCreatePipelineLayout(const ComputePipelineDesc& computeDesc)
+{
+	std::vector<VkDescriptorSetLayout> layouts;
+	layouts.reserve(computeDesc.shader->compilationResult.layouts.size());
+	for (auto& [set, layout] : computeDesc.shader->compilationResult.layouts)
+	{
+		layouts.push_back(layout);
+	}
+
+	const auto& pushConstantRange = computeDesc.shader->compilationResult.pushConstantRange;
+	const auto pushConstantRanges = pushConstantRange.size > 0 ? std::vector{ pushConstantRange } : std::vector<VkPushConstantRange>{};
+
+	return GetOrCreatePipelineLayout(layouts, pushConstantRanges);
+}
+
+gpu::Pipeline VulkanDevice::CreatePipeline(GraphicsPipelineKey graphicsKey)
+{
+	GraphicsPipelineEntry& entry = _GraphicsPipelines[graphicsKey.GetIndex()];
+
+	if (!entry.pipeline.IsValid())
+	{
+		check(!entry.isRetired, "Pipeline %u was retired with its render pass.", graphicsKey.GetIndex());
+
+		const auto startTime = std::chrono::high_resolution_clock::now();
+
+		const VkPipelineLayout pipelineLayout = GetOrCreatePipelineLayout(entry.desc);
+		entry.pipeline = gpu::Pipeline(std::make_shared<VkPipeline>(CreatePipeline(entry.desc, pipelineLayout)), pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+
+		_NumPipelinesCreatedThisFrame++;
+		_PipelineCreationMsThisFrame += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	}
+
+	return entry.pipeline;
+}
+
+gpu::Pipeline VulkanDevice::CreatePipeline(ComputePipelineKey computeKey)
+{
+	ComputePipelineEntry& entry = _ComputePipelines[computeKey.GetIndex()];
+
+	if (!entry.pipeline.IsValid())
+	{
+		const auto startTime = std::chrono::high_resolution_clock::now();
+
+		const VkPipelineLayout pipelineLayout = GetOrCreatePipelineLayout(entry.desc);
+		entry.pipeline = gpu::Pipeline(std::make_shared<VkPipeline>(CreatePipeline(entry.desc, pipelineLayout)), pipelineLayout, VK_PIPELINE_BIND_POINT_COMPUTE);
+
+		_NumPipelinesCreatedThisFrame++;
+		_PipelineCreationMsThisFrame += std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+	}
+
+	return entry.pipeline;
+}
+
+gpu::Pipeline VulkanDevice::CreatePipelineAsync(GraphicsPipelineKey graphicsKey)
+{
+	if (!_PipelineCompiler)
+	{
+		return CreatePipeline(graphicsKey);
+	}
+
+	GraphicsPipelineEntry& entry = _GraphicsPipelines[graphicsKey.GetIndex()];
+
+	if (entry.pipeline.IsValid())
+	{
+		return entry.pipeline;
+	}
+
+	if (!entry.isPending)
+	{
+		check(!entry.isRetired, "Pipeline %u was retired with its render pass.", graphicsKey.GetIndex());
+
+		entry.isPending = true;
+
+		_PipelineCompiler->Compile(graphicsKey, entry.desc, GetOrCreatePipelineLayout(entry.desc));
+	}
+
+	// Material constants only enable features, so the unspecialized pipeline draws the surface plainly until its own is ready.
+	if (!entry.desc.specInfo.GetMapEntries().empty())
+	{
+		GraphicsPipelineDesc fallbackDesc = entry.desc;
+		fallbackDesc.specInfo = {};
+
+		// Interning may grow the entries, so the entry isn't used past here.
+		return CreatePipelineAsync(GetPipelineKey(fallbackDesc));
+	}
+
+	return {};
+}
+
+void VulkanDevice::FlushPipelineCompiler()
+{
+	if (_PipelineCompiler)
+	{
+		_PipelineCompiler->Flush();
+
+		CollectCompiledPipelines();
+	}
+}
+
+void VulkanDevice::CollectCompiledPipelines()
+{
+	if (!_PipelineCompiler)
+	{
+		return;
+	}
+
+	for (const auto& compiled : _PipelineCompiler->TakeCompiledPipelines())
+	{
+		GraphicsPipelineEntry& entry = _GraphicsPipelines[compiled.key.GetIndex()];
+
+		entry.isPending = false;
+
+		// Created on demand while it was pending. Nothing has used this one.
+		if (entry.pipeline.IsValid())
 		{
-			layouts.push_back(layout);
+			vkDestroyPipeline(_Device, compiled.pipeline, nullptr);
+			continue;
 		}
 
-		std::vector<VkPushConstantRange> pushConstantRanges;
-		auto getPushConstantRange = [&] (const gpu::Shader* shader) 
-		{ if (shader && shader->compilationResult.pushConstantRange.size > 0) { pushConstantRanges.push_back(shader->compilationResult.pushConstantRange); } };
-		getPushConstantRange(graphicsDesc.shaderStages.vertex);
-		getPushConstantRange(graphicsDesc.shaderStages.tessControl);
-		getPushConstantRange(graphicsDesc.shaderStages.tessEval);
-		getPushConstantRange(graphicsDesc.shaderStages.geometry);
-		getPushConstantRange(graphicsDesc.shaderStages.fragment);
+		entry.pipeline = gpu::Pipeline(std::make_shared<VkPipeline>(compiled.pipeline), compiled.pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+	}
+}
 
-		const VkPipelineLayout pipelineLayout = GetOrCreatePipelineLayout(layouts, pushConstantRanges);
-		const gpu::Pipeline pipeline = gpu::Pipeline(std::make_shared<VkPipeline>(CreatePipeline(graphicsDesc, pipelineLayout)), pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+void VulkanDevice::WarmUpPipelines(const std::vector<GraphicsPipelineDesc>& graphicsDescs, const std::vector<ComputePipelineDesc>& computeDescs)
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
 
-		_GraphicsPipelineCache[crc] = pipeline;
-		_CrcToGraphicsPipelineDesc[crc] = graphicsDesc;
+	struct PendingPipeline
+	{
+		GraphicsPipelineKey graphicsKey;
+		ComputePipelineKey computeKey;
+		VkPipelineLayout pipelineLayout;
+		VkPipeline pipeline;
+	};
+
+	// Keys and layouts are looked up serially. Only the pipelines themselves are created in parallel.
+	std::vector<PendingPipeline> pendingPipelines;
+	std::unordered_set<uint32> pendingGraphics;
+	std::unordered_set<uint32> pendingCompute;
+
+	for (const GraphicsPipelineDesc& graphicsDesc : graphicsDescs)
+	{
+		const GraphicsPipelineKey graphicsKey = GetPipelineKey(graphicsDesc);
 
-		return pipeline;
+		if (!_GraphicsPipelines[graphicsKey.GetIndex()].pipeline.IsValid() && pendingGraphics.insert(graphicsKey.GetIndex()).second)
+		{
+			pendingPipelines.push_back({ graphicsKey, {}, GetOrCreatePipelineLayout(graphicsDesc), VK_NULL_HANDLE });
+		}
 	}
-	else
+
+	for (const ComputePipelineDesc& computeDesc : computeDescs)
+	{
+		const ComputePipelineKey computeKey = GetPipelineKey(computeDesc);
+
+		if (!_ComputePipelines[computeKey.GetIndex()].pipeline.IsValid() && pendingCompute.insert(computeKey.GetIndex()).second)
+		{
+			pendingPipelines.push_back({ {}, computeKey, GetOrCreatePipelineLayout(computeDesc), VK_NULL_HANDLE });
+		}
+	}
+
+	if (pendingPipelines.empty())
+	{
+		return;
+	}
+
+	// The pipeline cache is internally synchronized. Nothing is interned while the jobs run, so the entries don't move.
+	JobSystem::Get().ParallelFor(pendingPipelines.size(), [&] (std::size_t pipelineIndex)
 	{
-		return iter->second;
+		PendingPipeline& pending = pendingPipelines[pipelineIndex];
+
+		pending.pipeline = pending.graphicsKey.IsValid() ? 
+			CreatePipeline(_GraphicsPipelines[pending.graphicsKey.GetIndex()].desc, pending.pipelineLayout) : 
+			CreatePipeline(_ComputePipelines[pending.computeKey.GetIndex()].desc, pending.pipelineLayout);
+	}, 1);
+
+	for (const PendingPipeline& pending : pendingPipelines)
+	{
+		if (pending.graphicsKey.IsValid())
+		{
+			_GraphicsPipelines[pending.graphicsKey.GetIndex()].pipeline = 
+				gpu::Pipeline(std::make_shared<VkPipeline>(pending.pipeline), pending.pipelineLayout, VK_PIPELINE_BIND_POINT_GRAPHICS);
+		}
+		else
+		{
+			_ComputePipelines[pending.computeKey.GetIndex()].pipeline = 
+				gpu::Pipeline(std::make_shared<VkPipeline>(pending.pipeline), pending.pipelineLayout, VK_PIPELINE_BIND_POINT_COMPUTE);
+		}
 	}
+
+	const float warmUpMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	LOG("Warmed up %zu pipelines in %.1f ms.", pendingPipelines.size(), warmUpMs);
 }
 
-gpu::Pipeline VulkanDevice::CreatePipeline(const ComputePipelineDesc& computeDesc)
+PipelineKeyBenchmark VulkanDevice::MeasurePipelineKeys(uint32 numIterations)
 {
-	const uint64 shader = *reinterpret_cast<uint64*>(computeDesc.shader->compilationResult.shaderModule);
+	PipelineKeyBenchmark benchmark = {};
 
-	Crc crc = 0;
-	Platform::crc32_u32(crc, &shader, sizeof(shader));
-	Platform::crc32_u32(crc, computeDesc.specInfo.GetMapEntries().data(), computeDesc.specInfo.GetMapEntries().size() * sizeof(computeDesc.specInfo.GetMapEntries()[0]));
-	Platform::crc32_u8(crc, computeDesc.specInfo.GetData().data(), computeDesc.specInfo.GetData().size());
-
-	if (auto iter = _ComputePipelineCache.find(crc); iter == _ComputePipelineCache.end())
+	auto measureNs = [&] (auto&& function)
 	{
-		std::vector<VkDescriptorSetLayout> layouts;
-		layouts.reserve(computeDesc.shader->compilationResult.layouts.size());
-		for (auto& [set, layout] : computeDesc.shader->compilationResult.layouts)
+		const auto startTime = std::chrono::high_resolution_clock::now();
+
+		for (uint32 iteration = 0; iteration < numIterations; iteration++)
 		{
-			layouts.push_back(layout);
+			function();
 		}
 
-		const auto& pushConstantRange = computeDesc.shader->compilationResult.pushConstantRange;
-		const auto pushConstantRanges = pushConstantRange.size > 0 ? std::vector{ pushConstantRange } : std::vector<VkPushConstantRange>{};
+		return std::chrono::duration<float, std::nano>(std::chrono::high_resolution_clock::now() - startTime).count() / numIterations;
+	};
 
-		const VkPipelineLayout pipelineLayout = GetOrCreatePipelineLayout(layouts, pushConstantRanges);
-		const gpu::Pipeline pipeline = gpu::Pipeline(std::make_shared<VkPipeline>(CreatePipeline(computeDesc, pipelineLayout)), pipelineLayout, VK_PIPELINE_BIND_POINT_COMPUTE);
+	// Look up the first pipeline that was created, which is as large as any pass's.
+	if (auto iter = std::find_if(_GraphicsPipelines.begin(), _GraphicsPipelines.end(), [] (const auto& entry) { return entry.pipeline.IsValid(); });
+		iter != _GraphicsPipelines.end())
+	{
+		const GraphicsPipelineDesc graphicsDesc = iter->desc;
+		const GraphicsPipelineKey graphicsKey = GetPipelineKey(graphicsDesc);
 
-		_ComputePipelineCache[crc] = pipeline;
-		_CrcToComputeDesc[crc] = computeDesc;
+		volatile VkPipeline sink = VK_NULL_HANDLE;
 
-		return pipeline;
+		benchmark.descLookupNs = measureNs([&] () { sink = CreatePipeline(GetPipelineKey(graphicsDesc)).GetPipeline(); });
+		benchmark.keyLookupNs = measureNs([&] () { sink = CreatePipeline(graphicsKey).GetPipeline(); });
 	}
-	else
+
+	// Large enough that the loop dominates, small enough to stay in cache.
+	std::vector<uint8> bytes(64 * 1024);
+
+	for (std::size_t i = 0; i < bytes.size(); i++)
 	{
-		return iter->second;
+		bytes[i] = static_cast<uint8>(i * 131);
 	}
+
+	volatile uint64 hashSink = 0;
+
+	const float hash64Ns = measureNs([&] () { hashSink = Platform::Hash64(bytes.data(), bytes.size()); });
+	const float crc32u8Ns = measureNs([&] () { Crc crc = 0; Platform::crc32_u8(crc, bytes.data(), bytes.size()); hashSink = crc; });
+
+	// Bytes per nanosecond are GB/s.
+	benchmark.hash64GBps = bytes.size() / hash64Ns;
+	benchmark.crc32u8GBps = bytes.size() / crc32u8Ns;
+
+	return benchmark;
+}
+
+std::vector<ResourceCacheStats> VulkanDevice::GetResourceCacheStats()
+{
+	std::lock_guard lock(_DescriptorSetLayoutMutex);
+
+	return
+	{
+		_GraphicsPipelineIndices.GetStats(),
+		_ComputePipelineIndices.GetStats(),
+		_RenderPassCache.GetStats(),
+		_PipelineLayoutCache.GetStats(),
+		_DescriptorSetLayoutCache.GetStats(),
+		_SamplerCache.GetStats(),
+	};
 }
 
 gpu::Buffer VulkanDevice::CreateBuffer(EBufferUsage bufferUsage, EMemoryUsage memoryUsage, uint64 size, const void* data)
@@ -179,7 +528,9 @@ gpu::Buffer VulkanDevice::CreateBuffer(EBufferUsage bufferUsage, EMemoryUsage me
 		.flags = 0,
 		.size = size,
 		.usage = usage,
-		.sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+		.sharingMode = IsConcurrent(memoryUsage) ? VK_SHARING_MODE_CONCURRENT : VK_SHARING_MODE_EXCLUSIVE,
+		.queueFamilyIndexCount = IsConcurrent(memoryUsage) ? static_cast<uint32>(_ConcurrentQueueFamilies.size()) : 0,
+		.pQueueFamilyIndices = IsConcurrent(memoryUsage) ? _ConcurrentQueueFamilies.data() : nullptr,
 	};
 
 	VkBuffer buffer;
@@ -188,7 +539,7 @@ gpu::Buffer VulkanDevice::CreateBuffer(EBufferUsage bufferUsage, EMemoryUsage me
 	
 	vulkan( vmaCreateBuffer(_Allocator, &bufferInfo, &allocInfo, &buffer, &allocation, &allocationInfo) );
 
-	gpu::Buffer newBuffer(_Allocator, buffer, allocation, allocationInfo, size, bufferUsage);
+	gpu::Buffer newBuffer(*this, buffer, allocation, allocationInfo, size, bufferUsage);
 
 	if (data)
 	{
@@ -198,17 +549,30 @@ gpu::Buffer VulkanDevice::CreateBuffer(EBufferUsage bufferUsage, EMemoryUsage me
 	return newBuffer;
 }
 
-gpu::Image VulkanDevice::CreateImage(
+gpu::UploadAllocation VulkanDevice::AllocateUpload(uint64 size, const void* data, uint64 alignment)
+{
+	gpu::UploadAllocation allocation = _UploadRing->Allocate(size, alignment);
+
+	if (data)
+	{
+		Platform::Memcpy(allocation.data, data, size);
+	}
+
+	return allocation;
+}
+
+static VkImageCreateInfo GetImageCreateInfo(
+	VulkanDevice& device,
 	uint32 width,
 	uint32 height,
 	uint32 depth,
-	EFormat format,
+	EFormat& format,
 	EImageUsage imageUsage,
 	uint32 mipLevels)
 {
 	if (gpu::Image::IsDepth(format))
 	{
-		format = gpu::Image::GetEngineFormat(gpu::Image::FindSupportedDepthFormat(*this, format));
+		format = gpu::Image::GetEngineFormat(gpu::Image::FindSupportedDepthFormat(device, format));
 	}
 
 	VkImageCreateInfo imageInfo = { VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
@@ -241,6 +605,39 @@ gpu::Image VulkanDevice::CreateImage(
 	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
+	if (device.IsConcurrent(imageUsage))
+	{
+		imageInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		imageInfo.queueFamilyIndexCount = static_cast<uint32>(device.GetConcurrentQueueFamilies().size());
+		imageInfo.pQueueFamilyIndices = device.GetConcurrentQueueFamilies().data();
+	}
+
+	return imageInfo;
+}
+
+bool VulkanDevice::IsConcurrent(EImageUsage imageUsage) const
+{
+	return !_ConcurrentQueueFamilies.empty()
+		&& Any(imageUsage & EImageUsage::Sampled)
+		&& Any(imageUsage & EImageUsage::TransferDst)
+		&& !Any(imageUsage & (EImageUsage::Attachment | EImageUsage::Storage));
+}
+
+bool VulkanDevice::IsConcurrent(EMemoryUsage memoryUsage) const
+{
+	return !_ConcurrentQueueFamilies.empty() && memoryUsage == EMemoryUsage::CPU_TO_GPU;
+}
+
+gpu::Image VulkanDevice::CreateImage(
+	uint32 width,
+	uint32 height,
+	uint32 depth,
+	EFormat format,
+	EImageUsage imageUsage,
+	uint32 mipLevels)
+{
+	const VkImageCreateInfo imageInfo = GetImageCreateInfo(*this, width, height, depth, format, imageUsage, mipLevels);
+
 	VmaAllocationCreateInfo allocInfo = {};
 	allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
@@ -265,6 +662,75 @@ gpu::Image VulkanDevice::CreateImage(
 	);
 }
 
+gpu::MemoryRequirements VulkanDevice::GetImageMemoryRequirements(
+	uint32 width,
+	uint32 height,
+	uint32 depth,
+	EFormat format,
+	EImageUsage imageUsage,
+	uint32 mipLevels)
+{
+	const VkImageCreateInfo imageInfo = GetImageCreateInfo(*this, width, height, depth, format, imageUsage, mipLevels);
+
+	// Requirements can only be queried from an image, so create one without memory.
+	VkImage image;
+	vulkan( vkCreateImage(_Device, &imageInfo, nullptr, &image) );
+
+	VkMemoryRequirements memReqs;
+	vkGetImageMemoryRequirements(_Device, image, &memReqs);
+
+	vkDestroyImage(_Device, image, nullptr);
+
+	return gpu::MemoryRequirements{ memReqs.size, memReqs.alignment, memReqs.memoryTypeBits };
+}
+
+gpu::MemoryBlock VulkanDevice::AllocateMemory(const gpu::MemoryRequirements& memReqs)
+{
+	const VkMemoryRequirements vulkanMemReqs = { memReqs.size, memReqs.alignment, memReqs.memoryTypeBits };
+
+	VmaAllocationCreateInfo allocInfo = {};
+	allocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+	allocInfo.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+
+	VmaAllocation allocation;
+	vulkan( vmaAllocateMemory(_Allocator, &vulkanMemReqs, &allocInfo, &allocation, nullptr) );
+
+	return gpu::MemoryBlock(_Allocator, allocation, memReqs.size);
+}
+
+gpu::Image VulkanDevice::CreateImage(
+	const gpu::MemoryBlock& memory,
+	uint64 offset,
+	uint32 width,
+	uint32 height,
+	uint32 depth,
+	EFormat format,
+	EImageUsage imageUsage,
+	uint32 mipLevels)
+{
+	const VkImageCreateInfo imageInfo = GetImageCreateInfo(*this, width, height, depth, format, imageUsage, mipLevels);
+
+	VkImage image;
+	vulkan( vkCreateImage(_Device, &imageInfo, nullptr, &image) );
+
+	vulkan( vmaBindImageMemory2(_Allocator, memory.GetAllocation(), offset, image, nullptr) );
+
+	// The image doesn't own its memory, so destroying it leaves the block intact.
+	return gpu::Image(
+		*this
+		, _Allocator
+		, nullptr
+		, {}
+		, image
+		, format
+		, width
+		, height
+		, depth
+		, imageUsage
+		, mipLevels
+	);
+}
+
 gpu::ImageView VulkanDevice::CreateImageView(
 	const gpu::Image& image, 
 	uint32 baseMipLevel, 
@@ -291,19 +757,17 @@ gpu::ImageView VulkanDevice::CreateImageView(
 
 gpu::Sampler VulkanDevice::CreateSampler(const SamplerDesc& samplerDesc)
 {
-	Crc crc = 0;
-	Platform::crc32_u32(crc, &samplerDesc, sizeof(samplerDesc));
+	thread_local std::string keyBytes;
+	keyBytes.clear();
+	AppendKeyBytes(keyBytes, samplerDesc);
 
-	if (auto iter = _SamplerCache.find(crc); iter == _SamplerCache.end())
-	{
-		// Cache miss... Create a new sampler.
-		const auto sampler = _SamplerCache.emplace(crc, gpu::Sampler(*this, samplerDesc));
-		return sampler.first->second;
-	}
-	else
+	if (const gpu::Sampler* sampler = _SamplerCache.Find(keyBytes, _FrameNumber))
 	{
-		return iter->second;
+		return *sampler;
 	}
+
+	// Cache miss... Create a new sampler.
+	return _SamplerCache.Add(keyBytes, gpu::Sampler(*this, samplerDesc), _FrameNumber);
 }
 
 gpu::RenderPass VulkanDevice::CreateRenderPass(const RenderPassDesc& rpDesc)
@@ -421,10 +885,16 @@ void VulkanDevice::CreateDescriptorSetLayout(
 		descriptorUpdateTemplateEntries.push_back(descriptorUpdateTemplateEntry);
 	}
 
-	Crc crc = 0;
-	Platform::crc32_u32(crc, bindings, numBindings * sizeof(bindings[0]));
+	thread_local std::string keyBytes;
+	keyBytes.assign(reinterpret_cast<const char*>(bindings), numBindings * sizeof(bindings[0]));
+
+	std::lock_guard lock(_DescriptorSetLayoutMutex);
 
-	if (auto iter = _DescriptorSetLayoutCache.find(crc); iter == _DescriptorSetLayoutCache.end())
+	if (const auto* cached = _DescriptorSetLayoutCache.Find(keyBytes, _FrameNumber))
+	{
+		std::tie(descriptorSetLayout, descriptorUpdateTemplate) = *cached;
+	}
+	else
 	{
 		// Cache miss... Create a new descriptor set layout.
 		const VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo = 
@@ -447,27 +917,41 @@ void VulkanDevice::CreateDescriptorSetLayout(
 
 		_VkCreateDescriptorUpdateTemplateKHR(_Device, &descriptorUpdateTemplateInfo, nullptr, &descriptorUpdateTemplate);
 
-		_DescriptorSetLayoutCache[crc] = { descriptorSetLayout, descriptorUpdateTemplate };
-	}
-	else
-	{
-		std::tie(descriptorSetLayout, descriptorUpdateTemplate) = iter->second;
+		_DescriptorSetLayoutCache.Add(keyBytes, { descriptorSetLayout, descriptorUpdateTemplate }, _FrameNumber);
 	}
 }
 
-void VulkanDevice::RecompilePipelines()
+std::size_t VulkanDevice::RecompilePipelines(const std::unordered_set<const gpu::Shader*>& shaders)
 {
-	for (auto& [crc, pipeline] : _GraphicsPipelineCache)
+	WaitIdle();
+
+	std::size_t numPipelines = 0;
+
+	for (GraphicsPipelineEntry& entry : _GraphicsPipelines)
 	{
-		vkDestroyPipeline(_Device, *pipeline._Pipeline, nullptr);
-		*pipeline._Pipeline = CreatePipeline(_CrcToGraphicsPipelineDesc[crc], pipeline._PipelineLayout);
+		gpu::Pipeline& pipeline = entry.pipeline;
+
+		if (pipeline.IsValid() && std::any_of(shaders.begin(), shaders.end(), [&] (const gpu::Shader* shader) { return entry.desc.HasShader(shader); }))
+		{
+			vkDestroyPipeline(_Device, *pipeline._Pipeline, nullptr);
+			*pipeline._Pipeline = CreatePipeline(entry.desc, pipeline._PipelineLayout);
+			numPipelines++;
+		}
 	}
 
-	for (auto& [crc, pipeline] : _ComputePipelineCache)
+	for (ComputePipelineEntry& entry : _ComputePipelines)
 	{
-		vkDestroyPipeline(_Device, *pipeline._Pipeline, nullptr);
-		*pipeline._Pipeline = CreatePipeline(_CrcToComputeDesc[crc], pipeline._PipelineLayout);
+		gpu::Pipeline& pipeline = entry.pipeline;
+
+		if (pipeline.IsValid() && shaders.contains(entry.desc.shader))
+		{
+			vkDestroyPipeline(_Device, *pipeline._Pipeline, nullptr);
+			*pipeline._Pipeline = CreatePipeline(entry.desc, pipeline._PipelineLayout);
+			numPipelines++;
+		}
 	}
+
+	return numPipelines;
 }
 
 const char* VulkanDevice::GetErrorString(VkResult result)
@@ -4,13 +4,23 @@
 #include "VulkanRenderPass.h"
 #include "VulkanCommandBuffer.h"
 #include "VulkanBindlessDescriptors.h"
+#include "VulkanUploadRing.h"
+#include "VulkanUploadService.h"
+#include "VulkanTimestampQueries.h"
+#include "VulkanPipelineCompiler.h"
+#include "VulkanResourceCache.h"
 #include "vk_mem_alloc.h"
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
 
 class VulkanInstance;
 class VulkanPhysicalDevice;
 
 class VulkanDevice final : public gpu::Device
 {
+	friend class VulkanPipelineCompiler;
 public:
 	VulkanDevice(VulkanInstance& instance, VulkanPhysicalDevice& physicalDevice, std::vector<uint32> queueFamilyIndices);
 
@@ -18,6 +28,12 @@ public:
 
 	void EndFrame() override;
 
+	void WaitIdle() override;
+
+	inline uint32 GetFrameIndex() const override { return _FrameIndex; }
+
+	inline uint32 GetNumFramesInFlight() const override { return _NumFramesInFlight; }
+
 	void SubmitCommands(gpu::CommandBuffer& cmdBuf) override;
 
 	void SubmitCommands(
@@ -26,14 +42,65 @@ public:
 		const gpu::Semaphore& signalSemaphore
 	) override;
 
+	void SubmitCommands(
+		gpu::CommandBuffer& cmdBuf,
+		EQueue waitQueue,
+		const gpu::Semaphore& waitSemaphore,
+		const gpu::Semaphore& signalSemaphore
+	) override;
+
+	inline bool HasAsyncCompute() const override { return _ComputeQueue.GetQueueFamilyIndex() != -1; }
+
 	gpu::CommandBuffer CreateCommandBuffer(EQueue queue) override;
 
-	gpu::Pipeline CreatePipeline(const GraphicsPipelineDesc& graphicsDesc) override;
+	GraphicsPipelineKey GetPipelineKey(const GraphicsPipelineDesc& graphicsDesc) override;
+
+	ComputePipelineKey GetPipelineKey(const ComputePipelineDesc& computeDesc) override;
+
+	inline const GraphicsPipelineDesc& GetPipelineDesc(GraphicsPipelineKey graphicsKey) const override { return _GraphicsPipelines[graphicsKey.GetIndex()].desc; }
 
-	gpu::Pipeline CreatePipeline(const ComputePipelineDesc& computeDesc) override;
+	using gpu::Device::CreatePipeline;
+
+	gpu::Pipeline CreatePipeline(GraphicsPipelineKey graphicsKey) override;
+
+	gpu::Pipeline CreatePipeline(ComputePipelineKey computeKey) override;
+
+	using gpu::Device::CreatePipelineAsync;
+
+	gpu::Pipeline CreatePipelineAsync(GraphicsPipelineKey graphicsKey) override;
+
+	PipelineKeyBenchmark MeasurePipelineKeys(uint32 numIterations) override;
+
+	std::vector<ResourceCacheStats> GetResourceCacheStats() override;
+
+	void WarmUpPipelines(const std::vector<GraphicsPipelineDesc>& graphicsDescs, const std::vector<ComputePipelineDesc>& computeDescs) override;
 
 	gpu::Buffer CreateBuffer(EBufferUsage bufferUsage, EMemoryUsage memoryUsage, uint64 size, const void* data = nullptr) override;
 
+	gpu::UploadAllocation AllocateUpload(uint64 size, const void* data = nullptr, uint64 alignment = 0) override;
+
+	inline const gpu::Buffer& GetUploadBuffer() const override { return _UploadRing->GetBuffer(); }
+
+	inline gpu::UploadTicket UploadBufferData(const gpu::Buffer& dstBuffer, uint64 dstOffset, uint64 size, const void* data) override
+	{
+		return _UploadService->UploadBufferData(dstBuffer, dstOffset, size, data);
+	}
+
+	inline gpu::UploadTicket UploadImageData(const gpu::Image& dstImage, const void* srcPixels) override
+	{
+		return _UploadService->UploadImageData(dstImage, srcPixels);
+	}
+
+	inline void WaitForUpload(gpu::UploadTicket ticket) override { _UploadService->WaitForUpload(ticket); }
+
+	inline bool IsUploadComplete(gpu::UploadTicket ticket) const override { return _UploadService->IsComplete(ticket); }
+
+	inline void FlushUploads() override { _UploadService->Flush(); }
+
+	inline uint32 WriteTimestamp(gpu::CommandBuffer& cmdBuf) override { return _TimestampQueries->Write(cmdBuf); }
+
+	inline const std::vector<double>& GetCompletedTimestamps() const override { return _TimestampQueries->GetCompletedTimestamps(); }
+
 	gpu::Image CreateImage(
 		uint32 width,
 		uint32 height,
@@ -43,6 +110,28 @@ public:
 		uint32 mipLevels
 	) override;
 
+	gpu::MemoryRequirements GetImageMemoryRequirements(
+		uint32 width,
+		uint32 height,
+		uint32 depth,
+		EFormat format,
+		EImageUsage imageUsage,
+		uint32 mipLevels
+	) override;
+
+	gpu::MemoryBlock AllocateMemory(const gpu::MemoryRequirements& memReqs) override;
+
+	gpu::Image CreateImage(
+		const gpu::MemoryBlock& memory,
+		uint64 offset,
+		uint32 width,
+		uint32 height,
+		uint32 depth,
+		EFormat format,
+		EImageUsage imageUsage,
+		uint32 mipLevels
+	) override;
+
 	gpu::ImageView CreateImageView(
 		const gpu::Image& image, 
 		uint32 baseMipLevel, 
@@ -57,12 +146,40 @@ public:
 
 	VkDescriptorSet& GetTextures() override;
 
+	inline gpu::TextureID CreateTextureID(const gpu::Image& image, const gpu::Sampler& sampler) override
+	{
+		return _BindlessTextures->CreateTextureID(image, sampler);
+	}
+
+	inline void UpdateTextureID(gpu::TextureID textureID, const gpu::Image& image, const gpu::Sampler& sampler) override
+	{
+		_BindlessTextures->UpdateTextureID(textureID, image, sampler);
+	}
+
+	inline void ReleaseTextureID(gpu::TextureID textureID) override { _BindlessTextures->Release(textureID); }
+
 	VkDescriptorSet& GetImages() override;
 
 	gpu::Semaphore CreateSemaphore() override;
 
+	/** Recompile the shaders whose files or includes were written since they were compiled. */
 	void RecompileShaders() override;
 
+	/** Recompile the shaders that are compiled from, or include, any of the files. */
+	void RecompileShaders(const std::vector<std::filesystem::path>& changedFiles);
+
+	/** Recompile shaders and the pipelines that use them. */
+	void RecompileShaders(const std::unordered_set<const gpu::Shader*>& shaders);
+
+	/**
+	  * Compile shaders on the job system, each worker with its own compiler, and set their compilation results.
+	  * Shaders in the shader cache are loaded instead.
+	  */
+	void CompileShaders(const std::vector<ShaderCompilationTask>& tasks, const ShaderCompilationProgress& progress = {});
+
+	/** Compile every registered shader into the shader cache, so shipping builds start without compiling. Doesn't need a device. */
+	static void CookShaders();
+
 	void UpdateDescriptorSet(
 		VkDescriptorSet descriptorSet, 
 		VkDescriptorUpdateTemplate descriptorUpdateTemplate, 
@@ -74,8 +191,29 @@ public:
 		VkDescriptorSetLayout& descriptorSetLayout,
 		VkDescriptorUpdateTemplate& descriptorUpdateTemplate);
 
-	/** Recompile all pipelines. */
-	void RecompilePipelines();
+	/** Recompile the pipelines that use any of the shaders. Returns how many were recompiled. */
+	std::size_t RecompilePipelines(const std::unordered_set<const gpu::Shader*>& shaders);
+
+	/** Wait for the pipelines being created in the background and add them to the cache. */
+	void FlushPipelineCompiler();
+
+	/**
+	  * Whether images with the usage are shared concurrently by the graphics, compute and transfer families.
+	  * Uploaded textures are, since async compute samples them through bindless descriptors the frame graph doesn't see.
+	  */
+	bool IsConcurrent(EImageUsage imageUsage) const;
+
+	/** Whether buffers in the memory are shared concurrently. Host-written buffers are, e.g. the upload ring that async compute reads. */
+	bool IsConcurrent(EMemoryUsage memoryUsage) const;
+
+	/** Empty unless async compute has a family of its own. */
+	inline const std::vector<uint32>& GetConcurrentQueueFamilies() const { return _ConcurrentQueueFamilies; }
+
+	/** Destroy the buffer once the frames that may reference it have completed. */
+	void ReleaseBuffer(VkBuffer buffer, VmaAllocation allocation);
+
+	/** Destroy the framebuffer, and drop its reference to the cached render pass, once the frames that may reference it have completed. */
+	void ReleaseRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer);
 
 	operator VkDevice() const { return _Device; }
 
@@ -84,6 +222,7 @@ public:
 	inline VmaAllocator GetAllocator() const { return _Allocator; }
 	inline VulkanQueue& GetGraphicsQueue() { return _GraphicsQueue; }
 	inline VulkanQueue& GetTransferQueue() { return _TransferQueue; }
+	VulkanQueue& GetQueue(EQueue queue);
 	inline VkDescriptorPool& GetDescriptorPool() { return _DescriptorPool; }
 	
 	static inline VkAccessFlags GetAccessFlags(EAccess access) 
@@ -115,33 +254,119 @@ private:
 
 	VulkanQueue _GraphicsQueue;
 
+	VulkanQueue _ComputeQueue;
+
 	VulkanQueue _TransferQueue;
 
 	VkDevice _Device;
 
 	VkDescriptorPool _DescriptorPool;
 
+	/** Number of frames the CPU may record ahead of the GPU. */
+	uint32 _NumFramesInFlight;
+
+	/** Graphics, compute and transfer families, if async compute has a family of its own. */
+	std::vector<uint32> _ConcurrentQueueFamilies;
+
+	/** Index of the current frame in the frames-in-flight ring. */
+	uint32 _FrameIndex = 0;
+
+	/** Frames ended since the device was created. Caches stamp their entries with it. */
+	uint64 _FrameNumber = 0;
+
+	/** Persistently mapped ring for per-frame uniform, storage, vertex and index data. */
+	std::unique_ptr<VulkanUploadRing> _UploadRing;
+
+	/** Copies asset data on the transfer queue through a persistent staging ring. */
+	std::unique_ptr<VulkanUploadService> _UploadService;
+
+	std::unique_ptr<VulkanTimestampQueries> _TimestampQueries;
+
+	/** Buffers released during each frame in flight. */
+	std::vector<std::vector<std::pair<VkBuffer, VmaAllocation>>> _ReleasedBuffers;
+
+	/** Render passes and their framebuffers released during each frame in flight. */
+	std::vector<std::vector<std::pair<VkRenderPass, VkFramebuffer>>> _ReleasedRenderPasses;
+
 	PFN_vkCreateDescriptorUpdateTemplateKHR _VkCreateDescriptorUpdateTemplateKHR;
 
 	PFN_vkUpdateDescriptorSetWithTemplateKHR _VkUpdateDescriptorSetWithTemplateKHR;
 
 	/** Vulkan Resource Caches */
 
-	std::unordered_map<Crc, VkRenderPass> _RenderPassCache;
+	/** Bounded by RenderPassCacheSize in Engine.ini. */
+	VulkanResourceCache<VkRenderPass> _RenderPassCache{ "Render passes" };
+
+	/** Live gpu::RenderPasses, and the frames in flight, using each cached render pass. Referenced render passes aren't evicted. */
+	std::unordered_map<VkRenderPass, uint32> _RenderPassReferences;
+
+	/** An interned pipeline description, and its pipeline once it's created. */
+	template<typename PipelineDescType>
+	struct PipelineEntry
+	{
+		PipelineDescType desc;
+		gpu::Pipeline pipeline;
+		/** Queued on the pipeline compiler. */
+		bool isPending = false;
+		/** Its render pass was evicted. The pipeline is destroyed with the render pass, and the key mustn't be used again. */
+		bool isRetired = false;
+	};
+
+	using GraphicsPipelineEntry = PipelineEntry<GraphicsPipelineDesc>;
+	using ComputePipelineEntry = PipelineEntry<ComputePipelineDesc>;
+
+	/** Indexed by pipeline key. Entries are never removed, so keys stay valid. */
+	std::vector<GraphicsPipelineEntry> _GraphicsPipelines;
+
+	std::vector<ComputePipelineEntry> _ComputePipelines;
+
+	/** An evicted render pass and the pipelines created against it, destroyed once the graphics timeline reaches timelineValue. */
+	struct RetiredRenderPass
+	{
+		VkRenderPass renderPass;
+		std::vector<std::shared_ptr<VkPipeline>> pipelines;
+		uint64 timelineValue;
+	};
+
+	std::deque<RetiredRenderPass> _RetiredRenderPasses;
+
+	/** Maps the key bytes of each interned description to its key. */
+	VulkanResourceCache<uint32> _GraphicsPipelineIndices{ "Graphics pipelines" };
+
+	VulkanResourceCache<uint32> _ComputePipelineIndices{ "Compute pipelines" };
+
+	/** Pipelines keep their layouts, and shaders their descriptor set layouts, so neither cache evicts. */
+	VulkanResourceCache<VkPipelineLayout> _PipelineLayoutCache{ "Pipeline layouts" };
+
+	VulkanResourceCache<std::pair<VkDescriptorSetLayout, VkDescriptorUpdateTemplate>> _DescriptorSetLayoutCache{ "Descriptor set layouts" };
+
+	/** Shaders are compiled in parallel, and create their descriptor set layouts as they finish. */
+	std::mutex _DescriptorSetLayoutMutex;
+
+	/** Samplers are copied into descriptors and bindless textures without being released, so the cache doesn't evict. */
+	VulkanResourceCache<gpu::Sampler> _SamplerCache{ "Samplers" };
+
+	/** Driver cache of compiled pipelines, saved to disk on shutdown. */
+	VkPipelineCache _PipelineCache = VK_NULL_HANDLE;
 
-	std::unordered_map<Crc, gpu::Pipeline> _GraphicsPipelineCache;
+	/** Pipelines created on demand while recording the current frame, reported as a hitch at the end of the frame. */
+	uint32 _NumPipelinesCreatedThisFrame = 0;
+	float _PipelineCreationMsThisFrame = 0.0f;
 
-	std::unordered_map<Crc, GraphicsPipelineDesc> _CrcToGraphicsPipelineDesc;
+	/** Creates pipelines requested with CreatePipelineAsync(). Null if AsyncPipelines is off in Engine.ini. */
+	std::unique_ptr<VulkanPipelineCompiler> _PipelineCompiler;
 
-	std::unordered_map<Crc, gpu::Pipeline> _ComputePipelineCache;
 
-	std::unordered_map<Crc, ComputePipelineDesc> _CrcToComputeDesc;
+	/** Maps each shader file and include, by generic path, to the shaders compiled from it. */
+	std::unordered_map<std::string, std::vector<const gpu::Shader*>> _ShaderDependents;
 
-	std::unordered_map<Crc, VkPipelineLayout> _PipelineLayoutCache;
+	/** Watches ../Shaders so edited shaders are recompiled at the end of the frame. Null if ShaderHotReload is off in Engine.ini. */
+	std::unique_ptr<DirectoryWatcher> _ShaderWatcher;
 
-	std::unordered_map<Crc, std::pair<VkDescriptorSetLayout, VkDescriptorUpdateTemplate>> _DescriptorSetLayoutCache;
+	void UpdateShaderDependents();
 
-	std::unordered_map<Crc, gpu::Sampler> _SamplerCache;
+	/** Shaders compiled rather than loaded from the shader cache. */
+	std::atomic<uint32> _NumShadersCompiled = 0;
 
 	ShaderCompilationResult CompileShader(
 		const ShaderCompilerWorker& worker,
@@ -157,6 +382,20 @@ private:
 	VkPipelineLayout GetOrCreatePipelineLayout(
 		const std::vector<VkDescriptorSetLayout>& Layouts,
 		const std::vector<VkPushConstantRange>& PushConstantRanges);
+	VkPipelineLayout GetOrCreatePipelineLayout(const GraphicsPipelineDesc& graphicsDesc);
+	VkPipelineLayout GetOrCreatePipelineLayout(const ComputePipelineDesc& computeDesc);
+	static const std::string& GetPipelineKeyBytes(const GraphicsPipelineDesc& graphicsDesc);
+	static const std::string& GetPipelineKeyBytes(const ComputePipelineDesc& computeDesc);
+
+	/** Evict render passes beyond RenderPassCacheSize that nothing references, and retire the pipeline descriptions that use them. */
+	void EvictRenderPasses();
+	void DestroyRetiredRenderPass(RetiredRenderPass& retired);
+
+	/** Load the pipeline cache from disk. It's ignored if it was saved by another driver or device. */
+	void CreatePipelineCache();
+	void CollectCompiledPipelines();
+	void SavePipelineCache();
+	static std::filesystem::path GetPipelineCachePath();
 };
 
 #define vulkan(result) \
@@ -1,7 +1,9 @@
 #include "VulkanDevice.h"
 #include "VulkanInstance.h"
 #include "VulkanPhysicalDevice.h"
+#include <Engine/JobSystem.h>
 #include <unordered_set>
+#include <chrono>
 
 const std::vector<const char*>& VulkanDevice::GetRequiredExtensions()
 {
@@ -24,13 +26,13 @@ VulkanDevice::VulkanDevice(VulkanInstance& instance, VulkanPhysicalDevice& physi
 	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
 	vkGetPhysicalDeviceQueueFamilyProperties(_PhysicalDevice, &queueFamilyCount, queueFamilies.data());
 
-	auto getQueueFamilyIndex = [&queueFamilies] (VkQueueFlags queueFlags)
+	auto getQueueFamilyIndex = [&queueFamilies] (VkQueueFlags queueFlags, VkQueueFlags excludedQueueFlags)
 	{
 		int32 queueFamilyIndex = 0;
 
 		for (auto& queueFamily : queueFamilies)
 		{
-			if (queueFamily.queueCount > 0 && queueFamily.queueFlags & queueFlags)
+			if (queueFamily.queueCount > 0 && (queueFamily.queueFlags & queueFlags) == queueFlags && !(queueFamily.queueFlags & excludedQueueFlags))
 			{
 				queueFamily.queueCount = 0;
 				return queueFamilyIndex;
@@ -42,9 +44,13 @@ VulkanDevice::VulkanDevice(VulkanInstance& instance, VulkanPhysicalDevice& physi
 		return -1;
 	};
 
-	const int32 graphicsIndex = getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT);
+	const int32 graphicsIndex = getQueueFamilyIndex(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0);
 
-	int32 transferIndex = getQueueFamilyIndex(VK_QUEUE_TRANSFER_BIT);
+	// Async compute needs a family without graphics, or its work would be serialized with the graphics queue's.
+	const int32 computeIndex = Platform::GetBool("Engine.ini", "Renderer", "AsyncCompute", true) ? 
+		getQueueFamilyIndex(VK_QUEUE_COMPUTE_BIT, VK_QUEUE_GRAPHICS_BIT) : -1;
+
+	int32 transferIndex = getQueueFamilyIndex(VK_QUEUE_TRANSFER_BIT, 0);
 
 	if (transferIndex == -1)
 	{
@@ -52,6 +58,11 @@ VulkanDevice::VulkanDevice(VulkanInstance& instance, VulkanPhysicalDevice& physi
 	}
 
 	std::unordered_set<int32> uniqueQueueFamilies = { graphicsIndex, transferIndex };
+	if (computeIndex != -1)
+	{
+		uniqueQueueFamilies.insert(computeIndex);
+	}
+
 	for (auto queueFamilyIndex : queueFamilyIndices)
 	{
 		uniqueQueueFamilies.insert(queueFamilyIndex);
@@ -72,9 +83,12 @@ VulkanDevice::VulkanDevice(VulkanInstance& instance, VulkanPhysicalDevice& physi
 	const VkPhysicalDeviceFeatures physicalDeviceFeatures =
 	{
 		.geometryShader = true,
+		.multiDrawIndirect = true,
 		.samplerAnisotropy = true,
+		.textureCompressionBC = true,
 		.vertexPipelineStoresAndAtomics = true,
 		.fragmentStoresAndAtomics = true,
+		.shaderStorageImageExtendedFormats = true,
 		.shaderStorageImageWriteWithoutFormat = true
 	};
 
@@ -90,6 +104,7 @@ VulkanDevice::VulkanDevice(VulkanInstance& instance, VulkanPhysicalDevice& physi
 		.pNext = &timelineSemaphoreFeatures,
 		.shaderSampledImageArrayNonUniformIndexing = true,
 		.shaderStorageImageArrayNonUniformIndexing = true,
+		.descriptorBindingUpdateUnusedWhilePending = true,
 		.descriptorBindingPartiallyBound = true,
 		.descriptorBindingVariableDescriptorCount = true,
 		.runtimeDescriptorArray = true,
@@ -124,8 +139,24 @@ VulkanDevice::VulkanDevice(VulkanInstance& instance, VulkanPhysicalDevice& physi
 
 	vulkan(vkCreateDevice(_PhysicalDevice, &deviceInfo, nullptr, &_Device));
 
-	_GraphicsQueue = VulkanQueue(_Device, graphicsIndex);
-	_TransferQueue = VulkanQueue(_Device, transferIndex);
+	_NumFramesInFlight = static_cast<uint32>(std::max(Platform::GetInt("Engine.ini", "Renderer", "FramesInFlight", 2), 1));
+	_ReleasedBuffers.resize(_NumFramesInFlight);
+	_ReleasedRenderPasses.resize(_NumFramesInFlight);
+	_RenderPassCache.SetCapacity(static_cast<std::size_t>(std::max(Platform::GetInt("Engine.ini", "Renderer", "RenderPassCacheSize", 64), 0)));
+
+	_GraphicsQueue = VulkanQueue(_Device, graphicsIndex, _NumFramesInFlight);
+	_ComputeQueue = VulkanQueue(_Device, computeIndex, _NumFramesInFlight);
+	_TransferQueue = VulkanQueue(_Device, transferIndex, _NumFramesInFlight);
+
+	if (computeIndex != -1 && computeIndex != graphicsIndex)
+	{
+		const std::unordered_set<int32> sharedQueueFamilies = { graphicsIndex, computeIndex, transferIndex };
+
+		for (int32 queueFamilyIndex : sharedQueueFamilies)
+		{
+			_ConcurrentQueueFamilies.push_back(static_cast<uint32>(queueFamilyIndex));
+		}
+	}
 	
 	const VmaAllocatorCreateInfo allocatorInfo =
 	{
@@ -136,13 +167,20 @@ VulkanDevice::VulkanDevice(VulkanInstance& instance, VulkanPhysicalDevice& physi
 
 	vulkan(vmaCreateAllocator(&allocatorInfo, &_Allocator));
 
+	_UploadRing = std::make_unique<VulkanUploadRing>(*this, Platform::GetInt("Engine.ini", "Renderer", "UploadRingSize", 16) * 1024ull * 1024ull, _NumFramesInFlight);
+
+	_UploadService = std::make_unique<VulkanUploadService>(
+		*this, _TransferQueue, _GraphicsQueue, Platform::GetInt("Engine.ini", "Renderer", "StagingRingSize", 64) * 1024ull * 1024ull);
+
+	_TimestampQueries = std::make_unique<VulkanTimestampQueries>(*this, 128, _NumFramesInFlight);
+
 	// Load instance procedures.
 	_VkCreateDescriptorUpdateTemplateKHR = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplateKHR>(vkGetInstanceProcAddr(_Instance, "vkCreateDescriptorUpdateTemplateKHR"));
 	_VkUpdateDescriptorSetWithTemplateKHR = reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplateKHR>(vkGetInstanceProcAddr(_Instance, "vkUpdateDescriptorSetWithTemplateKHR"));
 
 	// Create the app's bindless descriptors.
-	_BindlessTextures = std::make_unique<VulkanBindlessDescriptors>(_Device, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 65556);
-	_BindlessImages = std::make_unique<VulkanBindlessDescriptors>(_Device, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 256);
+	_BindlessTextures = std::make_unique<VulkanBindlessDescriptors>(_Device, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 65556, _NumFramesInFlight);
+	_BindlessImages = std::make_unique<VulkanBindlessDescriptors>(_Device, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 256, _NumFramesInFlight);
 
 	// Create the app's descriptor set layouts.
 	auto& descriptorSetTaskCollector = gpu::GetStaticDescriptorSetTaskCollector();
@@ -210,40 +248,106 @@ VulkanDevice::VulkanDevice(VulkanInstance& instance, VulkanPhysicalDevice& physi
 		descriptorSetTaskCollector.tasks[i].descriptorSet = descriptorSets[i];
 	}
 
+	CreatePipelineCache();
+
+	if (Platform::GetBool("Engine.ini", "Renderer", "AsyncPipelines", true))
+	{
+		_PipelineCompiler = std::make_unique<VulkanPipelineCompiler>(*this);
+	}
+
 	// Compile all statically registered shaders.
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
 	auto& tasks = gpu::GetShaderCompilationTasks();
-	for (auto& task : tasks)
+
+	CompileShaders(tasks, [] (uint32 numCompiled, uint32 numShaders)
+	{
+		// Log every quarter, so a cold start shows it's making progress.
+		if (numCompiled * 4 / numShaders != (numCompiled - 1) * 4 / numShaders)
+		{
+			LOG("Compiled %u/%u shaders.", numCompiled, numShaders);
+		}
+	});
+
+	for (const auto& task : tasks)
 	{
-		task.shader->compilationResult = CompileShader(task.worker, task.path, task.entrypoint, task.stage);
 		_Shaders.emplace(task.typeIndex, task.shader);
 	}
+
+	UpdateShaderDependents();
+
+	if (Platform::GetBool("Engine.ini", "Renderer", "ShaderHotReload", true))
+	{
+		_ShaderWatcher = std::make_unique<DirectoryWatcher>("../Shaders");
+	}
+
+	const float compileMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	LOG("Loaded %zu shaders in %.1f ms on %u workers, %u compiled and %zu from the shader cache.",
+		tasks.size(), compileMs, JobSystem::Get().GetNumWorkers(), _NumShadersCompiled.load(), tasks.size() - _NumShadersCompiled);
+
 	tasks.clear();
 }
 
 VulkanDevice::~VulkanDevice()
 {
-	for (const auto& [crc, sampler] : _SamplerCache)
+	WaitIdle();
+
+	_ShaderWatcher.reset();
+
+	_PipelineCompiler.reset();
+
+	SavePipelineCache();
+
+	_UploadRing.reset();
+
+	_UploadService.reset();
+
+	_TimestampQueries.reset();
+
+	for (const auto& releasedBuffers : _ReleasedBuffers)
 	{
-		vkDestroySampler(_Device, sampler, nullptr);
+		for (const auto& [buffer, allocation] : releasedBuffers)
+		{
+			vmaDestroyBuffer(_Allocator, buffer, allocation);
+		}
 	}
 
+	for (RetiredRenderPass& retired : _RetiredRenderPasses)
+	{
+		DestroyRetiredRenderPass(retired);
+	}
+
+	for (const auto& releasedRenderPasses : _ReleasedRenderPasses)
+	{
+		for (const auto& [renderPass, framebuffer] : releasedRenderPasses)
+		{
+			vkDestroyFramebuffer(_Device, framebuffer, nullptr);
+		}
+	}
+
+	_SamplerCache.ForEach([&] (const gpu::Sampler& sampler)
+	{
+		vkDestroySampler(_Device, sampler, nullptr);
+	});
+
 	auto p_vkDestroyDescriptorUpdateTemplateKHR = reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplateKHR>(vkGetInstanceProcAddr(_Instance, "vkDestroyDescriptorUpdateTemplateKHR"));
-	for (const auto& [crc, descriptorSetLayoutPair] : _DescriptorSetLayoutCache)
+	_DescriptorSetLayoutCache.ForEach([&] (const auto& descriptorSetLayoutPair)
 	{
 		const auto& [descriptorSetLayout, descriptorUpdateTemplate] = descriptorSetLayoutPair;
 		p_vkDestroyDescriptorUpdateTemplateKHR(_Device, descriptorUpdateTemplate, nullptr);
 		vkDestroyDescriptorSetLayout(_Device, descriptorSetLayout, nullptr);
-	}
+	});
 
 	vkDestroyDescriptorPool(_Device, _DescriptorPool, nullptr);
 
-	for (const auto& [crc, pipelineLayout] : _PipelineLayoutCache)
+	_PipelineLayoutCache.ForEach([&] (VkPipelineLayout pipelineLayout)
 	{
 		vkDestroyPipelineLayout(_Device, pipelineLayout, nullptr);
-	}
+	});
 
-	for (const auto& [crc, renderPass] : _RenderPassCache)
+	_RenderPassCache.ForEach([&] (VkRenderPass renderPass)
 	{
 		vkDestroyRenderPass(_Device, renderPass, nullptr);
-	}
+	});
 }
\ No newline at end of file
@@ -35,12 +35,16 @@ namespace gpu
 		ENTRY(EFormat::R16G16_UINT, VK_FORMAT_R16G16_UINT)
 		ENTRY(EFormat::R16G16_SINT, VK_FORMAT_R16G16_SINT)
 		ENTRY(EFormat::R16G16_SFLOAT, VK_FORMAT_R16G16_SFLOAT)
+		ENTRY(EFormat::R16G16_UNORM, VK_FORMAT_R16G16_UNORM)
+		ENTRY(EFormat::R16G16_SNORM, VK_FORMAT_R16G16_SNORM)
 		ENTRY(EFormat::R16G16B16_UINT, VK_FORMAT_R16G16B16_UINT)
 		ENTRY(EFormat::R16G16B16_SINT, VK_FORMAT_R16G16B16_SINT)
 		ENTRY(EFormat::R16G16B16_SFLOAT, VK_FORMAT_R16G16B16_SFLOAT)
 		ENTRY(EFormat::R16G16B16A16_UINT, VK_FORMAT_R16G16B16A16_UINT)
 		ENTRY(EFormat::R16G16B16A16_SINT, VK_FORMAT_R16G16B16A16_SINT)
 		ENTRY(EFormat::R16G16B16A16_SFLOAT, VK_FORMAT_R16G16B16A16_SFLOAT)
+		ENTRY(EFormat::R16G16B16A16_UNORM, VK_FORMAT_R16G16B16A16_UNORM)
+		ENTRY(EFormat::R16G16B16A16_SNORM, VK_FORMAT_R16G16B16A16_SNORM)
 		ENTRY(EFormat::R32_UINT, VK_FORMAT_R32_UINT)
 		ENTRY(EFormat::R32_SINT, VK_FORMAT_R32_SINT)
 		ENTRY(EFormat::R32_SFLOAT, VK_FORMAT_R32_SFLOAT)
@@ -58,7 +62,14 @@ namespace gpu
 		ENTRY(EFormat::D32_SFLOAT, VK_FORMAT_D32_SFLOAT)
 		ENTRY(EFormat::S8_UINT, VK_FORMAT_S8_UINT)
 		ENTRY(EFormat::D32_SFLOAT_S8_UINT, VK_FORMAT_D32_SFLOAT_S8_UINT)
+		ENTRY(EFormat::BC1_RGBA_UNORM_BLOCK, VK_FORMAT_BC1_RGBA_UNORM_BLOCK)
 		ENTRY(EFormat::BC2_UNORM_BLOCK, VK_FORMAT_BC2_UNORM_BLOCK)
+		ENTRY(EFormat::BC3_UNORM_BLOCK, VK_FORMAT_BC3_UNORM_BLOCK)
+		ENTRY(EFormat::BC4_UNORM_BLOCK, VK_FORMAT_BC4_UNORM_BLOCK)
+		ENTRY(EFormat::BC5_UNORM_BLOCK, VK_FORMAT_BC5_UNORM_BLOCK)
+		ENTRY(EFormat::BC7_UNORM_BLOCK, VK_FORMAT_BC7_UNORM_BLOCK)
+		ENTRY(EFormat::A2B10G10R10_UNORM_PACK32, VK_FORMAT_A2B10G10R10_UNORM_PACK32)
+		ENTRY(EFormat::B10G11R11_UFLOAT_PACK32, VK_FORMAT_B10G11R11_UFLOAT_PACK32)
 	};
 
 	static std::unordered_map<VkFormat, EFormat> gVulkanToEngineFormat = [&] ()
@@ -199,6 +210,42 @@ namespace gpu
 		}
 	}
 
+	MemoryBlock::MemoryBlock(VmaAllocator allocator, VmaAllocation allocation, uint64 size)
+		: _Allocator(allocator)
+		, _Allocation(allocation)
+		, _Size(size)
+	{
+	}
+
+	MemoryBlock::MemoryBlock(MemoryBlock&& other)
+	{
+		*this = std::move(other);
+	}
+
+	MemoryBlock& MemoryBlock::operator=(MemoryBlock&& other)
+	{
+		Destroy();
+		_Allocator = std::exchange(other._Allocator, nullptr);
+		_Allocation = std::exchange(other._Allocation, nullptr);
+		_Size = std::exchange(other._Size, 0);
+		return *this;
+	}
+
+	MemoryBlock::~MemoryBlock()
+	{
+		Destroy();
+	}
+
+	void MemoryBlock::Destroy()
+	{
+		if (_Allocation)
+		{
+			vmaFreeMemory(_Allocator, _Allocation);
+
+			_Allocation = nullptr;
+		}
+	}
+
 	VkFormat Image::GetVulkanFormat(EFormat format)
 	{
 		return gEngineToVulkanFormat[format];
@@ -357,8 +404,8 @@ namespace gpu
 		samplerInfo.addressModeU = sam;
 		samplerInfo.addressModeV = sam;
 		samplerInfo.addressModeW = sam;
-		samplerInfo.anisotropyEnable = device.GetPhysicalDevice().GetFeatures().samplerAnisotropy;
-		samplerInfo.maxAnisotropy = device.GetPhysicalDevice().GetFeatures().samplerAnisotropy ? device.GetPhysicalDevice().GetProperties().limits.maxSamplerAnisotropy : 1.0f;
+		samplerInfo.anisotropyEnable = device.GetPhysicalDevice().GetFeatures().samplerAnisotropy && samplerDesc.maxAnisotropy > 1.0f;
+		samplerInfo.maxAnisotropy = samplerInfo.anisotropyEnable ? std::min(samplerDesc.maxAnisotropy, device.GetPhysicalDevice().GetProperties().limits.maxSamplerAnisotropy) : 1.0f;
 		samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
 		samplerInfo.unnormalizedCoordinates = VK_FALSE;
 		samplerInfo.compareEnable = VK_FALSE;
@@ -83,6 +83,37 @@ namespace gpu
 		void Destroy();
 	};
 
+	struct MemoryRequirements
+	{
+		uint64 size = 0;
+		uint64 alignment = 0;
+		uint32 memoryTypeBits = 0;
+	};
+
+	/** A block of device memory that images are placed in. */
+	class MemoryBlock
+	{
+	public:
+		MemoryBlock(const MemoryBlock&) = delete;
+		MemoryBlock& operator=(const MemoryBlock&) = delete;
+
+		MemoryBlock() = default;
+		MemoryBlock(VmaAllocator allocator, VmaAllocation allocation, uint64 size);
+		MemoryBlock(MemoryBlock&& other);
+		MemoryBlock& operator=(MemoryBlock&& other);
+		~MemoryBlock();
+
+		inline VmaAllocation GetAllocation() const { return _Allocation; }
+		inline uint64 GetSize() const { return _Size; }
+
+	private:
+		VmaAllocator	_Allocator = nullptr;
+		VmaAllocation	_Allocation = nullptr;
+		uint64			_Size = 0;
+
+		void Destroy();
+	};
+
 	class Sampler
 	{
 	public:
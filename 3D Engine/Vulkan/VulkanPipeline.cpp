@@ -1,5 +1,6 @@
 #include "VulkanDevice.h"
 #include "VulkanPipeline.h"
+#include "VulkanPhysicalDevice.h"
 #include <GPU/GPUShader.h>
 
 static void CreateDepthStencilState(const GraphicsPipelineDesc& graphicsDesc, VkPipelineDepthStencilStateCreateInfo& depthStencilState)
@@ -331,7 +332,7 @@ VkPipeline VulkanDevice::CreatePipeline(const GraphicsPipelineDesc& graphicsDesc
 	};
 
 	VkPipeline pipeline;
-	vulkan(vkCreateGraphicsPipelines(_Device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+	vulkan(vkCreateGraphicsPipelines(_Device, _PipelineCache, 1, &pipelineInfo, nullptr, &pipeline));
 	
 	return pipeline;
 }
@@ -364,7 +365,7 @@ VkPipeline VulkanDevice::CreatePipeline(const ComputePipelineDesc& computeDesc,
 	}
 
 	VkPipeline pipeline;
-	vulkan(vkCreateComputePipelines(_Device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pipeline));
+	vulkan(vkCreateComputePipelines(_Device, _PipelineCache, 1, &pipelineInfo, nullptr, &pipeline));
 
 	return pipeline;
 }
@@ -373,11 +374,16 @@ VkPipelineLayout VulkanDevice::GetOrCreatePipelineLayout(
 	const std::vector<VkDescriptorSetLayout>& layouts,
 	const std::vector<VkPushConstantRange>& pushConstantRanges)
 {
-	Crc crc = 0;
-	Platform::crc32_u32(crc, layouts.data(), layouts.size() * sizeof(layouts[0]));
-	Platform::crc32_u32(crc, pushConstantRanges.data(), pushConstantRanges.size() * sizeof(pushConstantRanges[0]));
+	thread_local std::string keyBytes;
+	keyBytes.clear();
+	AppendKeyBytes(keyBytes, layouts);
+	AppendKeyBytes(keyBytes, pushConstantRanges);
 
-	if (auto iter = _PipelineLayoutCache.find(crc); iter == _PipelineLayoutCache.end())
+	if (const VkPipelineLayout* cached = _PipelineLayoutCache.Find(keyBytes, _FrameNumber))
+	{
+		return *cached;
+	}
+	else
 	{
 		VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
 		pipelineLayoutCreateInfo.setLayoutCount = static_cast<uint32>(layouts.size());
@@ -392,14 +398,84 @@ VkPipelineLayout VulkanDevice::GetOrCreatePipelineLayout(
 		VkPipelineLayout pipelineLayout;
 		vulkan(vkCreatePipelineLayout(_Device, &pipelineLayoutCreateInfo, nullptr, &pipelineLayout));
 
-		_PipelineLayoutCache[crc] = pipelineLayout;
+		return _PipelineLayoutCache.Add(keyBytes, pipelineLayout, _FrameNumber);
+	}
+}
+
+/** The header every pipeline cache starts with. (VkPipelineCacheHeaderVersionOne is newer than our Vulkan headers.) */
+struct PipelineCacheHeader
+{
+	uint32 headerSize;
+	VkPipelineCacheHeaderVersion headerVersion;
+	uint32 vendorID;
+	uint32 deviceID;
+	uint8 pipelineCacheUUID[VK_UUID_SIZE];
+};
+
+void VulkanDevice::CreatePipelineCache()
+{
+	const VkPhysicalDeviceProperties& properties = _PhysicalDevice.GetProperties();
+	const bool isPipelineCacheEnabled = Platform::GetBool("Engine.ini", "Renderer", "PipelineCache", true);
+
+	std::string initialData;
 
-		return pipelineLayout;
+	if (isPipelineCacheEnabled && Platform::FileExists(GetPipelineCachePath().string()))
+	{
+		initialData = Platform::FileRead(GetPipelineCachePath());
+
+		// Drivers should reject caches that aren't theirs, but not all of them do.
+		PipelineCacheHeader header = {};
+
+		if (initialData.size() >= sizeof(header))
+		{
+			Platform::Memcpy(&header, initialData.data(), sizeof(header));
+		}
+
+		const bool isValid = header.headerSize >= sizeof(header)
+			&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header.vendorID == properties.vendorID
+			&& header.deviceID == properties.deviceID
+			&& std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+
+		if (!isValid)
+		{
+			LOG("Ignoring %s, it was saved by another driver or device.", GetPipelineCachePath().generic_string().c_str());
+			initialData.clear();
+		}
 	}
-	else
+
+	const VkPipelineCacheCreateInfo pipelineCacheInfo =
+	{
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.initialDataSize = initialData.size(),
+		.pInitialData = initialData.data(),
+	};
+
+	vulkan(vkCreatePipelineCache(_Device, &pipelineCacheInfo, nullptr, &_PipelineCache));
+}
+
+void VulkanDevice::SavePipelineCache()
+{
+	if (Platform::GetBool("Engine.ini", "Renderer", "PipelineCache", true))
 	{
-		return iter->second;
+		std::size_t dataSize = 0;
+		vulkan(vkGetPipelineCacheData(_Device, _PipelineCache, &dataSize, nullptr));
+
+		std::string data(dataSize, '\0');
+		vulkan(vkGetPipelineCacheData(_Device, _PipelineCache, &dataSize, data.data()));
+		data.resize(dataSize);
+
+		std::filesystem::create_directories(GetPipelineCachePath().parent_path());
+
+		Platform::FileWrite(GetPipelineCachePath(), data);
 	}
+
+	vkDestroyPipelineCache(_Device, _PipelineCache, nullptr);
+}
+
+std::filesystem::path VulkanDevice::GetPipelineCachePath()
+{
+	return "../Cooked/Pipelines.cache";
 }
 
 namespace gpu
@@ -15,6 +15,7 @@ namespace gpu
 		inline VkPipeline GetPipeline() const { return *_Pipeline; }
 		inline VkPipelineLayout GetPipelineLayout() const { return _PipelineLayout; }
 		inline VkPipelineBindPoint GetPipelineBindPoint() const { return _PipelineBindPoint; }
+		inline bool IsValid() const { return _Pipeline != nullptr; }
 
 	private:
 		std::shared_ptr<VkPipeline> _Pipeline = nullptr;
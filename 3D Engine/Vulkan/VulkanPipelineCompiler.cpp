@@ -0,0 +1,80 @@
+#include "VulkanPipelineCompiler.h"
+#include "VulkanDevice.h"
+
+VulkanPipelineCompiler::VulkanPipelineCompiler(const VulkanDevice& device)
+	: _Device(device)
+	, _Thread([this] () { ThreadMain(); })
+{
+}
+
+VulkanPipelineCompiler::~VulkanPipelineCompiler()
+{
+	{
+		std::lock_guard lock(_Mutex);
+		_Stop = true;
+		_Requests.clear();
+	}
+
+	_RequestCondition.notify_one();
+	_Thread.join();
+
+	for (const CompiledPipeline& compiled : _CompiledPipelines)
+	{
+		vkDestroyPipeline(_Device, compiled.pipeline, nullptr);
+	}
+}
+
+void VulkanPipelineCompiler::Compile(GraphicsPipelineKey key, const GraphicsPipelineDesc& graphicsDesc, VkPipelineLayout pipelineLayout)
+{
+	{
+		std::lock_guard lock(_Mutex);
+		_Requests.push_back({ key, graphicsDesc, pipelineLayout, VK_NULL_HANDLE });
+	}
+
+	_RequestCondition.notify_one();
+}
+
+std::vector<VulkanPipelineCompiler::CompiledPipeline> VulkanPipelineCompiler::TakeCompiledPipelines()
+{
+	std::lock_guard lock(_Mutex);
+	return std::exchange(_CompiledPipelines, {});
+}
+
+void VulkanPipelineCompiler::Flush()
+{
+	std::unique_lock lock(_Mutex);
+	_FlushCondition.wait(lock, [this] () { return _Requests.empty() && !_IsCompiling; });
+}
+
+void VulkanPipelineCompiler::ThreadMain()
+{
+	while (true)
+	{
+		CompiledPipeline request;
+
+		{
+			std::unique_lock lock(_Mutex);
+			_RequestCondition.wait(lock, [this] () { return _Stop || !_Requests.empty(); });
+
+			if (_Stop)
+			{
+				return;
+			}
+
+			request = std::move(_Requests.front());
+			_Requests.pop_front();
+			_IsCompiling = true;
+		}
+
+		// The pipeline cache is internally synchronized, so this can overlap the render thread's pipelines.
+		request.pipeline = _Device.CreatePipeline(request.graphicsDesc, request.pipelineLayout);
+
+		{
+			std::lock_guard lock(_Mutex);
+			_CompiledPipelines.push_back(std::move(request));
+			_IsCompiling = false;
+		}
+
+		_FlushCondition.notify_all();
+	}
+}
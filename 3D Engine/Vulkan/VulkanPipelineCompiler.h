@@ -0,0 +1,59 @@
+#pragma once
+#include <GPU/GPUDefinitions.h>
+#include <vulkan/vulkan.h>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+class VulkanDevice;
+
+/**
+  * Creates graphics pipelines on a background thread, so recording never waits on the driver's compiler.
+  * The device collects finished pipelines at the end of a frame, so a frame sees a pipeline as pending or finished, never in between.
+  * It's a thread of its own rather than jobs, since the frame's jobs would otherwise wait behind a pipeline.
+  */
+class VulkanPipelineCompiler
+{
+public:
+	VulkanPipelineCompiler(const VulkanPipelineCompiler&) = delete;
+	VulkanPipelineCompiler& operator=(const VulkanPipelineCompiler&) = delete;
+	VulkanPipelineCompiler(const VulkanDevice& device);
+
+	/** Requests that haven't started are dropped. Pipelines that weren't collected are destroyed. */
+	~VulkanPipelineCompiler();
+
+	struct CompiledPipeline
+	{
+		GraphicsPipelineKey key;
+		GraphicsPipelineDesc graphicsDesc;
+		VkPipelineLayout pipelineLayout;
+		VkPipeline pipeline;
+	};
+
+	/** Queue a pipeline. Its layout is created up front, since the layout cache belongs to the render thread. */
+	void Compile(GraphicsPipelineKey key, const GraphicsPipelineDesc& graphicsDesc, VkPipelineLayout pipelineLayout);
+
+	/** Take the pipelines finished since the last call. */
+	std::vector<CompiledPipeline> TakeCompiledPipelines();
+
+	/** Wait until every queued pipeline is finished, e.g. before the shaders they use are recompiled. */
+	void Flush();
+
+private:
+	const VulkanDevice& _Device;
+
+	std::mutex _Mutex;
+	std::condition_variable _RequestCondition;
+	std::condition_variable _FlushCondition;
+	std::deque<CompiledPipeline> _Requests;
+	std::vector<CompiledPipeline> _CompiledPipelines;
+	bool _IsCompiling = false;
+	bool _Stop = false;
+
+	/** Last, so it starts once everything else is constructed. */
+	std::thread _Thread;
+
+	void ThreadMain();
+};
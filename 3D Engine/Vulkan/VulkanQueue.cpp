@@ -3,7 +3,7 @@
 #include "VulkanCommandBuffer.h"
 #include "VulkanSemaphore.h"
 
-VulkanQueue::VulkanQueue(VkDevice device, int32 queueFamilyIndex)
+VulkanQueue::VulkanQueue(VkDevice device, int32 queueFamilyIndex, uint32 numFramesInFlight)
 	: _QueueFamilyIndex(queueFamilyIndex)
 {
 	if (_QueueFamilyIndex != -1)
@@ -11,11 +11,16 @@ VulkanQueue::VulkanQueue(VkDevice device, int32 queueFamilyIndex)
 		const VkCommandPoolCreateInfo commandPoolInfo = 
 		{ 
 			.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
-			.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+			.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
 			.queueFamilyIndex = static_cast<uint32>(_QueueFamilyIndex),
 		};
 
-		vkCreateCommandPool(device, &commandPoolInfo, nullptr, &_CommandPool);
+		_Frames.resize(numFramesInFlight);
+
+		for (auto& frame : _Frames)
+		{
+			vkCreateCommandPool(device, &commandPoolInfo, nullptr, &frame._CommandPool);
+		}
 
 		vkGetDeviceQueue(device, _QueueFamilyIndex, 0, &_Queue);
 
@@ -39,21 +44,57 @@ VulkanQueue::VulkanQueue(VkDevice device, int32 queueFamilyIndex)
 void VulkanQueue::Submit(
 	const gpu::CommandBuffer& cmdBuf,
 	const gpu::Semaphore& waitSemaphore,
-	const gpu::Semaphore& signalSemaphore)
+	const gpu::Semaphore& signalSemaphore,
+	const VulkanQueue* waitQueue,
+	uint64 waitQueueValue)
 {
 	vkEndCommandBuffer(cmdBuf._CommandBuffer);
 
-	const auto waitSemaphoreValues = waitSemaphore.Get() == VK_NULL_HANDLE ? 
-		std::vector{ _TimelineSemaphoreValue } : std::vector{ _TimelineSemaphoreValue, 0llu };
+	Submit(cmdBuf._CommandBuffer, waitSemaphore.Get(), signalSemaphore.Get(), waitQueue, waitQueueValue);
+
+	FrameResources& frame = _Frames[_FrameIndex];
+	frame._TimelineSemaphoreValue = _TimelineSemaphoreValue;
+	frame._IsDirty = true;
+}
+
+uint64 VulkanQueue::Submit(VkCommandBuffer cmdBuf)
+{
+	Submit(cmdBuf, VK_NULL_HANDLE, VK_NULL_HANDLE, nullptr, 0);
+
+	return _TimelineSemaphoreValue;
+}
 
-	const auto waitSemaphores = waitSemaphore.Get() == VK_NULL_HANDLE ?
-		std::vector{ _TimelineSemaphore } : std::vector{ _TimelineSemaphore, waitSemaphore.Get() };
+void VulkanQueue::Submit(
+	VkCommandBuffer cmdBuf,
+	VkSemaphore waitSemaphore,
+	VkSemaphore signalSemaphore,
+	const VulkanQueue* waitQueue,
+	uint64 waitQueueValue)
+{
+	// Binary semaphores ignore their value.
+	std::vector<VkSemaphore> waitSemaphores = { _TimelineSemaphore };
+	std::vector<uint64> waitSemaphoreValues = { _TimelineSemaphoreValue };
+
+	if (waitQueue)
+	{
+		waitSemaphores.push_back(waitQueue->_TimelineSemaphore);
+		waitSemaphoreValues.push_back(waitQueueValue == 0 ? waitQueue->_TimelineSemaphoreValue : waitQueueValue);
+	}
+
+	if (waitSemaphore != VK_NULL_HANDLE)
+	{
+		waitSemaphores.push_back(waitSemaphore);
+		waitSemaphoreValues.push_back(0);
+	}
 
-	const auto signalSemaphoreValues = signalSemaphore.Get() == VK_NULL_HANDLE ?
-		std::vector{ ++_TimelineSemaphoreValue } : std::vector{ ++_TimelineSemaphoreValue, 0llu };
+	std::vector<VkSemaphore> signalSemaphores = { _TimelineSemaphore };
+	std::vector<uint64> signalSemaphoreValues = { ++_TimelineSemaphoreValue };
 
-	const auto signalSemaphores = signalSemaphore.Get() == VK_NULL_HANDLE ?
-		std::vector{ _TimelineSemaphore } : std::vector{ _TimelineSemaphore, signalSemaphore.Get() };
+	if (signalSemaphore != VK_NULL_HANDLE)
+	{
+		signalSemaphores.push_back(signalSemaphore);
+		signalSemaphoreValues.push_back(0);
+	}
 
 	const VkTimelineSemaphoreSubmitInfo timelineSemaphoreSubmitInfo =
 	{
@@ -64,7 +105,8 @@ void VulkanQueue::Submit(
 		.pSignalSemaphoreValues = signalSemaphoreValues.data()
 	};
 
-	const std::vector<VkPipelineStageFlags> waitDstStage(waitSemaphores.size(), VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+	// Top of pipe in the second synchronization scope doesn't block any stage, so wait on all commands.
+	const std::vector<VkPipelineStageFlags> waitDstStage(waitSemaphores.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
 
 	const VkSubmitInfo submitInfo = 
 	{ 
@@ -74,44 +116,52 @@ void VulkanQueue::Submit(
 		.pWaitSemaphores = waitSemaphores.data(),
 		.pWaitDstStageMask = waitDstStage.data(),
 		.commandBufferCount = 1,
-		.pCommandBuffers = &cmdBuf._CommandBuffer,
+		.pCommandBuffers = &cmdBuf,
 		.signalSemaphoreCount = static_cast<uint32>(signalSemaphores.size()),
 		.pSignalSemaphores = signalSemaphores.data(),
 	};
 
 	vkQueueSubmit(_Queue, 1, &submitInfo, VK_NULL_HANDLE);
-
-	_InFlightCmdBufs.push_back(cmdBuf._CommandBuffer);
 }
 
-void VulkanQueue::WaitSemaphores(VkDevice device)
+void VulkanQueue::BeginFrame(VkDevice device, uint32 frameIndex)
 {
-	if (_InFlightCmdBufs.size() > 0)
-	{
-		const VkSemaphoreWaitInfo semaphoreWaitInfo =
-		{
-			.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
-			.semaphoreCount = 1,
-			.pSemaphores = &_TimelineSemaphore,
-			.pValues = &_TimelineSemaphoreValue
-		};
+	_FrameIndex = frameIndex;
 
-		vkWaitSemaphores(device, &semaphoreWaitInfo, UINT64_MAX);
+	FrameResources& frame = _Frames[_FrameIndex];
 
-		GiveUpInFlightResources(device);
+	if (frame._IsDirty)
+	{
+		// Only stalls when the CPU has gotten a full ring of frames ahead of the GPU.
+		WaitTimelineSemaphore(device, frame._TimelineSemaphoreValue);
+
+		ResetFrame(device, frame);
 	}
 }
 
-void VulkanQueue::AddInFlightStagingBuffer(std::shared_ptr<gpu::Buffer> stagingBuffer)
+void VulkanQueue::WaitTimelineSemaphore(VkDevice device, uint64 value) const
 {
-	_InFlightStagingBufs.push_back(stagingBuffer);
+	const VkSemaphoreWaitInfo semaphoreWaitInfo =
+	{
+		.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO,
+		.semaphoreCount = 1,
+		.pSemaphores = &_TimelineSemaphore,
+		.pValues = &value
+	};
+
+	vkWaitSemaphores(device, &semaphoreWaitInfo, UINT64_MAX);
 }
 
-void VulkanQueue::GiveUpInFlightResources(VkDevice device)
+uint64 VulkanQueue::GetCompletedTimelineSemaphoreValue(VkDevice device) const
 {
-	vkFreeCommandBuffers(device, _CommandPool, static_cast<uint32>(_InFlightCmdBufs.size()), _InFlightCmdBufs.data());
+	uint64 value;
+	vkGetSemaphoreCounterValue(device, _TimelineSemaphore, &value);
+	return value;
+}
 
-	_InFlightCmdBufs.clear();
+void VulkanQueue::ResetFrame(VkDevice device, FrameResources& frame)
+{
+	vkResetCommandPool(device, frame._CommandPool, 0);
 
-	_InFlightStagingBufs.clear();
-}
\ No newline at end of file
+	frame._IsDirty = false;
+}
@@ -15,35 +15,73 @@ class VulkanQueue
 public:
 	VulkanQueue() = default;
 
-	VulkanQueue(VkDevice device, int32 queueFamilyIndex);
+	VulkanQueue(VkDevice device, int32 queueFamilyIndex, uint32 numFramesInFlight);
 
+	/**
+	  * Submit after every earlier submission to this queue has completed.
+	  * If waitQueue is set, also wait for its timeline to reach waitQueueValue, or for every submission made to it so far if the value is 0.
+	  */
 	void Submit(
 		const gpu::CommandBuffer& cmdBuf,
 		const gpu::Semaphore& waitSemaphore,
-		const gpu::Semaphore& signalSemaphore);
-	
-	void WaitSemaphores(VkDevice device);
+		const gpu::Semaphore& signalSemaphore,
+		const VulkanQueue* waitQueue = nullptr,
+		uint64 waitQueueValue = 0);
 
-	void AddInFlightStagingBuffer(std::shared_ptr<gpu::Buffer> stagingBuffer);
+	/** 
+	  * Submit a command buffer allocated from a pool the queue doesn't own, after every earlier submission to this queue has completed.
+	  * Returns the timeline value signaled when it completes.
+	  */
+	uint64 Submit(VkCommandBuffer cmdBuf);
 
-	void GiveUpInFlightResources(VkDevice device);
+	/** Make frameIndex the current frame. Only blocks if the GPU hasn't finished the frame that last used the slot. */
+	void BeginFrame(VkDevice device, uint32 frameIndex);
+
+	/** Block until the queue's timeline reaches value. */
+	void WaitTimelineSemaphore(VkDevice device, uint64 value) const;
+
+	/** Timeline value of the last completed submission. Doesn't block. */
+	uint64 GetCompletedTimelineSemaphoreValue(VkDevice device) const;
 
 	inline int32 GetQueueFamilyIndex() const { return _QueueFamilyIndex; }
 	inline VkQueue GetQueue() const { return _Queue; }
-	inline VkCommandPool GetCommandPool() const { return _CommandPool; }
+	inline VkCommandPool GetCommandPool() const { return _Frames[_FrameIndex]._CommandPool; }
+
+	/** Timeline value signaled by the last submission. */
+	inline uint64 GetTimelineSemaphoreValue() const { return _TimelineSemaphoreValue; }
 
 private:
+	/** Resources owned by a frame in flight. */
+	struct FrameResources
+	{
+		/** Command buffers recorded this frame are allocated from here and reset in bulk. */
+		VkCommandPool _CommandPool = VK_NULL_HANDLE;
+
+		/** Timeline value signaled by the frame's last submit. */
+		uint64 _TimelineSemaphoreValue = 0;
+
+		/** Whether any command buffers were allocated since the last reset. */
+		bool _IsDirty = false;
+	};
+
 	int32 _QueueFamilyIndex = -1;
 
 	VkQueue _Queue = VK_NULL_HANDLE;
 
-	VkCommandPool _CommandPool = VK_NULL_HANDLE;
-
-	std::vector<std::shared_ptr<gpu::Buffer>> _InFlightStagingBufs;
+	std::vector<FrameResources> _Frames;
 
-	std::vector<VkCommandBuffer> _InFlightCmdBufs;
+	uint32 _FrameIndex = 0;
 
 	VkSemaphore _TimelineSemaphore;
 
 	uint64 _TimelineSemaphoreValue = 0;
-};
\ No newline at end of file
+
+	void Submit(
+		VkCommandBuffer cmdBuf,
+		VkSemaphore waitSemaphore,
+		VkSemaphore signalSemaphore,
+		const VulkanQueue* waitQueue,
+		uint64 waitQueueValue);
+
+	void ResetFrame(VkDevice device, FrameResources& frame);
+};
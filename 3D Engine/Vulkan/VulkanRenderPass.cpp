@@ -3,38 +3,133 @@
 
 std::pair<VkRenderPass, VkFramebuffer> VulkanDevice::GetOrCreateRenderPass(const RenderPassDesc& rpDesc)
 {
-	Crc crc = 0;
-	
+	thread_local std::string keyBytes;
+	keyBytes.clear();
+
+	AppendKeyBytes(keyBytes, static_cast<uint32>(rpDesc.colorAttachments.size()));
+
 	for (const auto& colorAttachment : rpDesc.colorAttachments)
 	{
-		Platform::crc32_u32(crc, &colorAttachment.initialLayout, sizeof(colorAttachment.initialLayout));
-		Platform::crc32_u32(crc, &colorAttachment.finalLayout, sizeof(colorAttachment.finalLayout));
-		Platform::crc32_u32(crc, &colorAttachment.loadAction, sizeof(colorAttachment.loadAction));
-		Platform::crc32_u32(crc, &colorAttachment.storeAction, sizeof(colorAttachment.storeAction));
+		AppendKeyBytes(keyBytes, colorAttachment.image->GetFormat());
+		AppendKeyBytes(keyBytes, colorAttachment.initialLayout);
+		AppendKeyBytes(keyBytes, colorAttachment.finalLayout);
+		AppendKeyBytes(keyBytes, colorAttachment.loadAction);
+		AppendKeyBytes(keyBytes, colorAttachment.storeAction);
 	}
 
-	Platform::crc32_u32(crc, &rpDesc.depthAttachment.initialLayout, sizeof(rpDesc.depthAttachment.initialLayout));
-	Platform::crc32_u32(crc, &rpDesc.depthAttachment.finalLayout, sizeof(rpDesc.depthAttachment.finalLayout));
-	Platform::crc32_u32(crc, &rpDesc.depthAttachment.loadAction, sizeof(rpDesc.depthAttachment.loadAction));
-	Platform::crc32_u32(crc, &rpDesc.depthAttachment.storeAction, sizeof(rpDesc.depthAttachment.storeAction));
+	AppendKeyBytes(keyBytes, rpDesc.depthAttachment.image ? rpDesc.depthAttachment.image->GetFormat() : EFormat::UNDEFINED);
+	AppendKeyBytes(keyBytes, rpDesc.depthAttachment.initialLayout);
+	AppendKeyBytes(keyBytes, rpDesc.depthAttachment.finalLayout);
+	AppendKeyBytes(keyBytes, rpDesc.depthAttachment.loadAction);
+	AppendKeyBytes(keyBytes, rpDesc.depthAttachment.storeAction);
+	AppendKeyBytes(keyBytes, rpDesc.srcStageMask);
+	AppendKeyBytes(keyBytes, rpDesc.dstStageMask);
+	AppendKeyBytes(keyBytes, rpDesc.srcAccessMask);
+	AppendKeyBytes(keyBytes, rpDesc.dstAccessMask);
 
 	VkRenderPass renderPass = VK_NULL_HANDLE;
 
-	if (auto iter = _RenderPassCache.find(crc); iter != _RenderPassCache.end())
+	if (const VkRenderPass* cached = _RenderPassCache.Find(keyBytes, _FrameNumber))
 	{
-		renderPass = iter->second;
+		renderPass = *cached;
 	}
-
-	if (renderPass == VK_NULL_HANDLE)
+	else
 	{
-		renderPass = CreateRenderPass(_Device, rpDesc);
-		_RenderPassCache.emplace(crc, renderPass);
+		renderPass = _RenderPassCache.Add(keyBytes, CreateRenderPass(_Device, rpDesc), _FrameNumber);
 	}
 
+	// Released by the gpu::RenderPass that owns the framebuffer.
+	_RenderPassReferences[renderPass]++;
+
 	const VkFramebuffer framebuffer = CreateFramebuffer(renderPass, rpDesc);
 	return { renderPass, framebuffer };
 }
 
+void VulkanDevice::EvictRenderPasses()
+{
+	const uint64 completedValue = _GraphicsQueue.GetCompletedTimelineSemaphoreValue(_Device);
+
+	while (!_RetiredRenderPasses.empty() && _RetiredRenderPasses.front().timelineValue <= completedValue)
+	{
+		DestroyRetiredRenderPass(_RetiredRenderPasses.front());
+		_RetiredRenderPasses.pop_front();
+	}
+
+	// The frame that last used this frame's slot has completed, and every frame before it.
+	if (_FrameNumber < _NumFramesInFlight)
+	{
+		return;
+	}
+
+	// Pipelines being compiled still read their render pass.
+	std::unordered_set<VkRenderPass> pendingRenderPasses;
+
+	for (const GraphicsPipelineEntry& entry : _GraphicsPipelines)
+	{
+		if (entry.isPending)
+		{
+			pendingRenderPasses.insert(entry.desc.renderPass.GetRenderPass());
+		}
+	}
+
+	// Maps each evicted render pass to its place in the retired list.
+	std::unordered_map<VkRenderPass, std::size_t> evictedRenderPasses;
+
+	_RenderPassCache.Evict(_FrameNumber - _NumFramesInFlight, [&] (VkRenderPass renderPass)
+	{
+		return _RenderPassReferences[renderPass] == 0 && !pendingRenderPasses.contains(renderPass);
+	}, [&] (VkRenderPass renderPass)
+	{
+		_RenderPassReferences.erase(renderPass);
+		evictedRenderPasses.emplace(renderPass, _RetiredRenderPasses.size());
+
+		// A pipeline may still be bound by a frame in flight with a compatible render pass, so the graphics timeline decides.
+		_RetiredRenderPasses.push_back({ renderPass, {}, _GraphicsQueue.GetTimelineSemaphoreValue() });
+	});
+
+	if (evictedRenderPasses.empty())
+	{
+		return;
+	}
+
+	// A new render pass may get an evicted one's handle, so descriptions using the evicted ones mustn't be found again.
+	// Only the index of a retired entry is kept, so its key stays unique.
+	for (GraphicsPipelineEntry& entry : _GraphicsPipelines)
+	{
+		if (entry.isRetired)
+		{
+			continue;
+		}
+
+		if (auto iter = evictedRenderPasses.find(entry.desc.renderPass.GetRenderPass()); iter != evictedRenderPasses.end())
+		{
+			_GraphicsPipelineIndices.Remove(GetPipelineKeyBytes(entry.desc));
+
+			if (entry.pipeline.IsValid())
+			{
+				_RetiredRenderPasses[iter->second].pipelines.push_back(entry.pipeline._Pipeline);
+			}
+
+			entry.pipeline = {};
+			entry.desc = {};
+			entry.isRetired = true;
+		}
+	}
+}
+
+void VulkanDevice::DestroyRetiredRenderPass(RetiredRenderPass& retired)
+{
+	for (const std::shared_ptr<VkPipeline>& pipeline : retired.pipelines)
+	{
+		vkDestroyPipeline(_Device, *pipeline, nullptr);
+
+		// Copies of the gpu::Pipeline see that it's gone rather than a destroyed handle.
+		*pipeline = VK_NULL_HANDLE;
+	}
+
+	vkDestroyRenderPass(_Device, retired.renderPass, nullptr);
+}
+
 static VkAttachmentLoadOp GetVulkanLoadOp(ELoadAction loadAction)
 {
 	static const VkAttachmentLoadOp loadOps[] =
@@ -130,6 +225,8 @@ VkRenderPass VulkanDevice::CreateRenderPass(VkDevice device, const RenderPassDes
 		.pDepthStencilAttachment = !rpDesc.depthAttachment.image ? nullptr : &depthRef,
 	};
 	
+	const bool hasExternalDependencies = Any(rpDesc.srcStageMask) && Any(rpDesc.dstStageMask);
+
 	const VkSubpassDependency dependencies[] =
 	{
 		{
@@ -159,8 +256,8 @@ VkRenderPass VulkanDevice::CreateRenderPass(VkDevice device, const RenderPassDes
 		.pAttachments = descriptions.data(),
 		.subpassCount = 1,
 		.pSubpasses = &subpass,
-		.dependencyCount = static_cast<uint32>(std::size(dependencies)),
-		.pDependencies = dependencies,
+		.dependencyCount = hasExternalDependencies ? static_cast<uint32>(std::size(dependencies)) : 0,
+		.pDependencies = hasExternalDependencies ? dependencies : nullptr,
 	};
 	
 	VkRenderPass renderPass;
@@ -233,7 +330,7 @@ namespace gpu
 	{
 		if (_Device)
 		{
-			vkDestroyFramebuffer(*_Device, _Framebuffer, nullptr);
+			_Device->ReleaseRenderPass(_RenderPass, _Framebuffer);
 		}
 	}
 
@@ -249,6 +346,11 @@ namespace gpu
 
 	RenderPass& RenderPass::operator=(RenderPass&& other)
 	{
+		if (_Device)
+		{
+			_Device->ReleaseRenderPass(_RenderPass, _Framebuffer);
+		}
+
 		_Device = std::exchange(other._Device, nullptr);
 		_RenderPass = std::exchange(other._RenderPass, nullptr);
 		_Framebuffer = std::exchange(other._Framebuffer, nullptr);
@@ -33,7 +33,8 @@ namespace gpu
 		inline uint32 GetNumAttachments() const { return _NumAttachments; }
 
 	private:
-		const VulkanDevice* _Device;
+		/** Null if moved from. The framebuffer and the reference to the cached render pass are released through the device. */
+		VulkanDevice* _Device = nullptr;
 
 		/** The Vulkan render pass. */
 		VkRenderPass _RenderPass;
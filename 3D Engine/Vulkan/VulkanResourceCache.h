@@ -0,0 +1,125 @@
+#pragma once
+#include <GPU/GPUDefinitions.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+
+/**
+  * Caches Vulkan objects by the bytes of the state that describes them. Keys are hashed with Platform::Hash64() and compared in full,
+  * so a collision costs a probe rather than returning the wrong object. Entries remember the last frame that used them, and bounded
+  * caches evict the least recently used entries that the frames in flight are done with. Not synchronized.
+  */
+template<typename ValueType>
+class VulkanResourceCache
+{
+public:
+	/** A capacity of 0 never evicts. */
+	VulkanResourceCache(const char* name, std::size_t capacity = 0)
+		: _Name(name)
+		, _Capacity(capacity)
+	{
+	}
+
+	inline void SetCapacity(std::size_t capacity) { _Capacity = capacity; }
+
+	/** The cached object, or null on a miss. A hit marks the entry used in the frame. */
+	ValueType* Find(const std::string& key, uint64 frameNumber)
+	{
+		if (auto iter = _Entries.find(key); iter != _Entries.end())
+		{
+			_NumHits++;
+			iter->second.lastUsedFrame = frameNumber;
+			return &iter->second.value;
+		}
+
+		_NumMisses++;
+		return nullptr;
+	}
+
+	ValueType& Add(const std::string& key, ValueType value, uint64 frameNumber)
+	{
+		return _Entries.insert_or_assign(key, Entry{ std::move(value), frameNumber }).first->second.value;
+	}
+
+	/** Forget an entry without destroying it. */
+	inline void Remove(const std::string& key) { _Entries.erase(key); }
+
+	/**
+	  * Evict the least recently used entries until the cache is within its capacity. Entries used after lastCompletedFrame, or
+	  * that canEvict() rejects, are kept, so the cache may stay over capacity until they're released.
+	  */
+	template<typename CanEvictFunction, typename DestroyFunction>
+	void Evict(uint64 lastCompletedFrame, CanEvictFunction&& canEvict, DestroyFunction&& destroy)
+	{
+		if (_Capacity == 0 || _Entries.size() <= _Capacity)
+		{
+			return;
+		}
+
+		std::vector<typename EntryMap::iterator> candidates;
+
+		for (auto iter = _Entries.begin(); iter != _Entries.end(); iter++)
+		{
+			if (iter->second.lastUsedFrame <= lastCompletedFrame && canEvict(iter->second.value))
+			{
+				candidates.push_back(iter);
+			}
+		}
+
+		const std::size_t numToEvict = std::min(_Entries.size() - _Capacity, candidates.size());
+
+		std::partial_sort(candidates.begin(), candidates.begin() + numToEvict, candidates.end(), [] (const auto& a, const auto& b)
+		{
+			return a->second.lastUsedFrame < b->second.lastUsedFrame;
+		});
+
+		// Erasing doesn't invalidate the other candidates.
+		for (std::size_t candidateIndex = 0; candidateIndex < numToEvict; candidateIndex++)
+		{
+			destroy(candidates[candidateIndex]->second.value);
+			_Entries.erase(candidates[candidateIndex]);
+		}
+
+		_NumEvictions += numToEvict;
+	}
+
+	template<typename Function>
+	void ForEach(Function&& function) const
+	{
+		for (const auto& [key, entry] : _Entries)
+		{
+			function(entry.value);
+		}
+	}
+
+	inline ResourceCacheStats GetStats() const
+	{
+		return { _Name, _NumHits, _NumMisses, _NumEvictions, _Entries.size(), _Capacity };
+	}
+
+private:
+	struct Entry
+	{
+		ValueType value;
+		uint64 lastUsedFrame;
+	};
+
+	struct KeyHash
+	{
+		inline std::size_t operator()(const std::string& key) const { return static_cast<std::size_t>(Platform::Hash64(key.data(), key.size())); }
+	};
+
+	using EntryMap = std::unordered_map<std::string, Entry, KeyHash>;
+
+	EntryMap _Entries;
+
+	const char* _Name;
+
+	std::size_t _Capacity;
+
+	uint64 _NumHits = 0;
+
+	uint64 _NumMisses = 0;
+
+	uint64 _NumEvictions = 0;
+};
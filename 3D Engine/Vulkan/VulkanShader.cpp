@@ -1,7 +1,11 @@
 #include "VulkanDevice.h"
+#include "VulkanShaderCache.h"
+#include <Engine/JobSystem.h>
 #include <SPIRV-Cross/spirv_glsl.hpp>
 #include <shaderc/shaderc.hpp>
 #include <unordered_map>
+#include <unordered_set>
+#include <chrono>
 
 static VkFormat GetFormatFromBaseType(const spirv_cross::SPIRType& type)
 {
@@ -82,14 +86,11 @@ static std::vector<VertexAttributeDescription> ReflectVertexAttributeDescription
 	return descriptions;
 }
 
-static std::map<uint32, VkDescriptorSetLayout> ReflectDescriptorSetLayouts(
-	VulkanDevice& device, 
+static void ReflectDescriptorSets(
 	const spirv_cross::CompilerGLSL& glsl,
-	const spirv_cross::ShaderResources& resources)
+	const spirv_cross::ShaderResources& resources,
+	ShaderBinary& binary)
 {
-	std::map<uint32, VkDescriptorSetLayout> layouts;
-	std::map<uint32, std::vector<VkDescriptorSetLayoutBinding>> bindings;
-
 	for (const auto& resource : resources.sampled_images)
 	{
 		const spirv_cross::SPIRType& type = glsl.get_type(resource.type_id);
@@ -97,11 +98,11 @@ static std::map<uint32, VkDescriptorSetLayout> ReflectDescriptorSetLayouts(
 
 		if (type.array.size())
 		{
-			layouts.insert({ set, device._BindlessTextures->GetLayout() });
+			binary.bindlessSets.insert({ set, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER });
 		}
 		else
 		{
-			bindings[set].push_back({
+			binary.bindings[set].push_back({
 					.binding = glsl.get_decoration(resource.id, spv::DecorationBinding),
 					.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 					.descriptorCount = 1,
@@ -117,11 +118,11 @@ static std::map<uint32, VkDescriptorSetLayout> ReflectDescriptorSetLayouts(
 
 		if (type.array.size())
 		{
-			layouts.insert({ set, device._BindlessImages->GetLayout() });
+			binary.bindlessSets.insert({ set, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE });
 		}
 		else
 		{
-			bindings[set].push_back({
+			binary.bindings[set].push_back({
 					.binding = glsl.get_decoration(resource.id, spv::DecorationBinding),
 					.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
 					.descriptorCount = 1,
@@ -136,7 +137,7 @@ static std::map<uint32, VkDescriptorSetLayout> ReflectDescriptorSetLayouts(
 		{
 			const spirv_cross::SPIRType& type = glsl.get_type(resource.type_id);
 			const uint32 set = glsl.get_decoration(resource.id, spv::DecorationDescriptorSet);
-			bindings[set].push_back({
+			binary.bindings[set].push_back({
 					.binding = glsl.get_decoration(resource.id, spv::DecorationBinding),
 					.descriptorType = descriptorType,
 					.descriptorCount = type.array.size() ? type.array[0] : 1,
@@ -147,8 +148,18 @@ static std::map<uint32, VkDescriptorSetLayout> ReflectDescriptorSetLayouts(
 
 	getBindings(resources.uniform_buffers, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC);
 	getBindings(resources.storage_buffers, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER);
+}
+
+static std::map<uint32, VkDescriptorSetLayout> CreateDescriptorSetLayouts(VulkanDevice& device, const ShaderBinary& binary)
+{
+	std::map<uint32, VkDescriptorSetLayout> layouts;
 
-	for (auto& [set, bindings] : bindings)
+	for (const auto& [set, descriptorType] : binary.bindlessSets)
+	{
+		layouts.insert({ set, descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE ? device._BindlessImages->GetLayout() : device._BindlessTextures->GetLayout() });
+	}
+
+	for (const auto& [set, bindings] : binary.bindings)
 	{
 		VkDescriptorSetLayout descriptorSetLayout;
 		VkDescriptorUpdateTemplate descriptorUpdateTemplate;
@@ -166,10 +177,11 @@ static VkPushConstantRange ReflectPushConstantRange(
 {
 	for (const auto& pushConstant : resources.push_constant_buffers)
 	{
-		const auto ranges = glsl.get_active_buffer_ranges(pushConstant.id);
+		// The range starts at the first member, so stages can push constants at different offsets.
 		const spirv_cross::SPIRType& type = glsl.get_type(pushConstant.base_type_id);
-		const std::size_t size = glsl.get_declared_struct_size(type);
-		return { stageFlags, static_cast<uint32>(ranges.front().offset), static_cast<uint32>(size) };
+		const uint32 offset = glsl.type_struct_member_offset(type, 0);
+		const std::size_t size = glsl.get_declared_struct_size(type) - offset;
+		return { stageFlags, offset, static_cast<uint32>(size) };
 	}
 
 	return {};
@@ -202,22 +214,62 @@ public:
 
 	void ReleaseInclude(shaderc_include_result* data) override {}
 
+	/** Every file included so far, directly or not. */
+	std::vector<std::filesystem::path> GetIncludes() const
+	{
+		std::vector<std::filesystem::path> includes;
+
+		for (const auto& [sourceName, include] : _Includes)
+		{
+			includes.push_back(std::filesystem::path(sourceName).lexically_normal());
+		}
+
+		return includes;
+	}
+
 private:
 	std::list<std::string> _SourceNames;
 	std::list<std::string> _Sources;
 	std::unordered_map<std::string, shaderc_include_result> _Includes;
 };
 
-ShaderCompilationResult VulkanDevice::CompileShader(
+/** Last time the shader or any of its includes was written. */
+static uint64 GetLastWriteTime(const std::filesystem::path& path, const std::vector<std::filesystem::path>& includes)
+{
+	uint64 lastWriteTime = Platform::GetLastWriteTime(path);
+
+	for (const std::filesystem::path& include : includes)
+	{
+		// Includes that were deleted show up as errors once the shader is recompiled.
+		if (Platform::FileExists(include.string()))
+		{
+			lastWriteTime = std::max(lastWriteTime, Platform::GetLastWriteTime(include));
+		}
+	}
+
+	return lastWriteTime;
+}
+
+/**
+  * Preprocess a shader and load its binary from the cache, or compile and reflect it and cache the binary.
+  * Cooking always compiles, and stores the binary even if the cache is disabled.
+  * Sources that fail to preprocess or compile are retried until they're fixed or the user cancels.
+  */
+static ShaderBinary CompileShaderBinary(
 	const ShaderCompilerWorker& worker,
 	const std::filesystem::path& path,
 	const std::string& entrypoint,
-	EShaderStage stage
+	EShaderStage stage,
+	bool isCooking,
+	bool& isCached
 )
 {
 	shaderc::CompileOptions compileOptions;
-	compileOptions.SetForcedVersionProfile(450, shaderc_profile::shaderc_profile_none);
-	compileOptions.SetIncluder(std::make_unique<ShadercIncluder>());
+	VulkanShaderCache::SetCompileOptions(compileOptions);
+
+	auto includer = std::make_unique<ShadercIncluder>();
+	const ShadercIncluder& includes = *includer;
+	compileOptions.SetIncluder(std::move(includer));
 
 	const shaderc_shader_kind shaderKind = [&] ()
 	{
@@ -250,20 +302,48 @@ ShaderCompilationResult VulkanDevice::CompileShader(
 
 	const auto& shaderTypesReflected = gpu::GetShaderTypeReflectionTasks();
 
-	shaderc::Compiler compiler;
+	const bool isCacheEnabled = VulkanShaderCache::IsEnabled();
+
+	// Compilers aren't thread-safe, so each worker has its own.
+	thread_local shaderc::Compiler compiler;
+
 	shaderc::SpvCompilationResult spvCompilationResult;
+	std::string preprocessedSource;
+	bool isCompiled = false;
 
 	do
 	{
 		const std::string sourceText = Platform::FileRead(path, shaderTypesReflected);
 
-		spvCompilationResult = compiler.CompileGlslToSpv(sourceText, shaderKind, path.string().c_str(), entrypoint.c_str(), compileOptions);
+		// The preprocessed source has every include, define and reflected struct, so it keys the cache without tracking them.
+		const shaderc::PreprocessedSourceCompilationResult preprocessResult = compiler.PreprocessGlsl(sourceText, shaderKind, path.string().c_str(), compileOptions);
+
+		std::string errorMessage = preprocessResult.GetErrorMessage();
+
+		if (preprocessResult.GetNumErrors() == 0)
+		{
+			preprocessedSource.assign(preprocessResult.begin(), preprocessResult.end());
+
+			if (isCacheEnabled && !isCooking)
+			{
+				if (std::optional<ShaderBinary> binary = VulkanShaderCache::Load(VulkanShaderCache::GetKey(preprocessedSource, entrypoint, stage), preprocessedSource))
+				{
+					binary->includes = includes.GetIncludes();
+					isCached = true;
+					return std::move(*binary);
+				}
+			}
+
+			spvCompilationResult = compiler.CompileGlslToSpv(sourceText, shaderKind, path.string().c_str(), entrypoint.c_str(), compileOptions);
+			errorMessage = spvCompilationResult.GetErrorMessage();
+			isCompiled = spvCompilationResult.GetNumErrors() == 0;
+		}
 
-		if (spvCompilationResult.GetNumErrors() > 0)
+		if (!isCompiled)
 		{
 			const EMBReturn ret = Platform::DisplayMessageBox(
 				EMBType::RETRYCANCEL, EMBIcon::WARNING, 
-				"Failed to compile " + path.string() + "\n\n" + spvCompilationResult.GetErrorMessage().c_str(), "Shader Compiler"
+				"Failed to compile " + path.string() + "\n\n" + errorMessage, "Shader Compiler"
 			);
 
 			if (ret == EMBReturn::CANCEL)
@@ -271,57 +351,190 @@ ShaderCompilationResult VulkanDevice::CompileShader(
 				Platform::Exit();
 			}
 		}
-	} while (spvCompilationResult.GetNumErrors() > 0);
+	} while (!isCompiled);
+
+	ShaderBinary binary;
+	binary.code.assign(spvCompilationResult.begin(), spvCompilationResult.end());
+	binary.includes = includes.GetIncludes();
+
+	const spirv_cross::CompilerGLSL glsl(binary.code.data(), binary.code.size());
+	const spirv_cross::ShaderResources resources = glsl.get_shader_resources();
+
+	if (stage == EShaderStage::Vertex)
+	{
+		binary.vertexAttributeDescriptions = ReflectVertexAttributeDescriptions(glsl, resources);
+	}
+
+	ReflectDescriptorSets(glsl, resources, binary);
+
+	binary.pushConstantRange = ReflectPushConstantRange(glsl, resources, static_cast<VkShaderStageFlags>(stage));
+
+	if (isCacheEnabled || isCooking)
+	{
+		VulkanShaderCache::Store(VulkanShaderCache::GetKey(preprocessedSource, entrypoint, stage), preprocessedSource, binary);
+	}
+
+	isCached = false;
+
+	return binary;
+}
+
+ShaderCompilationResult VulkanDevice::CompileShader(
+	const ShaderCompilerWorker& worker,
+	const std::filesystem::path& path,
+	const std::string& entrypoint,
+	EShaderStage stage
+)
+{
+	bool isCached = false;
 
-	const std::vector<uint32> code(spvCompilationResult.begin(), spvCompilationResult.end());
+	const ShaderBinary binary = CompileShaderBinary(worker, path, entrypoint, stage, false, isCached);
+
+	_NumShadersCompiled += isCached ? 0 : 1;
 
 	VkShaderModuleCreateInfo shaderModuleCreateInfo = { VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
-	shaderModuleCreateInfo.codeSize = code.size() * sizeof(uint32);
-	shaderModuleCreateInfo.pCode = code.data();
+	shaderModuleCreateInfo.codeSize = binary.code.size() * sizeof(uint32);
+	shaderModuleCreateInfo.pCode = binary.code.data();
 
 	VkShaderModule shaderModule;
 	vulkan(vkCreateShaderModule(_Device, &shaderModuleCreateInfo, nullptr, &shaderModule));
 
-	const spirv_cross::CompilerGLSL glsl(code.data(), code.size());
-	const spirv_cross::ShaderResources resources = glsl.get_shader_resources();
+	const auto descriptorSetLayouts = CreateDescriptorSetLayouts(*this, binary);
+
+	ShaderCompilationResult compilationResult(path, entrypoint, stage, GetLastWriteTime(path, binary.includes), worker,
+		shaderModule, binary.vertexAttributeDescriptions, descriptorSetLayouts, binary.pushConstantRange);
+	compilationResult.includes = binary.includes;
+
+	return compilationResult;
+}
+
+void VulkanDevice::CompileShaders(const std::vector<ShaderCompilationTask>& tasks, const ShaderCompilationProgress& progress)
+{
+	std::mutex progressMutex;
+	uint32 numCompiled = 0;
 
-	const auto vertexAttributeDescriptions = [&] () -> std::vector<VertexAttributeDescription>
+	JobSystem::Get().ParallelFor(tasks.size(), [&] (std::size_t taskIndex)
 	{
-		if (stage == EShaderStage::Vertex)
+		const ShaderCompilationTask& task = tasks[taskIndex];
+
+		task.shader->compilationResult = CompileShader(task.worker, task.path, task.entrypoint, task.stage);
+
+		if (progress)
 		{
-			return ReflectVertexAttributeDescriptions(glsl, resources);
+			std::lock_guard lock(progressMutex);
+			progress(++numCompiled, static_cast<uint32>(tasks.size()));
 		}
+	}, 1);
+}
 
-		return {};
-	}();
+void VulkanDevice::CookShaders()
+{
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	const auto& tasks = gpu::GetShaderCompilationTasks();
+
+	JobSystem::Get().ParallelFor(tasks.size(), [&] (std::size_t taskIndex)
+	{
+		const ShaderCompilationTask& task = tasks[taskIndex];
+
+		bool isCached = false;
+		CompileShaderBinary(task.worker, task.path, task.entrypoint, task.stage, true, isCached);
+	}, 1);
 
-	const auto descriptorSetLayouts = ReflectDescriptorSetLayouts(*this, glsl, resources);
+	const float cookMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
 
-	const auto pushConstantRange = ReflectPushConstantRange(glsl, resources, static_cast<VkShaderStageFlags>(stage));
-	
-	return ShaderCompilationResult(path, entrypoint, stage, Platform::GetLastWriteTime(path), worker,
-		shaderModule, vertexAttributeDescriptions, descriptorSetLayouts, pushConstantRange);
+	LOG("Cooked %zu shaders in %.1f ms.", tasks.size(), cookMs);
 }
 
 void VulkanDevice::RecompileShaders()
 {
+	std::unordered_set<const gpu::Shader*> shaders;
+
 	for (const auto& [typeIndex, shader] : _Shaders)
 	{
 		const auto& compilationResult = shader->compilationResult;
-		const uint64 lastWriteTime = Platform::GetLastWriteTime(compilationResult.path);
 
-		if (lastWriteTime > compilationResult.lastWriteTime)
+		if (GetLastWriteTime(compilationResult.path, compilationResult.includes) > compilationResult.lastWriteTime)
+		{
+			shaders.insert(shader);
+		}
+	}
+
+	RecompileShaders(shaders);
+}
+
+void VulkanDevice::RecompileShaders(const std::vector<std::filesystem::path>& changedFiles)
+{
+	std::unordered_set<const gpu::Shader*> shaders;
+
+	for (const std::filesystem::path& changedFile : changedFiles)
+	{
+		if (auto iter = _ShaderDependents.find(changedFile.lexically_normal().generic_string()); iter != _ShaderDependents.end())
+		{
+			shaders.insert(iter->second.begin(), iter->second.end());
+		}
+	}
+
+	RecompileShaders(shaders);
+}
+
+void VulkanDevice::RecompileShaders(const std::unordered_set<const gpu::Shader*>& shaders)
+{
+	if (shaders.empty())
+	{
+		return;
+	}
+
+	const auto startTime = std::chrono::high_resolution_clock::now();
+
+	// Pipelines being created in the background use the shader modules that are about to be replaced.
+	FlushPipelineCompiler();
+
+	std::vector<ShaderCompilationTask> tasks;
+	std::vector<VkShaderModule> oldShaderModules;
+
+	for (const auto& [typeIndex, shader] : _Shaders)
+	{
+		if (shaders.contains(shader))
 		{
-			// Destroy the old shader module.
-			vkDestroyShaderModule(_Device, compilationResult.shaderModule, nullptr);
-
-			shader->compilationResult = CompileShader(
-				compilationResult.worker,
-				compilationResult.path,
-				compilationResult.entrypoint,
-				compilationResult.stage);
+			const auto& compilationResult = shader->compilationResult;
+
+			tasks.push_back({ typeIndex, shader, compilationResult.path, compilationResult.entrypoint, compilationResult.stage, compilationResult.worker });
+			oldShaderModules.push_back(compilationResult.shaderModule);
 		}
 	}
 
-	RecompilePipelines();
-}
\ No newline at end of file
+	CompileShaders(tasks);
+
+	// Destroy the old shader modules.
+	for (VkShaderModule shaderModule : oldShaderModules)
+	{
+		vkDestroyShaderModule(_Device, shaderModule, nullptr);
+	}
+
+	// Edits may have added or removed includes.
+	UpdateShaderDependents();
+
+	const std::size_t numPipelines = RecompilePipelines(shaders);
+
+	const float recompileMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+
+	LOG("Recompiled %zu shaders and %zu pipelines in %.1f ms.", tasks.size(), numPipelines, recompileMs);
+}
+
+void VulkanDevice::UpdateShaderDependents()
+{
+	_ShaderDependents.clear();
+
+	for (const auto& [typeIndex, shader] : _Shaders)
+	{
+		const auto& compilationResult = shader->compilationResult;
+
+		_ShaderDependents[compilationResult.path.lexically_normal().generic_string()].push_back(shader);
+
+		for (const std::filesystem::path& include : compilationResult.includes)
+		{
+			_ShaderDependents[include.generic_string()].push_back(shader);
+		}
+	}
+}
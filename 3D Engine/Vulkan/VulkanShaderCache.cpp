@@ -0,0 +1,242 @@
+#include "VulkanShaderCache.h"
+#include <shaderc/shaderc.hpp>
+
+static constexpr uint32 cachedShaderMagic = 0x52444853; // "SHDR"
+
+/**
+  * A cached shader is a header, then the SPIR-V, vertex attributes, bindings and bindless sets, then the preprocessed source.
+  * Every table has 4-byte members, so the tables are aligned.
+  */
+struct CachedShaderHeader
+{
+	uint32 magic;
+	uint32 version;
+	uint64 key;
+	uint32 codeSize;
+	uint32 numVertexAttributes;
+	uint32 numBindings;
+	uint32 numBindlessSets;
+	uint32 sourceSize;
+	VkPushConstantRange pushConstantRange;
+	uint32 fileSize;
+	/** Pads the header to the key's alignment, so no byte of it is left uninitialized. */
+	uint32 reserved;
+};
+
+struct CachedBinding
+{
+	uint32 set;
+	uint32 binding;
+	VkDescriptorType descriptorType;
+	uint32 descriptorCount;
+	VkShaderStageFlags stageFlags;
+};
+
+struct CachedBindlessSet
+{
+	uint32 set;
+	VkDescriptorType descriptorType;
+};
+
+static_assert(sizeof(CachedShaderHeader) % sizeof(uint32) == 0 && sizeof(VertexAttributeDescription) % sizeof(uint32) == 0);
+
+bool VulkanShaderCache::IsEnabled()
+{
+	return Platform::GetBool("Engine.ini", "Renderer", "ShaderCache", true);
+}
+
+/** The options every shader is compiled with. */
+struct ShaderCompileSettings
+{
+	int32 glslVersion;
+	shaderc_profile profile;
+	shaderc_optimization_level optimizationLevel;
+	shaderc_target_env targetEnv;
+	uint32 targetEnvVersion;
+};
+
+static constexpr ShaderCompileSettings compileSettings =
+{
+	.glslVersion = 450,
+	.profile = shaderc_profile_none,
+	.optimizationLevel = shaderc_optimization_level_zero,
+	.targetEnv = shaderc_target_env_vulkan,
+	.targetEnvVersion = shaderc_env_version_vulkan_1_0,
+};
+
+void VulkanShaderCache::SetCompileOptions(shaderc::CompileOptions& compileOptions)
+{
+	compileOptions.SetForcedVersionProfile(compileSettings.glslVersion, compileSettings.profile);
+	compileOptions.SetOptimizationLevel(compileSettings.optimizationLevel);
+	compileOptions.SetTargetEnvironment(compileSettings.targetEnv, compileSettings.targetEnvVersion);
+}
+
+uint64 VulkanShaderCache::GetCompilerFingerprint()
+{
+	static const uint64 fingerprint = [] ()
+	{
+		static constexpr const char* probeSource =
+			"layout(local_size_x = 64) in;\n"
+			"layout(binding = 0) buffer Data { vec4 _Data[]; };\n"
+			"void main() { _Data[gl_GlobalInvocationID.x] = normalize(_Data[gl_GlobalInvocationID.x]) * 2.0f; }\n";
+
+		shaderc::CompileOptions compileOptions;
+		SetCompileOptions(compileOptions);
+
+		const shaderc::Compiler compiler;
+		const shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(probeSource, shaderc_compute_shader, "Probe", "main", compileOptions);
+
+		check(result.GetNumErrors() == 0, "Failed to compile the shader cache's probe shader: %s", result.GetErrorMessage().c_str());
+
+		const std::vector<uint32> code(result.begin(), result.end());
+
+		return Platform::Hash64(code.data(), code.size() * sizeof(uint32));
+	}();
+
+	return fingerprint;
+}
+
+uint64 VulkanShaderCache::GetKey(const std::string& preprocessedSource, const std::string& entrypoint, EShaderStage stage)
+{
+	uint32 spvVersion = 0;
+	uint32 spvRevision = 0;
+	shaderc_get_spv_version(&spvVersion, &spvRevision);
+
+	// The source is hashed on its own, so it isn't copied into the key bytes.
+	std::string keyBytes;
+	AppendKeyBytes(keyBytes, Platform::Hash64(preprocessedSource.data(), preprocessedSource.size()));
+	AppendKeyBytes(keyBytes, static_cast<uint32>(entrypoint.size()));
+	keyBytes.append(entrypoint);
+	AppendKeyBytes(keyBytes, stage);
+	AppendKeyBytes(keyBytes, spvVersion);
+	AppendKeyBytes(keyBytes, spvRevision);
+	AppendKeyBytes(keyBytes, compileSettings);
+	AppendKeyBytes(keyBytes, GetCompilerFingerprint());
+	AppendKeyBytes(keyBytes, cacheVersion);
+
+	return Platform::Hash64(keyBytes.data(), keyBytes.size());
+}
+
+std::optional<ShaderBinary> VulkanShaderCache::Load(uint64 key, const std::string& preprocessedSource)
+{
+	const MappedFile file(GetCachePath(key));
+
+	if (!file.IsOpen() || file.GetSize() < sizeof(CachedShaderHeader))
+	{
+		return std::nullopt;
+	}
+
+	const CachedShaderHeader* header = reinterpret_cast<const CachedShaderHeader*>(file.GetData());
+
+	const std::size_t tablesSize = header->codeSize * sizeof(uint32)
+		+ header->numVertexAttributes * sizeof(VertexAttributeDescription)
+		+ header->numBindings * sizeof(CachedBinding)
+		+ header->numBindlessSets * sizeof(CachedBindlessSet);
+
+	if (header->magic != cachedShaderMagic || header->version != cacheVersion || header->key != key || header->fileSize != file.GetSize()
+		|| sizeof(CachedShaderHeader) + tablesSize + header->sourceSize != file.GetSize())
+	{
+		return std::nullopt;
+	}
+
+	const uint32* code = reinterpret_cast<const uint32*>(header + 1);
+	const VertexAttributeDescription* vertexAttributes = reinterpret_cast<const VertexAttributeDescription*>(code + header->codeSize);
+	const CachedBinding* bindings = reinterpret_cast<const CachedBinding*>(vertexAttributes + header->numVertexAttributes);
+	const CachedBindlessSet* bindlessSets = reinterpret_cast<const CachedBindlessSet*>(bindings + header->numBindings);
+	const char* source = reinterpret_cast<const char*>(bindlessSets + header->numBindlessSets);
+
+	if (std::string_view(source, header->sourceSize) != preprocessedSource)
+	{
+		return std::nullopt;
+	}
+
+	ShaderBinary binary;
+	binary.code.assign(code, code + header->codeSize);
+	binary.vertexAttributeDescriptions.assign(vertexAttributes, vertexAttributes + header->numVertexAttributes);
+
+	for (uint32 bindingIndex = 0; bindingIndex < header->numBindings; bindingIndex++)
+	{
+		const CachedBinding& binding = bindings[bindingIndex];
+
+		binary.bindings[binding.set].push_back({
+			.binding = binding.binding,
+			.descriptorType = binding.descriptorType,
+			.descriptorCount = binding.descriptorCount,
+			.stageFlags = binding.stageFlags
+		});
+	}
+
+	for (uint32 setIndex = 0; setIndex < header->numBindlessSets; setIndex++)
+	{
+		binary.bindlessSets.insert({ bindlessSets[setIndex].set, bindlessSets[setIndex].descriptorType });
+	}
+
+	binary.pushConstantRange = header->pushConstantRange;
+
+	return binary;
+}
+
+void VulkanShaderCache::Store(uint64 key, const std::string& preprocessedSource, const ShaderBinary& binary)
+{
+	std::vector<CachedBinding> bindings;
+
+	for (const auto& [set, setBindings] : binary.bindings)
+	{
+		for (const VkDescriptorSetLayoutBinding& binding : setBindings)
+		{
+			bindings.push_back({ set, binding.binding, binding.descriptorType, binding.descriptorCount, binding.stageFlags });
+		}
+	}
+
+	std::vector<CachedBindlessSet> bindlessSets;
+
+	for (const auto& [set, descriptorType] : binary.bindlessSets)
+	{
+		bindlessSets.push_back({ set, descriptorType });
+	}
+
+	const std::size_t codeBytes = binary.code.size() * sizeof(uint32);
+	const std::size_t vertexAttributeBytes = binary.vertexAttributeDescriptions.size() * sizeof(VertexAttributeDescription);
+	const std::size_t bindingBytes = bindings.size() * sizeof(CachedBinding);
+	const std::size_t bindlessSetBytes = bindlessSets.size() * sizeof(CachedBindlessSet);
+
+	const CachedShaderHeader header =
+	{
+		.magic = cachedShaderMagic,
+		.version = cacheVersion,
+		.key = key,
+		.codeSize = static_cast<uint32>(binary.code.size()),
+		.numVertexAttributes = static_cast<uint32>(binary.vertexAttributeDescriptions.size()),
+		.numBindings = static_cast<uint32>(bindings.size()),
+		.numBindlessSets = static_cast<uint32>(bindlessSets.size()),
+		.sourceSize = static_cast<uint32>(preprocessedSource.size()),
+		.pushConstantRange = binary.pushConstantRange,
+		.fileSize = static_cast<uint32>(sizeof(header) + codeBytes + vertexAttributeBytes + bindingBytes + bindlessSetBytes + preprocessedSource.size()),
+	};
+
+	std::string file(header.fileSize, '\0');
+	char* dst = file.data();
+
+	Platform::Memcpy(dst, &header, sizeof(header));
+	dst += sizeof(header);
+	Platform::Memcpy(dst, binary.code.data(), codeBytes);
+	dst += codeBytes;
+	Platform::Memcpy(dst, binary.vertexAttributeDescriptions.data(), vertexAttributeBytes);
+	dst += vertexAttributeBytes;
+	Platform::Memcpy(dst, bindings.data(), bindingBytes);
+	dst += bindingBytes;
+	Platform::Memcpy(dst, bindlessSets.data(), bindlessSetBytes);
+	dst += bindlessSetBytes;
+	Platform::Memcpy(dst, preprocessedSource.data(), preprocessedSource.size());
+
+	const std::filesystem::path path = GetCachePath(key);
+
+	std::filesystem::create_directories(path.parent_path());
+
+	Platform::FileWrite(path, file);
+}
+
+std::filesystem::path VulkanShaderCache::GetCachePath(uint64 key)
+{
+	return std::filesystem::path("../Cooked/Shaders") / Platform::FormatString("%016llx.shader", key);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <GPU/GPUShader.h>
+#include <optional>
+
+namespace shaderc
+{
+	class CompileOptions;
+}
+
+/** SPIR-V of a shader and what was reflected from it. Nothing here depends on a device, so binaries can be cooked offline. */
+struct ShaderBinary
+{
+	std::vector<uint32> code;
+
+	/** (Vertex shader only.) Reflected vertex attribute descriptions. */
+	std::vector<VertexAttributeDescription> vertexAttributeDescriptions;
+
+	/** Bindings of each descriptor set that isn't bindless. */
+	std::map<uint32, std::vector<VkDescriptorSetLayoutBinding>> bindings;
+
+	/** Bindless descriptor sets, which use the device's layouts. COMBINED_IMAGE_SAMPLER for textures, STORAGE_IMAGE for images. */
+	std::map<uint32, VkDescriptorType> bindlessSets;
+
+	VkPushConstantRange pushConstantRange = {};
+
+	/** Files included while preprocessing. They're found again each time the shader is preprocessed, so they aren't cached. */
+	std::vector<std::filesystem::path> includes;
+};
+
+/**
+  * Caches shader binaries in ../Cooked/Shaders, keyed by the preprocessed source, which has every include, define and
+  * reflected struct, with the entrypoint, stage, compile options and a fingerprint of the compiler. Entries store the
+  * preprocessed source to rule out key collisions. Edited shaders, compile options and compilers get new keys, so entries
+  * are never stale, only unused.
+  */
+class VulkanShaderCache
+{
+public:
+	/** Bump to invalidate cached shaders after changing the reflection or the file layout. */
+	static constexpr uint32 cacheVersion = 2;
+
+	/** ShaderCache in Engine.ini. If disabled, shaders are always compiled and the cache is left alone. */
+	static bool IsEnabled();
+
+	/** Set the options every shader is compiled with. They're part of the key, so they're only set here. */
+	static void SetCompileOptions(shaderc::CompileOptions& compileOptions);
+
+	static uint64 GetKey(const std::string& preprocessedSource, const std::string& entrypoint, EShaderStage stage);
+
+	/** Load the binary of a preprocessed source, if it was cached. */
+	static std::optional<ShaderBinary> Load(uint64 key, const std::string& preprocessedSource);
+
+	static void Store(uint64 key, const std::string& preprocessedSource, const ShaderBinary& binary);
+
+private:
+	static std::filesystem::path GetCachePath(uint64 key);
+
+	/**
+	  * Hash of a probe shader's SPIR-V. shaderc doesn't report its version, but the SPIR-V header has glslang's generator
+	  * version, and any change to code generation changes the code itself.
+	  */
+	static uint64 GetCompilerFingerprint();
+};
@@ -0,0 +1,93 @@
+#include "VulkanTimestampQueries.h"
+#include "VulkanDevice.h"
+#include "VulkanPhysicalDevice.h"
+
+VulkanTimestampQueries::VulkanTimestampQueries(VulkanDevice& device, uint32 maxTimestamps, uint32 numFramesInFlight)
+	: _Device(device)
+	, _MaxTimestamps(maxTimestamps)
+	, _QueryPools(numFramesInFlight)
+	, _NumTimestamps(numFramesInFlight, 0)
+	, _Ticks(maxTimestamps)
+{
+	// timestampPeriod is the number of nanoseconds per tick.
+	_MillisecondsPerTick = device.GetPhysicalDevice().GetProperties().limits.timestampPeriod / 1e6;
+
+	uint32 numQueueFamilies = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(device.GetPhysicalDevice(), &numQueueFamilies, nullptr);
+
+	std::vector<VkQueueFamilyProperties> queueFamilies(numQueueFamilies);
+	vkGetPhysicalDeviceQueueFamilyProperties(device.GetPhysicalDevice(), &numQueueFamilies, queueFamilies.data());
+
+	for (const VkQueueFamilyProperties& queueFamily : queueFamilies)
+	{
+		_TimestampValidBits.push_back(queueFamily.timestampValidBits);
+	}
+
+	const VkQueryPoolCreateInfo queryPoolInfo =
+	{
+		.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+		.queryType = VK_QUERY_TYPE_TIMESTAMP,
+		.queryCount = maxTimestamps,
+	};
+
+	for (auto& queryPool : _QueryPools)
+	{
+		vulkan(vkCreateQueryPool(_Device, &queryPoolInfo, nullptr, &queryPool));
+	}
+}
+
+VulkanTimestampQueries::~VulkanTimestampQueries()
+{
+	for (auto queryPool : _QueryPools)
+	{
+		vkDestroyQueryPool(_Device, queryPool, nullptr);
+	}
+}
+
+uint32 VulkanTimestampQueries::Write(gpu::CommandBuffer& cmdBuf)
+{
+	uint32& numTimestamps = _NumTimestamps[_FrameIndex];
+
+	// E.g. dedicated compute families that don't support timestamps. Their passes aren't timed.
+	if (numTimestamps == _MaxTimestamps || _TimestampValidBits[cmdBuf._Queue.GetQueueFamilyIndex()] == 0)
+	{
+		return invalidTimestamp;
+	}
+
+	// The pool is reset by the first command buffer to write a timestamp in the frame.
+	if (numTimestamps == 0)
+	{
+		vkCmdResetQueryPool(cmdBuf._CommandBuffer, _QueryPools[_FrameIndex], 0, _MaxTimestamps);
+	}
+
+	vkCmdWriteTimestamp(cmdBuf._CommandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, _QueryPools[_FrameIndex], numTimestamps);
+
+	return numTimestamps++;
+}
+
+void VulkanTimestampQueries::EndFrame(uint32 frameIndex)
+{
+	_FrameIndex = frameIndex;
+
+	uint32& numTimestamps = _NumTimestamps[_FrameIndex];
+
+	_CompletedTimestamps.clear();
+
+	if (numTimestamps > 0)
+	{
+		const VkResult result = vkGetQueryPoolResults(
+			_Device, _QueryPools[_FrameIndex], 0, numTimestamps,
+			numTimestamps * sizeof(uint64), _Ticks.data(), sizeof(uint64), VK_QUERY_RESULT_64_BIT);
+
+		// Not ready if the command buffer that wrote the timestamps was never submitted.
+		if (result == VK_SUCCESS)
+		{
+			for (uint32 i = 0; i < numTimestamps; i++)
+			{
+				_CompletedTimestamps.push_back(static_cast<double>(_Ticks[i] - _Ticks[0]) * _MillisecondsPerTick);
+			}
+		}
+	}
+
+	numTimestamps = 0;
+}
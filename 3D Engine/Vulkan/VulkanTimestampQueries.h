@@ -0,0 +1,48 @@
+#pragma once
+#include <Engine/Types.h>
+#include <vulkan/vulkan.h>
+#include <limits>
+
+class VulkanDevice;
+
+namespace gpu
+{
+	class CommandBuffer;
+}
+
+/** GPU timestamps with a query pool per frame in flight. Results are read back once the frame that wrote them has completed. */
+class VulkanTimestampQueries
+{
+public:
+	static constexpr uint32 invalidTimestamp = std::numeric_limits<uint32>::max();
+
+	VulkanTimestampQueries(const VulkanTimestampQueries&) = delete;
+	VulkanTimestampQueries& operator=(const VulkanTimestampQueries&) = delete;
+	VulkanTimestampQueries(VulkanDevice& device, uint32 maxTimestamps, uint32 numFramesInFlight);
+	~VulkanTimestampQueries();
+
+	/** Write a timestamp once all prior commands have completed. Returns its index in the frame, or invalidTimestamp if the frame is out of queries. */
+	uint32 Write(gpu::CommandBuffer& cmdBuf);
+
+	/** Called in VulkanDevice::EndFrame() after the frame at frameIndex has completed. */
+	void EndFrame(uint32 frameIndex);
+
+	/** Timestamps in milliseconds written by the last completed frame in the current slot. */
+	inline const std::vector<double>& GetCompletedTimestamps() const { return _CompletedTimestamps; }
+
+private:
+	VulkanDevice&			_Device;
+	uint32					_MaxTimestamps;
+	double					_MillisecondsPerTick;
+	uint32					_FrameIndex = 0;
+	std::vector<VkQueryPool> _QueryPools;
+
+	/** timestampValidBits of each queue family. 0 if the family can't write timestamps. */
+	std::vector<uint32>		_TimestampValidBits;
+
+	/** Timestamps written in each frame in flight. */
+	std::vector<uint32>		_NumTimestamps;
+
+	std::vector<uint64>		_Ticks;
+	std::vector<double>		_CompletedTimestamps;
+};
@@ -0,0 +1,52 @@
+#include "VulkanUploadRing.h"
+#include "VulkanDevice.h"
+#include "VulkanPhysicalDevice.h"
+
+VulkanUploadRing::VulkanUploadRing(VulkanDevice& device, uint64 size, uint32 numFramesInFlight)
+	: _Size(size)
+	, _FrameHeads(numFramesInFlight, 0)
+{
+	const VkPhysicalDeviceLimits& limits = device.GetPhysicalDevice().GetProperties().limits;
+
+	_Alignment = std::max<uint64>({ limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment, 16 });
+	
+	_Buffer = device.CreateBuffer(
+		EBufferUsage::Uniform | EBufferUsage::Storage | EBufferUsage::Vertex | EBufferUsage::Index, 
+		EMemoryUsage::CPU_TO_GPU, 
+		_Size);
+
+	_Data = static_cast<uint8*>(_Buffer.GetData());
+}
+
+gpu::UploadAllocation VulkanUploadRing::Allocate(uint64 size, uint64 alignment)
+{
+	alignment = alignment == 0 ? _Alignment : alignment;
+
+	// Align the physical offset, since the size of the ring needn't be a multiple of the alignment.
+	const uint64 wrapStart = _Head - _Head % _Size;
+	uint64 physicalOffset = DivideAndRoundUp(_Head % _Size, alignment) * alignment;
+	uint64 offset = wrapStart + physicalOffset;
+
+	// Allocations never straddle the end of the ring.
+	if (physicalOffset + size > _Size)
+	{
+		physicalOffset = 0;
+		offset = wrapStart + _Size;
+	}
+
+	check(offset + size - _Tail <= _Size, "Upload ring is out of memory (%llu bytes). Increase Renderer.UploadRingSize.", _Size);
+
+	_Head = offset + size;
+
+	return gpu::UploadAllocation{ &_Buffer, physicalOffset, size, _Data + physicalOffset };
+}
+
+void VulkanUploadRing::EndFrame(uint32 frameIndex)
+{
+	_FrameHeads[_FrameIndex] = _Head;
+
+	_FrameIndex = frameIndex;
+
+	// Everything allocated before the end of the completed frame is free.
+	_Tail = std::max(_Tail, _FrameHeads[_FrameIndex]);
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include "VulkanBuffer.h"
+
+namespace gpu
+{
+	/** Transient memory sub-allocated from the upload ring. Only valid for the frame it was allocated in. */
+	struct UploadAllocation
+	{
+		const Buffer* buffer = nullptr;
+		uint64 offset = 0;
+		uint64 size = 0;
+		void* data = nullptr;
+	};
+}
+
+/** A persistently mapped ring buffer that's linearly sub-allocated each frame. Memory is reclaimed when the frame completes. */
+class VulkanUploadRing
+{
+public:
+	VulkanUploadRing(const VulkanUploadRing&) = delete;
+	VulkanUploadRing& operator=(const VulkanUploadRing&) = delete;
+	VulkanUploadRing(VulkanDevice& device, uint64 size, uint32 numFramesInFlight);
+
+	/** 
+	  * Allocate memory for the current frame. By default the offset satisfies uniform, storage, vertex and index buffer alignment.
+	  * Pass the element size as the alignment to index into the ring as an array of elements.
+	  */
+	gpu::UploadAllocation Allocate(uint64 size, uint64 alignment = 0);
+
+	/** Called in VulkanDevice::EndFrame() after the frame at frameIndex has completed. */
+	void EndFrame(uint32 frameIndex);
+
+	inline const gpu::Buffer& GetBuffer() const { return _Buffer; }
+	inline uint64 GetSize() const { return _Size; }
+	inline uint64 GetBytesInFlight() const { return _Head - _Tail; }
+
+private:
+	gpu::Buffer			_Buffer;
+	uint8*				_Data;
+	uint64				_Size;
+	uint64				_Alignment;
+
+	/** Head and tail are monotonic. Their physical offset is modulo the size of the ring. */
+	uint64				_Head = 0;
+	uint64				_Tail = 0;
+
+	uint32				_FrameIndex = 0;
+
+	/** Head of the ring at the end of each frame in flight. */
+	std::vector<uint64>	_FrameHeads;
+};
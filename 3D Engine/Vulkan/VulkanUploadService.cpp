@@ -0,0 +1,366 @@
+#include "VulkanUploadService.h"
+#include "VulkanDevice.h"
+#include "VulkanPhysicalDevice.h"
+
+VulkanUploadService::VulkanUploadService(VulkanDevice& device, VulkanQueue& transferQueue, VulkanQueue& graphicsQueue, uint64 stagingSize)
+	: _Device(device)
+	, _TransferQueue(transferQueue)
+	, _GraphicsQueue(graphicsQueue)
+	, _StagingSize(stagingSize)
+	, _IsOwnershipTransferred(transferQueue.GetQueueFamilyIndex() != graphicsQueue.GetQueueFamilyIndex())
+{
+	const VkPhysicalDeviceLimits& limits = device.GetPhysicalDevice().GetProperties().limits;
+
+	// Buffer to image copies need offsets that are a multiple of the texel size and of 4.
+	_Alignment = std::max<uint64>(limits.optimalBufferCopyOffsetAlignment, 16);
+
+	_StagingBuffer = device.CreateBuffer(EBufferUsage::None, EMemoryUsage::CPU_ONLY, _StagingSize);
+
+	_StagingData = static_cast<uint8*>(_StagingBuffer.GetData());
+
+	const VkCommandPoolCreateInfo commandPoolInfo =
+	{
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT,
+		.queueFamilyIndex = static_cast<uint32>(_TransferQueue.GetQueueFamilyIndex()),
+	};
+
+	vulkan(vkCreateCommandPool(_Device, &commandPoolInfo, nullptr, &_CommandPool));
+}
+
+VulkanUploadService::~VulkanUploadService()
+{
+	vkDestroyCommandPool(_Device, _CommandPool, nullptr);
+}
+
+gpu::UploadTicket VulkanUploadService::UploadBufferData(const gpu::Buffer& dstBuffer, uint64 dstOffset, uint64 size, const void* data)
+{
+	check(dstOffset + size <= dstBuffer.GetSize(), "Upload of %llu bytes at offset %llu overflows the buffer.", size, dstOffset);
+
+	const auto [stagingBuffer, stagingOffset] = AllocateStaging(size, data);
+
+	VkCommandBuffer cmdBuf = GetCommandBuffer();
+
+	const VkBufferCopy region = { stagingOffset, dstOffset, size };
+
+	vkCmdCopyBuffer(cmdBuf, stagingBuffer, dstBuffer, 1, &region);
+
+	if (_IsOwnershipTransferred)
+	{
+		VkBufferMemoryBarrier barrier =
+		{
+			.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+			.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+			.dstAccessMask = 0,
+			.srcQueueFamilyIndex = static_cast<uint32>(_TransferQueue.GetQueueFamilyIndex()),
+			.dstQueueFamilyIndex = static_cast<uint32>(_GraphicsQueue.GetQueueFamilyIndex()),
+			.buffer = dstBuffer,
+			.offset = dstOffset,
+			.size = size,
+		};
+
+		vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 1, &barrier, 0, nullptr);
+
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+
+		GetPendingAcquire().bufferBarriers.push_back(barrier);
+	}
+
+	// Without an ownership transfer, the semaphore the graphics queue waits on makes the copy visible.
+
+	return _Recording.ticket;
+}
+
+gpu::UploadTicket VulkanUploadService::UploadImageData(const gpu::Image& dstImage, const void* srcPixels)
+{
+	const uint32 layerCount = Any(dstImage.GetUsage() & EImageUsage::Cubemap) ? 6 : 1;
+	const uint32 mipLevels = dstImage.GetMipLevels();
+
+	auto getMipExtent = [&] (uint32 mip) -> VkExtent3D
+	{
+		return { std::max(dstImage.GetWidth() >> mip, 1u), std::max(dstImage.GetHeight() >> mip, 1u), std::max(dstImage.GetDepth() >> mip, 1u) };
+	};
+
+	uint64 size = 0;
+
+	for (uint32 mip = 0; mip < mipLevels; mip++)
+	{
+		const VkExtent3D extent = getMipExtent(mip);
+		size += gpu::Image::GetMipSize(dstImage.GetFormat(), extent.width, extent.height) * extent.depth * layerCount;
+	}
+
+	const auto [stagingBuffer, stagingOffset] = AllocateStaging(size, srcPixels);
+
+	VkCommandBuffer cmdBuf = GetCommandBuffer();
+
+	VkImageMemoryBarrier barrier =
+	{
+		.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+		.srcAccessMask = 0,
+		.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.image = dstImage,
+		.subresourceRange = { dstImage.GetVulkanAspect(), 0, mipLevels, 0, layerCount },
+	};
+
+	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	// Mips are packed from the largest to the smallest. The layers of a mip are packed one after the other,
+	// e.g. cubemap faces in the order +X, -X, +Y, -Y, +Z, -Z.
+	std::vector<VkBufferImageCopy> regions;
+	regions.reserve(mipLevels * layerCount);
+
+	uint64 bufferOffset = stagingOffset;
+
+	for (uint32 mip = 0; mip < mipLevels; mip++)
+	{
+		const VkExtent3D extent = getMipExtent(mip);
+		const uint64 layerSize = gpu::Image::GetMipSize(dstImage.GetFormat(), extent.width, extent.height) * extent.depth;
+
+		for (uint32 layer = 0; layer < layerCount; layer++)
+		{
+			regions.push_back({
+				.bufferOffset = bufferOffset,
+				.bufferRowLength = 0,
+				.bufferImageHeight = 0,
+				.imageSubresource = { dstImage.GetVulkanAspect(), mip, layer, 1 },
+				.imageOffset = { 0, 0, 0 },
+				.imageExtent = extent,
+			});
+
+			bufferOffset += layerSize;
+		}
+	}
+
+	vkCmdCopyBufferToImage(cmdBuf, stagingBuffer, dstImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, static_cast<uint32>(regions.size()), regions.data());
+
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = 0;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	// Concurrent images belong to every family, so graphics and async compute read them without an acquire.
+	const bool isConcurrent = _Device.IsConcurrent(dstImage.GetUsage());
+	const bool isOwnershipTransferred = _IsOwnershipTransferred && !isConcurrent;
+
+	if (isOwnershipTransferred)
+	{
+		barrier.srcQueueFamilyIndex = static_cast<uint32>(_TransferQueue.GetQueueFamilyIndex());
+		barrier.dstQueueFamilyIndex = static_cast<uint32>(_GraphicsQueue.GetQueueFamilyIndex());
+	}
+
+	vkCmdPipelineBarrier(cmdBuf, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+	if (isOwnershipTransferred)
+	{
+		// The acquire repeats the layout transition of the release.
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+		GetPendingAcquire().imageBarriers.push_back(barrier);
+	}
+	else if (isConcurrent)
+	{
+		// Still order the next graphics submission, and the compute work that waits on it, after the copy.
+		GetPendingAcquire();
+	}
+
+	return _Recording.ticket;
+}
+
+void VulkanUploadService::Flush()
+{
+	if (_Recording.cmdBuf == VK_NULL_HANDLE)
+	{
+		return;
+	}
+
+	vulkan(vkEndCommandBuffer(_Recording.cmdBuf));
+
+	const uint64 timelineValue = _TransferQueue.Submit(_Recording.cmdBuf);
+
+	check(timelineValue == _Recording.ticket, "The transfer queue was submitted to outside of the upload service.");
+
+	_Recording.stagingHead = _Head;
+
+	_Batches.push_back(std::move(_Recording));
+
+	_Recording = {};
+}
+
+bool VulkanUploadService::IsComplete(gpu::UploadTicket ticket) const
+{
+	return ticket <= _TransferQueue.GetCompletedTimelineSemaphoreValue(_Device);
+}
+
+void VulkanUploadService::BeginGraphicsSubmit()
+{
+	uint64 waitTicket = std::exchange(_GraphicsWaitTicket, 0);
+
+	if (waitTicket == _Recording.ticket)
+	{
+		Flush();
+	}
+
+	// Acquire whatever has already arrived too, so the pending list stays short.
+	const uint64 acquireTicket = std::max(waitTicket, _TransferQueue.GetCompletedTimelineSemaphoreValue(_Device));
+
+	std::vector<VkBufferMemoryBarrier> bufferBarriers;
+	std::vector<VkImageMemoryBarrier> imageBarriers;
+
+	while (!_PendingAcquires.empty() && _PendingAcquires.front().ticket <= acquireTicket)
+	{
+		const PendingAcquire& acquire = _PendingAcquires.front();
+
+		bufferBarriers.insert(bufferBarriers.end(), acquire.bufferBarriers.begin(), acquire.bufferBarriers.end());
+		imageBarriers.insert(imageBarriers.end(), acquire.imageBarriers.begin(), acquire.imageBarriers.end());
+
+		waitTicket = std::max(waitTicket, acquire.ticket);
+
+		_PendingAcquires.pop_front();
+	}
+
+	if (waitTicket == 0 || (bufferBarriers.empty() && imageBarriers.empty() && IsComplete(waitTicket)))
+	{
+		return;
+	}
+
+	// Submitted ahead of the graphics work, which is ordered after it on the graphics timeline.
+	gpu::CommandBuffer cmdBuf(_Device, _GraphicsQueue);
+
+	if (!bufferBarriers.empty() || !imageBarriers.empty())
+	{
+		vkCmdPipelineBarrier(
+			cmdBuf._CommandBuffer,
+			VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+			VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+			0,
+			0, nullptr,
+			static_cast<uint32>(bufferBarriers.size()), bufferBarriers.data(),
+			static_cast<uint32>(imageBarriers.size()), imageBarriers.data()
+		);
+	}
+
+	_GraphicsQueue.Submit(cmdBuf, gpu::Semaphore(), gpu::Semaphore(), &_TransferQueue, waitTicket);
+}
+
+void VulkanUploadService::EndFrame()
+{
+	Flush();
+
+	Reclaim();
+}
+
+std::pair<VkBuffer, uint64> VulkanUploadService::AllocateStaging(uint64 size, const void* data)
+{
+	if (size > _StagingSize)
+	{
+		// Kept alive until the batch completes.
+		_Recording.dedicatedStagingBuffers.push_back(_Device.CreateBuffer(EBufferUsage::None, EMemoryUsage::CPU_ONLY, size, data));
+
+		return { _Recording.dedicatedStagingBuffers.back(), 0 };
+	}
+
+	while (true)
+	{
+		// Align the physical offset, since the size of the ring needn't be a multiple of the alignment.
+		const uint64 wrapStart = _Head - _Head % _StagingSize;
+		uint64 physicalOffset = DivideAndRoundUp(_Head % _StagingSize, _Alignment) * _Alignment;
+		uint64 offset = wrapStart + physicalOffset;
+
+		// Allocations never straddle the end of the ring.
+		if (physicalOffset + size > _StagingSize)
+		{
+			physicalOffset = 0;
+			offset = wrapStart + _StagingSize;
+		}
+
+		if (offset + size - _Tail <= _StagingSize)
+		{
+			_Head = offset + size;
+
+			Platform::Memcpy(_StagingData + physicalOffset, data, size);
+
+			return { _StagingBuffer, physicalOffset };
+		}
+
+		// The ring is full of copies in flight. Submit the recorded copies and wait for the oldest batch only.
+		Flush();
+
+		_TransferQueue.WaitTimelineSemaphore(_Device, _Batches.front().ticket);
+
+		Reclaim();
+	}
+}
+
+VkCommandBuffer VulkanUploadService::GetCommandBuffer()
+{
+	if (_Recording.cmdBuf == VK_NULL_HANDLE)
+	{
+		if (_FreeCommandBuffers.empty())
+		{
+			const VkCommandBufferAllocateInfo commandBufferAllocateInfo =
+			{
+				.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+				.commandPool = _CommandPool,
+				.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+				.commandBufferCount = 1,
+			};
+
+			vulkan(vkAllocateCommandBuffers(_Device, &commandBufferAllocateInfo, &_Recording.cmdBuf));
+		}
+		else
+		{
+			_Recording.cmdBuf = _FreeCommandBuffers.back();
+			_FreeCommandBuffers.pop_back();
+
+			vkResetCommandBuffer(_Recording.cmdBuf, 0);
+		}
+
+		const VkCommandBufferBeginInfo commandBufferBeginInfo =
+		{
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+			.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+		};
+
+		vulkan(vkBeginCommandBuffer(_Recording.cmdBuf, &commandBufferBeginInfo));
+
+		_Recording.ticket = _TransferQueue.GetTimelineSemaphoreValue() + 1;
+	}
+
+	return _Recording.cmdBuf;
+}
+
+void VulkanUploadService::Reclaim()
+{
+	const uint64 completedTicket = _TransferQueue.GetCompletedTimelineSemaphoreValue(_Device);
+
+	while (!_Batches.empty() && _Batches.front().ticket <= completedTicket)
+	{
+		_Tail = _Batches.front().stagingHead;
+
+		_FreeCommandBuffers.push_back(_Batches.front().cmdBuf);
+
+		_Batches.pop_front();
+	}
+
+	// Restart at the beginning of the ring when it's empty, so large uploads don't wrap needlessly.
+	if (_Batches.empty() && _Recording.cmdBuf == VK_NULL_HANDLE)
+	{
+		_Head = _Tail = 0;
+	}
+}
+
+VulkanUploadService::PendingAcquire& VulkanUploadService::GetPendingAcquire()
+{
+	if (_PendingAcquires.empty() || _PendingAcquires.back().ticket != _Recording.ticket)
+	{
+		_PendingAcquires.push_back({ _Recording.ticket });
+	}
+
+	return _PendingAcquires.back();
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include "VulkanBuffer.h"
+#include <vulkan/vulkan.h>
+#include <deque>
+
+class VulkanQueue;
+
+namespace gpu
+{
+	class Image;
+
+	/** Timeline value of the transfer queue that an upload has completed at. Uploads with a ticket of 0 have always completed. */
+	using UploadTicket = uint64;
+}
+
+/**
+  * Uploads buffer and image data on the transfer queue without blocking the CPU or the graphics queue.
+  * Data is copied into a persistent staging ring, and the copies are batched into one transfer submission.
+  * Uploaded resources are handed to the graphics queue family. Graphics submissions only wait on the uploads they use.
+  * The service must be the only user of the transfer queue, since tickets are predicted from its timeline.
+  */
+class VulkanUploadService
+{
+public:
+	VulkanUploadService(const VulkanUploadService&) = delete;
+	VulkanUploadService& operator=(const VulkanUploadService&) = delete;
+	VulkanUploadService(VulkanDevice& device, VulkanQueue& transferQueue, VulkanQueue& graphicsQueue, uint64 stagingSize);
+	~VulkanUploadService();
+
+	/** Copy data to a range of a GPU buffer. */
+	gpu::UploadTicket UploadBufferData(const gpu::Buffer& dstBuffer, uint64 dstOffset, uint64 size, const void* data);
+
+	/** Copy tightly packed pixels to every mip and layer of an image. The image ends up in the shader read-only layout. */
+	gpu::UploadTicket UploadImageData(const gpu::Image& dstImage, const void* srcPixels);
+
+	/** Submit the copies recorded so far. */
+	void Flush();
+
+	/** Whether the copies of an upload have completed. Doesn't block. */
+	bool IsComplete(gpu::UploadTicket ticket) const;
+
+	/** The next graphics submission waits on the GPU for the upload to complete. */
+	inline void WaitForUpload(gpu::UploadTicket ticket) { _GraphicsWaitTicket = std::max(_GraphicsWaitTicket, ticket); }
+
+	/**
+	  * Called before a graphics submission. Acquires the resources of completed uploads and of the uploads the submission waits on,
+	  * and makes the graphics queue wait for the latter.
+	  */
+	void BeginGraphicsSubmit();
+
+	/** Called in VulkanDevice::EndFrame(). Submits the frame's uploads and reclaims the staging memory of completed ones. */
+	void EndFrame();
+
+	inline uint64 GetStagingBytesInFlight() const { return _Head - _Tail; }
+	inline std::size_t GetNumBatchesInFlight() const { return _Batches.size(); }
+
+private:
+	/** Copies submitted together. */
+	struct Batch
+	{
+		VkCommandBuffer cmdBuf = VK_NULL_HANDLE;
+		gpu::UploadTicket ticket = 0;
+
+		/** Head of the staging ring at the end of the batch. */
+		uint64 stagingHead = 0;
+
+		/** Staging buffers of uploads that didn't fit in the ring. */
+		std::vector<gpu::Buffer> dedicatedStagingBuffers;
+	};
+
+	/** Barriers that take ownership of uploaded resources on the graphics queue. */
+	struct PendingAcquire
+	{
+		gpu::UploadTicket ticket;
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+	};
+
+	VulkanDevice&					_Device;
+	VulkanQueue&					_TransferQueue;
+	VulkanQueue&					_GraphicsQueue;
+
+	gpu::Buffer						_StagingBuffer;
+	uint8*							_StagingData;
+	uint64							_StagingSize;
+	uint64							_Alignment;
+
+	/** Head and tail are monotonic. Their physical offset is modulo the size of the ring. */
+	uint64							_Head = 0;
+	uint64							_Tail = 0;
+
+	VkCommandPool					_CommandPool = VK_NULL_HANDLE;
+	std::vector<VkCommandBuffer>	_FreeCommandBuffers;
+
+	/** Batch being recorded. Its command buffer is null until the first upload. */
+	Batch							_Recording;
+
+	/** Submitted batches, oldest first. */
+	std::deque<Batch>				_Batches;
+
+	/** Acquires not yet submitted to the graphics queue, oldest first. */
+	std::deque<PendingAcquire>		_PendingAcquires;
+
+	gpu::UploadTicket				_GraphicsWaitTicket = 0;
+
+	/** Whether ownership has to move from the transfer queue family to the graphics queue family. */
+	bool							_IsOwnershipTransferred;
+
+	/** Returns the staging buffer and offset to copy size bytes from. */
+	std::pair<VkBuffer, uint64> AllocateStaging(uint64 size, const void* data);
+
+	VkCommandBuffer GetCommandBuffer();
+
+	void Reclaim();
+
+	PendingAcquire& GetPendingAcquire();
+};
@@ -1,4 +1,6 @@
 #include <Engine/Engine.h>
+#include <Engine/JobSystem.h>
+#include <Engine/TextureCooker.h>
 #include <Vulkan/VulkanInstance.h>
 #include <Vulkan/VulkanPhysicalDevice.h>
 #include <Vulkan/VulkanDevice.h>
@@ -10,6 +12,29 @@
 
 int main(int argc, char* argv[])
 {
+	JobSystem jobSystem(Platform::GetInt("Engine.ini", "Renderer", "WorkerThreads", 0));
+
+	// -cookshaders fills the shader cache and exits, without opening a window or creating a device.
+	if (argc > 1 && std::string_view(argv[1]) == "-cookshaders")
+	{
+		VulkanDevice::CookShaders();
+		return 0;
+	}
+
+	// -cooktextures <dir> checks the block compressors on the CPU, then cooks the textures of the glTF files under dir and exits.
+	if (argc > 1 && std::string_view(argv[1]) == "-cooktextures")
+	{
+		check(argc > 2, "Usage: -cooktextures <dir>");
+
+		if (!TextureCooker::CheckRoundTrip())
+		{
+			return 1;
+		}
+
+		TextureCooker::CookDirectory(argv[2]);
+		return 0;
+	}
+
 	Platform platform(
 		Platform::GetInt("Engine.ini", "Renderer", "WindowSizeX", 720),
 		Platform::GetInt("Engine.ini", "Renderer", "WindowSizeY", 720)
@@ -27,7 +52,7 @@ int main(int argc, char* argv[])
 	VulkanCompositor compositor(instance, physicalDevice, platform.GetWindow());
 	VulkanDevice device(instance, physicalDevice, { compositor.GetPresentIndex() });
 
-	Engine engine(platform, cursor, input, screen, device, compositor);
+	Engine engine(platform, jobSystem, cursor, input, screen, device, compositor);
 	engine.Main();
 
 	return 0;
@@ -3,6 +3,7 @@
 #include "SurfaceInterface.glsl"
 #include "MaterialInterface.glsl"
 #include "LightingCommon.glsl"
+#include "GBufferCommon.glsl"
 
 #ifdef CAMERA_SET
 
@@ -13,7 +14,7 @@ layout(binding = 3, set = CAMERA_SET) uniform sampler2D _GBuffer1;
 layout(binding = 4, set = CAMERA_SET, rgba16f) uniform image2D _SceneColor;
 layout(binding = 5, set = CAMERA_SET, rgba16f) uniform image2D _SSRHistory;
 layout(binding = 6, set = CAMERA_SET, rgba16f) uniform image2D _SSGIHistory;
-layout(binding = 7, set = CAMERA_SET, rgba16f) uniform image2D _DirectLighting;
+layout(binding = 7, set = CAMERA_SET, r11f_g11f_b10f) uniform image2D _DirectLighting;
 
 /** Transform from screen space to world space. */
 vec3 ScreenToWorld(vec2 screenUV, float depth)
@@ -34,18 +35,18 @@ void UnpackGBuffers(vec2 screenUV, ivec2 screenCoords, inout SurfaceData surface
 	surface.depth = texture(_SceneDepth, screenUV).r;
 
 	surface.worldPosition = ScreenToWorld(screenUV, surface.depth);
-	surface.worldNormal = gBuffer0Data.rgb;
+	surface.worldNormal = DecodeWorldNormal(gBuffer0Data);
 
-	material.baseColor = gBuffer1Data.rgb;
-	material.metallic = gBuffer0Data.a;
-	material.roughness = clamp( gBuffer1Data.a, 1e-1, 1.0 );
+	material.baseColor = DecodeBaseColor(gBuffer1Data);
+	material.metallic = DecodeMetallic(gBuffer0Data);
+	material.roughness = clamp( DecodeRoughness(gBuffer1Data), 1e-1, 1.0 );
 	material.specularColor = mix(vec3(0.04), material.baseColor, material.metallic);
 	material.diffuseColor = Diffuse_BRDF(material.baseColor);
 }
 
 vec3 LoadNormal(ivec2 screenCoords)
 {
-	return texelFetch(_GBuffer0, screenCoords, 0).rgb;
+	return DecodeWorldNormal(texelFetch(_GBuffer0, screenCoords, 0));
 }
 
 #endif
@@ -0,0 +1,125 @@
+#define TEXTURE_SET 2
+#include "SceneResources.glsl"
+
+layout(binding = 0, set = 0) readonly buffer SurfaceBuffer { LocalToWorldUniform _LocalToWorld[]; };
+layout(binding = 0, set = 1) readonly buffer CandidateBuffer { ClusterCandidate _Candidates[]; };
+layout(binding = 1, set = 1) readonly buffer ViewBuffer { ClusterCullingView _Views[]; };
+
+/** VkDrawIndexedIndirectCommand. */
+struct DrawIndexedIndirectCommand
+{
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint firstInstance;
+};
+
+layout(binding = 2, set = 1) writeonly buffer CommandBuffer { DrawIndexedIndirectCommand _Commands[]; };
+
+layout(push_constant) uniform Params { ClusterCullingParams _Params; };
+
+/** Test a sphere against the planes of a clip space frustum with a depth range of [0, 1]. Works for perspective and orthographic views. */
+bool IsSphereInFrustum(mat4 worldToClip, vec3 center, float radius)
+{
+	const vec4 row0 = vec4(worldToClip[0][0], worldToClip[1][0], worldToClip[2][0], worldToClip[3][0]);
+	const vec4 row1 = vec4(worldToClip[0][1], worldToClip[1][1], worldToClip[2][1], worldToClip[3][1]);
+	const vec4 row2 = vec4(worldToClip[0][2], worldToClip[1][2], worldToClip[2][2], worldToClip[3][2]);
+	const vec4 row3 = vec4(worldToClip[0][3], worldToClip[1][3], worldToClip[2][3], worldToClip[3][3]);
+
+	const vec4 planes[6] = vec4[6](row3 + row0, row3 - row0, row3 + row1, row3 - row1, row2, row3 - row2);
+
+	for (int i = 0; i < 6; i++)
+	{
+		if (dot(planes[i].xyz, center) + planes[i].w < -radius * length(planes[i].xyz))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+  * Test a sphere against the farthest depth of the last frame. The sphere's box is projected with the last frame's transform,
+  * and the Hi-Z mip where the box covers at most 2x2 texels is tested. Spheres that crossed the near plane or the edge of the screen are visible.
+  */
+bool IsSphereOccluded(mat4 prevWorldToClip, vec3 center, float radius)
+{
+	vec3 ndcMin = vec3(1.0f);
+	vec3 ndcMax = vec3(-1.0f);
+
+	for (int i = 0; i < 8; i++)
+	{
+		const vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0f : -1.0f, (i & 2) != 0 ? 1.0f : -1.0f, (i & 4) != 0 ? 1.0f : -1.0f);
+		const vec4 clipPosition = prevWorldToClip * vec4(corner, 1.0f);
+
+		if (clipPosition.w <= 0.0f || clipPosition.z < 0.0f)
+		{
+			return false;
+		}
+
+		const vec3 ndc = clipPosition.xyz / clipPosition.w;
+		ndcMin = min(ndcMin, ndc);
+		ndcMax = max(ndcMax, ndc);
+	}
+
+	const vec2 uvMin = ndcMin.xy * 0.5f + 0.5f;
+	const vec2 uvMax = ndcMax.xy * 0.5f + 0.5f;
+
+	if (any(lessThan(uvMin, vec2(0.0f))) || any(greaterThan(uvMax, vec2(1.0f))))
+	{
+		return false;
+	}
+
+	const vec2 hiZSize = vec2(TextureSize(_Params._HiZ, 0));
+	const vec2 extent = (uvMax - uvMin) * hiZSize;
+	const int level = clamp(int(ceil(log2(max(max(extent.x, extent.y), 1.0f)))), 0, int(_Params._HiZMipLevels) - 1);
+	const ivec2 levelSize = TextureSize(_Params._HiZ, level);
+
+	const ivec2 texelMin = clamp(ivec2(uvMin * vec2(levelSize)), ivec2(0), levelSize - 1);
+	const ivec2 texelMax = clamp(ivec2(uvMax * vec2(levelSize)), ivec2(0), levelSize - 1);
+
+	const float maxDepth = max(
+		max(texelFetch(_Textures[_Params._HiZ], texelMin, level).r, texelFetch(_Textures[_Params._HiZ], ivec2(texelMax.x, texelMin.y), level).r),
+		max(texelFetch(_Textures[_Params._HiZ], ivec2(texelMin.x, texelMax.y), level).r, texelFetch(_Textures[_Params._HiZ], texelMax, level).r));
+
+	return ndcMin.z > maxDepth;
+}
+
+layout(local_size_x = 64) in;
+void main()
+{
+	if (gl_GlobalInvocationID.x >= _Params._NumCandidates)
+		return;
+
+	const ClusterCandidate candidate = _Candidates[_Params._FirstCandidate + gl_GlobalInvocationID.x];
+	const ClusterCullingView view = _Views[_Params._View];
+	const mat4 localToWorld = _LocalToWorld[candidate.surfaceID].transform;
+
+	const vec3 scale = vec3(length(localToWorld[0].xyz), length(localToWorld[1].xyz), length(localToWorld[2].xyz));
+	const float maxScale = max(scale.x, max(scale.y, scale.z));
+	const float minScale = min(scale.x, min(scale.y, scale.z));
+
+	const vec3 center = (localToWorld * vec4(candidate.center, 1.0f)).xyz;
+	const float radius = candidate.radius * maxScale;
+
+	bool isVisible = IsSphereInFrustum(view.worldToClip, center, radius);
+
+	// Normal cones are only preserved by rotations and uniform scales.
+	if (isVisible && _Params._ConeCulling != 0 && candidate.coneCutoff < 1.0f && maxScale - minScale <= 1e-3f * maxScale)
+	{
+		const vec3 coneAxis = normalize(mat3(localToWorld) * candidate.coneAxis);
+		const vec3 viewToCenter = center - view.position;
+
+		isVisible = dot(viewToCenter, coneAxis) < candidate.coneCutoff * length(viewToCenter) + radius;
+	}
+
+	if (isVisible && _Params._OcclusionCulling != 0)
+	{
+		isVisible = !IsSphereOccluded(view.prevWorldToClip, center, radius);
+	}
+
+	// Every candidate has a command, so the draws index them directly. Culled meshlets have no instances.
+	_Commands[_Params._FirstCommand + gl_GlobalInvocationID.x] = DrawIndexedIndirectCommand(candidate.indexCount, isVisible ? 1 : 0, candidate.firstIndex, 0, 0);
+}
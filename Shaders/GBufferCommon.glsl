@@ -0,0 +1,63 @@
+#ifndef GBUFFER_COMMON
+#define GBUFFER_COMMON
+
+/**
+  * GBuffer layout:
+  *	_GBuffer0 (A2B10G10R10_UNORM)	rg: octahedral world normal, b: metallic, a: unused.
+  *	_GBuffer1 (R8G8B8A8_UNORM)		rgb: base color, a: roughness.
+  *	World position is reconstructed from _SceneDepth.
+  */
+
+vec2 OctWrap(vec2 v)
+{
+	return (1.0 - abs(v.yx)) * mix(vec2(-1.0), vec2(1.0), greaterThanEqual(v, vec2(0.0)));
+}
+
+/** Map a unit vector to [0, 1]^2. Reference: "A Survey of Efficient Representations for Independent Unit Vectors" */
+vec2 EncodeOctahedral(vec3 n)
+{
+	n /= abs(n.x) + abs(n.y) + abs(n.z);
+	n.xy = n.z >= 0.0 ? n.xy : OctWrap(n.xy);
+	return n.xy * 0.5 + 0.5;
+}
+
+vec3 DecodeOctahedral(vec2 f)
+{
+	f = f * 2.0 - 1.0;
+	vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+	const float t = clamp(-n.z, 0.0, 1.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+
+vec4 EncodeGBuffer0(vec3 worldNormal, float metallic)
+{
+	return vec4(EncodeOctahedral(worldNormal), metallic, 0.0);
+}
+
+vec4 EncodeGBuffer1(vec3 baseColor, float roughness)
+{
+	return vec4(baseColor, roughness);
+}
+
+vec3 DecodeWorldNormal(vec4 gBuffer0Data)
+{
+	return DecodeOctahedral(gBuffer0Data.rg);
+}
+
+float DecodeMetallic(vec4 gBuffer0Data)
+{
+	return gBuffer0Data.b;
+}
+
+vec3 DecodeBaseColor(vec4 gBuffer1Data)
+{
+	return gBuffer1Data.rgb;
+}
+
+float DecodeRoughness(vec4 gBuffer1Data)
+{
+	return gBuffer1Data.a;
+}
+
+#endif
@@ -10,6 +10,8 @@ layout(location = 1) out vec4 outGBuffer1;
 
 void main()
 {
+	Surface_DitherLODFade();
+
 	SurfaceData surface = Surface_Get();
 	MaterialData material = Material_Get(surface);
 
@@ -19,8 +21,6 @@ void main()
 
 	Material_NormalMapping(surface, v);
 
-	outGBuffer0.rgb = surface.worldNormal;
-	outGBuffer0.a = material.metallic;
-	outGBuffer1.rgb = material.baseColor;
-	outGBuffer1.a = material.roughness;
+	outGBuffer0 = EncodeGBuffer0(surface.worldNormal, material.metallic);
+	outGBuffer1 = EncodeGBuffer1(material.baseColor, material.roughness);
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#define CAMERA_SET 0
+#include "CameraCommon.glsl"
+#define IMAGE_SET 1
+#include "SceneResources.glsl"
+
+layout(push_constant) uniform Params { HiZBuildParams _Params; };
+
+/** Reduce the mip above, or the scene depth for the first mip, to the farthest depth of each 2x2 texels. */
+layout(local_size_x = 8, local_size_y = 8) in;
+void main()
+{
+	const ivec2 dstSize = ImageSize(_Params._Dst);
+	const ivec2 dstCoords = ivec2(gl_GlobalInvocationID.xy);
+
+	if (any(greaterThanEqual(dstCoords, dstSize)))
+		return;
+
+	const ivec2 srcSize = _Params._IsFirstMip != 0 ? textureSize(_SceneDepth, 0) : ImageSize(_Params._Src);
+	const ivec2 srcBegin = dstCoords * 2;
+
+	// The last texel of an odd-sized source row or column is covered by the last destination texel, so no depth is missed.
+	ivec2 srcEnd = srcBegin + 2;
+	srcEnd.x = dstCoords.x == dstSize.x - 1 ? srcSize.x : srcEnd.x;
+	srcEnd.y = dstCoords.y == dstSize.y - 1 ? srcSize.y : srcEnd.y;
+	srcEnd = min(srcEnd, srcSize);
+
+	float maxDepth = 0.0f;
+
+	for (int y = srcBegin.y; y < srcEnd.y; y++)
+	{
+		for (int x = srcBegin.x; x < srcEnd.x; x++)
+		{
+			const float depth = _Params._IsFirstMip != 0 ? texelFetch(_SceneDepth, ivec2(x, y), 0).r : ImageLoad(_Params._Src, ivec2(x, y)).r;
+			maxDepth = max(maxDepth, depth);
+		}
+	}
+
+	ImageStore(_Params._Dst, dstCoords, vec4(maxDepth));
+}
@@ -3,9 +3,10 @@
 #include "MaterialInterface.glsl"
 #include "SceneResources.glsl"
 
+// After the vertex stage's SurfaceParams. The offset keeps emissiveFactor 16-byte aligned where Material::PushConstants has it.
 layout(push_constant) uniform MaterialConstants
 {
-	layout(offset = 4) uint baseColor;
+	layout(offset = 56) uint baseColor;
 	uint metallicRoughness;
 	uint normal;
 	uint emissive;
@@ -26,7 +27,8 @@ MaterialData Material_Get(SurfaceData surface)
 
 	if (_HasMetallicRoughnessTexture)
 	{
-		vec2 metallicRoughness = Sample2D(_Material.metallicRoughness, surface.uv).gb;
+		// Cooked with roughness in R and metallic in G.
+		vec2 metallicRoughness = Sample2D(_Material.metallicRoughness, surface.uv).rg;
 		material.metallic = metallicRoughness.y;
 		material.roughness = 1.0 - metallicRoughness.x;
 	}
@@ -74,7 +76,10 @@ void Material_NormalMapping(inout SurfaceData surface, vec3 v)
 {
 	if (_HasNormalTexture)
 	{
-		const vec3 mapNormal = Sample2D(_Material.normal, surface.uv).xyz * 2.0 - 1.0;
+		// Normals are cooked to two channels, so Z is reconstructed.
+		vec3 mapNormal;
+		mapNormal.xy = Sample2D(_Material.normal, surface.uv).xy * 2.0 - 1.0;
+		mapNormal.z = sqrt(max(1.0 - dot(mapNormal.xy, mapNormal.xy), 0.0));
 		surface.worldNormal = normalize(CotangentFrame(surface.worldNormal, v, surface.uv) * mapNormal);
 	}
 }
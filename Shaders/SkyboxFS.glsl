@@ -4,7 +4,7 @@
 layout(location = 0) in vec3 inPosition;
 layout(location = 0) out vec4 outColor;
 
-layout(push_constant) uniform Params { SkyboxParams _Params; };
+layout(push_constant) uniform Params { layout(offset = 32) SkyboxParams _Params; };
 
 void main()
 {
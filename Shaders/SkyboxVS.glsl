@@ -1,11 +1,14 @@
 #define CAMERA_SET 0
 #include "CameraCommon.glsl"
 
-layout(location = 0) in vec3 position;
+layout(location = 0) in vec3 quantizedPosition;
 layout(location = 0) out vec3 outTexCoord;
 
+layout(push_constant) uniform VertexParams { SkyboxVertexParams _VertexParams; };
+
 void main()
 {
+	const vec3 position = _VertexParams._PositionBias + _VertexParams._PositionScale * quantizedPosition;
 	vec4 outPosition = _Camera.viewToClip * vec4(mat3(_Camera.worldToView) * position, 0.0f);
 	gl_Position = outPosition.xyzz;
 	outTexCoord = position;
@@ -1,5 +1,6 @@
 #ifndef STATIC_MESH_COMMON
 #define STATIC_MESH_COMMON
+#include "GBufferCommon.glsl"
 
 #define SURFACE(InOut)						\
 layout(location = 0) InOut Surface##InOut	\
@@ -10,9 +11,10 @@ layout(location = 0) InOut Surface##InOut	\
 } 											\
 
 #if VERTEX_SHADER
+// Quantized attributes, laid out by VertexLayout. Positions and UVs are dequantized with the submesh's SurfaceParams.
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec2 uv;
-layout(location = 2) in vec3 normal;
+layout(location = 2) in vec2 octahedralNormal;
 #elif GEOMETRY_SHADER
 SURFACE(in) inSurface[];
 #else
@@ -23,6 +25,14 @@ SURFACE(in) inSurface;
 SURFACE(out) outSurface;
 #endif
 
+#if LOD_CROSS_FADE
+#if VERTEX_SHADER
+layout(location = 3) flat out float outLODFade;
+#elif FRAGMENT_SHADER
+layout(location = 3) flat in float inLODFade;
+#endif
+#endif
+
 #ifdef MESH_SET
 #extension GL_EXT_nonuniform_qualifier : require
 layout(binding = 0, set = MESH_SET) readonly buffer SurfaceBuffer { LocalToWorldUniform _LocalToWorld[]; };
@@ -30,21 +40,25 @@ layout(binding = 0, set = MESH_SET) readonly buffer SurfaceBuffer { LocalToWorld
 
 #if VERTEX_SHADER
 
-layout(push_constant) uniform SurfaceConstants
-{
-	layout(offset = 0) uint _SurfaceID;
-};
+layout(push_constant) uniform SurfaceConstants { SurfaceParams _Surface; };
 
 vec4 Surface_GetWorldPosition()
 {
-	return _LocalToWorld[_SurfaceID.x].transform * vec4(position, 1.0f);
+	const vec3 localPosition = _Surface._PositionBias + _Surface._PositionScale * position;
+	return _LocalToWorld[_Surface._SurfaceID].transform * vec4(localPosition, 1.0f);
 }
 
 void Surface_SetAttributes(in vec4 worldPosition)
 {
+	// Normals are snorm, and DecodeOctahedral() takes [0, 1].
+	const vec3 normal = DecodeOctahedral(octahedralNormal * 0.5f + 0.5f);
+
 	outSurface.position = worldPosition.xyz;
-	outSurface.uv = uv;
-	outSurface.normal = mat3(_LocalToWorld[_SurfaceID.x].inverseTranspose) * normal;
+	outSurface.uv = _Surface._UVBias + _Surface._UVScale * uv;
+	outSurface.normal = mat3(_LocalToWorld[_Surface._SurfaceID].inverseTranspose) * normal;
+#if LOD_CROSS_FADE
+	outLODFade = _Surface._LODFade;
+#endif
 }
 
 #elif GEOMETRY_SHADER
@@ -76,6 +90,23 @@ SurfaceData Surface_Get()
 	return surface;
 }
 
+/** Discard the pixels the other level covers while cross-fading between levels of detail. Both levels use the same dither, so they don't overlap. */
+void Surface_DitherLODFade()
+{
+#if LOD_CROSS_FADE
+	if (inLODFade != 0.0f)
+	{
+		// Interleaved gradient noise (Jimenez, "Next Generation Post Processing in Call of Duty: Advanced Warfare").
+		const float dither = fract(52.9829189f * fract(dot(gl_FragCoord.xy, vec2(0.06711056f, 0.00583715f))));
+
+		if (inLODFade > 0.0f ? dither >= inLODFade : dither < -inLODFade)
+		{
+			discard;
+		}
+	}
+#endif
+}
+
 #endif
 
 #endif
\ No newline at end of file
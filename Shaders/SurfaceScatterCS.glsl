@@ -0,0 +1,18 @@
+layout(binding = 0, set = 0) writeonly buffer SurfaceBuffer { LocalToWorldUniform _LocalToWorld[]; };
+layout(binding = 1, set = 0) readonly buffer SurfaceDeltaBuffer { SurfaceDelta _SurfaceDeltas[]; };
+
+layout(push_constant) uniform Params { SurfaceScatterParams _Params; };
+
+layout(local_size_x = 64) in;
+void main()
+{
+	if (gl_GlobalInvocationID.x >= _Params._NumDeltas)
+		return;
+
+	const SurfaceDelta surfaceDelta = _SurfaceDeltas[_Params._FirstDelta + gl_GlobalInvocationID.x];
+	const mat4 inverseTransform = inverse(surfaceDelta.transform);
+
+	_LocalToWorld[surfaceDelta.surfaceID].transform = surfaceDelta.transform;
+	_LocalToWorld[surfaceDelta.surfaceID].inverse = inverseTransform;
+	_LocalToWorld[surfaceDelta.surfaceID].inverseTranspose = transpose(inverseTransform);
+}